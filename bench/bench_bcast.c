@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // for strncmp
+#include <sched.h>
+#include <omp.h>
+#include "queue.h"
+#include "bcast.h"
+#include "utils.c"
+
+// Fan-out benchmark: one producer hands MSGS messages to N subscribers
+// that each need every message (N = 1, 2, 4, 8).
+//   - queues:     one Queue per subscriber (the MODE's implementation,
+//                 twolock by default); the producer enqueues every
+//                 message N times, each subscriber dequeues from its own
+//   - bcast:      one broadcast ring; the producer publishes once and
+//                 every subscriber consumes through its own cursor
+//   - bcast_bulk: the same, subscribers take up to BULK messages per call
+// Producer and subscribers block when they cannot proceed (enqueue_wait/
+// dequeue_wait, bcast_publish_wait/bcast_consume_wait). Rows are the
+// best of TRIALS runs; msgs_per_s counts published messages, vs_queues
+// is relative to the queues row with the same N.
+//
+//   make bench_bcast [MODE=...]
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+#ifndef MSGS
+#define MSGS (1 << 18)
+#endif
+
+// Capacity of the ring and of each queue
+#ifndef BCAST_CAP
+#define BCAST_CAP 1024
+#endif
+
+#ifndef BULK
+#define BULK 64
+#endif
+
+#ifndef TRIALS
+#define TRIALS 3
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+#define MAX_SUBS 8
+
+// Every subscriber must receive 0..MSGS-1 once
+static void check_sums(const long long *sums, int subs) {
+    for (int i = 0; i < subs; i++) {
+        if (sums[i] != (long long)MSGS * (MSGS - 1) / 2) {
+            fprintf(stderr, "subscriber %d misbehaved (sum %lld)\n", i, sums[i]);
+            exit(1);
+        }
+    }
+}
+
+static double run_queues(int subs) {
+    Queue *qs[MAX_SUBS];
+    long long sums[MAX_SUBS] = {0};
+    for (int i = 0; i < subs; i++) {
+        qs[i] = create(BCAST_CAP);
+        if (!qs[i]) {
+            fprintf(stderr, "Failed to create queue (cap=%d)\n", BCAST_CAP);
+            exit(1);
+        }
+    }
+
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(subs + 1) shared(qs, sums)
+    {
+        int tid = omp_get_thread_num();
+        if (tid == 0) {
+            for (int m = 0; m < MSGS; m++) {
+                for (int i = 0; i < subs; i++) enqueue_wait(qs[i], m);
+            }
+        } else {
+            Queue *q = qs[tid - 1];
+            long long sum = 0;
+            int v;
+            for (int m = 0; m < MSGS; m++) {
+                dequeue_wait(q, &v);
+                sum += v;
+            }
+            sums[tid - 1] = sum;
+        }
+    }
+    double t1 = omp_get_wtime();
+
+    for (int i = 0; i < subs; i++) destroy(qs[i]);
+    check_sums(sums, subs);
+    return t1 - t0;
+}
+
+static double run_bcast(int subs, int bulk) {
+    long long sums[MAX_SUBS] = {0};
+    Bcast *b = bcast_create(BCAST_CAP, subs);
+    if (!b) {
+        fprintf(stderr, "Failed to create broadcast ring (cap=%d)\n", BCAST_CAP);
+        exit(1);
+    }
+    for (int i = 0; i < subs; i++) bcast_subscribe(b, -1);
+
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(subs + 1) shared(b, sums)
+    {
+        int tid = omp_get_thread_num();
+        if (tid == 0) {
+            for (int m = 0; m < MSGS; m++) bcast_publish_wait(b, m);
+        } else {
+            int c = tid - 1;
+            long long sum = 0;
+            int buf[BULK];
+            for (int m = 0; m < MSGS;) {
+                int n = bulk ? bcast_consume_bulk(b, c, buf, BULK) : 0;
+                // Nothing ready (or one at a time): wait for the next one
+                if (n == 0) {
+                    bcast_consume_wait(b, c, buf);
+                    n = 1;
+                }
+                for (int k = 0; k < n; k++) sum += buf[k];
+                m += n;
+            }
+            sums[c] = sum;
+        }
+    }
+    double t1 = omp_get_wtime();
+
+    bcast_destroy(b);
+    check_sums(sums, subs);
+    return t1 - t0;
+}
+
+static double best_of(int variant, int subs) {
+    double best = 0;
+    for (int t = 0; t < TRIALS; t++) {
+        double secs = variant == 0 ? run_queues(subs) : run_bcast(subs, variant == 2);
+        if (t == 0 || secs < best) best = secs;
+    }
+    return best;
+}
+
+int main(void) {
+    // The per-subscriber queues need a thread-safe queue
+    if (strncmp(IMPL_NAME, "seq", 3) == 0) {
+        fprintf(stderr, "fan-out benchmark needs a concurrent implementation\n");
+        return 1;
+    }
+
+    static const char *const variants[] = {"queues", "bcast", "bcast_bulk"};
+
+    printf("# queue = %s, cap = %d\n", IMPL_NAME, BCAST_CAP);
+    printf("variant,impl,subs,msgs,msgs_per_s,deliveries_per_s,vs_queues\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_bcast();
+#endif
+
+    for (int subs = 1; subs <= MAX_SUBS; subs *= 2) {
+        double base = 0;
+        for (int v = 0; v < 3; v++) {
+            double rate = MSGS / best_of(v, subs);
+            if (v == 0) base = rate;
+#ifdef USE_PRETTY_TABLE
+            print_row_bcast(variants[v], IMPL_NAME, subs, MSGS, rate, rate * subs, rate / base);
+#else
+            printf("%s,%s,%d,%d,%.1f,%.1f,%.2f\n", variants[v], IMPL_NAME, subs, MSGS, rate,
+                   rate * subs, rate / base);
+#endif
+        }
+    }
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_bcast();
+#endif
+    return 0;
+}
@@ -0,0 +1,116 @@
+#define _GNU_SOURCE   // for sysconf
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>         // for sysconf
+#include <sys/resource.h>   // for getrusage
+#include <omp.h>
+#include "queue.h"
+#include "utils.c"
+
+// Bursty-producer benchmark: N_QUEUES queues, each sized for the largest
+// burst, take turns receiving a burst of BURST items that is then drained.
+// A bounded ring touches its whole array during its first burst, so peak
+// RSS grows with N_QUEUES * BURST; the segmented queue only holds memory
+// for what is queued right now, so its peak is about one burst.
+//
+// Peak RSS is per process, so run one binary per implementation:
+//   make bench_burst MODE=two
+//   make bench_burst MODE=segmented
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+#ifndef N_QUEUES
+#define N_QUEUES 16
+#endif
+
+#ifndef BURST
+#define BURST (1 << 16)
+#endif
+
+// Bursts per queue
+#ifndef N_ROUNDS
+#define N_ROUNDS 4
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+// Peak resident set size of the process so far, in KiB
+static long peak_rss_kb(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// Current resident set size in KiB (Linux), or -1 if unknown
+static long current_rss_kb(void) {
+    long pages = -1;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%*s %ld", &pages) != 1) pages = -1;
+    fclose(f);
+    return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(void) {
+    Queue *qs[N_QUEUES];
+
+    long peak0 = peak_rss_kb();
+    long rss0 = current_rss_kb();
+
+    // Every queue is provisioned for the full burst
+    for (int i = 0; i < N_QUEUES; i++) {
+        qs[i] = create(BURST);
+        if (!qs[i]) {
+            fprintf(stderr, "Failed to create queue (cap=%d)\n", BURST);
+            return 1;
+        }
+    }
+
+    double t0 = omp_get_wtime();
+    int v;
+    for (int r = 0; r < N_ROUNDS * N_QUEUES; r++) {
+        Queue *q = qs[r % N_QUEUES];
+        // Burst: the producer fills the queue faster than it is drained
+        for (int i = 0; i < BURST; i++) {
+            if (!enqueue(q, i)) {
+                fprintf(stderr, "enqueue failed during burst\n");
+                return 1;
+            }
+        }
+        // Quiet period: consumers catch up
+        while (dequeue(q, &v)) {
+        }
+    }
+    double t1 = omp_get_wtime();
+
+    long peak = peak_rss_kb() - peak0;
+    long rss = current_rss_kb() - rss0;
+#ifdef SEGMENTED
+    int segs = 0;
+    for (int i = 0; i < N_QUEUES; i++) segs += live_segments(qs[i]);
+#else
+    int segs = -1;
+#endif
+
+    double ops = 2.0 * (double)BURST * N_ROUNDS * N_QUEUES;
+
+    printf("impl,queues,burst,rounds,time_s,throughput_ops_per_s,"
+           "peak_rss_delta_kb,rss_after_drain_delta_kb,live_segments\n");
+    #ifdef USE_PRETTY_TABLE
+        print_header_burst();
+        print_row_burst(IMPL_NAME, N_QUEUES, BURST, N_ROUNDS, t1 - t0, ops / (t1 - t0),
+                        peak, rss, segs);
+        print_footer_burst();
+    #else
+        printf("%s,%d,%d,%d,%.6f,%.1f,%ld,%ld,%d\n",
+               IMPL_NAME, N_QUEUES, BURST, N_ROUNDS, t1 - t0, ops / (t1 - t0),
+               peak, rss, segs);
+    #endif
+
+    for (int i = 0; i < N_QUEUES; i++) destroy(qs[i]);
+    return 0;
+}
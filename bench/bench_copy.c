@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "queue.h"
+#include "utils.c"
+
+// Bulk drain bandwidth: for each capacity, the queue is filled (untimed)
+// and then emptied by one dequeue_bulk call, which is timed; the ring
+// starts half way round so every fill and drain wraps. Each copy kernel
+// of ring_copy.c is measured (those the CPU supports), plain and with
+// non-temporal stores, against a plain memcpy of the same number of
+// bytes between two buffers of the same size.
+//
+//   make bench_copy [MODE=...] [CFLAGS_EXTRA=-DCOPY_BYTES=...]
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// Capacities in ints: MIN_CAP, MIN_CAP * 4, ... up to MAX_CAP
+#ifndef MIN_CAP
+#define MIN_CAP (1 << 10)
+#endif
+
+#ifndef MAX_CAP
+#define MAX_CAP (1 << 24)
+#endif
+
+// Bytes drained per measurement (at least one full drain)
+#ifndef COPY_BYTES
+#define COPY_BYTES (1LL << 28)
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+typedef struct {
+    const char *label;
+    const char *kernel;
+    int nt;
+} Kernel;
+
+static const Kernel kernels[] = {
+    {"memcpy", "memcpy", 0},
+    {"sse2", "sse2", 0},
+    {"sse2+nt", "sse2", 1},
+    {"avx2", "avx2", 0},
+    {"avx2+nt", "avx2", 1},
+};
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int reps_for(int cap) {
+    long long reps = COPY_BYTES / ((long long)cap * (long long)sizeof(int));
+    return reps < 1 ? 1 : (int)reps;
+}
+
+static double gbps(int cap, int reps, long long ns) {
+    return (double)cap * sizeof(int) * reps / (double)ns;
+}
+
+// Fill q from src, timing nothing
+static void fill(Queue *q, const int *src, int cap) {
+    if (enqueue_bulk(q, src, cap) != cap) {
+        fprintf(stderr, "enqueue_bulk fell short (cap=%d)\n", cap);
+        exit(1);
+    }
+}
+
+// GB/s of draining q (cap ints) into out, reps times
+static double drain_gbps(Queue *q, const int *src, int *out, int cap) {
+    int reps = reps_for(cap);
+    long long ns = 0;
+    // Untimed lap: faults in out and warms the path
+    fill(q, src, cap);
+    dequeue_bulk(q, out, cap);
+    for (int r = 0; r < reps; r++) {
+        fill(q, src, cap);
+        long long t0 = now_ns();
+        int got = dequeue_bulk(q, out, cap);
+        ns += now_ns() - t0;
+        if (got != cap || out[0] != src[0] || out[cap - 1] != src[cap - 1]) {
+            fprintf(stderr, "dequeue_bulk misbehaved (cap=%d, got=%d)\n", cap, got);
+            exit(1);
+        }
+    }
+    return gbps(cap, reps, ns);
+}
+
+static double memcpy_gbps(const int *src, int *out, int cap) {
+    int reps = reps_for(cap);
+    long long ns = 0;
+    memcpy(out, src, (size_t)cap * sizeof(int));
+    for (int r = 0; r < reps; r++) {
+        long long t0 = now_ns();
+        memcpy(out, src, (size_t)cap * sizeof(int));
+        ns += now_ns() - t0;
+        // Keep the copies from being merged or dropped
+        __asm__ __volatile__("" : : "r"(out) : "memory");
+    }
+    return gbps(cap, reps, ns);
+}
+
+int main(void) {
+    int *src = malloc((size_t)MAX_CAP * sizeof(int));
+    int *out = malloc((size_t)MAX_CAP * sizeof(int));
+    if (!src || !out) {
+        fprintf(stderr, "Failed to allocate %d-int buffers\n", MAX_CAP);
+        return 1;
+    }
+    for (int i = 0; i < MAX_CAP; i++) src[i] = i;
+
+    printf("# queue = %s, auto kernel = %s\n", IMPL_NAME, queue_copy_kernel());
+    printf("impl,cap,kernel,drain_gbps,memcpy_gbps\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_copy();
+#endif
+
+    for (int cap = MIN_CAP; cap <= MAX_CAP; cap *= 4) {
+        Queue *q = create(cap);
+        if (!q) {
+            fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
+            return 1;
+        }
+        // Start half way round, so fills and drains cross the wrap
+        fill(q, src, cap / 2);
+        dequeue_bulk(q, out, cap / 2);
+
+        double base = memcpy_gbps(src, out, cap);
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            // Kernels this CPU does not have are skipped
+            if (!queue_set_copy_kernel(kernels[k].kernel)) continue;
+            queue_set_stream_threshold(kernels[k].nt ? 1 : 0);
+            double bw = drain_gbps(q, src, out, cap);
+#ifdef USE_PRETTY_TABLE
+            print_row_copy(IMPL_NAME, cap, kernels[k].label, bw, base);
+#else
+            printf("%s,%d,%s,%.2f,%.2f\n", IMPL_NAME, cap, kernels[k].label, bw, base);
+#endif
+        }
+        queue_set_copy_kernel(NULL);
+        queue_set_stream_threshold(0);
+        destroy(q);
+    }
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_copy();
+#endif
+    free(src);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>   // for strncmp
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "queue_coro.hpp"
+#include "utils.c"
+
+// Many idle consumers: WAITERS consumers each take PER messages from one
+// queue of capacity CORO_CAP, and all of them are waiting before the
+// first message is sent.
+//   - coro:    consumer coroutines suspended in co_await q.pop() on an
+//              AsyncQueue over the MODE's queue, resumed on a
+//              single-threaded LoopExecutor; a producer coroutine sends
+//   - threads: one OS thread per consumer blocked on a mutex/condition-
+//              variable queue; the main thread sends
+// spawn_ms is the time until every consumer waits and rss_kb the
+// resident memory that took (thread stacks' kernel side not included);
+// drain_ms is the time to deliver every message.
+//
+//   make bench_coro [MODE=...] [CFLAGS_EXTRA=-DWAITERS=1000]
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+#ifndef WAITERS
+#define WAITERS 10000
+#endif
+
+// Messages per consumer
+#ifndef PER
+#define PER 10
+#endif
+
+#ifndef CORO_CAP
+#define CORO_CAP 1024
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static long rss_kb() {
+    long pages = 0, resident = 0;
+    FILE *f = std::fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = -1;
+    std::fclose(f);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void check_sum(long long sum) {
+    long long n = (long long)WAITERS * PER;
+    if (sum != n * (n - 1) / 2) {
+        std::fprintf(stderr, "consumers misbehaved (sum %lld)\n", sum);
+        std::exit(1);
+    }
+}
+
+static void report(const char *variant, double spawn_ms, long kb, double drain_ms) {
+    int msgs = WAITERS * PER;
+    double rate = msgs / (drain_ms / 1000.0);
+#ifdef USE_PRETTY_TABLE
+    print_row_coro(variant, IMPL_NAME, WAITERS, msgs, spawn_ms, kb, drain_ms, rate);
+#else
+    std::printf("%s,%s,%d,%d,%.2f,%ld,%.2f,%.1f\n", variant, IMPL_NAME, WAITERS, msgs,
+                spawn_ms, kb, drain_ms, rate);
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Coroutines suspended on an AsyncQueue
+// ---------------------------------------------------------------------
+static queue_coro::Detached coro_consumer(queue_coro::AsyncQueue<int> &q, long long &sum) {
+    long long s = 0;
+    for (int i = 0; i < PER; i++) s += co_await q.pop();
+    sum += s;
+}
+
+static queue_coro::Detached coro_producer(queue_coro::AsyncQueue<int> &q, int msgs) {
+    for (int i = 0; i < msgs; i++) co_await q.push(i);
+}
+
+static void run_coro() {
+    queue_coro::LoopExecutor ex;
+    queue_coro::AsyncQueue<int> q(CORO_CAP, ex);
+    long long sum = 0;
+
+    long kb0 = rss_kb();
+    auto t0 = Clock::now();
+    for (int i = 0; i < WAITERS; i++) coro_consumer(q, sum);
+    double spawn_ms = ms_since(t0);
+    long kb = rss_kb() - kb0;
+
+    t0 = Clock::now();
+    coro_producer(q, WAITERS * PER);
+    ex.run();
+    double drain_ms = ms_since(t0);
+
+    check_sum(sum);
+    report("coro", spawn_ms, kb, drain_ms);
+}
+
+// ---------------------------------------------------------------------
+// OS threads blocked on a condition-variable queue
+// ---------------------------------------------------------------------
+class CvQueue {
+public:
+    explicit CvQueue(size_t cap) : cap_(cap) {}
+
+    void push(int v) {
+        std::unique_lock<std::mutex> lk(mu_);
+        not_full_.wait(lk, [&] { return items_.size() < cap_; });
+        items_.push_back(v);
+        lk.unlock();
+        not_empty_.notify_one();
+    }
+
+    int pop() {
+        std::unique_lock<std::mutex> lk(mu_);
+        waiting_++;
+        not_empty_.wait(lk, [&] { return !items_.empty(); });
+        waiting_--;
+        int v = items_.front();
+        items_.pop_front();
+        lk.unlock();
+        not_full_.notify_one();
+        return v;
+    }
+
+    // Threads blocked in pop
+    int waiting() {
+        std::lock_guard<std::mutex> g(mu_);
+        return waiting_;
+    }
+
+private:
+    size_t cap_;
+    std::mutex mu_;
+    std::condition_variable not_empty_, not_full_;
+    std::deque<int> items_;
+    int waiting_ = 0;
+};
+
+static void run_threads() {
+    CvQueue q(CORO_CAP);
+    std::atomic<long long> sum(0);
+    std::vector<std::thread> threads;
+    threads.reserve(WAITERS);
+
+    long kb0 = rss_kb();
+    auto t0 = Clock::now();
+    try {
+        for (int i = 0; i < WAITERS; i++) {
+            threads.emplace_back([&] {
+                long long s = 0;
+                for (int k = 0; k < PER; k++) s += q.pop();
+                sum += s;
+            });
+        }
+    } catch (const std::system_error &e) {
+        // Out of threads: let the ones we have finish, report nothing
+        std::fprintf(stderr, "threads: only %zu of %d created (%s)\n", threads.size(), WAITERS,
+                     e.what());
+        for (size_t i = 0; i < threads.size() * PER; i++) q.push(0);
+        for (auto &t : threads) t.join();
+        return;
+    }
+    while (q.waiting() < WAITERS) std::this_thread::yield();
+    double spawn_ms = ms_since(t0);
+    long kb = rss_kb() - kb0;
+
+    t0 = Clock::now();
+    for (int i = 0; i < WAITERS * PER; i++) q.push(i);
+    for (auto &t : threads) t.join();
+    double drain_ms = ms_since(t0);
+
+    check_sum(sum.load());
+    report("threads", spawn_ms, kb, drain_ms);
+}
+
+int main() {
+    std::printf("# queue = %s, cap = %d\n", IMPL_NAME, CORO_CAP);
+    std::printf("variant,impl,waiters,msgs,spawn_ms,rss_kb,drain_ms,msgs_per_s\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_coro();
+#endif
+
+    run_coro();
+    run_threads();
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_coro();
+#endif
+    return 0;
+}
@@ -0,0 +1,251 @@
+#define _GNU_SOURCE   // for rand_r
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // for strncmp
+#include <omp.h>
+#include "queue.h"
+#include "deque.h"
+#include "utils.c"
+
+// Fork/join-style benchmark: sum over an implicit binary tree of N_TASKS
+// nodes where every task spawns its two children (node i has children
+// 2i+1 and 2i+2). Two worker pools run the same tasks:
+//   - "deque":  one Chase-Lev deque per worker; a worker pops its own
+//               newest task (LIFO) and only steals (FIFO) from a random
+//               victim when it runs dry
+//   - IMPL_NAME: every worker takes from and spawns into one shared Queue
+//               (the MODE's implementation, twolock by default)
+//
+//   make bench_forkjoin            # deque vs twolock
+//   make bench_forkjoin MODE=sharded
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// Tree depth: N_TASKS = 2^TREE_DEPTH - 1 tasks
+#ifndef TREE_DEPTH
+#define TREE_DEPTH 18
+#endif
+#define N_TASKS ((1 << TREE_DEPTH) - 1)
+
+// Busy work per task (LCG steps), so the pools are compared at a
+// realistic task size rather than on bare queue operations
+#ifndef TASK_WORK
+#define TASK_WORK 64
+#endif
+
+#ifndef N_TRIALS
+#define N_TRIALS 5
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+// Per-worker counters on their own cache line; only the owner writes them
+typedef struct {
+    _Alignas(64) long long done;   // tasks run (read by idle workers)
+    long long sum;
+    long long steals;
+} Worker;
+
+static long long task_value(int node) {
+    unsigned x = (unsigned)node;
+    for (int i = 0; i < TASK_WORK; i++) x = x * 1103515245u + 12345u;
+    return (long long)(x >> 24);
+}
+
+// Idle workers stop once every task of the tree has run
+static int all_done(Worker *w, int T) {
+    long long total = 0;
+    for (int i = 0; i < T; i++) {
+        long long d;
+        #pragma omp atomic read
+        d = w[i].done;
+        total += d;
+    }
+    return total == N_TASKS;
+}
+
+static long long reduce_sum(Worker *w, int T, long long *steals) {
+    long long sum = 0;
+    *steals = 0;
+    for (int i = 0; i < T; i++) {
+        sum += w[i].sum;
+        *steals += w[i].steals;
+    }
+    return sum;
+}
+
+// ---------------------------------------------------------------------
+// Work-stealing pool: one deque per worker
+// ---------------------------------------------------------------------
+static double run_once_deque(int T, long long *sum, long long *steals) {
+    Deque **ds = malloc(sizeof(Deque *) * (size_t)T);
+    Worker *w = aligned_alloc(64, sizeof(Worker) * (size_t)T);
+    if (!ds || !w) {
+        fprintf(stderr, "Failed to allocate workers\n");
+        exit(1);
+    }
+    for (int i = 0; i < T; i++) {
+        // Depth-first LIFO keeps a deque at about TREE_DEPTH tasks
+        ds[i] = deque_create(64);
+        if (!ds[i]) {
+            fprintf(stderr, "Failed to create deque\n");
+            exit(1);
+        }
+        w[i].done = w[i].sum = w[i].steals = 0;
+    }
+    deque_push(ds[0], 0);
+
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(T) shared(ds, w)
+    {
+        int id = omp_get_thread_num();
+        Deque *own = ds[id];
+        Worker *me = &w[id];
+        unsigned seed = (unsigned)id + 1;
+        long long done = 0;
+        int node;
+
+        while (1) {
+            bool got = deque_pop(own, &node);
+            if (!got && T > 1) {
+                int victim = (int)(rand_r(&seed) % (unsigned)(T - 1));
+                if (victim >= id) victim++;
+                got = deque_steal(ds[victim], &node);
+                if (got) me->steals++;
+            }
+            if (!got) {
+                if (all_done(w, T)) break;
+                continue;
+            }
+
+            // Fork: spawn the children, then run this task
+            if (2 * node + 1 < N_TASKS) deque_push(own, 2 * node + 1);
+            if (2 * node + 2 < N_TASKS) deque_push(own, 2 * node + 2);
+            me->sum += task_value(node);
+            done++;
+            #pragma omp atomic write
+            me->done = done;
+        }
+    }
+
+    double t1 = omp_get_wtime();
+
+    *sum = reduce_sum(w, T, steals);
+    for (int i = 0; i < T; i++) deque_destroy(ds[i]);
+    free(ds);
+    free(w);
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Shared-queue pool: every worker takes from and spawns into one Queue
+// ---------------------------------------------------------------------
+static double run_once_queue(int T, long long *sum) {
+    // Room for every task, so spawning never has to wait for space
+    Queue *q = create(N_TASKS);
+    Worker *w = aligned_alloc(64, sizeof(Worker) * (size_t)T);
+    if (!q || !w) {
+        fprintf(stderr, "Failed to create queue (cap=%d)\n", N_TASKS);
+        exit(1);
+    }
+    for (int i = 0; i < T; i++) w[i].done = w[i].sum = w[i].steals = 0;
+    enqueue(q, 0);
+
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(T) shared(q, w)
+    {
+        Worker *me = &w[omp_get_thread_num()];
+        long long done = 0;
+        int node;
+
+        while (1) {
+            if (!dequeue(q, &node)) {
+                if (all_done(w, T)) break;
+                continue;
+            }
+
+            if (2 * node + 1 < N_TASKS) {
+                while (!enqueue(q, 2 * node + 1)) { /* busy-wait */ }
+            }
+            if (2 * node + 2 < N_TASKS) {
+                while (!enqueue(q, 2 * node + 2)) { /* busy-wait */ }
+            }
+            me->sum += task_value(node);
+            done++;
+            #pragma omp atomic write
+            me->done = done;
+        }
+    }
+
+    double t1 = omp_get_wtime();
+
+    long long steals;
+    *sum = reduce_sum(w, T, &steals);
+    destroy(q);
+    free(w);
+    return t1 - t0;
+}
+
+int main(void) {
+    // The shared-queue pool needs a thread-safe queue
+    if (strncmp(IMPL_NAME, "seq", 3) == 0) {
+        fprintf(stderr, "fork/join benchmark needs a concurrent implementation\n");
+        return 1;
+    }
+
+    int workers[] = {1, 2, 4, 8};
+
+    long long expect = 0;
+    for (int i = 0; i < N_TASKS; i++) expect += task_value(i);
+
+    printf("pool,workers,tasks,trials,time_avg_s,throughput_tasks_per_s,steals_avg\n");
+    #ifdef USE_PRETTY_TABLE
+        print_header_forkjoin();
+    #endif
+
+    for (int i = 0; i < (int)(sizeof(workers)/sizeof(workers[0])); ++i) {
+        int T = workers[i];
+
+        for (int pool = 0; pool < 2; ++pool) {
+            const char *name = pool == 0 ? "deque" : IMPL_NAME;
+            double sum_t = 0.0;
+            double steals_sum = 0.0;
+
+            for (int t = 0; t < N_TRIALS; ++t) {
+                long long sum, steals = 0;
+                double sec = pool == 0 ? run_once_deque(T, &sum, &steals)
+                                       : run_once_queue(T, &sum);
+                if (sum != expect) {
+                    fprintf(stderr, "%s pool: wrong tree sum %lld (expected %lld)\n",
+                            name, sum, expect);
+                    return 1;
+                }
+                sum_t += sec;
+                steals_sum += (double)steals;
+            }
+
+            double avg = sum_t / (double)N_TRIALS;
+            double thr = (double)N_TASKS / avg;
+            double steals_avg = steals_sum / (double)N_TRIALS;
+
+            #ifdef USE_PRETTY_TABLE
+                print_row_forkjoin(name, T, N_TASKS, N_TRIALS, avg, thr, steals_avg);
+            #else
+                printf("%s,%d,%d,%d,%.6f,%.1f,%.1f\n",
+                       name, T, N_TASKS, N_TRIALS, avg, thr, steals_avg);
+            #endif
+        }
+    }
+
+    #ifdef USE_PRETTY_TABLE
+        print_footer_forkjoin();
+    #endif
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#define _GNU_SOURCE   // for syscall
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>   // for getrusage
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include "queue.h"
+#include "utils.c"
+
+// Large-queue memory benchmark: for capacities from 1M to MEM_MAX_CAP
+// ints, create a queue through create_ex with each set of QUEUE_MEM_*
+// options and measure
+//   - create time (pre-faulting moves page faults in here),
+//   - time of the first FIRST_OPS operations, which sweep through fresh
+//     pages of a malloc'd ring, and the minor page faults of create and
+//     those operations together,
+//   - steady-state throughput and dTLB misses once every page is mapped,
+//     with producer and consumer half a ring apart so both sweep the
+//     whole ring.
+// One thread does everything: the cost measured here is per page, not
+// per lock. dTLB misses need perf_event_open (perf_event_paranoid <= 2);
+// -1 when unavailable. Huge pages come from the reserved pool if there
+// is one (vm.nr_hugepages), else from transparent huge pages.
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// Largest capacity in ints (64M ints = 256 MB of ring); override with
+// make bench_mem CFLAGS_EXTRA=-DMEM_MAX_CAP=...
+#ifndef MEM_MAX_CAP
+#define MEM_MAX_CAP (64 << 20)
+#endif
+
+#define FIRST_OPS (1 << 20)
+#define STEADY_OPS (1 << 24)
+// Enqueues (and then dequeues) per burst
+#define BURST 1024
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+static const struct { const char *name; unsigned mem; } options[] = {
+    {"malloc", 0},
+    {"prefault", QUEUE_MEM_PREFAULT},
+    {"huge", QUEUE_MEM_HUGE},
+    {"huge+prefault", QUEUE_MEM_HUGE | QUEUE_MEM_PREFAULT},
+    {"huge+lock", QUEUE_MEM_HUGE | QUEUE_MEM_LOCK},
+};
+
+static long minor_faults(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_minflt;
+}
+
+// dTLB load misses of the calling thread, or -1 if perf is unavailable
+static int dtlb_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static long long dtlb_close(int fd) {
+    long long v = -1;
+    if (fd < 0) return -1;
+    if (read(fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) v = -1;
+    close(fd);
+    return v;
+}
+
+// ops operations (half enqueues, half dequeues) in bursts, keeping the
+// queue `depth` deep; returns false if the queue misbehaves
+static bool sweep(Queue *q, long long ops, int depth) {
+    int v;
+    for (long long done = 0; done < ops; done += 2 * BURST) {
+        for (int i = 0; i < BURST; i++) {
+            if (!enqueue(q, i)) return false;
+        }
+        while (size(q) > depth) {
+            if (!dequeue(q, &v)) return false;
+        }
+    }
+    return true;
+}
+
+// String of the QUEUE_MEM_* flags in mem ("-" for none)
+static const char *mem_flags(unsigned mem, char *buf, size_t len) {
+    snprintf(buf, len, "%s%s%s%s",
+             mem & QUEUE_MEM_HUGE ? "H" : "", mem & QUEUE_MEM_PREFAULT ? "P" : "",
+             mem & QUEUE_MEM_LOCK ? "L" : "", mem & QUEUE_MEM_NODE ? "N" : "");
+    if (!buf[0]) snprintf(buf, len, "-");
+    return buf;
+}
+
+int main(void) {
+    printf("impl,cap,options,got,create_ms,first_ms,faults,"
+           "steady_ops_per_s,dtlb_misses_per_kop\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_mem();
+#endif
+
+    for (int cap = 1 << 20; cap <= MEM_MAX_CAP; cap *= 4) {
+        for (size_t k = 0; k < sizeof(options) / sizeof(options[0]); k++) {
+            QueueOptions o = {0};
+            o.mem = options[k].mem;
+
+            long f0 = minor_faults();
+            double t0 = omp_get_wtime();
+            Queue *q = create_ex(cap, &o);
+            double t1 = omp_get_wtime();
+            if (!q) {
+                fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
+                return 1;
+            }
+
+            // First operations: a burst-deep queue walking into fresh pages
+            bool ok = sweep(q, FIRST_OPS, BURST);
+            double t2 = omp_get_wtime();
+            long faults = minor_faults() - f0;
+
+            // Finish the first pass over the ring, then measure with
+            // producer and consumer half a ring apart
+            ok = ok && sweep(q, 2LL * cap, cap / 2);
+            int fd = dtlb_open();
+            double t3 = omp_get_wtime();
+            ok = ok && sweep(q, STEADY_OPS, cap / 2);
+            double t4 = omp_get_wtime();
+            long long misses = dtlb_close(fd);
+            if (!ok) {
+                fprintf(stderr, "queue misbehaved (cap=%d, %s)\n", cap, options[k].name);
+                return 1;
+            }
+
+            char got[8];
+            mem_flags(queue_mem(q), got, sizeof(got));
+            double create_ms = (t1 - t0) * 1e3, first_ms = (t2 - t1) * 1e3;
+            double steady = STEADY_OPS / (t4 - t3);
+            double per_kop = misses < 0 ? -1.0 : misses * 1000.0 / STEADY_OPS;
+#ifdef USE_PRETTY_TABLE
+            print_row_mem(IMPL_NAME, cap, options[k].name, got, create_ms, first_ms,
+                          faults, steady, per_kop);
+#else
+            printf("%s,%d,%s,%s,%.3f,%.3f,%ld,%.1f,%.3f\n", IMPL_NAME, cap, options[k].name,
+                   got, create_ms, first_ms, faults, steady, per_kop);
+#endif
+            destroy(q);
+        }
+    }
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_mem();
+#endif
+    return 0;
+}
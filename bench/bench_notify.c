@@ -0,0 +1,165 @@
+#define _GNU_SOURCE   // for usleep
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // for strncmp
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <omp.h>
+#include "queue.h"
+#include "utils.c"
+
+// Wake-up latency benchmark: one producer sends N_MSGS values spaced
+// GAP_US apart (sporadic traffic, the consumer is idle in between); the
+// consumer waits for them in one of three ways:
+//   - spin:  dequeue() in a tight loop (lowest latency, burns a core)
+//   - poll:  dequeue(), sleep POLL_US when empty (cheap, adds latency)
+//   - epoll: epoll_wait on queue_get_fd(), drain with dequeue_or_arm
+// Latency is from just before enqueue to just after dequeue; consumer
+// CPU time shows what each strategy costs while idle.
+//
+//   make bench_notify [MODE=...]
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+#ifndef N_MSGS
+#define N_MSGS 2000
+#endif
+
+#ifndef GAP_US
+#define GAP_US 50
+#endif
+
+#ifndef POLL_US
+#define POLL_US 100
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+enum { WAIT_SPIN, WAIT_POLL, WAIT_EPOLL };
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double thread_cpu_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+// One run; fills lat_ns[0..N_MSGS-1] and returns the consumer's CPU time
+static double run_once_notify(int wait, long long *lat_ns) {
+    Queue *q = create(64);
+    long long *sent_ns = malloc(sizeof(long long) * N_MSGS);
+    if (!q || !sent_ns) {
+        fprintf(stderr, "Failed to create queue (cap=64)\n");
+        exit(1);
+    }
+
+    int ep = -1, qfd = -1;
+    if (wait == WAIT_EPOLL) {
+        qfd = queue_get_fd(q);
+        ep = epoll_create1(0);
+        struct epoll_event ev = { .events = EPOLLIN };
+        ev.data.fd = qfd;
+        if (qfd < 0 || ep < 0 || epoll_ctl(ep, EPOLL_CTL_ADD, qfd, &ev) != 0) {
+            fprintf(stderr, "eventfd/epoll unavailable\n");
+            exit(1);
+        }
+    }
+
+    double cpu = 0.0;
+
+    #pragma omp parallel num_threads(2) shared(q, sent_ns, lat_ns, cpu)
+    {
+        if (omp_get_thread_num() == 0) {
+            for (int i = 0; i < N_MSGS; i++) {
+                usleep(GAP_US);
+                sent_ns[i] = now_ns();
+                while (!enqueue(q, i)) { /* busy-wait */ }
+            }
+        } else {
+            double c0 = thread_cpu_s();
+            int got = 0, v;
+            while (got < N_MSGS) {
+                bool ok;
+                if (wait == WAIT_EPOLL) {
+                    ok = dequeue_or_arm(q, &v);
+                    if (!ok) {
+                        struct epoll_event ev;
+                        epoll_wait(ep, &ev, 1, -1);
+                        continue;
+                    }
+                } else {
+                    ok = dequeue(q, &v);
+                    if (!ok) {
+                        if (wait == WAIT_POLL) usleep(POLL_US);
+                        continue;
+                    }
+                }
+                lat_ns[v] = now_ns() - sent_ns[v];
+                got++;
+            }
+            cpu = thread_cpu_s() - c0;
+        }
+    }
+
+    if (ep >= 0) close(ep);
+    free(sent_ns);
+    destroy(q);
+    return cpu;
+}
+
+int main(void) {
+    // The producer and consumer need a thread-safe queue
+    if (strncmp(IMPL_NAME, "seq", 3) == 0) {
+        fprintf(stderr, "notification benchmark needs a concurrent implementation\n");
+        return 1;
+    }
+
+    const char *waits[] = {"spin", "poll", "epoll"};
+    long long *lat = malloc(sizeof(long long) * N_MSGS);
+    if (!lat) return 1;
+
+    printf("impl,wait,msgs,gap_us,lat_avg_us,lat_p50_us,lat_p99_us,consumer_cpu_s\n");
+    #ifdef USE_PRETTY_TABLE
+        print_header_notify();
+    #endif
+
+    for (int w = 0; w < 3; ++w) {
+        double cpu = run_once_notify(w, lat);
+
+        double sum = 0.0;
+        for (int i = 0; i < N_MSGS; i++) sum += (double)lat[i];
+        qsort(lat, N_MSGS, sizeof(long long), cmp_ll);
+        double avg_us = sum / N_MSGS / 1e3;
+        double p50_us = (double)lat[N_MSGS / 2] / 1e3;
+        double p99_us = (double)lat[(N_MSGS * 99) / 100] / 1e3;
+
+        #ifdef USE_PRETTY_TABLE
+            print_row_notify(IMPL_NAME, waits[w], N_MSGS, GAP_US, avg_us, p50_us, p99_us, cpu);
+        #else
+            printf("%s,%s,%d,%d,%.2f,%.2f,%.2f,%.4f\n",
+                   IMPL_NAME, waits[w], N_MSGS, GAP_US, avg_us, p50_us, p99_us, cpu);
+        #endif
+    }
+
+    #ifdef USE_PRETTY_TABLE
+        print_footer_notify();
+    #endif
+
+    free(lat);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <omp.h>
+#include "pq.h"
+#include "utils.c"
+
+// Priority queue benchmark (make bench MODE=pq), strict vs relaxed at
+// 1-16 threads:
+//   - throughput: the queue starts with PREFILL random keys and every
+//     thread alternates pq_push (random key) and pq_pop_min
+//   - rank error: RANK_KEYS distinct keys are popped until empty by all
+//     threads; each pop takes a ticket from a shared counter right after
+//     it returns, and replaying the pops in ticket order gives each one's
+//     rank (how many smaller keys were still queued). 0 = exact; with
+//     more than one thread the strict queue can show ~1 because a thread
+//     may be preempted between its pop and its ticket.
+
+#ifndef N_TRIALS
+#define N_TRIALS 5
+#endif
+
+#ifndef PREFILL
+#define PREFILL (1 << 14)
+#endif
+
+// push + pop pairs per thread
+#ifndef OPS_PER_THREAD
+#define OPS_PER_THREAD 100000
+#endif
+
+#ifndef RANK_KEYS
+#define RANK_KEYS (1 << 16)
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+static PQueue *make_pq(int relaxed, int cap) {
+    PQueue *q = relaxed ? pq_create_relaxed(cap, 0) : pq_create(cap);
+    if (!q) {
+        fprintf(stderr, "Failed to create priority queue (cap=%d)\n", cap);
+        exit(1);
+    }
+    return q;
+}
+
+static inline uint32_t lcg_next(uint32_t *s) {
+    *s = *s * 1103515245u + 12345u;
+    return *s >> 1;
+}
+
+// ---------------------------------------------------------------------
+// Throughput: alternating push / pop_min around a steady size
+// ---------------------------------------------------------------------
+static double run_once_throughput(int relaxed, int T) {
+    PQueue *q = make_pq(relaxed, PREFILL + 2 * T + 64);
+    uint32_t s = 12345;
+    for (int i = 0; i < PREFILL; i++) pq_push(q, lcg_next(&s), i);
+
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(T) shared(q)
+    {
+        uint32_t seed = 1u + (uint32_t)omp_get_thread_num();
+        int v;
+        for (int i = 0; i < OPS_PER_THREAD; i++) {
+            while (!pq_push(q, lcg_next(&seed), i)) { /* busy-wait */ }
+            while (!pq_pop_min(q, NULL, &v)) { /* busy-wait */ }
+        }
+    }
+
+    double t1 = omp_get_wtime();
+    pq_destroy(q);
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Rank error: concurrent drain, replayed in ticket order
+// ---------------------------------------------------------------------
+
+// Fenwick tree over keys 0..n-1 counting the keys still queued
+static void bit_add(int *bit, int n, int i, int d) {
+    for (i++; i <= n; i += i & -i) bit[i - 1] += d;
+}
+
+static int bit_prefix(const int *bit, int i) {   // keys 0..i-1
+    int s = 0;
+    for (; i > 0; i -= i & -i) s += bit[i - 1];
+    return s;
+}
+
+static void run_once_rank(int relaxed, int T, double *avg, int *max) {
+    int n = RANK_KEYS;
+    PQueue *q = make_pq(relaxed, n);
+    int *order = malloc(sizeof(int) * (size_t)n);   // key popped with ticket i
+    int *bit = calloc((size_t)n, sizeof(int));
+    if (!order || !bit) {
+        fprintf(stderr, "Failed to allocate rank buffers\n");
+        exit(1);
+    }
+
+    // Distinct keys 0..n-1 pushed in a scrambled order (odd stride mod 2^k)
+    for (int i = 0; i < n; i++) {
+        int key = (int)(((unsigned)i * 40503u) % (unsigned)n);
+        pq_push(q, key, key);
+    }
+
+    int ticket = 0;
+    #pragma omp parallel num_threads(T) shared(q, order, ticket)
+    {
+        int key, t;
+        while (pq_pop_min(q, NULL, &key)) {
+            #pragma omp atomic capture
+            t = ticket++;
+            order[t] = key;
+        }
+    }
+
+    // Replay: rank = queued keys smaller than the popped one
+    for (int k = 0; k < n; k++) bit_add(bit, n, k, 1);
+    long long sum = 0;
+    int worst = 0;
+    for (int i = 0; i < n; i++) {
+        int rank = bit_prefix(bit, order[i]);
+        sum += rank;
+        if (rank > worst) worst = rank;
+        bit_add(bit, n, order[i], -1);
+    }
+    *avg = (double)sum / (double)n;
+    *max = worst;
+
+    free(order);
+    free(bit);
+    pq_destroy(q);
+}
+
+int main(void) {
+    int threads[] = {1, 2, 4, 8, 16};
+    const char *impls[] = {"strict", "relaxed"};
+
+    printf("impl,threads,ops,trials,time_avg_s,throughput_ops_per_s,"
+           "rank_err_avg,rank_err_max\n");
+    #ifdef USE_PRETTY_TABLE
+        print_header_pq();
+    #endif
+
+    for (int relaxed = 0; relaxed < 2; ++relaxed) {
+        for (int i = 0; i < (int)(sizeof(threads)/sizeof(threads[0])); ++i) {
+            int T = threads[i];
+            double sum = 0.0;
+            double rank_sum = 0.0;
+            int rank_max = 0;
+
+            for (int t = 0; t < N_TRIALS; ++t) {
+                double ravg;
+                int rmax;
+                sum += run_once_throughput(relaxed, T);
+                run_once_rank(relaxed, T, &ravg, &rmax);
+                rank_sum += ravg;
+                if (rmax > rank_max) rank_max = rmax;
+            }
+
+            double avg = sum / (double)N_TRIALS;
+            int ops = 2 * T * OPS_PER_THREAD;
+            double throughput_avg = (double)ops / avg;
+            double rank_avg = rank_sum / (double)N_TRIALS;
+
+            #ifdef USE_PRETTY_TABLE
+                print_row_pq(impls[relaxed], T, ops, N_TRIALS, avg, throughput_avg,
+                             rank_avg, rank_max);
+            #else
+                printf("%s,%d,%d,%d,%.6f,%.1f,%.3f,%d\n",
+                       impls[relaxed], T, ops, N_TRIALS, avg, throughput_avg,
+                       rank_avg, rank_max);
+            #endif
+        }
+    }
+
+    #ifdef USE_PRETTY_TABLE
+        print_footer_pq();
+    #endif
+
+    return 0;
+}
@@ -1,10 +1,26 @@
+#define _GNU_SOURCE   // for syscall, sched_setaffinity
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>   // for strcmp
+#include <math.h>     // for isfinite
+#include <time.h>
+#include <getopt.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>   // for getrusage
+#include <sys/utsname.h>
 #include <omp.h>
 #include "queue.h"
 #include "utils.c"
 
+#ifdef BENCH_PERF
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
 // Allow the implementation name to be injected at compile time.
 // Example:
 //   gcc -O2 -fopenmp -DIMPL_NAME=\"twolock\" -o bench_queue bench_queue.c queue.c
@@ -12,20 +28,390 @@
 #define IMPL_NAME "default"
 #endif
 
-// How many times to repeat each (cap, P, C, items) configuration
+// Built with -DBENCH_POW2 (make POW2=1), every queue comes from create_pow2
+#ifdef BENCH_POW2
+#define bench_create_default create_pow2
+#define bench_create_sized create_sized_pow2
+#else
+#define bench_create_default create
+#define bench_create_sized create_sized
+#endif
+
+// --node N: int queues come from create_on_node(cap, N) (N = -1: the
+// node of the thread creating them)
+static bool g_on_node = false;
+static int g_node = -1;
+
+static Queue *bench_create(int cap) {
+    return g_on_node ? create_on_node(cap, g_node) : bench_create_default(cap);
+}
+
+// Default number of timed runs per configuration (--trials)
 #ifndef N_TRIALS
 #define N_TRIALS 5
 #endif
 
-#ifndef CSV_ONLY
-#define USE_PRETTY_TABLE 1
+// Compiler flags recorded in the output metadata (set by the Makefile)
+#ifndef BENCH_CFLAGS
+#define BENCH_CFLAGS "unknown"
+#endif
+
+// --pin: thread i of every parallel region runs on CPU i mod #CPUs
+static bool g_pin = false;
+
+// --layout: where producer i runs relative to consumer i. Producer tid
+// runs on g_prod_cpus[tid mod n], consumer j on g_cons_cpus[j mod n].
+// Only CPUs the process may run on count, so e.g.
+//   numactl --physcpubind=0,1 ./bin/bench_twolock --layout cross-socket
+// picks the CPUs a layout draws from on a machine with fewer sockets.
+typedef enum { LAYOUT_NONE, LAYOUT_SAME_CORE, LAYOUT_SAME_SOCKET, LAYOUT_CROSS_SOCKET } Layout;
+static Layout g_layout = LAYOUT_NONE;
+static int g_prod_cpus[CPU_SETSIZE], g_cons_cpus[CPU_SETSIZE];
+static int g_n_prod_cpus = 0, g_n_cons_cpus = 0;
+static char g_layout_desc[160] = "none";   // recorded in the output metadata
+
+static void bench_pin(int tid, int P) {
+    int cpu;
+    if (g_layout != LAYOUT_NONE) {
+        cpu = tid < P ? g_prod_cpus[tid % g_n_prod_cpus] : g_cons_cpus[(tid - P) % g_n_cons_cpus];
+    } else if (g_pin) {
+        cpu = tid % omp_get_num_procs();
+    } else {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    // pid 0 = the calling thread
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Read a sysfs CPU list such as "0-3,8-11" into *set
+static bool read_cpulist(const char *path, cpu_set_t *set) {
+    CPU_ZERO(set);
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    int lo, hi;
+    char sep;
+    while (fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        int got = fscanf(f, "%c", &sep);
+        if (got == 1 && sep == '-') {
+            if (fscanf(f, "%d", &hi) != 1) break;
+            got = fscanf(f, "%c", &sep);
+        }
+        for (int c = lo; c <= hi && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+        if (got != 1 || sep != ',') break;
+    }
+    fclose(f);
+    return true;
+}
+
+// Allowed CPUs of each NUMA node that has any, most CPUs first; without
+// NUMA information all allowed CPUs form one node. Returns the node count.
+static int layout_nodes(const cpu_set_t *allowed, cpu_set_t *nodes, int max) {
+    int n = 0;
+    for (int node = 0; node < 1024 && n < max; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        cpu_set_t cpus;
+        if (!read_cpulist(path, &cpus)) continue;
+        CPU_AND(&cpus, &cpus, allowed);
+        if (CPU_COUNT(&cpus) > 0) nodes[n++] = cpus;
+    }
+    if (n == 0) nodes[n++] = *allowed;
+    // Insertion sort by CPU count, descending
+    for (int i = 1; i < n; i++) {
+        cpu_set_t t = nodes[i];
+        int j = i;
+        for (; j > 0 && CPU_COUNT(&nodes[j - 1]) < CPU_COUNT(&t); j--) nodes[j] = nodes[j - 1];
+        nodes[j] = t;
+    }
+    return n;
+}
+
+// An allowed SMT sibling of cpu not in *used, or -1
+static int layout_sibling(int cpu, const cpu_set_t *allowed, const cpu_set_t *used) {
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    cpu_set_t sib;
+    if (!read_cpulist(path, &sib)) return -1;
+    for (int s = 0; s < CPU_SETSIZE; s++) {
+        if (s != cpu && CPU_ISSET(s, &sib) && CPU_ISSET(s, allowed) && !CPU_ISSET(s, used)) return s;
+    }
+    return -1;
+}
+
+// Fill the --layout CPU lists. A layout the allowed CPUs cannot give for
+// real (no SMT, one CPU, one node) is approximated and marked "emulated".
+static bool layout_init(void) {
+    cpu_set_t allowed, used;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+    CPU_ZERO(&used);
+    static cpu_set_t nodes[64];
+    int n_nodes = layout_nodes(&allowed, nodes, 64);
+    bool emulated = false;
+    const char *name = "";
+
+    switch (g_layout) {
+    case LAYOUT_SAME_CORE:
+        // Producer i and consumer i on two hardware threads of one core
+        name = "same-core";
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (!CPU_ISSET(c, &allowed) || CPU_ISSET(c, &used)) continue;
+            int mate = layout_sibling(c, &allowed, &used);
+            //Edge case: no SMT: share the one hardware thread
+            if (mate < 0) {
+                mate = c;
+                emulated = true;
+            }
+            CPU_SET(c, &used);
+            CPU_SET(mate, &used);
+            g_prod_cpus[g_n_prod_cpus++] = c;
+            g_cons_cpus[g_n_cons_cpus++] = mate;
+        }
+        break;
+    case LAYOUT_SAME_SOCKET: {
+        // Different cores of the node with the most CPUs, one hardware
+        // thread per core, producers and consumers alternating
+        name = "same-socket";
+        int k = 0;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (!CPU_ISSET(c, &nodes[0]) || CPU_ISSET(c, &used)) continue;
+            int mate;
+            while ((mate = layout_sibling(c, &nodes[0], &used)) >= 0) CPU_SET(mate, &used);
+            CPU_SET(c, &used);
+            if (k++ % 2 == 0) g_prod_cpus[g_n_prod_cpus++] = c;
+            else g_cons_cpus[g_n_cons_cpus++] = c;
+        }
+        break;
+    }
+    case LAYOUT_CROSS_SOCKET: {
+        // Producers on one node, consumers on another
+        name = "cross-socket";
+        if (n_nodes >= 2) {
+            for (int c = 0; c < CPU_SETSIZE; c++) {
+                if (CPU_ISSET(c, &nodes[0])) g_prod_cpus[g_n_prod_cpus++] = c;
+                if (CPU_ISSET(c, &nodes[1])) g_cons_cpus[g_n_cons_cpus++] = c;
+            }
+            break;
+        }
+        //Edge case: one node: the lower half of the CPUs stands in for
+        //one socket, the upper half for the other
+        emulated = true;
+        int half = (CPU_COUNT(&allowed) + 1) / 2, k = 0;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (!CPU_ISSET(c, &allowed)) continue;
+            if (k++ < half) g_prod_cpus[g_n_prod_cpus++] = c;
+            else g_cons_cpus[g_n_cons_cpus++] = c;
+        }
+        break;
+    }
+    default:
+        return true;
+    }
+
+    //Edge case: a single usable CPU serves both sides
+    if (g_n_cons_cpus == 0) {
+        g_cons_cpus[g_n_cons_cpus++] = g_prod_cpus[0];
+        emulated = true;
+    }
+    snprintf(g_layout_desc, sizeof(g_layout_desc), "%s, producers on %d CPU(s) from %d, consumers on %d from %d%s",
+             name, g_n_prod_cpus, g_prod_cpus[0], g_n_cons_cpus, g_cons_cpus[0],
+             emulated ? " (emulated)" : "");
+    return g_n_prod_cpus > 0;
+}
+
+// ---------------------------------------------------------------------
+// Output: a pretty table (default), CSV (--format csv, or built with
+// -DCSV_ONLY) or one JSON document (--format json). Every sweep is a
+// "section": its rows are written once as a CSV line, which the JSON
+// writer zips with the section's column names.
+// ---------------------------------------------------------------------
+typedef enum { OUT_TABLE, OUT_CSV, OUT_JSON } OutFormat;
+
+#ifdef CSV_ONLY
+static OutFormat out_fmt = OUT_CSV;
+#else
+static OutFormat out_fmt = OUT_TABLE;
+#endif
+
+static int out_sections = 0;          // sections started so far
+static int out_rows = 0;              // rows in the current section
+static const char *out_cols = NULL;   // column names of the current section
+static bool out_csv_fallback = false; // table mode, section has no table
+
+// True if the current section should go through the print_* table helpers
+static bool out_table(void) {
+    return out_fmt == OUT_TABLE && !out_csv_fallback;
+}
+
+static void json_string(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') printf("\\%c", *s);
+        else if ((unsigned char)*s < 0x20) printf("\\u%04x", *s);
+        else putchar(*s);
+    }
+    putchar('"');
+}
+
+// First line of /proc/cpuinfo naming the CPU, or "unknown"
+static void cpu_model(char *buf, size_t len) {
+    snprintf(buf, len, "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "model name", 10) == 0 || strncmp(line, "Model", 5) == 0) {
+            char *v = strchr(line, ':');
+            if (!v) continue;
+            for (v++; *v == ' ' || *v == '\t'; v++) {}
+            v[strcspn(v, "\n")] = '\0';
+            snprintf(buf, len, "%s", v);
+            break;
+        }
+    }
+    fclose(f);
+}
+
+// Machine metadata: "# key: value" lines for table/CSV, the "meta" object
+// for JSON (which also opens the document)
+static void out_open(int argc, char **argv) {
+    char cpu[128], date[32], args[512] = "", kernel[256] = "unknown";
+    cpu_model(cpu, sizeof(cpu));
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    struct utsname un;
+    if (uname(&un) == 0) {
+        snprintf(kernel, sizeof(kernel), "%s %s %s", un.sysname, un.release, un.machine);
+    }
+    for (int i = 1; i < argc; i++) {
+        size_t used = strlen(args);
+        snprintf(args + used, sizeof(args) - used, "%s%s", i > 1 ? " " : "", argv[i]);
+    }
+    char cores[16], node[16] = "none";
+    snprintf(cores, sizeof(cores), "%d", omp_get_num_procs());
+    if (g_on_node) snprintf(node, sizeof(node), "%d", g_node);
+
+    const char *keys[] = {"impl", "date", "cpu", "cores", "kernel", "compiler", "cflags", "args",
+                          "layout", "node"};
+    const char *vals[] = {IMPL_NAME, date, cpu, cores, kernel, __VERSION__, BENCH_CFLAGS, args,
+                          g_layout_desc, node};
+    int n = (int)(sizeof(keys)/sizeof(keys[0]));
+
+    if (out_fmt == OUT_JSON) {
+        printf("{\n  \"meta\": {");
+        for (int i = 0; i < n; i++) {
+            printf("%s\n    \"%s\": ", i ? "," : "", keys[i]);
+            if (strcmp(keys[i], "cores") == 0) printf("%s", vals[i]);
+            else json_string(vals[i]);
+        }
+        printf("\n  },\n  \"sections\": {");
+    } else {
+        for (int i = 0; i < n; i++) printf("# %s: %s\n", keys[i], vals[i]);
+    }
+}
+
+static void out_close(void) {
+    if (out_fmt == OUT_JSON) printf("\n  }\n}\n");
+}
+
+// Start a section; has_table says whether the caller has print_* helpers
+// for it (sections without one are written as CSV in table mode)
+static void out_begin(const char *section, const char *cols, bool has_table) {
+    out_cols = cols;
+    out_rows = 0;
+    out_csv_fallback = out_fmt == OUT_TABLE && !has_table;
+    if (out_fmt == OUT_JSON) {
+        printf("%s\n    \"%s\": [", out_sections ? "," : "", section);
+    } else {
+        printf("\n# section: %s\n", section);
+        if (!out_table()) printf("%s\n", cols);
+    }
+    out_sections++;
+}
+
+static void out_end(void) {
+    if (out_fmt == OUT_JSON) printf("%s]", out_rows ? "\n    " : "");
+}
+
+// One row, given as a CSV line in the section's column order
+static void out_row(const char *fmt, ...) {
+    char line[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    if (out_fmt != OUT_JSON) {
+        printf("%s\n", line);
+        out_rows++;
+        return;
+    }
+
+    printf("%s\n      {", out_rows ? "," : "");
+    const char *col = out_cols, *val = line;
+    for (int i = 0; *col; i++) {
+        size_t cl = strcspn(col, ","), vl = strcspn(val, ",");
+        char v[128];
+        snprintf(v, sizeof(v), "%.*s", (int)vl, val);
+        printf("%s\"%.*s\": ", i ? ", " : "", (int)cl, col);
+
+        // Numbers as numbers (null if not finite), anything else as a string
+        char *end;
+        double d = strtod(v, &end);
+        if (*v && *end == '\0') {
+            if (isfinite(d)) printf("%s", v);
+            else printf("null");
+        } else {
+            json_string(v);
+        }
+
+        col += cl + (col[cl] == ',');
+        val += vl + (val[vl] == ',');
+    }
+    printf("}");
+    out_rows++;
+}
+
+// ---------------------------------------------------------------------
+// Queue statistics (STATS=1): the throughput runs free their queue with
+// bench_destroy, which keeps its counters in g_stats; they are reported
+// per configuration, averaged over the trials, in a "stats" section
+// ---------------------------------------------------------------------
+#ifdef QUEUE_STATS
+static QueueStats g_stats;
+
+typedef struct {
+    QueueStats sum;   // counters summed over the recorded trials
+    int items;        // as reported in the throughput section
+    bool used;
+} StatsRow;
+
+static void stats_accumulate(QueueStats *into, const QueueStats *s) {
+    into->enqueued += s->enqueued;
+    into->dequeued += s->dequeued;
+    into->full += s->full;
+    into->empty += s->empty;
+    into->contended += s->contended;
+    if (s->high_water > into->high_water) into->high_water = s->high_water;
+    into->wait_s += s->wait_s;
+}
+#endif
+
+static void bench_destroy(Queue *q) {
+#ifdef QUEUE_STATS
+    queue_get_stats(q, &g_stats);
 #endif
+    destroy(q);
+}
 
 // ---------------------------------------------------------------------
 // Concurrent benchmark: multiple producers + consumers, OpenMP parallel
 // ---------------------------------------------------------------------
 static double run_once_concurrent(int cap, int P, int C, int items) {
-    Queue *q = create(cap);
+    Queue *q = bench_create(cap);
     int total = P * items;
     int consumed = 0;
 
@@ -34,6 +420,7 @@ static double run_once_concurrent(int cap, int P, int C, int items) {
     #pragma omp parallel num_threads(P + C) shared(q, consumed)
     {
         int tid = omp_get_thread_num();
+        bench_pin(tid, P);
         if (tid < P) {
             // producers: thread 0 .. P-1
             for (int i = 0; i < items; i++) {
@@ -60,7 +447,7 @@ static double run_once_concurrent(int cap, int P, int C, int items) {
     }
 
     double t1 = omp_get_wtime();
-    destroy(q);
+    bench_destroy(q);
     return t1 - t0;
 }
 
@@ -68,7 +455,7 @@ static double run_once_concurrent(int cap, int P, int C, int items) {
 // Sequential benchmark: no P/C, just enqueue all then dequeue all
 // ---------------------------------------------------------------------
 static double run_once_seq(int cap, int items) {
-    Queue *q = create(cap);
+    Queue *q = bench_create(cap);
 
     if (!q) {
         fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
@@ -92,105 +479,1189 @@ static double run_once_seq(int cap, int items) {
     }
 
     double t1 = omp_get_wtime();
+    bench_destroy(q);
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Duration mode (--duration): like run_once_concurrent / run_once_seq,
+// but producers keep going until `seconds` have passed instead of
+// stopping after a fixed item count. *moved gets the number of values
+// that went through the queue.
+// ---------------------------------------------------------------------
+static double run_once_concurrent_duration(int cap, int P, int C, double seconds,
+                                           long long *moved) {
+    Queue *q = bench_create(cap);
+    int producing = P;
+    long long total = 0;
+
+    double t0 = omp_get_wtime();
+    double t_end = t0 + seconds;
+
+    #pragma omp parallel num_threads(P + C) shared(q, producing, total)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        if (tid < P) {
+            // producers: check the clock every 64 attempts
+            for (long long i = 0; ; i++) {
+                if ((i & 63) == 0 && omp_get_wtime() >= t_end) break;
+                enqueue(q, (int)i);
+            }
+            #pragma omp atomic
+            producing--;
+        } else {
+            // consumers: run until the producers stopped and the queue is empty
+            long long n = 0;
+            int v;
+            while (1) {
+                if (dequeue(q, &v)) {
+                    n++;
+                    continue;
+                }
+                int p;
+                #pragma omp atomic read
+                p = producing;
+                if (p == 0) {
+                    while (dequeue(q, &v)) n++;
+                    break;
+                }
+            }
+            #pragma omp atomic
+            total += n;
+        }
+    }
+
+    double t1 = omp_get_wtime();
+    bench_destroy(q);
+    *moved = total;
+    return t1 - t0;
+}
+
+static double run_once_seq_duration(int cap, double seconds, long long *moved) {
+    Queue *q = bench_create(cap);
+
+    if (!q) {
+        fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
+        exit(1);
+    }
+
+    double t0 = omp_get_wtime();
+    double t_end = t0 + seconds;
+    long long n = 0;
+    int v;
+
+    while (1) {
+        if ((n & 63) == 0 && omp_get_wtime() >= t_end) break;
+        enqueue(q, (int)n);
+        dequeue(q, &v);
+        n++;
+    }
+
+    double t1 = omp_get_wtime();
+    bench_destroy(q);
+    *moved = n;
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Batched concurrent benchmark: same as run_once_concurrent, but items
+// move through enqueue_bulk/dequeue_bulk in batches of `batch`
+// ---------------------------------------------------------------------
+static double run_once_bulk_concurrent(int cap, int P, int C, int items, int batch) {
+    Queue *q = bench_create(cap);
+    int total = P * items;
+    int consumed = 0;
+
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        int *buf = (int *)malloc(sizeof(int) * (size_t)batch);
+        if (tid < P) {
+            // producers: thread 0 .. P-1
+            for (int i = 0; i < items; i += batch) {
+                int n = (items - i < batch) ? items - i : batch;
+                for (int j = 0; j < n; j++) buf[j] = i + j;
+                // busy-wait until the whole batch is in
+                int done = 0;
+                while (done < n) {
+                    done += enqueue_bulk(q, buf + done, n - done);
+                }
+            }
+        } else {
+            // consumers: thread P .. P+C-1
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed;
+                if (c >= total) break;
+
+                int k = dequeue_bulk(q, buf, batch);
+                if (k > 0) {
+                    #pragma omp atomic
+                    consumed += k;
+                }
+            }
+        }
+        free(buf);
+    }
+
+    double t1 = omp_get_wtime();
+    destroy(q);
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Batched sequential benchmark: enqueue a batch, then dequeue it
+// ---------------------------------------------------------------------
+static double run_once_bulk_seq(int cap, int items, int batch) {
+    Queue *q = bench_create(cap);
+
+    if (!q) {
+        fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
+        exit(1);
+    }
+
+    int *buf = (int *)malloc(sizeof(int) * (size_t)batch);
+    double t0 = omp_get_wtime();
+
+    for (int i = 0; i < items; i += batch) {
+        int n = (items - i < batch) ? items - i : batch;
+        for (int j = 0; j < n; j++) buf[j] = i + j;
+        // batch <= cap, so both calls move the whole batch at once
+        enqueue_bulk(q, buf, n);
+        dequeue_bulk(q, buf, n);
+    }
+
+    double t1 = omp_get_wtime();
+    free(buf);
+    destroy(q);
+    return t1 - t0;
+}
+
+// ---------------------------------------------------------------------
+// Payload-size benchmark: same as run_once_concurrent, but the queue holds
+// esize-byte elements. Producers build each element (first int = item
+// number, rest filled) and consumers read its tag, either through a local
+// buffer with enqueue_elem/dequeue_elem (use_zc = 0) or in place in the
+// ring with enqueue_reserve/commit and dequeue_peek/release (use_zc = 1).
+// ---------------------------------------------------------------------
+static double run_once_sized_concurrent(int cap, size_t esize, int P, int C, int items,
+                                        int use_zc) {
+    Queue *q = bench_create_sized(cap, esize);
+    int total = P * items;
+    int consumed = 0;
+    size_t tag = esize < sizeof(int) ? esize : sizeof(int);
+
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        unsigned char *elem = (unsigned char *)malloc(esize);
+        int n;
+        if (tid < P) {
+            // producers: thread 0 .. P-1
+            for (int i = 0; i < items; i++) {
+                if (use_zc) {
+                    unsigned char *slot;
+                    while (!(slot = (unsigned char *)enqueue_reserve(q, 1, &n))) {
+                        // spin
+                    }
+                    memset(slot, i & 0xff, esize);
+                    memcpy(slot, &i, tag);
+                    enqueue_commit(q, slot, 1);
+                } else {
+                    memset(elem, i & 0xff, esize);
+                    memcpy(elem, &i, tag);
+                    while (!enqueue_elem(q, elem)) {
+                        // spin
+                    }
+                }
+            }
+        } else {
+            // consumers: thread P .. P+C-1
+            int v = 0;
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed;
+                if (c >= total) break;
+
+                int got = 0;
+                if (use_zc) {
+                    unsigned char *slot = (unsigned char *)dequeue_peek(q, 1, &n);
+                    if (slot) {
+                        memcpy(&v, slot, tag);
+                        dequeue_release(q, slot, 1);
+                        got = 1;
+                    }
+                } else if (dequeue_elem(q, elem)) {
+                    memcpy(&v, elem, tag);
+                    got = 1;
+                }
+                if (got) {
+                    #pragma omp atomic
+                    consumed++;
+                }
+            }
+            (void)v;
+        }
+        free(elem);
+    }
+
+    double t1 = omp_get_wtime();
+    destroy(q);
+    return t1 - t0;
+}
+
+// Payload-size benchmark for the sequential implementation
+static double run_once_sized_seq(int cap, size_t esize, int items, int use_zc) {
+    Queue *q = bench_create_sized(cap, esize);
+
+    if (!q) {
+        fprintf(stderr, "Failed to create queue (cap=%d, elem=%zu)\n", cap, esize);
+        exit(1);
+    }
+
+    unsigned char *elem = (unsigned char *)malloc(esize);
+    size_t tag = esize < sizeof(int) ? esize : sizeof(int);
+    volatile int sink = 0;
+    int n, v = 0;
+    double t0 = omp_get_wtime();
+
+    for (int i = 0; i < items; i++) {
+        if (use_zc) {
+            unsigned char *slot = (unsigned char *)enqueue_reserve(q, 1, &n);
+            memset(slot, i & 0xff, esize);
+            memcpy(slot, &i, tag);
+            enqueue_commit(q, slot, 1);
+            slot = (unsigned char *)dequeue_peek(q, 1, &n);
+            memcpy(&v, slot, tag);
+            dequeue_release(q, slot, 1);
+        } else {
+            memset(elem, i & 0xff, esize);
+            memcpy(elem, &i, tag);
+            enqueue_elem(q, elem);
+            dequeue_elem(q, elem);
+            memcpy(&v, elem, tag);
+        }
+        sink += v;
+    }
+
+    double t1 = omp_get_wtime();
+    free(elem);
+    destroy(q);
+    return t1 - t0;
+}
+
+// Process CPU time (user + system) in seconds
+static double cpu_seconds(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec * 1e-6 +
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec * 1e-6;
+}
+
+// ---------------------------------------------------------------------
+// Oversubscribed benchmark: like run_once_concurrent, but callers either
+// busy-wait on enqueue/dequeue (use_wait = 0) or block in
+// enqueue_wait/dequeue_wait (use_wait = 1). CPU time spent by the whole
+// process is returned through *cpu_out.
+// ---------------------------------------------------------------------
+static double run_once_oversub(int cap, int P, int C, int items, int use_wait,
+                               double *cpu_out) {
+    Queue *q = bench_create(cap);
+    int total = P * items;
+    int claimed = 0;
+
+    double c0 = cpu_seconds();
+    double t0 = omp_get_wtime();
+
+    #pragma omp parallel num_threads(P + C) shared(q, claimed)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        if (tid < P) {
+            // producers: thread 0 .. P-1
+            for (int i = 0; i < items; i++) {
+                if (use_wait) {
+                    enqueue_wait(q, i);
+                } else {
+                    while (!enqueue(q, i)) {
+                        // spin
+                    }
+                }
+            }
+        } else {
+            // consumers: claim an item, then wait for it
+            int v;
+            while (1) {
+                int c;
+                #pragma omp atomic capture
+                c = claimed++;
+                if (c >= total) break;
+
+                if (use_wait) {
+                    dequeue_wait(q, &v);
+                } else {
+                    while (!dequeue(q, &v)) {
+                        // spin
+                    }
+                }
+            }
+        }
+    }
+
+    double t1 = omp_get_wtime();
+    *cpu_out = cpu_seconds() - c0;
     destroy(q);
     return t1 - t0;
 }
 
+#ifdef BENCH_PERF
+// ---------------------------------------------------------------------
+// Perf-counter mode (-DBENCH_PERF): count cache references/misses, and
+// optionally HITM (loads served from another core's modified line), per
+// thread with perf_event_open. The HITM event is CPU specific, so it is
+// only counted when its raw code is given, e.g. on Skylake-SP
+// MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM: -DPERF_HITM_RAW=0x04d2
+// ---------------------------------------------------------------------
+typedef struct {
+    long long refs;     // cache references
+    long long misses;   // cache misses
+    long long hitm;     // HITM loads (-1 if not counted)
+} PerfCounts;
+
+// Count `config` for the calling thread only. Returns -1 if unavailable.
+static int perf_open(unsigned type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Read and close a counter. Returns -1 if it was never opened.
+static long long perf_close(int fd) {
+    long long v = -1;
+    if (fd < 0) return -1;
+    if (read(fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) v = -1;
+    close(fd);
+    return v;
+}
+
+// Sum a per-thread count into a total, keeping -1 once any thread failed
+static void perf_add(long long *total, long long v) {
+    #pragma omp critical(perf_add)
+    {
+        if (v < 0 || *total < 0) *total = -1;
+        else *total += v;
+    }
+}
+
+// Same workload as run_once_concurrent, with per-thread counters
+static void run_once_concurrent_perf(int cap, int P, int C, int items,
+                                     PerfCounts *pc_out) {
+    Queue *q = bench_create(cap);
+    int total = P * items;
+    int consumed = 0;
+    PerfCounts sum = {0, 0, 0};
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed, sum)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        int fd_refs = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+        int fd_misses = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#ifdef PERF_HITM_RAW
+        int fd_hitm = perf_open(PERF_TYPE_RAW, PERF_HITM_RAW);
+#else
+        int fd_hitm = -1;
+#endif
+        // Start everyone together once all counters are running
+        #pragma omp barrier
+
+        if (tid < P) {
+            for (int i = 0; i < items; i++) {
+                while (!enqueue(q, i)) {
+                    // spin
+                }
+            }
+        } else {
+            int v;
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed;
+                if (c >= total) break;
+
+                if (dequeue(q, &v)) {
+                    #pragma omp atomic
+                    consumed++;
+                }
+            }
+        }
+
+        perf_add(&sum.refs, perf_close(fd_refs));
+        perf_add(&sum.misses, perf_close(fd_misses));
+        perf_add(&sum.hitm, perf_close(fd_hitm));
+    }
+
+    destroy(q);
+    *pc_out = sum;
+}
+#endif
+
+#ifdef BENCH_LATENCY
+// ---------------------------------------------------------------------
+// Latency mode (-DBENCH_LATENCY): producers stamp every element with a
+// CLOCK_MONOTONIC timestamp right before the enqueue attempt that succeeds
+// and consumers record now - stamp into a log-bucketed histogram in the
+// style of HdrHistogram: values below 2 * LAT_SUB are exact, above that
+// every power of two is split into LAT_SUB buckets (~3% resolution for
+// LAT_SUB = 32), so one fixed array covers ns to minutes.
+// Producers never stop to wait, so under load this is the time an element
+// sits in a full-ish queue, i.e. the queueing delay behind the throughput
+// numbers.
+// ---------------------------------------------------------------------
+#define LAT_SUB_BITS 5
+#define LAT_SUB      (1 << LAT_SUB_BITS)
+#define LAT_BUCKETS  (64 * LAT_SUB)
+
+typedef struct {
+    uint64_t counts[LAT_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} LatHist;
+
+static inline long long lat_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline int lat_bucket(uint64_t v) {
+    if (v < 2 * LAT_SUB) return (int)v;
+    int shift = 63 - __builtin_clzll(v) - LAT_SUB_BITS;
+    return (shift + 1) * LAT_SUB + (int)((v >> shift) - LAT_SUB);
+}
+
+// Largest value that falls into bucket b
+static uint64_t lat_bucket_high(int b) {
+    if (b < 2 * LAT_SUB) return (uint64_t)b;
+    int shift = b / LAT_SUB - 1;
+    uint64_t low = (uint64_t)(LAT_SUB + b % LAT_SUB) << shift;
+    return low + ((uint64_t)1 << shift) - 1;
+}
+
+static inline void lat_record(LatHist *h, long long ns) {
+    uint64_t v = ns > 0 ? (uint64_t)ns : 0;
+    h->counts[lat_bucket(v)]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+static void lat_merge(LatHist *into, const LatHist *h) {
+    for (int b = 0; b < LAT_BUCKETS; b++) into->counts[b] += h->counts[b];
+    into->total += h->total;
+    if (h->max > into->max) into->max = h->max;
+}
+
+// Smallest recorded value v with at least pct percent of values <= v
+// (reported as the top of its bucket, capped at the exact max)
+static long long lat_percentile(const LatHist *h, double pct) {
+    if (h->total == 0) return 0;
+    uint64_t want = (uint64_t)((double)h->total * pct / 100.0 + 0.5);
+    if (want < 1) want = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= want) {
+            uint64_t v = lat_bucket_high(b);
+            return (long long)(v < h->max ? v : h->max);
+        }
+    }
+    return (long long)h->max;
+}
+
+// Same workload as run_once_concurrent, on 8-byte elements holding the
+// enqueue timestamp; the consumers' histograms are merged into *out
+static void run_once_latency(int cap, int P, int C, int items, LatHist *out) {
+    Queue *q = bench_create_sized(cap, sizeof(long long));
+    if (!q) {
+        fprintf(stderr, "Failed to create queue (cap=%d)\n", cap);
+        exit(1);
+    }
+    int total = P * items;
+    int consumed = 0;
+    memset(out, 0, sizeof(*out));
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed, out)
+    {
+        int tid = omp_get_thread_num();
+        bench_pin(tid, P);
+        if (tid < P) {
+            for (int i = 0; i < items; i++) {
+                long long stamp;
+                do {
+                    stamp = lat_now_ns();
+                } while (!enqueue_elem(q, &stamp));
+            }
+        } else {
+            LatHist *h = (LatHist *)calloc(1, sizeof(LatHist));
+            if (!h) {
+                fprintf(stderr, "Failed to allocate histogram\n");
+                exit(1);
+            }
+            long long stamp;
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed;
+                if (c >= total) break;
+
+                if (dequeue_elem(q, &stamp)) {
+                    lat_record(h, lat_now_ns() - stamp);
+                    #pragma omp atomic
+                    consumed++;
+                }
+            }
+            #pragma omp critical(lat_merge)
+            lat_merge(out, h);
+            free(h);
+        }
+    }
+
+    destroy(q);
+}
+
+// CDF points for plot_bench.py: percentiles 100 * (1 - 2^(-k/4)), i.e.
+// four points per halving of the tail, from ~16% up to 99.9%, plus max
+#define LAT_CDF_POINTS 40
+
+static void out_latency_cdf(int cap, int P, int C, const LatHist *h) {
+    double tail = 1.0;
+    for (int k = 1; k <= LAT_CDF_POINTS; k++) {
+        tail *= 0.8408964152537145;   // 2^(-1/4)
+        double pct = 100.0 * (1.0 - tail);
+        out_row("%s,%d,%d,%d,%.4f,%lld", IMPL_NAME, cap, P, C, pct,
+                lat_percentile(h, pct));
+    }
+    out_row("%s,%d,%d,%d,%.4f,%lld", IMPL_NAME, cap, P, C, 100.0,
+            (long long)h->max);
+}
+#endif
+
+// ---------------------------------------------------------------------
+// Command line
+// ---------------------------------------------------------------------
+#define MAX_LIST 64
+
+// Which sweeps to run (--workloads)
+enum {
+    WL_THROUGHPUT = 1 << 0,   // enqueue/dequeue, every (cap, P, C, items)
+    WL_BULK       = 1 << 1,   // enqueue_bulk/dequeue_bulk batch sizes
+    WL_SIZED      = 1 << 2,   // create_sized payload sizes, copy vs zero-copy
+    WL_OVERSUB    = 1 << 3,   // 2 x cores threads, busy-wait vs blocking
+};
+
+typedef struct {
+    int cap;
+    int P;
+    int C;
+    int items;
+} Config;
+
+// True if an earlier configuration only differs from cfgs[k] in what the
+// caller ignores (P and C, items), i.e. cfgs[k] would repeat its run
+static bool seen_before(const Config *cfgs, int k, bool ignore_pc, bool ignore_items) {
+    for (int j = 0; j < k; ++j) {
+        if (cfgs[j].cap != cfgs[k].cap) continue;
+        if (!ignore_pc && (cfgs[j].P != cfgs[k].P || cfgs[j].C != cfgs[k].C)) continue;
+        if (!ignore_items && cfgs[j].items != cfgs[k].items) continue;
+        return true;
+    }
+    return false;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -c, --caps LIST        queue capacities (default 64,100,256,1000,1024)\n"
+        "  -p, --producers LIST   producer counts (default 1,2,4,8,16)\n"
+        "  -C, --consumers LIST   consumer counts; every P is paired with every C\n"
+        "                         (default: C = P)\n"
+        "  -n, --items LIST       items per producer (default 100000)\n"
+        "  -b, --batches LIST     bulk batch sizes (default 1,8,64,256)\n"
+        "  -e, --elem-bytes LIST  payload sizes (default 4,16,64,256)\n"
+        "  -t, --trials N         timed runs per configuration (default %d)\n"
+        "  -w, --warmup N         untimed runs before the trials (default 0)\n"
+        "  -d, --duration SEC     run each throughput configuration for SEC\n"
+        "                         seconds instead of a fixed item count\n"
+        "  -W, --workloads LIST   any of throughput,bulk,sized,oversub (default all)\n"
+        "      --pin              pin thread i to CPU i mod #CPUs\n"
+        "      --layout L         pin producer i and consumer i to the same-core,\n"
+        "                         same-socket or cross-socket CPUs of the CPUs\n"
+        "                         allowed (restrict them with numactl/taskset)\n"
+        "      --node N           int queues from create_on_node(cap, N), N = -1\n"
+        "                         for the creating thread's node\n"
+        "  -f, --format FMT       table, csv or json (default %s)\n"
+        "LIST is comma separated; lo:hi doubles from lo to hi, lo:hi:step adds step\n"
+        "(e.g. -c 64:4096 -p 1:8 -C 1,4).\n",
+        prog, N_TRIALS, out_fmt == OUT_CSV ? "csv" : "table");
+}
+
+// Parse LIST into out[]; returns the number of values or -1 if malformed
+static int parse_list(const char *arg, int *out) {
+    int n = 0;
+    const char *p = arg;
+    while (*p) {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo, step = 0;
+        if (end == p || lo <= 0) return -1;
+        if (*end == ':') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p || hi < lo) return -1;
+            if (*end == ':') {
+                p = end + 1;
+                step = strtol(p, &end, 10);
+                if (end == p || step <= 0) return -1;
+            }
+        }
+        for (long v = lo; v <= hi && v <= 0x7fffffff; v = step ? v + step : v * 2) {
+            if (n == MAX_LIST) return -1;
+            out[n++] = (int)v;
+        }
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    return n;
+}
+
+static int parse_int(const char *arg, int min) {
+    char *end;
+    long v = strtol(arg, &end, 10);
+    return (end == arg || *end != '\0' || v < min || v > 0x7fffffff) ? -1 : (int)v;
+}
+
+static unsigned parse_workloads(const char *arg) {
+    const char *names[] = {"throughput", "bulk", "sized", "oversub"};
+    unsigned mask = 0;
+    while (*arg) {
+        size_t len = strcspn(arg, ",");
+        int found = 0;
+        for (int i = 0; i < 4; i++) {
+            if (strlen(names[i]) == len && strncmp(arg, names[i], len) == 0) {
+                mask |= 1u << i;
+                found = 1;
+            }
+        }
+        if (!found) return 0;
+        arg += len + (arg[len] == ',');
+    }
+    return mask;
+}
+
 // Helper: detect if we’re benchmarking the sequential implementation
 static int is_sequential_impl(void) {
-    return strcmp(IMPL_NAME, "seq") == 0 ||
-           strcmp(IMPL_NAME, "sequential") == 0;
+    // prefix match so the _pow2 builds are recognized too
+    return strncmp(IMPL_NAME, "seq", 3) == 0;
 }
 
-int main(void) {
-    int caps[] = {64, 256, 1024};
-    int pc[]   = {1, 2, 4, 8};
-    int items  = 100000;
+int main(int argc, char **argv) {
+    // powers of two plus sizes that are not, where the index update
+    // is a modulo unless the queue comes from create_pow2
+    int caps[MAX_LIST] = {64, 100, 256, 1000, 1024};
+    int n_caps = 5;
+#ifdef SPSC_ONLY
+    // Single-producer/single-consumer implementation: P = C = 1 sweep only,
+    // comparable with the P = C = 1 rows of twolock and the seq rows
+    int producers[MAX_LIST] = {1};
+    int n_prod = 1;
+#else
+    // up to P + C = 32 threads for the scaling curves
+    int producers[MAX_LIST] = {1, 2, 4, 8, 16};
+    int n_prod = 5;
+#endif
+    int consumers[MAX_LIST];
+    int n_cons = 0;   // 0: C = P
+    int items_list[MAX_LIST] = {100000};
+    int n_items = 1;
+    int batches[MAX_LIST] = {1, 8, 64, 256};
+    int n_batches = 4;
+    // 4 = same payload as the int API, 8/16/64 have specialized copies
+    int elem_bytes[MAX_LIST] = {4, 16, 64, 256};
+    int n_elem = 4;
+    int trials = N_TRIALS;
+    int warmup = 0;
+    double duration = 0.0;
+    unsigned workloads = WL_THROUGHPUT | WL_BULK | WL_SIZED | WL_OVERSUB;
 
-    // Print CSV Header
-    printf("impl,cap,P,C,items,trials,"
-           "time_avg_s,time_min_s,time_max_s,"
-           "throughput_avg_ops_per_s\n");
+    static const struct option longopts[] = {
+        {"caps",       required_argument, NULL, 'c'},
+        {"producers",  required_argument, NULL, 'p'},
+        {"consumers",  required_argument, NULL, 'C'},
+        {"items",      required_argument, NULL, 'n'},
+        {"batches",    required_argument, NULL, 'b'},
+        {"elem-bytes", required_argument, NULL, 'e'},
+        {"trials",     required_argument, NULL, 't'},
+        {"warmup",     required_argument, NULL, 'w'},
+        {"duration",   required_argument, NULL, 'd'},
+        {"workloads",  required_argument, NULL, 'W'},
+        {"pin",        no_argument,       NULL, 'P'},
+        {"layout",     required_argument, NULL, 'L'},
+        {"node",       required_argument, NULL, 'N'},
+        {"format",     required_argument, NULL, 'f'},
+        {"help",       no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
 
+    int opt;
+    bool bad = false;
+    while (!bad && (opt = getopt_long(argc, argv, "c:p:C:n:b:e:t:w:d:W:f:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'c': bad = (n_caps = parse_list(optarg, caps)) <= 0; break;
+        case 'p': bad = (n_prod = parse_list(optarg, producers)) <= 0; break;
+        case 'C': bad = (n_cons = parse_list(optarg, consumers)) <= 0; break;
+        case 'n': bad = (n_items = parse_list(optarg, items_list)) <= 0; break;
+        case 'b': bad = (n_batches = parse_list(optarg, batches)) <= 0; break;
+        case 'e': bad = (n_elem = parse_list(optarg, elem_bytes)) <= 0; break;
+        case 't': bad = (trials = parse_int(optarg, 1)) < 0; break;
+        case 'w': bad = (warmup = parse_int(optarg, 0)) < 0; break;
+        case 'd': duration = strtod(optarg, NULL); bad = !(duration > 0.0); break;
+        case 'W': bad = (workloads = parse_workloads(optarg)) == 0; break;
+        case 'P': g_pin = true; break;
+        case 'L':
+            if (strcmp(optarg, "same-core") == 0) g_layout = LAYOUT_SAME_CORE;
+            else if (strcmp(optarg, "same-socket") == 0) g_layout = LAYOUT_SAME_SOCKET;
+            else if (strcmp(optarg, "cross-socket") == 0) g_layout = LAYOUT_CROSS_SOCKET;
+            else bad = true;
+            break;
+        case 'N':
+            g_on_node = true;
+            if (strcmp(optarg, "-1") == 0) g_node = -1;
+            else bad = (g_node = parse_int(optarg, 0)) < 0;
+            break;
+        case 'f':
+            if (strcmp(optarg, "table") == 0) out_fmt = OUT_TABLE;
+            else if (strcmp(optarg, "csv") == 0) out_fmt = OUT_CSV;
+            else if (strcmp(optarg, "json") == 0) out_fmt = OUT_JSON;
+            else bad = true;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            bad = true;
+        }
+    }
+    if (bad || optind < argc) {
+        if (bad && opt != '?') fprintf(stderr, "%s: bad value for -%c: %s\n", argv[0], opt, optarg);
+        usage(argv[0]);
+        return 2;
+    }
+    if (!layout_init()) {
+        fprintf(stderr, "%s: cannot read the allowed CPUs for --layout\n", argv[0]);
+        return 2;
+    }
 
+    // Every (cap, P, C, items) combination, P and C paired unless -C was given
+    int n_pairs = n_cons ? n_prod * n_cons : n_prod;
+    Config *cfgs = (Config *)malloc(sizeof(Config) * (size_t)(n_caps * n_pairs * n_items));
+    if (!cfgs) return 1;
+    int n_cfgs = 0;
+    for (int ci = 0; ci < n_caps; ++ci) {
+        for (int pi = 0; pi < n_pairs; ++pi) {
+            int P = n_cons ? producers[pi / n_cons] : producers[pi];
+            int C = n_cons ? consumers[pi % n_cons] : P;
+#ifdef SPSC_ONLY
+            //Edge case: the SPSC ring only supports one producer and one consumer
+            if (P != 1 || C != 1) continue;
+#endif
+            for (int ii = 0; ii < n_items; ++ii) {
+                cfgs[n_cfgs++] = (Config){caps[ci], P, C, items_list[ii]};
+            }
+        }
+    }
+    if (n_cfgs == 0) {
+        fprintf(stderr, "no configuration left to run (spsc needs P = C = 1)\n");
+        return 2;
+    }
+
+    out_open(argc, argv);
+
+#ifdef BENCH_PERF
+    // -----------------------------------------------------------------
+    // PERF COUNTERS: one run per (cap, P, C, items); -1 means not available
+    // -----------------------------------------------------------------
+    if (is_sequential_impl()) {
+        // Nothing is shared between threads, so there is nothing to measure
+        fprintf(stderr, "perf-counter mode needs a concurrent implementation\n");
+        return 1;
+    }
+
+    out_begin("perf", "impl,cap,P,C,items,cache_refs,cache_misses,hitm,misses_per_op", false);
+    for (int k = 0; k < n_cfgs; ++k) {
+        Config f = cfgs[k];
+        PerfCounts c;
+        run_once_concurrent_perf(f.cap, f.P, f.C, f.items, &c);
+        double ops = 2.0 * (double)f.P * (double)f.items;
+        out_row("%s,%d,%d,%d,%d,%lld,%lld,%lld,%.3f",
+                IMPL_NAME, f.cap, f.P, f.C, f.items, c.refs, c.misses, c.hitm,
+                c.misses < 0 ? -1.0 : (double)c.misses / ops);
+    }
+    out_end();
+    out_close();
+    free(cfgs);
+    return 0;
+#endif
+
+#ifdef BENCH_LATENCY
+    // -----------------------------------------------------------------
+    // LATENCY: enqueue-to-dequeue percentiles per (cap, P, C, items), then
+    // the CDF points of every run as a second section
+    // -----------------------------------------------------------------
     if (is_sequential_impl()) {
-        #ifdef USE_PRETTY_TABLE
-            print_header_seq();
-        #endif
-        // -------------------------------------------------------------
-        // SEQUENTIAL: only vary capacity, ignore P and C
-        // -------------------------------------------------------------
-        for (int ci = 0; ci < (int)(sizeof(caps)/sizeof(caps[0])); ++ci) {
-            int cap = caps[ci];
+        // Every value is dequeued right after its enqueue: nothing to measure
+        fprintf(stderr, "latency mode needs a concurrent implementation\n");
+        return 1;
+    }
+
+    LatHist *hists = (LatHist *)malloc(sizeof(LatHist) * (size_t)n_cfgs);
+    if (!hists) {
+        fprintf(stderr, "Failed to allocate histograms\n");
+        return 1;
+    }
+
+    out_begin("latency", "impl,cap,P,C,items,lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns", true);
+    if (out_table()) print_header_latency();
+    for (int k = 0; k < n_cfgs; ++k) {
+        Config f = cfgs[k];
+        LatHist *h = &hists[k];
+        for (int w = 0; w < warmup; ++w) run_once_latency(f.cap, f.P, f.C, f.items, h);
+        run_once_latency(f.cap, f.P, f.C, f.items, h);
+
+        if (out_table()) {
+            print_row_latency(IMPL_NAME, f.cap, f.P, f.C, f.items,
+                              lat_percentile(h, 50.0), lat_percentile(h, 90.0),
+                              lat_percentile(h, 99.0), lat_percentile(h, 99.9),
+                              (long long)h->max);
+        } else {
+            out_row("%s,%d,%d,%d,%d,%lld,%lld,%lld,%lld,%lld",
+                    IMPL_NAME, f.cap, f.P, f.C, f.items,
+                    lat_percentile(h, 50.0), lat_percentile(h, 90.0),
+                    lat_percentile(h, 99.0), lat_percentile(h, 99.9),
+                    (long long)h->max);
+        }
+    }
+    if (out_table()) print_footer_latency();
+    out_end();
+
+    out_begin("latency_cdf", "impl,cap,P,C,percentile,lat_ns", false);
+    for (int k = 0; k < n_cfgs; ++k) {
+        out_latency_cdf(cfgs[k].cap, cfgs[k].P, cfgs[k].C, &hists[k]);
+    }
+    out_end();
+    out_close();
+    free(hists);
+    free(cfgs);
+    return 0;
+#endif
+
+    // -----------------------------------------------------------------
+    // THROUGHPUT: every (cap, P, C, items), or every (cap, P, C) for
+    // `duration` seconds; the sequential implementation only varies cap
+    // and items (P = C = 0)
+    // -----------------------------------------------------------------
+    if (workloads & WL_THROUGHPUT) {
+        out_begin("throughput",
+                  "impl,cap,P,C,items,trials,"
+                  "time_avg_s,time_min_s,time_max_s,"
+                  "throughput_avg_ops_per_s", true);
+        if (out_table()) {
+            if (is_sequential_impl()) print_header_seq();
+            else print_header();
+        }
+#ifdef QUEUE_STATS
+        StatsRow *srows = (StatsRow *)calloc((size_t)n_cfgs, sizeof(StatsRow));
+        if (!srows) {
+            fprintf(stderr, "Failed to allocate stats rows\n");
+            return 1;
+        }
+#endif
+
+        for (int k = 0; k < n_cfgs; ++k) {
+            Config f = cfgs[k];
+            //Edge case: seq ignores P and C, and duration mode ignores items
+            if (seen_before(cfgs, k, is_sequential_impl(), duration > 0.0)) continue;
+            if (is_sequential_impl()) f.P = f.C = 0;
 
             double sum = 0.0;
             double tmin = 1e300;
             double tmax = 0.0;
+            double ops_sum = 0.0;
+            long long moved = 0;
 
-            for (int t = 0; t < N_TRIALS; ++t) {
-                double sec = run_once_seq(cap, items);
+            for (int t = -warmup; t < trials; ++t) {
+                double sec;
+                double ops;
+                if (duration > 0.0) {
+                    sec = is_sequential_impl()
+                        ? run_once_seq_duration(f.cap, duration, &moved)
+                        : run_once_concurrent_duration(f.cap, f.P, f.C, duration, &moved);
+                    ops = 2.0 * (double)moved;
+                } else {
+                    sec = is_sequential_impl()
+                        ? run_once_seq(f.cap, f.items)
+                        : run_once_concurrent(f.cap, f.P, f.C, f.items);
+                    // each produced item is enqueued and dequeued
+                    ops = 2.0 * (double)(f.P > 0 ? f.P : 1) * (double)f.items;
+                }
+                // negative t: warm-up run, not recorded
+                if (t < 0) continue;
+#ifdef QUEUE_STATS
+                stats_accumulate(&srows[k].sum, &g_stats);
+#endif
                 sum += sec;
+                ops_sum += ops;
                 if (sec < tmin) tmin = sec;
                 if (sec > tmax) tmax = sec;
             }
 
-            double avg = sum / (double)N_TRIALS;
+            double avg = sum / (double)trials;
+            double throughput_avg = ops_sum / sum;
+            // duration mode: report the items each producer got through on average
+            int items = duration > 0.0
+                ? (int)(ops_sum / 2.0 / (double)trials / (double)(f.P > 0 ? f.P : 1))
+                : f.items;
 
-            // total operations: items enqueued + items dequeued
-            double total_ops = 2.0 * (double)items;
-            double throughput_avg = total_ops / avg;
+            if (out_table()) {
+                if (is_sequential_impl()) {
+                    print_row_seq(IMPL_NAME, f.cap, items,
+                                  trials, avg, tmin, tmax, throughput_avg);
+                } else {
+                    print_row(IMPL_NAME, f.cap, f.P, f.C, items,
+                              trials, avg, tmin, tmax, throughput_avg);
+                }
+            } else {
+                out_row("%s,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f",
+                        IMPL_NAME, f.cap, f.P, f.C, items, trials,
+                        avg, tmin, tmax, throughput_avg);
+            }
+#ifdef QUEUE_STATS
+            srows[k].items = items;
+            srows[k].used = true;
+#endif
+        }
+        if (out_table()) print_footer();
+        out_end();
 
-            #ifdef USE_PRETTY_TABLE
-                print_row_seq(IMPL_NAME, cap, items,
-                      N_TRIALS, avg, tmin, tmax, throughput_avg);
-            #else 
-                printf("%s,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f\n",
-                       IMPL_NAME, cap, 0, 0, items, N_TRIALS,
-                       avg, tmin, tmax, throughput_avg);
-            #endif
+#ifdef QUEUE_STATS
+        // STATS: counters of the same runs, per trial (high water: max)
+        out_begin("stats",
+                  "impl,cap,P,C,items,enqueued,dequeued,full,empty,"
+                  "contended,high_water,wait_s", true);
+        if (out_table()) print_header_stats();
+        for (int k = 0; k < n_cfgs; ++k) {
+            if (!srows[k].used) continue;
+            Config f = cfgs[k];
+            if (is_sequential_impl()) f.P = f.C = 0;
+            QueueStats *st = &srows[k].sum;
+            unsigned long long n = (unsigned long long)trials;
+            if (out_table()) {
+                print_row_stats(IMPL_NAME, f.cap, f.P, f.C, srows[k].items,
+                                st->enqueued / n, st->dequeued / n, st->full / n,
+                                st->empty / n, st->contended / n, st->high_water,
+                                st->wait_s / (double)trials);
+            } else {
+                out_row("%s,%d,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%.6f",
+                        IMPL_NAME, f.cap, f.P, f.C, srows[k].items,
+                        st->enqueued / n, st->dequeued / n, st->full / n,
+                        st->empty / n, st->contended / n, st->high_water,
+                        st->wait_s / (double)trials);
+            }
         }
-    } else {
-        // -------------------------------------------------------------
-        // CONCURRENT: vary capacity and P/C
-        // -------------------------------------------------------------
-        #ifdef USE_PRETTY_TABLE
-            print_header();
-        #endif
-        for (int ci = 0; ci < (int)(sizeof(caps)/sizeof(caps[0])); ++ci) {
-            for (int i = 0; i < (int)(sizeof(pc)/sizeof(pc[0])); ++i) {
-                int cap = caps[ci];
-                int P = pc[i];
-                int C = pc[i];
+        if (out_table()) print_footer_stats();
+        out_end();
+        free(srows);
+#endif
+    }
+
+    // -----------------------------------------------------------------
+    // BATCH-SIZE SWEEP: enqueue_bulk/dequeue_bulk with batch <= cap
+    // (seq runs with P = C = 0)
+    // -----------------------------------------------------------------
+    if (workloads & WL_BULK) {
+        out_begin("bulk",
+                  "impl,cap,P,C,items,batch,trials,"
+                  "time_avg_s,time_min_s,time_max_s,"
+                  "throughput_avg_ops_per_s", true);
+        if (out_table()) print_header_bulk();
+        for (int k = 0; k < n_cfgs; ++k) {
+            Config f = cfgs[k];
+            if (seen_before(cfgs, k, is_sequential_impl(), false)) continue;
+            if (is_sequential_impl()) f.P = f.C = 0;
+            for (int bi = 0; bi < n_batches; ++bi) {
+                int batch = batches[bi];
+                if (batch > f.cap) continue;
 
                 double sum = 0.0;
                 double tmin = 1e300;
                 double tmax = 0.0;
 
-                for (int t = 0; t < N_TRIALS; ++t) {
-                    double sec = run_once_concurrent(cap, P, C, items);
+                for (int t = -warmup; t < trials; ++t) {
+                    double sec = is_sequential_impl()
+                        ? run_once_bulk_seq(f.cap, f.items, batch)
+                        : run_once_bulk_concurrent(f.cap, f.P, f.C, f.items, batch);
+                    if (t < 0) continue;
                     sum += sec;
                     if (sec < tmin) tmin = sec;
                     if (sec > tmax) tmax = sec;
                 }
 
-                double avg = sum / (double)N_TRIALS;
+                double avg = sum / (double)trials;
 
-                // total operations: each produced item is enqueued and dequeued
-                double total_ops = 2.0 * (double)P * (double)items;
+                // total operations: each item is enqueued and dequeued once
+                double total_ops = 2.0 * (double)(f.P > 0 ? f.P : 1) * (double)f.items;
                 double throughput_avg = total_ops / avg;
 
-                #ifdef USE_PRETTY_TABLE
-                    print_row(IMPL_NAME, cap, P, C, items,
-                              N_TRIALS, avg, tmin, tmax, throughput_avg);
-                #else 
-                    printf("%s,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f\n",
-                           IMPL_NAME, cap, P, C, items, N_TRIALS,
-                           avg, tmin, tmax, throughput_avg);
-                #endif
+                if (out_table()) {
+                    print_row_bulk(IMPL_NAME, f.cap, f.P, f.C, f.items, batch,
+                                   trials, avg, tmin, tmax, throughput_avg);
+                } else {
+                    out_row("%s,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f",
+                            IMPL_NAME, f.cap, f.P, f.C, f.items, batch, trials,
+                            avg, tmin, tmax, throughput_avg);
+                }
+            }
+        }
+        if (out_table()) print_footer_bulk();
+        out_end();
+    }
+
+    // -----------------------------------------------------------------
+    // PAYLOAD-SIZE SWEEP: create_sized, copying calls (enqueue_elem/
+    // dequeue_elem) vs zero-copy calls (reserve/commit, peek/release),
+    // at the middle capacity of the list (seq runs with P = C = 0)
+    // -----------------------------------------------------------------
+    if (workloads & WL_SIZED) {
+        out_begin("sized",
+                  "impl,cap,P,C,items,elem_bytes,trials,"
+                  "time_avg_s,time_min_s,time_max_s,"
+                  "throughput_avg_ops_per_s,mb_per_s,zc_throughput_avg_ops_per_s", true);
+        if (out_table()) print_header_sized();
+        int cap = caps[n_caps / 2];
+        for (int k = 0; k < n_cfgs; ++k) {
+            Config f = cfgs[k];
+            //Edge case: one capacity only, so one pass per (P, C, items)
+            if (f.cap != cfgs[0].cap) continue;
+            if (seen_before(cfgs, k, is_sequential_impl(), false)) continue;
+            if (is_sequential_impl()) f.P = f.C = 0;
+            for (int ei = 0; ei < n_elem; ++ei) {
+                int bytes = elem_bytes[ei];
+
+                double sum = 0.0;
+                double zc_sum = 0.0;
+                double tmin = 1e300;
+                double tmax = 0.0;
+
+                for (int t = -warmup; t < trials; ++t) {
+                    double sec = is_sequential_impl()
+                        ? run_once_sized_seq(cap, (size_t)bytes, f.items, 0)
+                        : run_once_sized_concurrent(cap, (size_t)bytes, f.P, f.C, f.items, 0);
+                    double zc_sec = is_sequential_impl()
+                        ? run_once_sized_seq(cap, (size_t)bytes, f.items, 1)
+                        : run_once_sized_concurrent(cap, (size_t)bytes, f.P, f.C, f.items, 1);
+                    if (t < 0) continue;
+                    sum += sec;
+                    zc_sum += zc_sec;
+                    if (sec < tmin) tmin = sec;
+                    if (sec > tmax) tmax = sec;
+                }
+
+                double avg = sum / (double)trials;
+                double zc_avg = zc_sum / (double)trials;
+
+                // total operations: each item is enqueued and dequeued once;
+                // bandwidth counts each element's bytes once
+                double items_total = (double)(f.P > 0 ? f.P : 1) * (double)f.items;
+                double throughput_avg = 2.0 * items_total / avg;
+                double zc_throughput_avg = 2.0 * items_total / zc_avg;
+                double mbps = items_total * (double)bytes / avg / 1e6;
+
+                if (out_table()) {
+                    print_row_sized(IMPL_NAME, cap, f.P, f.C, f.items, bytes,
+                                    trials, avg, tmin, throughput_avg, mbps,
+                                    zc_throughput_avg);
+                } else {
+                    out_row("%s,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.1f,%.1f,%.1f",
+                            IMPL_NAME, cap, f.P, f.C, f.items, bytes, trials,
+                            avg, tmin, tmax, throughput_avg, mbps, zc_throughput_avg);
+                }
+            }
+        }
+        if (out_table()) print_footer_sized();
+        out_end();
+    }
+
+    // -----------------------------------------------------------------
+    // OVERSUBSCRIBED: P + C = 2 x cores, busy-wait vs blocking calls
+    // -----------------------------------------------------------------
+    if ((workloads & WL_OVERSUB) && !is_sequential_impl()) {
+#ifdef SPSC_ONLY
+        int P = 1;
+#else
+        int P = omp_get_num_procs();
+#endif
+        int C = P;
+        int cap = caps[0];
+        int items = items_list[0];
+        const char *waits[] = {"spin", "park"};
+
+        out_begin("oversub",
+                  "impl,cap,P,C,items,wait,trials,"
+                  "time_avg_s,cpu_avg_s,throughput_avg_ops_per_s", true);
+        if (out_table()) print_header_oversub();
+        for (int w = 0; w < 2; ++w) {
+            double sum = 0.0;
+            double cpu_sum = 0.0;
+
+            for (int t = -warmup; t < trials; ++t) {
+                double cpu;
+                double sec = run_once_oversub(cap, P, C, items, w, &cpu);
+                if (t < 0) continue;
+                sum += sec;
+                cpu_sum += cpu;
+            }
+
+            double avg = sum / (double)trials;
+            double cpu_avg = cpu_sum / (double)trials;
+            double throughput_avg = 2.0 * (double)P * (double)items / avg;
+
+            if (out_table()) {
+                print_row_oversub(IMPL_NAME, cap, P, C, items, waits[w],
+                                  trials, avg, cpu_avg, throughput_avg);
+            } else {
+                out_row("%s,%d,%d,%d,%d,%s,%d,%.6f,%.6f,%.1f",
+                        IMPL_NAME, cap, P, C, items, waits[w], trials,
+                        avg, cpu_avg, throughput_avg);
             }
         }
+        if (out_table()) print_footer_oversub();
+        out_end();
     }
 
-    print_footer();
+    out_close();
+    free(cfgs);
     return 0;
 }
@@ -0,0 +1,265 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "queue.h"
+#include "utils.c"
+
+// Two-process benchmark: the shared-memory queue against a Unix
+// socketpair, the usual way to pass messages between a parent and a
+// forked child. For each transport
+//   - stream: the child sends STREAM_MSGS ints, the parent receives them,
+//     one per call (batch 1) or BATCH per call (enqueue_bulk/dequeue_bulk,
+//     one BATCH*4-byte write);
+//   - pingpong: the parent sends an int and the child echoes it back,
+//     PING_ROUNDS times; latency is half the round trip.
+// Both sides block when they cannot proceed (enqueue_wait/dequeue_wait,
+// blocking read/write), so neither burns a core while waiting.
+//
+//   make bench_shm MODE=shm
+
+#ifndef PARK_SHARED
+#error "bench_shm needs the shared-memory queue: make bench_shm MODE=shm"
+#endif
+
+#ifndef STREAM_MSGS
+#define STREAM_MSGS (1 << 21)
+#endif
+
+#ifndef PING_ROUNDS
+#define PING_ROUNDS 20000
+#endif
+
+#ifndef BATCH
+#define BATCH 64
+#endif
+
+// Queue capacity in ints
+#ifndef SHM_CAP
+#define SHM_CAP 1024
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *transport, const char *test, long msgs, int batch,
+                   double secs, long long *lat) {
+    double p50 = -1, p99 = -1;
+    if (lat) {
+        qsort(lat, (size_t)msgs / 2, sizeof(long long), cmp_ll);
+        p50 = (double)lat[msgs / 2 / 2];
+        p99 = (double)lat[(long)(msgs / 2 * 0.99)];
+    }
+#ifdef USE_PRETTY_TABLE
+    print_row_shm(transport, test, msgs, batch, msgs / secs, p50, p99);
+#else
+    printf("%s,%s,%ld,%d,%.1f,%.0f,%.0f\n", transport, test, msgs, batch, msgs / secs, p50, p99);
+#endif
+}
+
+static void reap(pid_t pid) {
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "child failed\n");
+        exit(1);
+    }
+}
+
+// Write/read exactly len bytes (a stream socket may split them)
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w <= 0) return -1;
+        p += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t r = read(fd, p, len);
+        if (r <= 0) return -1;
+        p += r;
+        len -= (size_t)r;
+    }
+    return 0;
+}
+
+// ============================
+// Shared-memory queue
+// ============================
+
+static void shm_stream(int batch) {
+    Queue *q = create(SHM_CAP);
+    if (!q) { fprintf(stderr, "Failed to create queue\n"); exit(1); }
+
+    long long t0 = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int buf[BATCH];
+        for (int i = 0; i < STREAM_MSGS; ) {
+            int k = 0;
+            if (batch > 1) {
+                int n = STREAM_MSGS - i < batch ? STREAM_MSGS - i : batch;
+                for (int j = 0; j < n; j++) buf[j] = i + j;
+                k = enqueue_bulk(q, buf, n);
+            }
+            // Full (or one at a time): block for one slot
+            if (k == 0) {
+                if (!enqueue_wait(q, i)) _exit(1);
+                k = 1;
+            }
+            i += k;
+        }
+        _exit(0);
+    }
+
+    int buf[BATCH], v, expect = 0;
+    while (expect < STREAM_MSGS) {
+        int k = batch > 1 ? dequeue_bulk(q, buf, batch) : 0;
+        if (k == 0) {
+            if (!dequeue_wait(q, &v)) exit(1);
+            buf[0] = v;
+            k = 1;
+        }
+        for (int j = 0; j < k; j++) {
+            if (buf[j] != expect++) { fprintf(stderr, "shm stream out of order\n"); exit(1); }
+        }
+    }
+    double secs = (now_ns() - t0) * 1e-9;
+    reap(pid);
+    destroy(q);
+    report("shm", "stream", STREAM_MSGS, batch, secs, NULL);
+}
+
+static void shm_pingpong(void) {
+    Queue *req = create(SHM_CAP), *resp = create(SHM_CAP);
+    if (!req || !resp) { fprintf(stderr, "Failed to create queue\n"); exit(1); }
+    long long *lat = malloc(PING_ROUNDS * sizeof(long long));
+
+    long long t0 = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int v;
+        for (int i = 0; i < PING_ROUNDS; i++) {
+            if (!dequeue_wait(req, &v) || !enqueue_wait(resp, v)) _exit(1);
+        }
+        _exit(0);
+    }
+
+    int v;
+    for (int i = 0; i < PING_ROUNDS; i++) {
+        long long s = now_ns();
+        if (!enqueue_wait(req, i) || !dequeue_wait(resp, &v) || v != i) exit(1);
+        lat[i] = (now_ns() - s) / 2;
+    }
+    double secs = (now_ns() - t0) * 1e-9;
+    reap(pid);
+    destroy(req);
+    destroy(resp);
+    report("shm", "pingpong", 2L * PING_ROUNDS, 1, secs, lat);
+    free(lat);
+}
+
+// ============================
+// Unix socketpair
+// ============================
+
+static void sock_stream(int batch) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) { perror("socketpair"); exit(1); }
+
+    long long t0 = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        int buf[BATCH];
+        for (int i = 0; i < STREAM_MSGS; i += batch) {
+            int n = STREAM_MSGS - i < batch ? STREAM_MSGS - i : batch;
+            for (int j = 0; j < n; j++) buf[j] = i + j;
+            if (write_all(sv[1], buf, (size_t)n * sizeof(int)) != 0) _exit(1);
+        }
+        _exit(0);
+    }
+    close(sv[1]);
+
+    int buf[BATCH], expect = 0;
+    while (expect < STREAM_MSGS) {
+        int n = STREAM_MSGS - expect < batch ? STREAM_MSGS - expect : batch;
+        if (read_all(sv[0], buf, (size_t)n * sizeof(int)) != 0) exit(1);
+        for (int j = 0; j < n; j++) {
+            if (buf[j] != expect++) { fprintf(stderr, "socket stream out of order\n"); exit(1); }
+        }
+    }
+    double secs = (now_ns() - t0) * 1e-9;
+    reap(pid);
+    close(sv[0]);
+    report("socketpair", "stream", STREAM_MSGS, batch, secs, NULL);
+}
+
+static void sock_pingpong(void) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) { perror("socketpair"); exit(1); }
+    long long *lat = malloc(PING_ROUNDS * sizeof(long long));
+
+    long long t0 = now_ns();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(sv[0]);
+        int v;
+        for (int i = 0; i < PING_ROUNDS; i++) {
+            if (read_all(sv[1], &v, sizeof(v)) != 0 || write_all(sv[1], &v, sizeof(v)) != 0) _exit(1);
+        }
+        _exit(0);
+    }
+    close(sv[1]);
+
+    int v;
+    for (int i = 0; i < PING_ROUNDS; i++) {
+        long long s = now_ns();
+        if (write_all(sv[0], &i, sizeof(i)) != 0 || read_all(sv[0], &v, sizeof(v)) != 0 || v != i) exit(1);
+        lat[i] = (now_ns() - s) / 2;
+    }
+    double secs = (now_ns() - t0) * 1e-9;
+    reap(pid);
+    close(sv[0]);
+    report("socketpair", "pingpong", 2L * PING_ROUNDS, 1, secs, lat);
+    free(lat);
+}
+
+int main(void) {
+    printf("transport,test,msgs,batch,msgs_per_s,p50_ns,p99_ns\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_shm();
+#endif
+
+    shm_stream(1);
+    sock_stream(1);
+    shm_stream(BATCH);
+    sock_stream(BATCH);
+    shm_pingpong();
+    sock_pingpong();
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_shm();
+#endif
+    return 0;
+}
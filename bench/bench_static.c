@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>   // for strncmp
+#include <omp.h>
+#include "queue.h"
+#include "queue_static.h"
+#include "utils.c"
+
+// Inlined vs opaque queue: DEFINE_QUEUE (queue_static.h) instances of
+// every policy against the MODE's Queue (from create, and from
+// create_pow2 so the ring masks match), with the same capacity.
+//   - seq:  one thread enqueues then dequeues each value (the run_once_seq
+//           pattern of bench_queue.c), where call overhead dominates
+//   - p1c1: one producer and one consumer thread, spinning on full/empty
+// Each row is the best of TRIALS runs; vs_queue is its throughput over
+// the `queue` row of the same workload.
+//
+//   make bench_static [MODE=...] [CFLAGS_EXTRA=-DSTATIC_CAP=64]
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// Capacity of every queue; a compile-time constant for the static ones
+#ifndef STATIC_CAP
+#define STATIC_CAP 1024
+#endif
+
+#ifndef SEQ_ITEMS
+#define SEQ_ITEMS (1 << 24)
+#endif
+
+#ifndef P1C1_ITEMS
+#define P1C1_ITEMS (1 << 21)
+#endif
+
+#ifndef TRIALS
+#define TRIALS 3
+#endif
+
+#ifndef CSV_ONLY
+#define USE_PRETTY_TABLE 1
+#endif
+
+DEFINE_QUEUE(static_seq, int, STATIC_CAP, seq)
+DEFINE_QUEUE(static_onelock, int, STATIC_CAP, onelock)
+DEFINE_QUEUE(static_twolock, int, STATIC_CAP, twolock)
+DEFINE_QUEUE(static_lockfree, int, STATIC_CAP, lockfree)
+
+// Dequeued values are summed into here so no loop can be optimized away
+static volatile long long sink;
+
+static void check_sum(long long sum, int items) {
+    if (sum != (long long)items * (items - 1) / 2) {
+        fprintf(stderr, "queue misbehaved (sum %lld)\n", sum);
+        exit(1);
+    }
+    sink = sum;
+}
+
+// run_once_seq / a P = C = 1 run for one DEFINE_QUEUE instance
+#define BENCH_SEQ(name)                                                         \
+    static double seq_##name(int items) {                                       \
+        static name q;                                                          \
+        name##_init(&q);                                                        \
+        long long sum = 0;                                                      \
+        int v;                                                                  \
+        double t0 = omp_get_wtime();                                            \
+        for (int i = 0; i < items; i++) {                                       \
+            while (!name##_enqueue(&q, i)) {}                                   \
+            while (!name##_dequeue(&q, &v)) {}                                  \
+            sum += v;                                                           \
+        }                                                                       \
+        double t1 = omp_get_wtime();                                            \
+        name##_destroy(&q);                                                     \
+        check_sum(sum, items);                                                  \
+        return t1 - t0;                                                         \
+    }
+
+#define BENCH_P1C1(name)                                                        \
+    static double p1c1_##name(int items) {                                      \
+        static name q;                                                          \
+        name##_init(&q);                                                        \
+        long long sum = 0;                                                      \
+        double t0 = omp_get_wtime();                                            \
+        _Pragma("omp parallel num_threads(2) shared(q, sum)")                   \
+        {                                                                       \
+            if (omp_get_thread_num() == 0) {                                    \
+                for (int i = 0; i < items; i++) {                               \
+                    while (!name##_enqueue(&q, i)) {}                           \
+                }                                                               \
+            } else {                                                            \
+                long long s = 0;                                                \
+                int v;                                                          \
+                for (int i = 0; i < items; i++) {                               \
+                    while (!name##_dequeue(&q, &v)) {}                          \
+                    s += v;                                                     \
+                }                                                               \
+                sum = s;                                                        \
+            }                                                                   \
+        }                                                                       \
+        double t1 = omp_get_wtime();                                            \
+        name##_destroy(&q);                                                     \
+        check_sum(sum, items);                                                  \
+        return t1 - t0;                                                         \
+    }
+
+BENCH_SEQ(static_seq)
+BENCH_SEQ(static_onelock)
+BENCH_SEQ(static_twolock)
+BENCH_SEQ(static_lockfree)
+BENCH_P1C1(static_onelock)
+BENCH_P1C1(static_twolock)
+BENCH_P1C1(static_lockfree)
+
+// The same two loops through the opaque API
+static Queue *opaque_create(int pow2) {
+    Queue *q = pow2 ? create_pow2(STATIC_CAP) : create(STATIC_CAP);
+    if (!q) {
+        fprintf(stderr, "Failed to create queue (cap=%d)\n", STATIC_CAP);
+        exit(1);
+    }
+    return q;
+}
+
+static double seq_queue(int items, int pow2) {
+    Queue *q = opaque_create(pow2);
+    long long sum = 0;
+    int v;
+    double t0 = omp_get_wtime();
+    for (int i = 0; i < items; i++) {
+        while (!enqueue(q, i)) {}
+        while (!dequeue(q, &v)) {}
+        sum += v;
+    }
+    double t1 = omp_get_wtime();
+    destroy(q);
+    check_sum(sum, items);
+    return t1 - t0;
+}
+
+static double p1c1_queue(int items, int pow2) {
+    Queue *q = opaque_create(pow2);
+    long long sum = 0;
+    double t0 = omp_get_wtime();
+    #pragma omp parallel num_threads(2) shared(q, sum)
+    {
+        if (omp_get_thread_num() == 0) {
+            for (int i = 0; i < items; i++) {
+                while (!enqueue(q, i)) {}
+            }
+        } else {
+            long long s = 0;
+            int v;
+            for (int i = 0; i < items; i++) {
+                while (!dequeue(q, &v)) {}
+                s += v;
+            }
+            sum = s;
+        }
+    }
+    double t1 = omp_get_wtime();
+    destroy(q);
+    check_sum(sum, items);
+    return t1 - t0;
+}
+
+static double seq_queue_plain(int items) { return seq_queue(items, 0); }
+static double seq_queue_pow2(int items) { return seq_queue(items, 1); }
+static double p1c1_queue_plain(int items) { return p1c1_queue(items, 0); }
+static double p1c1_queue_pow2(int items) { return p1c1_queue(items, 1); }
+
+typedef struct {
+    const char *variant;
+    double (*run)(int items);
+} Variant;
+
+// Best of TRIALS runs of each variant; the first one is the baseline
+static void run_workload(const char *workload, const Variant *vs, int n, int items) {
+    double base = 0;
+    for (int k = 0; k < n; k++) {
+        double best = 0;
+        for (int t = 0; t < TRIALS; t++) {
+            double secs = vs[k].run(items);
+            if (t == 0 || secs < best) best = secs;
+        }
+        double ops = items / best;
+        if (k == 0) base = ops;
+#ifdef USE_PRETTY_TABLE
+        print_row_static(vs[k].variant, workload, STATIC_CAP, items, ops, ops / base);
+#else
+        printf("%s,%s,%d,%d,%.1f,%.2f\n", vs[k].variant, workload, STATIC_CAP, items, ops,
+               ops / base);
+#endif
+    }
+}
+
+int main(void) {
+    static const Variant seq_variants[] = {
+        {"queue", seq_queue_plain},
+        {"queue_pow2", seq_queue_pow2},
+        {"static_seq", seq_static_seq},
+        {"static_onelock", seq_static_onelock},
+        {"static_twolock", seq_static_twolock},
+        {"static_lockfree", seq_static_lockfree},
+    };
+    static const Variant p1c1_variants[] = {
+        {"queue", p1c1_queue_plain},
+        {"queue_pow2", p1c1_queue_pow2},
+        {"static_onelock", p1c1_static_onelock},
+        {"static_twolock", p1c1_static_twolock},
+        {"static_lockfree", p1c1_static_lockfree},
+    };
+
+    printf("# queue = %s\n", IMPL_NAME);
+    printf("variant,workload,cap,items,ops_per_s,vs_queue\n");
+#ifdef USE_PRETTY_TABLE
+    print_header_static();
+#endif
+
+    run_workload("seq", seq_variants, sizeof(seq_variants) / sizeof(seq_variants[0]), SEQ_ITEMS);
+    // The sequential queue is not thread-safe: no P = C = 1 run
+    if (strncmp(IMPL_NAME, "seq", 3) != 0) {
+        run_workload("p1c1", p1c1_variants, sizeof(p1c1_variants) / sizeof(p1c1_variants[0]),
+                     P1C1_ITEMS);
+    }
+
+#ifdef USE_PRETTY_TABLE
+    print_footer_static();
+#endif
+    return 0;
+}
@@ -7,29 +7,86 @@ IMG_DIR = "imgs"
 
 os.makedirs(IMG_DIR, exist_ok=True)
 
+def read_section(path, section):
+    # bench_queue writes "# key: value" metadata, then each sweep after a
+    # "# section: <name>" line; files without section lines hold one table.
+    # A file may hold several runs (make bench_locks): rows of every section
+    # with this name are joined, keeping only the first header line
+    lines = []
+    current = None
+    header_next = False
+    with open(path, newline="", encoding="utf-8") as f:
+        for line in f:
+            if line.startswith("# section:"):
+                current = line.split(":", 1)[1].strip()
+                header_next = True
+            elif line.startswith("#") or not line.strip():
+                continue
+            elif current is None or current == section:
+                if header_next and lines:
+                    header_next = False
+                    continue
+                header_next = False
+                lines.append(line)
+    return list(csv.DictReader(lines))
+
 def load_csv(path):
     rows = []
-    with open(path, newline="", encoding="utf-16") as f:
-        reader = csv.DictReader(f)
-        for r in reader:
-            r["impl"] = r["impl"].strip()
-            r["cap"] = int(r["cap"])
-            r["P"] = int(r["P"])
-            r["C"] = int(r["C"])
-            r["items"] = int(r["items"])
-            r["trials"] = int(r["trials"])
-            r["time_avg_s"] = float(r["time_avg_s"])
-            r["time_min_s"] = float(r["time_min_s"])
-            r["time_max_s"] = float(r["time_max_s"])
-            r["throughput_avg_ops_per_s"] = float(r["throughput_avg_ops_per_s"])
-            rows.append(r)
+    for r in read_section(path, "throughput"):
+        r["impl"] = r["impl"].strip()
+        r["cap"] = int(r["cap"])
+        r["P"] = int(r["P"])
+        r["C"] = int(r["C"])
+        r["items"] = int(r["items"])
+        r["trials"] = int(r["trials"])
+        r["time_avg_s"] = float(r["time_avg_s"])
+        r["time_min_s"] = float(r["time_min_s"])
+        r["time_max_s"] = float(r["time_max_s"])
+        r["throughput_avg_ops_per_s"] = float(r["throughput_avg_ops_per_s"])
+        rows.append(r)
     return rows
 
 twolock = load_csv("csv/twolock.csv")
 onelock = load_csv("csv/onelock.csv")
 seq     = load_csv("csv/seq.csv")  # seq has P=C=0, one row per cap
 
+def load_optional_csv(path):
+    # Newer implementations may not have a CSV checked in yet
+    if not os.path.exists(path):
+        print("Skipping missing", path)
+        return []
+    return load_csv(path)
+
+lockfree = load_optional_csv("csv/lockfree.csv")
+spsc     = load_optional_csv("csv/spsc.csv")  # spsc only has P=C=1 rows
+sharded  = load_optional_csv("csv/sharded.csv")
+combining = load_optional_csv("csv/combining.csv")
+# make bench_locks: one throughput section per LOCK (impl twolock, twolock_ticket, ...)
+locks    = load_optional_csv("csv/locks_twolock.csv")
+
+def load_latency_cdf(path):
+    # CDF points from bench_latency (--format csv)
+    if not os.path.exists(path):
+        print("Skipping missing", path)
+        return []
+    rows = []
+    for r in read_section(path, "latency_cdf"):
+        rows.append({
+            "impl": r["impl"].strip(),
+            "cap": int(r["cap"]),
+            "P": int(r["P"]),
+            "C": int(r["C"]),
+            "percentile": float(r["percentile"]),
+            "lat_ns": float(r["lat_ns"]),
+        })
+    return rows
+
+latency = {name: load_latency_cdf(f"csv/latency_{name}.csv")
+           for name in ("twolock", "onelock", "lockfree", "sharded")}
+
 def filter_rows(rows, cap=None):
+    # The plots compare symmetric runs (C = P; seq has P = C = 0)
+    rows = [r for r in rows if r["P"] == r["C"]]
     if cap is None:
         return rows
     return [r for r in rows if r["cap"] == cap]
@@ -40,10 +97,12 @@ def filter_rows(rows, cap=None):
 def plot_throughput_vs_threads(cap=256):
     two = filter_rows(twolock, cap)
     one = filter_rows(onelock, cap)
+    lf  = filter_rows(lockfree, cap)
 
     # Sort by total threads
     two.sort(key=lambda r: r["P"] + r["C"])
     one.sort(key=lambda r: r["P"] + r["C"])
+    lf.sort(key=lambda r: r["P"] + r["C"])
 
     threads_two = [r["P"] + r["C"] for r in two]
     thr_two     = [r["throughput_avg_ops_per_s"] for r in two]
@@ -51,9 +110,14 @@ def plot_throughput_vs_threads(cap=256):
     threads_one = [r["P"] + r["C"] for r in one]
     thr_one     = [r["throughput_avg_ops_per_s"] for r in one]
 
+    threads_lf = [r["P"] + r["C"] for r in lf]
+    thr_lf     = [r["throughput_avg_ops_per_s"] for r in lf]
+
     plt.figure()
     plt.plot(threads_two, thr_two, marker="o", label="twolock")
     plt.plot(threads_one, thr_one, marker="o", label="onelock")
+    if lf:
+        plt.plot(threads_lf, thr_lf, marker="o", label="lockfree")
     plt.xlabel("Total threads (P + C)")
     plt.ylabel("Throughput (ops/s)")
     plt.title(f"Throughput vs Threads (cap={cap})")
@@ -69,9 +133,10 @@ def plot_throughput_vs_threads(cap=256):
 # 2) Speedup vs baseline (twolock & onelock, cap=256, P=1,C=1)
 # --------------------------------------------------------
 def plot_speedup_vs_threads(cap=256):
-    # twolock and onelock rows for this capacity
+    # twolock, onelock and lockfree rows for this capacity
     two = filter_rows(twolock, cap)
     one = filter_rows(onelock, cap)
+    lf  = filter_rows(lockfree, cap)
 
     # sequential baseline row for this capacity (P=0,C=0)
     seq_rows = [r for r in seq if r["cap"] == cap]
@@ -110,9 +175,19 @@ def plot_speedup_vs_threads(cap=256):
         Ps_one.append(P)
         speed_one.append(T_seq / T_par if T_par > 0 else float("nan"))
 
+    # Compute speedup vs sequential for lockfree
+    lf.sort(key=lambda r: r["P"])
+    Ps_lf = [r["P"] for r in lf]
+    speed_lf = []
+    for r in lf:
+        T_par = runtime_parallel(r)
+        speed_lf.append(T_seq / T_par if T_par > 0 else float("nan"))
+
     plt.figure()
     plt.plot(Ps_two, speed_two, marker="o", label="twolock (vs seq)")
     plt.plot(Ps_one, speed_one, marker="o", label="onelock (vs seq)")
+    if lf:
+        plt.plot(Ps_lf, speed_lf, marker="o", label="lockfree (vs seq)")
 
     # optional: horizontal line at 1.0 = same speed as sequential
     plt.axhline(1.0, linestyle="--", color="gray", label="same as seq")
@@ -136,6 +211,7 @@ def plot_throughput_vs_cap(P_fixed=4):
     caps = sorted({r["cap"] for r in twolock})
     thr_two = []
     thr_one = []
+    thr_lf = []
 
     for cap in caps:
         # pick row with given P_fixed
@@ -152,9 +228,14 @@ def plot_throughput_vs_cap(P_fixed=4):
         else:
             thr_one.append(float("nan"))
 
+        r_lf = next((r for r in lockfree if r["cap"] == cap and r["P"] == P_fixed and r["C"] == P_fixed), None)
+        thr_lf.append(r_lf["throughput_avg_ops_per_s"] if r_lf is not None else float("nan"))
+
     plt.figure()
     plt.plot(caps, thr_two, marker="o", label=f"twolock (P=C={P_fixed})")
     plt.plot(caps, thr_one, marker="o", label=f"onelock (P=C={P_fixed})")
+    if lockfree:
+        plt.plot(caps, thr_lf, marker="o", label=f"lockfree (P=C={P_fixed})")
     plt.xlabel("Capacity (cap)")
     plt.ylabel("Throughput (ops/s)")
     plt.title(f"Throughput vs Capacity (P=C={P_fixed})")
@@ -166,9 +247,178 @@ def plot_throughput_vs_cap(P_fixed=4):
     plt.close()
     print("Saved:", out)
 
+# --------------------------------------------------------
+# 4) Single producer / single consumer: throughput vs cap at P=C=1
+# --------------------------------------------------------
+def plot_spsc_vs_cap():
+    caps = sorted({r["cap"] for r in twolock})
+
+    def thr_at(rows, cap, P):
+        r = next((r for r in rows if r["cap"] == cap and r["P"] == P), None)
+        return r["throughput_avg_ops_per_s"] if r is not None else float("nan")
+
+    plt.figure()
+    plt.plot(caps, [thr_at(seq, c, 0) for c in caps], marker="o", label="sequential")
+    plt.plot(caps, [thr_at(twolock, c, 1) for c in caps], marker="o", label="twolock (P=C=1)")
+    if lockfree:
+        plt.plot(caps, [thr_at(lockfree, c, 1) for c in caps], marker="o", label="lockfree (P=C=1)")
+    if spsc:
+        plt.plot(caps, [thr_at(spsc, c, 1) for c in caps], marker="o", label="spsc (P=C=1)")
+    plt.xlabel("Capacity (cap)")
+    plt.ylabel("Throughput (ops/s)")
+    plt.yscale("log")
+    plt.title("Throughput vs Capacity (P=C=1)")
+    plt.grid(True)
+    plt.legend()
+    plt.tight_layout()
+    out = os.path.join(IMG_DIR, "throughput_vs_cap_P1.png")
+    plt.savefig(out)
+    plt.close()
+    print("Saved:", out)
+
+# --------------------------------------------------------
+# 5) Scaling up to 32 threads: throughput vs P+C, log2 x axis
+# --------------------------------------------------------
+def plot_scaling(cap=1024):
+    impls = [("twolock", twolock), ("onelock", onelock),
+             ("lockfree", lockfree), ("sharded", sharded),
+             ("combining", combining)]
+
+    plt.figure()
+    for name, rows in impls:
+        rows = sorted(filter_rows(rows, cap), key=lambda r: r["P"] + r["C"])
+        if not rows:
+            continue
+        threads = [r["P"] + r["C"] for r in rows]
+        thr     = [r["throughput_avg_ops_per_s"] for r in rows]
+        plt.plot(threads, thr, marker="o", label=name)
+    plt.xscale("log", base=2)
+    plt.xticks([2, 4, 8, 16, 32], ["2", "4", "8", "16", "32"])
+    plt.xlabel("Total threads (P + C)")
+    plt.ylabel("Throughput (ops/s)")
+    plt.title(f"Scaling up to 32 threads (cap={cap})")
+    plt.grid(True)
+    plt.legend()
+    plt.tight_layout()
+    out = os.path.join(IMG_DIR, f"scaling_cap{cap}.png")
+    plt.savefig(out)
+    plt.close()
+    print("Saved:", out)
+
+# --------------------------------------------------------
+# 6) Latency CDF: enqueue-to-dequeue latency by percentile, with the
+#    x axis stretched toward the tail (50%, 90%, 99%, 99.9%)
+# --------------------------------------------------------
+def plot_latency_cdf(cap=1024, P=4):
+    plt.figure()
+    plotted = False
+    for name, rows in latency.items():
+        rows = sorted((r for r in rows if r["cap"] == cap and r["P"] == P and r["C"] == P
+                       and r["percentile"] < 100.0),
+                      key=lambda r: r["percentile"])
+        if not rows:
+            continue
+        x = [1.0 / (1.0 - r["percentile"] / 100.0) for r in rows]
+        y = [r["lat_ns"] / 1e3 for r in rows]
+        plt.plot(x, y, marker=".", label=name)
+        plotted = True
+    if not plotted:
+        plt.close()
+        print("No latency rows for cap", cap, "P", P)
+        return
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.xticks([2, 10, 100, 1000], ["50%", "90%", "99%", "99.9%"])
+    plt.xlabel("Percentile")
+    plt.ylabel("Enqueue-to-dequeue latency (us)")
+    plt.title(f"Latency CDF (cap={cap}, P=C={P})")
+    plt.grid(True, which="both")
+    plt.legend()
+    plt.tight_layout()
+    out = os.path.join(IMG_DIR, f"latency_cdf_cap{cap}_P{P}.png")
+    plt.savefig(out)
+    plt.close()
+    print("Saved:", out)
+
+# --------------------------------------------------------
+# 7) Lock strategies: twolock throughput vs P+C for each LOCK
+# --------------------------------------------------------
+def plot_locks(cap=1024):
+    names = sorted({r["impl"] for r in locks})
+    if not names:
+        print("No lock matrix rows (make -s bench_locks > bench/csv/locks_twolock.csv)")
+        return
+    plt.figure()
+    for name in names:
+        rows = sorted((r for r in filter_rows(locks, cap) if r["impl"] == name),
+                      key=lambda r: r["P"] + r["C"])
+        if not rows:
+            continue
+        threads = [r["P"] + r["C"] for r in rows]
+        thr     = [r["throughput_avg_ops_per_s"] for r in rows]
+        # the default build has no suffix
+        label = name.split("_", 1)[1] if "_" in name else "omp"
+        plt.plot(threads, thr, marker="o", label=label)
+    plt.xscale("log", base=2)
+    plt.xticks([2, 4, 8, 16, 32], ["2", "4", "8", "16", "32"])
+    plt.xlabel("Total threads (P + C)")
+    plt.ylabel("Throughput (ops/s)")
+    plt.title(f"twolock by lock strategy (cap={cap})")
+    plt.grid(True)
+    plt.legend()
+    plt.tight_layout()
+    out = os.path.join(IMG_DIR, f"locks_cap{cap}.png")
+    plt.savefig(out)
+    plt.close()
+    print("Saved:", out)
+
+# --------------------------------------------------------
+# 8) Flat combining under contention: throughput at P + C = 8 and 16
+#    next to the single-lock and two-lock rings it is built from
+# --------------------------------------------------------
+def plot_combining(cap=1024, threads=(8, 16)):
+    if not combining:
+        print("No combining rows (./bin/bench_combining --format csv > bench/csv/combining.csv)")
+        return
+    impls = [("onelock", onelock), ("twolock", twolock),
+             ("lockfree", lockfree), ("combining", combining)]
+    impls = [(name, rows) for name, rows in impls if rows]
+    width = 0.8 / len(impls)
+
+    plt.figure()
+    for k, (name, rows) in enumerate(impls):
+        by_threads = {r["P"] + r["C"]: r["throughput_avg_ops_per_s"]
+                      for r in filter_rows(rows, cap)}
+        x = [i + k * width for i in range(len(threads))]
+        y = [by_threads.get(t, 0.0) for t in threads]
+        plt.bar(x, y, width, label=name)
+    plt.xticks([i + width * (len(impls) - 1) / 2 for i in range(len(threads))],
+               [str(t) for t in threads])
+    plt.xlabel("Total threads (P + C)")
+    plt.ylabel("Throughput (ops/s)")
+    plt.title(f"Flat combining under contention (cap={cap})")
+    plt.grid(True, axis="y")
+    plt.legend()
+    plt.tight_layout()
+    out = os.path.join(IMG_DIR, f"combining_cap{cap}.png")
+    plt.savefig(out)
+    plt.close()
+    print("Saved:", out)
+
 if __name__ == "__main__":
     # Pick a representative capacity (say 256) for first two plots
     plot_throughput_vs_threads(cap=256)
     plot_speedup_vs_threads(cap=256)
     # Throughput vs cap, e.g. P=C=4
     plot_throughput_vs_cap(P_fixed=4)
+    # Single producer / single consumer comparison
+    plot_spsc_vs_cap()
+    # Multi-lane vs single-ring scaling up to P + C = 32
+    plot_scaling(cap=1024)
+    # Tail latency from make bench_latency (csv/latency_<impl>.csv)
+    plot_latency_cdf(cap=1024, P=4)
+    plot_latency_cdf(cap=64, P=1)
+    # Lock strategies from make bench_locks (csv/locks_twolock.csv)
+    plot_locks(cap=1024)
+    # Flat combining vs the locked rings (csv/combining.csv)
+    plot_combining(cap=1024)
@@ -0,0 +1,269 @@
+// bcast.c
+#define _GNU_SOURCE
+#include "bcast.h"
+#include "ring.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <time.h>
+
+#define CACHE_LINE 64
+
+// Failed attempts before a waiting caller starts yielding the CPU
+#ifndef WAIT_SPIN_LIMIT
+#define WAIT_SPIN_LIMIT 128
+#endif
+
+// Internal representation: one ring of `slots` (power of two) entries and
+// 64-bit sequence numbers that only grow; message s lives in slot
+// s & mask.
+//   - claim is the next sequence to hand out. A producer claims s with a
+//     CAS once s - (slowest consumer's cursor) < capacity, writes the
+//     value, then stores s in the slot's seq (release): that store is the
+//     publication, so producers finish out of order without waiting for
+//     each other.
+//   - every consumer's cursor is the next sequence it reads. Message s is
+//     available to it once slot[s & mask].seq == s and, for a pipeline
+//     stage, once the upstream consumer's cursor is past s. The cursor
+//     moves (release) only after the value was read, so a producer never
+//     overwrites a slot somebody still has to read.
+// The slowest cursor is cached on the producers' line and only recomputed
+// when the cached one says the ring is full.
+// Waiting callers spin briefly, then yield the CPU between attempts
+// (the Disruptor's yielding wait strategy); nothing sleeps in the kernel.
+
+typedef struct {
+    _Atomic int64_t seq;   // sequence last published here, -1 before the first
+    int value;
+} Slot;
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic int64_t cursor;   // next sequence to read
+    int after;                                     // upstream consumer, or -1
+} Consumer;
+
+struct Bcast {
+    // Producers' end
+    _Alignas(CACHE_LINE) _Atomic int64_t claim;
+    _Atomic int64_t gate;   // cached slowest cursor
+
+    // Read-only after create (nconsumers: until the first publish)
+    _Alignas(CACHE_LINE) Slot *ring;
+    int64_t capacity;
+    int64_t mask;
+    int max_consumers;
+    _Atomic int nconsumers;
+    Consumer *consumers;
+};
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Spin for the first WAIT_SPIN_LIMIT attempts, then yield
+static inline void backoff(int *spins) {
+    if (*spins < WAIT_SPIN_LIMIT) {
+        (*spins)++;
+        cpu_relax();
+    } else {
+        sched_yield();
+    }
+}
+
+Bcast* bcast_create(int capacity, int max_consumers) {
+    //Edge case: capacity or max_consumers <= 0, or capacity too large to round up
+    if (capacity <= 0 || max_consumers <= 0 || capacity > INT_MAX / 2) return NULL;
+
+    //Allocate the struct so the producers' counters get their own cache line
+    Bcast *b = (Bcast *)aligned_alloc(CACHE_LINE, sizeof(Bcast));
+    //Edge case: allocation fails
+    if (!b) return NULL;
+
+    size_t slots = ring_round_pow2((size_t)capacity);
+    b->ring = (Slot *)malloc(slots * sizeof(Slot));
+    b->consumers = (Consumer *)aligned_alloc(CACHE_LINE,
+                                             (size_t)max_consumers * sizeof(Consumer));
+    if (!b->ring || !b->consumers) {
+        free(b->ring);
+        free(b->consumers);
+        free(b);
+        return NULL;
+    }
+
+    //Initialize the ring: no slot holds a published message yet
+    for (size_t i = 0; i < slots; i++) {
+        atomic_init(&b->ring[i].seq, -1);
+        b->ring[i].value = 0;
+    }
+    for (int i = 0; i < max_consumers; i++) {
+        atomic_init(&b->consumers[i].cursor, 0);
+        b->consumers[i].after = -1;
+    }
+
+    atomic_init(&b->claim, 0);
+    atomic_init(&b->gate, 0);
+    b->capacity = capacity;
+    b->mask = (int64_t)slots - 1;
+    b->max_consumers = max_consumers;
+    atomic_init(&b->nconsumers, 0);
+    return b;
+}
+
+void bcast_destroy(Bcast *b) {
+    //Edge case: b is NULL
+    if (!b) return;
+    free(b->ring);
+    free(b->consumers);
+    free(b);
+}
+
+int bcast_subscribe(Bcast *b, int after) {
+    //Edge case: b is NULL
+    if (!b) return -1;
+    //Edge case: publishing has started, the new cursor would be behind
+    if (atomic_load_explicit(&b->claim, memory_order_acquire) != 0) return -1;
+
+    int n = atomic_load_explicit(&b->nconsumers, memory_order_relaxed);
+    do {
+        //Edge case: no room for another consumer
+        if (n >= b->max_consumers) return -1;
+        //Edge case: `after` is not a registered consumer
+        if (after < -1 || after >= n) return -1;
+        // The new consumer's cursor is already 0 (bcast_create), so the
+        // producers may gate on it as soon as the count includes it
+    } while (!atomic_compare_exchange_weak_explicit(&b->nconsumers, &n, n + 1,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+    b->consumers[n].after = after;
+    return n;
+}
+
+// Slowest cursor over every consumer; with none, everything claimed
+// counts as consumed
+static int64_t slowest_cursor(Bcast *b, int64_t claimed) {
+    int n = atomic_load_explicit(&b->nconsumers, memory_order_acquire);
+    int64_t min = claimed;
+    for (int i = 0; i < n; i++) {
+        int64_t c = atomic_load_explicit(&b->consumers[i].cursor, memory_order_acquire);
+        if (c < min) min = c;
+    }
+    return min;
+}
+
+bool bcast_publish(Bcast *b, int value) {
+    //Edge case: b is NULL
+    if (!b) return false;
+
+    int64_t s = atomic_load_explicit(&b->claim, memory_order_relaxed);
+    do {
+        // Full by the cached gate: recompute it before giving up
+        int64_t gate = atomic_load_explicit(&b->gate, memory_order_relaxed);
+        if (s - gate >= b->capacity) {
+            gate = slowest_cursor(b, s);
+            atomic_store_explicit(&b->gate, gate, memory_order_relaxed);
+            //Edge case: the slowest consumer is a whole ring behind
+            if (s - gate >= b->capacity) return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&b->claim, &s, s + 1,
+                                                    memory_order_acq_rel,
+                                                    memory_order_relaxed));
+
+    // Sequence s is ours: fill the slot, then publish it
+    Slot *slot = &b->ring[s & b->mask];
+    slot->value = value;
+    atomic_store_explicit(&slot->seq, s, memory_order_release);
+    return true;
+}
+
+bool bcast_publish_wait(Bcast *b, int value) {
+    //Edge case: b is NULL
+    if (!b) return false;
+    int spins = 0;
+    while (!bcast_publish(b, value)) backoff(&spins);
+    return true;
+}
+
+int bcast_consume_bulk(Bcast *b, int c, int *out, int max) {
+    //Edge case: b/out is NULL or max <= 0
+    if (!b || !out || max <= 0) return 0;
+    //Edge case: c is not a registered consumer
+    if (c < 0 || c >= atomic_load_explicit(&b->nconsumers, memory_order_acquire)) return 0;
+
+    Consumer *me = &b->consumers[c];
+    int64_t next = atomic_load_explicit(&me->cursor, memory_order_relaxed);
+
+    // A pipeline stage stays behind its upstream consumer
+    int64_t limit = next + max;
+    if (me->after >= 0) {
+        int64_t up = atomic_load_explicit(&b->consumers[me->after].cursor,
+                                          memory_order_acquire);
+        if (up < limit) limit = up;
+    }
+
+    // Take published messages in order, up to the first gap
+    int n = 0;
+    for (int64_t s = next; s < limit; s++, n++) {
+        const Slot *slot = &b->ring[s & b->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != s) break;
+        out[n] = slot->value;
+    }
+
+    //Edge case: nothing new yet
+    if (n == 0) return 0;
+    // Hand the slots back (and the messages on to dependent stages)
+    atomic_store_explicit(&me->cursor, next + n, memory_order_release);
+    return n;
+}
+
+bool bcast_consume(Bcast *b, int c, int *out) {
+    return bcast_consume_bulk(b, c, out, 1) == 1;
+}
+
+bool bcast_consume_wait_timeout(Bcast *b, int c, int *out, int timeout_ms) {
+    //Edge case: invalid arguments never succeed, don't wait for them
+    if (!b || !out || c < 0 || c >= bcast_consumers(b)) return false;
+
+    long long deadline = (timeout_ms > 0) ? now_ns() + (long long)timeout_ms * 1000000LL : -1;
+    int spins = 0;
+    for (;;) {
+        if (bcast_consume(b, c, out)) return true;
+        //Edge case: caller asked not to wait, or the time is up
+        if (timeout_ms == 0) return false;
+        if (deadline >= 0 && now_ns() >= deadline) return false;
+        backoff(&spins);
+    }
+}
+
+bool bcast_consume_wait(Bcast *b, int c, int *out) {
+    return bcast_consume_wait_timeout(b, c, out, -1);
+}
+
+long long bcast_cursor(const Bcast *b, int c) {
+    if (!b || c < 0 || c >= bcast_consumers(b)) return -1;
+    return (long long)atomic_load_explicit(&b->consumers[c].cursor, memory_order_acquire);
+}
+
+int bcast_consumers(const Bcast *b) {
+    if (!b) return 0;
+    return atomic_load_explicit(&b->nconsumers, memory_order_acquire);
+}
+
+int bcast_capacity(const Bcast *b) {
+    if (!b) return 0;
+    return (int)b->capacity;
+}
@@ -0,0 +1,103 @@
+//bcast.h
+#ifndef BCAST_H
+#define BCAST_H
+
+#include <stdbool.h>
+
+// Broadcast ring of ints (LMAX Disruptor style): every message published
+// is seen by every subscribed consumer, in publish order, from a single
+// sequence-numbered buffer. Each consumer has its own cursor; producers
+// are gated by the slowest consumer, and a consumer can follow another
+// one's cursor to form a pipeline. Any number of producers may publish
+// concurrently. Built in every MODE, independent of the Queue.
+
+typedef struct Bcast Bcast;
+
+/**
+ * Create a broadcast ring holding up to `capacity` unconsumed messages
+ * (the ring is rounded up to a power of two internally), with room for
+ * up to `max_consumers` subscribers.
+ * Returns NULL on failure or if capacity <= 0 or max_consumers <= 0.
+ */
+Bcast* bcast_create(int capacity, int max_consumers);
+
+/**
+ * Free all memory associated with the ring.
+ * Safe to call with NULL (no-op).
+ */
+void bcast_destroy(Bcast *b);
+
+/**
+ * Register a consumer and return its id (0, 1, ... in subscription
+ * order). It receives every message published from now on.
+ * With after >= 0 the consumer depends on consumer `after`: it only gets
+ * a message once `after` has consumed it (a pipeline stage). Use -1 to
+ * depend on the producers only.
+ * Subscribe every consumer before the first publish; messages published
+ * while there are no consumers go to nobody.
+ * Returns -1 if publishing has started, max_consumers are registered,
+ * `after` is not a registered consumer, or b is NULL.
+ */
+int bcast_subscribe(Bcast *b, int after);
+
+/**
+ * Publish value to every consumer.
+ * Returns true on success, false if the slowest consumer is `capacity`
+ * messages behind or b is NULL.
+ */
+bool bcast_publish(Bcast *b, int value);
+
+/**
+ * Publish value, waiting while the ring is full (spin, then yield the
+ * CPU until the slowest consumer moves on).
+ * Returns false only if b is NULL.
+ */
+bool bcast_publish_wait(Bcast *b, int value);
+
+/**
+ * Consumer `c` takes its next message into *out.
+ * Only one thread may consume as a given consumer at a time.
+ * Returns true on success, false if nothing new is available to c (yet),
+ * c is not a registered consumer, or b/out is NULL.
+ */
+bool bcast_consume(Bcast *b, int c, int *out);
+
+/**
+ * Consumer `c` takes up to max available messages into out[0..max-1],
+ * in publish order, advancing its cursor once for the whole batch.
+ * Returns the number of messages taken: 0 if nothing is available, c is
+ * not a registered consumer, b/out is NULL or max <= 0.
+ */
+int bcast_consume_bulk(Bcast *b, int c, int *out, int max);
+
+/**
+ * bcast_consume, waiting while nothing is available (spin, then yield).
+ * Returns false only if c is not a registered consumer or b/out is NULL.
+ */
+bool bcast_consume_wait(Bcast *b, int c, int *out);
+
+/**
+ * bcast_consume_wait, giving up after timeout_ms milliseconds
+ * (0: try once).
+ * Returns true on success, false on timeout or invalid arguments.
+ */
+bool bcast_consume_wait_timeout(Bcast *b, int c, int *out, int timeout_ms);
+
+/**
+ * Number of messages consumer c has taken so far.
+ * If c is not a registered consumer or b is NULL, returns -1.
+ */
+long long bcast_cursor(const Bcast *b, int c);
+
+/**
+ * Number of registered consumers. If b is NULL, returns 0.
+ */
+int bcast_consumers(const Bcast *b);
+
+/**
+ * Maximum number of unconsumed messages the ring holds.
+ * If b is NULL, returns 0.
+ */
+int bcast_capacity(const Bcast *b);
+
+#endif // BCAST_H
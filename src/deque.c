@@ -0,0 +1,201 @@
+// deque.c
+#include "deque.h"
+#include "ring.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+// Internal representation: Chase-Lev deque with the C11 orderings of
+// Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing
+// for Weak Memory Models" (PPoPP 2013).
+//
+// top and bottom are signed 64-bit counters that only grow (bottom moves
+// back by one during a pop); value i lives in slot i & mask of the current
+// array. The owner works at bottom, thieves at top:
+//   - push: plain store of the value, release fence, relaxed bottom store
+//   - pop: bottom-1, seq_cst fence, then read top; a CAS on top is needed
+//     only when taking the last value, which a thief may be racing for
+//   - steal: read top, seq_cst fence, read bottom, CAS top forward
+// Growth copies the live range into an array twice the size. Thieves may
+// still be reading the old array, so it is kept (linked from the new one)
+// and freed by deque_destroy; the arrays add up to less than twice the
+// final one.
+
+typedef struct Array {
+    struct Array *prev;   // array this one replaced (freed on destroy)
+    int64_t size;         // power of two
+    int64_t mask;         // size - 1
+    _Atomic int buf[];    // slots; relaxed accesses, ordered by the fences
+} Array;
+
+struct Deque {
+    // Thieves' end
+    _Alignas(CACHE_LINE) _Atomic int64_t top;
+
+    // Owner's end
+    _Alignas(CACHE_LINE) _Atomic int64_t bottom;
+    _Atomic(Array *) array;
+};
+
+static Array *array_new(int64_t size, Array *prev) {
+    Array *a = (Array *)malloc(sizeof(Array) + sizeof(_Atomic int) * (size_t)size);
+    //Edge case: allocation fails
+    if (!a) return NULL;
+    a->prev = prev;
+    a->size = size;
+    a->mask = size - 1;
+    return a;
+}
+
+static inline int array_get(Array *a, int64_t i) {
+    return atomic_load_explicit(&a->buf[i & a->mask], memory_order_relaxed);
+}
+
+static inline void array_put(Array *a, int64_t i, int value) {
+    atomic_store_explicit(&a->buf[i & a->mask], value, memory_order_relaxed);
+}
+
+// Owner only: copy values [t, b) into an array twice as large and make it
+// current. The old array stays readable for in-flight thieves.
+static Array *grow(Deque *d, Array *a, int64_t t, int64_t b) {
+    //Edge case: the slot count would no longer fit deque_capacity's int
+    if (a->size > INT_MAX / 2) return NULL;
+    Array *na = array_new(a->size * 2, a);
+    if (!na) return NULL;
+    for (int64_t i = t; i < b; i++) array_put(na, i, array_get(a, i));
+    atomic_store_explicit(&d->array, na, memory_order_release);
+    return na;
+}
+
+Deque* deque_create(int capacity) {
+    //Edge case: capacity <= 0 or too large to round up
+    if (capacity <= 0 || capacity > INT_MAX / 2) return NULL;
+
+    //Allocate the deque struct so top and bottom get their own cache lines
+    Deque *d = (Deque *)aligned_alloc(CACHE_LINE, sizeof(Deque));
+    //Edge case: allocation fails
+    if (!d) return NULL;
+
+    Array *a = array_new((int64_t)ring_round_pow2((size_t)capacity), NULL);
+    if (!a) {
+        free(d);
+        return NULL;
+    }
+
+    //Initialize the deque fields
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, a);
+    return d;
+}
+
+void deque_destroy(Deque *d) {
+    //Edge case: d is NULL
+    if (!d) return;
+
+    //Free the current array and every array it replaced
+    Array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    while (a) {
+        Array *prev = a->prev;
+        free(a);
+        a = prev;
+    }
+    //Free the deque struct
+    free(d);
+}
+
+bool deque_push(Deque *d, int value) {
+    //Edge case: d is NULL
+    if (!d) return false;
+
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    Array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+
+    //Edge case: array is full, double it
+    if (b - t > a->mask) {
+        a = grow(d, a, t, b);
+        if (!a) return false;
+    }
+
+    // Store the value, then publish it to thieves by moving bottom
+    array_put(a, b, value);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+bool deque_pop(Deque *d, int *out) {
+    //Edge case: d or out is NULL
+    if (!d || !out) return false;
+
+    // Claim the bottom value first, then see whether thieves got there
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    Array *a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    //Edge case: deque was empty, undo the claim
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    int value = array_get(a, b);
+    if (t == b) {
+        // Last value: a thief may be racing for it, settle with a CAS on top
+        bool won = atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        if (!won) return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+bool deque_steal(Deque *d, int *out) {
+    //Edge case: d or out is NULL
+    if (!d || !out) return false;
+
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+
+    //Edge case: deque is empty
+    if (t >= b) return false;
+
+    // Read the value before claiming it: once top moves, the owner may
+    // overwrite the slot
+    Array *a = atomic_load_explicit(&d->array, memory_order_acquire);
+    int value = array_get(a, t);
+    if (!atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        // Lost the race to another thief or to the owner's pop
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+int deque_size(const Deque *d) {
+    if (!d) return 0;
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    // bottom dips below top for a moment while the owner pops an empty deque
+    return b > t ? (int)(b - t) : 0;
+}
+
+int deque_capacity(const Deque *d) {
+    if (!d) return 0;
+    Array *a = atomic_load_explicit(&d->array, memory_order_acquire);
+    return (int)a->size;
+}
@@ -0,0 +1,61 @@
+//deque.h
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <stdbool.h>
+
+// Chase-Lev work-stealing deque of ints (task ids/indices), for worker
+// pools where tasks spawn subtasks. One owner thread pushes and pops at
+// the bottom (LIFO, no atomic read-modify-write except when taking the
+// last element); any number of thief threads steal from the top (FIFO,
+// one CAS per steal). Built in every MODE, independent of the Queue.
+
+typedef struct Deque Deque;
+
+/**
+ * Create a new deque with room for `capacity` values before it first
+ * grows (rounded up to a power of two). The deque grows without bound.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Deque* deque_create(int capacity);
+
+/**
+ * Free all memory associated with the deque (including arrays left
+ * behind by growth). Safe to call with NULL (no-op).
+ */
+void deque_destroy(Deque *d);
+
+/**
+ * Owner only: push value at the bottom, doubling the array if it is full.
+ * Returns true on success, false if growing fails or d is NULL.
+ */
+bool deque_push(Deque *d, int value);
+
+/**
+ * Owner only: pop the most recently pushed value into *out (LIFO).
+ * Returns true on success, false if the deque is empty (or a thief took
+ * the last value first) or d/out is NULL.
+ */
+bool deque_pop(Deque *d, int *out);
+
+/**
+ * Any thread: steal the oldest value into *out (FIFO).
+ * Returns true on success, false if the deque is empty, another thread
+ * won the race for the value (just try again or elsewhere), or d/out is
+ * NULL.
+ */
+bool deque_steal(Deque *d, int *out);
+
+/**
+ * Current number of values in the deque; approximate while other
+ * threads are using it. If d is NULL, returns 0.
+ */
+int deque_size(const Deque *d);
+
+/**
+ * Number of values the deque holds before it next grows.
+ * If d is NULL, returns 0.
+ */
+int deque_capacity(const Deque *d);
+
+#endif // DEQUE_H
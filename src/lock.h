@@ -0,0 +1,262 @@
+// lock.h
+// Internal helper shared by the lock-based implementations (queue.c,
+// queue_v1.c, queue_sharded.c, queue_segmented.c, queue_combining.c): one
+// lock type, QLock, whose strategy is picked at compile time (make LOCK=...):
+//   QLOCK_OMP          omp_lock_t (default; a futex-backed mutex in libgomp)
+//   QLOCK_PTHREAD      pthread_mutex_t
+//   QLOCK_TICKET       ticket lock: FIFO hand-off, one shared cache line
+//   QLOCK_MCS          MCS queue lock: FIFO, each waiter spins on its own node
+//   QLOCK_TAS_BACKOFF  test-and-test-and-set with exponential backoff
+// With any strategy but omp, queue.c and queue_v1.c need no OpenMP
+// runtime. Spinning strategies yield the CPU after LOCK_SPIN_LIMIT spins,
+// so an oversubscribed machine still makes progress. Not part of the
+// public API.
+#ifndef LOCK_H
+#define LOCK_H
+
+#include <stdbool.h>
+
+#if !defined(QLOCK_OMP) && !defined(QLOCK_PTHREAD) && !defined(QLOCK_TICKET) && \
+    !defined(QLOCK_MCS) && !defined(QLOCK_TAS_BACKOFF)
+#define QLOCK_OMP
+#endif
+
+#include <sched.h>
+#if defined(QLOCK_OMP)
+#include <omp.h>
+#elif defined(QLOCK_PTHREAD)
+#include <pthread.h>
+#else
+#include <stdatomic.h>
+#endif
+
+// Spins (pause hints) before a waiting thread starts yielding
+#ifndef LOCK_SPIN_LIMIT
+#define LOCK_SPIN_LIMIT 256
+#endif
+
+// Also used by code that polls a flag next to the lock (queue_combining.c)
+static inline void lock_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// One step of a spin-wait: a pause hint, or a yield once *spins is past
+// LOCK_SPIN_LIMIT (the holder may not be running)
+static inline void lock_relax(unsigned *spins) {
+    if (++*spins > LOCK_SPIN_LIMIT) {
+        sched_yield();
+        return;
+    }
+    lock_pause();
+}
+
+// ---------------------------------------------------------------------
+// omp_lock_t
+// ---------------------------------------------------------------------
+#if defined(QLOCK_OMP)
+
+typedef omp_lock_t QLock;
+
+static inline void qlock_init(QLock *l) { omp_init_lock(l); }
+static inline void qlock_destroy(QLock *l) { omp_destroy_lock(l); }
+static inline void qlock_acquire(QLock *l) { omp_set_lock(l); }
+static inline bool qlock_try(QLock *l) { return omp_test_lock(l) != 0; }
+static inline void qlock_release(QLock *l) { omp_unset_lock(l); }
+
+// ---------------------------------------------------------------------
+// pthread_mutex_t
+// ---------------------------------------------------------------------
+#elif defined(QLOCK_PTHREAD)
+
+typedef pthread_mutex_t QLock;
+
+static inline void qlock_init(QLock *l) { pthread_mutex_init(l, NULL); }
+static inline void qlock_destroy(QLock *l) { pthread_mutex_destroy(l); }
+static inline void qlock_acquire(QLock *l) { pthread_mutex_lock(l); }
+static inline bool qlock_try(QLock *l) { return pthread_mutex_trylock(l) == 0; }
+static inline void qlock_release(QLock *l) { pthread_mutex_unlock(l); }
+
+// ---------------------------------------------------------------------
+// Ticket lock: take a number, wait until it is served
+// ---------------------------------------------------------------------
+#elif defined(QLOCK_TICKET)
+
+typedef struct {
+    atomic_uint next;      // next ticket to hand out
+    atomic_uint serving;   // ticket that holds the lock
+} QLock;
+
+static inline void qlock_init(QLock *l) {
+    atomic_init(&l->next, 0);
+    atomic_init(&l->serving, 0);
+}
+
+static inline void qlock_destroy(QLock *l) { (void)l; }
+
+static inline void qlock_acquire(QLock *l) {
+    unsigned me = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+    unsigned spins = 0;
+    while (atomic_load_explicit(&l->serving, memory_order_acquire) != me) lock_relax(&spins);
+}
+
+static inline bool qlock_try(QLock *l) {
+    // Free only if nobody holds or waits for a ticket
+    unsigned s = atomic_load_explicit(&l->serving, memory_order_relaxed);
+    unsigned expected = s;
+    return atomic_compare_exchange_strong_explicit(&l->next, &expected, s + 1,
+                                                   memory_order_acquire,
+                                                   memory_order_relaxed);
+}
+
+static inline void qlock_release(QLock *l) {
+    // Only the holder writes serving
+    unsigned s = atomic_load_explicit(&l->serving, memory_order_relaxed);
+    atomic_store_explicit(&l->serving, s + 1, memory_order_release);
+}
+
+// ---------------------------------------------------------------------
+// MCS lock: waiters form a queue of nodes and each spins on its own node,
+// so a release touches one waiter's cache line instead of all of them.
+// Nodes come from a small per-thread pool; the holder's node is kept in
+// the lock so release needs no extra argument.
+// ---------------------------------------------------------------------
+#elif defined(QLOCK_MCS)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// MCS locks one thread may hold at once (e.g. a reservation and a peek)
+#ifndef MCS_MAX_HELD
+#define MCS_MAX_HELD 8
+#endif
+
+typedef struct McsNode {
+    _Alignas(64) _Atomic(struct McsNode *) next;
+    atomic_bool locked;   // true while this waiter must keep spinning
+    int index;            // slot in the owning thread's pool
+} McsNode;
+
+typedef struct {
+    _Atomic(McsNode *) tail;   // last waiter, NULL if the lock is free
+    McsNode *holder;           // node of the current holder
+} QLock;
+
+static _Thread_local McsNode mcs_pool[MCS_MAX_HELD];
+static _Thread_local unsigned mcs_used;   // bit i set: mcs_pool[i] in use
+
+static inline McsNode *mcs_node_get(void) {
+    for (int i = 0; i < MCS_MAX_HELD; i++) {
+        if (!(mcs_used & (1u << i))) {
+            mcs_used |= 1u << i;
+            mcs_pool[i].index = i;
+            atomic_store_explicit(&mcs_pool[i].next, NULL, memory_order_relaxed);
+            atomic_store_explicit(&mcs_pool[i].locked, true, memory_order_relaxed);
+            return &mcs_pool[i];
+        }
+    }
+    fprintf(stderr, "lock.h: more than %d MCS locks held by one thread\n", MCS_MAX_HELD);
+    abort();
+}
+
+static inline void mcs_node_put(McsNode *n) {
+    mcs_used &= ~(1u << n->index);
+}
+
+static inline void qlock_init(QLock *l) {
+    atomic_init(&l->tail, NULL);
+    l->holder = NULL;
+}
+
+static inline void qlock_destroy(QLock *l) { (void)l; }
+
+static inline void qlock_acquire(QLock *l) {
+    McsNode *me = mcs_node_get();
+    McsNode *pred = atomic_exchange_explicit(&l->tail, me, memory_order_acq_rel);
+    if (pred) {
+        // Queue behind pred and wait for it to hand the lock over
+        atomic_store_explicit(&pred->next, me, memory_order_release);
+        unsigned spins = 0;
+        while (atomic_load_explicit(&me->locked, memory_order_acquire)) lock_relax(&spins);
+    }
+    l->holder = me;
+}
+
+static inline bool qlock_try(QLock *l) {
+    McsNode *me = mcs_node_get();
+    McsNode *expected = NULL;
+    if (atomic_compare_exchange_strong_explicit(&l->tail, &expected, me,
+                                                memory_order_acq_rel,
+                                                memory_order_relaxed)) {
+        l->holder = me;
+        return true;
+    }
+    mcs_node_put(me);
+    return false;
+}
+
+static inline void qlock_release(QLock *l) {
+    McsNode *me = l->holder;
+    McsNode *next = atomic_load_explicit(&me->next, memory_order_acquire);
+    if (!next) {
+        // No known successor: try to mark the lock free
+        McsNode *expected = me;
+        if (atomic_compare_exchange_strong_explicit(&l->tail, &expected, NULL,
+                                                    memory_order_release,
+                                                    memory_order_relaxed)) {
+            mcs_node_put(me);
+            return;
+        }
+        // A successor swapped itself in but has not linked yet
+        unsigned spins = 0;
+        while (!(next = atomic_load_explicit(&me->next, memory_order_acquire))) {
+            lock_relax(&spins);
+        }
+    }
+    atomic_store_explicit(&next->locked, false, memory_order_release);
+    mcs_node_put(me);
+}
+
+// ---------------------------------------------------------------------
+// Test-and-test-and-set with exponential backoff: waiters read the flag
+// until it looks free and back off longer after every lost race
+// ---------------------------------------------------------------------
+#else // QLOCK_TAS_BACKOFF
+
+// Longest backoff, in pause hints
+#ifndef TAS_BACKOFF_MAX
+#define TAS_BACKOFF_MAX 1024
+#endif
+
+typedef struct {
+    atomic_int held;
+} QLock;
+
+static inline void qlock_init(QLock *l) { atomic_init(&l->held, 0); }
+static inline void qlock_destroy(QLock *l) { (void)l; }
+
+static inline bool qlock_try(QLock *l) {
+    return atomic_load_explicit(&l->held, memory_order_relaxed) == 0 &&
+           atomic_exchange_explicit(&l->held, 1, memory_order_acquire) == 0;
+}
+
+static inline void qlock_acquire(QLock *l) {
+    unsigned backoff = 1, spins = 0;
+    while (!qlock_try(l)) {
+        // Lost the race: back off, then wait for the flag to look free
+        for (unsigned i = 0; i < backoff; i++) lock_pause();
+        if (backoff < TAS_BACKOFF_MAX) backoff <<= 1;
+        while (atomic_load_explicit(&l->held, memory_order_relaxed)) lock_relax(&spins);
+    }
+}
+
+static inline void qlock_release(QLock *l) {
+    atomic_store_explicit(&l->held, 0, memory_order_release);
+}
+
+#endif
+
+#endif // LOCK_H
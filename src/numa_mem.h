@@ -0,0 +1,67 @@
+// numa_mem.h
+// Internal helper for the placement-aware constructors (create_on_node,
+// create_ex, MODE=hier): memory whose pages are bound to one NUMA node,
+// placed with the mbind system call before first touch, so no libnuma is
+// needed, and rings on huge, pre-faulted or locked pages (QUEUE_MEM_*).
+// Whatever the machine or kernel cannot do is skipped: the memory is
+// usable either way. Not part of the public API.
+#ifndef NUMA_MEM_H
+#define NUMA_MEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+// The QUEUE_MEM_* flags a ring can report through queue_mem
+#define NUMA_MEM_FLAGS (QUEUE_MEM_HUGE | QUEUE_MEM_PREFAULT | QUEUE_MEM_LOCK | QUEUE_MEM_NODE)
+
+/**
+ * Number of NUMA nodes (highest online node + 1); 1 if the kernel
+ * reports none.
+ */
+int numa_mem_nodes(void);
+
+/**
+ * Node of the CPU the calling thread runs on; 0 if unknown.
+ */
+int numa_mem_current_node(void);
+
+/**
+ * Allocate bytes aligned to align (a power of two, at most a page).
+ * node < 0: plain aligned_alloc. node >= 0: whole zero-filled pages,
+ * bound to node; *bound tells whether the binding took effect (false if
+ * node does not exist or the kernel has no NUMA support, the memory is
+ * usable either way).
+ * Returns NULL on failure. Free with numa_mem_free and the same node.
+ */
+void *numa_mem_alloc(size_t bytes, size_t align, int node, bool *bound);
+
+/**
+ * Free memory from numa_mem_alloc(bytes, ..., node, ...).
+ * Safe to call with NULL (no-op).
+ */
+void numa_mem_free(void *p, size_t bytes, int node);
+
+/**
+ * Node create_ex places a queue on: -1 unless opts asks for QUEUE_MEM_NODE,
+ * the calling thread's node if opts->node < 0.
+ */
+int numa_mem_opts_node(const QueueOptions *opts);
+
+/**
+ * Allocate a ring of bytes aligned to align with the QUEUE_MEM_* flags
+ * (QUEUE_MEM_NODE is implied by node >= 0 and ignored in flags).
+ * Without a node or flags this is plain aligned_alloc. *got receives the
+ * flags that took effect, plus bookkeeping bits for numa_mem_ring_free.
+ * Returns NULL on failure.
+ */
+void *numa_mem_ring_alloc(size_t bytes, size_t align, int node, unsigned flags, unsigned *got);
+
+/**
+ * Free a ring from numa_mem_ring_alloc(bytes, ...) that reported *got.
+ * Safe to call with NULL (no-op).
+ */
+void numa_mem_ring_free(void *p, size_t bytes, unsigned got);
+
+#endif // NUMA_MEM_H
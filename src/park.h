@@ -0,0 +1,89 @@
+// park.h
+// Internal helper shared by the queue implementations: a parking spot
+// (event count) that blocking callers sleep on until the opposite side
+// changes the queue. Not part of the public API.
+#ifndef PARK_H
+#define PARK_H
+
+#include <stdatomic.h>
+
+#include "queue.h"
+
+// Parker.fenced: until someone first waits on a parker, wakes skip the
+// fence (see parker_wake and parker_prepare)
+enum { PARK_UNFENCED = 0, PARK_FENCING = 1, PARK_FENCED = 2 };
+
+typedef struct {
+    atomic_uint seq;      // bumped by every wake; waiters sleep on it
+    atomic_int waiters;   // threads parked (or about to park) here, +1 while fd is armed
+    atomic_int fd;        // eventfd from queue_get_fd/queue_get_space_fd, or -1
+    atomic_int armed;     // 1 while fd waits for the next wake
+    atomic_int fenced;    // PARK_*: PARK_UNFENCED until the first wait or arm
+} Parker;
+
+// State a new parker starts in (queue_wait.c): PARK_UNFENCED if the
+// first waiter can fence the other threads for them (Linux membarrier),
+// else PARK_FENCED.
+int parker_initial_state(void);
+
+static inline void parker_init(Parker *p) {
+    atomic_init(&p->seq, 0);
+    atomic_init(&p->waiters, 0);
+    atomic_init(&p->fd, -1);
+    atomic_init(&p->armed, 0);
+#ifdef PARK_SHARED
+    // Wakers in other processes are beyond a process-wide barrier
+    atomic_init(&p->fenced, PARK_FENCED);
+#else
+    atomic_init(&p->fenced, parker_initial_state());
+#endif
+}
+
+// Called by the implementations' destroy: closes the eventfd, if any
+// (queue_notify.c).
+void parker_destroy(Parker *p);
+
+// Slow path of parker_wake (queue_wait.c): signal an armed eventfd, then
+// bump seq and wake up to n sleepers.
+void parker_wake_slow(Parker *p, int n);
+
+// Part of the slow path (queue_notify.c): if the eventfd is armed, disarm
+// it and make it readable. Only one wake per edge gets to write.
+void parker_signal_fd(Parker *p);
+
+// Slow path of parker_prepare (queue_wait.c)
+void parker_prepare_slow(Parker *p);
+
+// Called by a waiter before it counts itself in waiters (blocking calls,
+// armed eventfd). The first one on p makes every other thread execute a
+// full barrier (membarrier), so wakes that still skipped the fence are
+// ordered before its re-check of the queue; from then on wakes fence.
+static inline void parker_prepare(Parker *p) {
+    if (atomic_load_explicit(&p->fenced, memory_order_acquire) != PARK_FENCED) {
+        parker_prepare_slow(p);
+    }
+}
+
+// Called by the side that just made progress (enqueued -> not_empty,
+// dequeued -> not_full) AFTER its change is visible. Costs one load while
+// nobody ever waited on p, one fence and two loads once someone has;
+// nothing is signalled unless someone is waiting now.
+static inline void parker_wake(Parker *p, int n) {
+    // Keep the compiler from hoisting the load above our queue change: the
+    // first waiter's membarrier relies on program order (parker_prepare)
+    atomic_signal_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&p->fenced, memory_order_relaxed) == PARK_UNFENCED) return;
+    // Pairs with the seq_cst increment of waiters in the waiter: either the
+    // waiter sees our queue change when it re-checks, or we see waiters > 0.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&p->waiters, memory_order_relaxed) == 0) return;
+    parker_wake_slow(p, n);
+}
+
+// Implemented by each queue_*.c: the parkers that blocked producers
+// (not_full) and blocked consumers (not_empty) sleep on. NULL means the
+// implementation has no other thread to wait for (sequential queue).
+Parker *queue_not_full_parker(Queue *q);
+Parker *queue_not_empty_parker(Queue *q);
+
+#endif // PARK_H
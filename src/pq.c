@@ -0,0 +1,290 @@
+// pq.c
+#include "pq.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <omp.h>
+
+#define CACHE_LINE 64
+
+// Internal representation: k array-based binary min-heaps, each behind
+// its own OpenMP lock. The strict queue is the k = 1 case. For k > 1
+// (MultiQueue, Rihani/Sanders/Dementiev 2015) each heap publishes its
+// size and smallest key in atomics that are read without the lock:
+//   - push: try-lock a random heap that is not full; after k busy or full
+//     picks, take the locks in turn and fail only if every heap is full
+//   - pop_min: look at the tops of two random heaps, try-lock the one
+//     with the smaller key; after k misses, lock the heap with the
+//     smallest top seen by a full scan and fail only if all are empty
+// The capacity is split across the heaps.
+
+typedef struct {
+    int64_t key;
+    int value;
+} Entry;
+
+typedef struct {
+    _Alignas(CACHE_LINE) omp_lock_t lock;   // protects e[] and the fields below
+    _Atomic int64_t top;   // smallest key (valid while n > 0), read lock-free
+    _Atomic int n;         // number of entries, read lock-free
+    int capacity;          // this heap's share of the queue capacity
+    Entry *e;              // e[0..n-1], heap-ordered by key
+} Heap;
+
+struct PQueue {
+    Heap *heaps;     // n_heaps heaps
+    int n_heaps;
+    int capacity;    // maximum number of pairs (as requested)
+};
+
+static _Thread_local uint64_t rng_state;
+static atomic_uint_fast64_t rng_seed;
+
+// Per-thread xorshift64* draw in [0, n)
+static inline int rand_below(int n) {
+    if (rng_state == 0) {
+        rng_state = (atomic_fetch_add_explicit(&rng_seed, 1, memory_order_relaxed) + 1)
+                    * 0x9E3779B97F4A7C15ull;
+    }
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (int)(((rng_state * 0x2545F4914F6CDD1Dull) >> 32) % (uint64_t)n);
+}
+
+// Size and smallest key of a heap without its lock (hints only)
+static inline int heap_size(Heap *h) {
+    return atomic_load_explicit(&h->n, memory_order_relaxed);
+}
+
+static inline bool heap_top(Heap *h, int64_t *key) {
+    if (heap_size(h) == 0) return false;
+    *key = atomic_load_explicit(&h->top, memory_order_relaxed);
+    return true;
+}
+
+// Insert into a heap; its lock must be held
+static bool heap_push(Heap *h, int64_t key, int value) {
+    int n = atomic_load_explicit(&h->n, memory_order_relaxed);
+    //Edge case: heap is full
+    if (n == h->capacity) return false;
+
+    // Sift the hole up from the new last position
+    int i = n;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (h->e[parent].key <= key) break;
+        h->e[i] = h->e[parent];
+        i = parent;
+    }
+    h->e[i].key = key;
+    h->e[i].value = value;
+
+    atomic_store_explicit(&h->top, h->e[0].key, memory_order_relaxed);
+    atomic_store_explicit(&h->n, n + 1, memory_order_relaxed);
+    return true;
+}
+
+// Remove the smallest entry of a heap; its lock must be held
+static bool heap_pop(Heap *h, int64_t *key, int *value) {
+    int n = atomic_load_explicit(&h->n, memory_order_relaxed);
+    //Edge case: heap is empty
+    if (n == 0) return false;
+
+    if (key) *key = h->e[0].key;
+    *value = h->e[0].value;
+
+    // Sift the last entry down from the root
+    Entry last = h->e[--n];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && h->e[child + 1].key < h->e[child].key) child++;
+        if (last.key <= h->e[child].key) break;
+        h->e[i] = h->e[child];
+        i = child;
+    }
+    if (n > 0) {
+        h->e[i] = last;
+        atomic_store_explicit(&h->top, h->e[0].key, memory_order_relaxed);
+    }
+    atomic_store_explicit(&h->n, n, memory_order_relaxed);
+    return true;
+}
+
+static PQueue* create_heaps(int capacity, int n_heaps) {
+    //Edge case: capacity <= 0
+    if (capacity <= 0) return NULL;
+
+    // Default: two heaps per thread; never more heaps than pairs
+    if (n_heaps <= 0) n_heaps = 2 * omp_get_max_threads();
+    if (n_heaps > capacity) n_heaps = capacity;
+
+    //Allocate the queue struct and the heaps on their own cache lines
+    PQueue *q = (PQueue *)malloc(sizeof(PQueue));
+    //Edge case: allocation fails
+    if (!q) return NULL;
+    q->heaps = (Heap *)aligned_alloc(CACHE_LINE, sizeof(Heap) * (size_t)n_heaps);
+    if (!q->heaps) {
+        free(q);
+        return NULL;
+    }
+
+    //Initialize the queue fields
+    q->n_heaps = n_heaps;
+    q->capacity = capacity;
+
+    //Initialize the heaps, splitting capacity as evenly as possible
+    for (int i = 0; i < n_heaps; i++) {
+        Heap *h = &q->heaps[i];
+        h->capacity = capacity / n_heaps + (i < capacity % n_heaps ? 1 : 0);
+        h->e = (Entry *)malloc(sizeof(Entry) * (size_t)h->capacity);
+        //Edge case: allocation fails, undo the heaps made so far
+        if (!h->e) {
+            for (int j = 0; j < i; j++) {
+                omp_destroy_lock(&q->heaps[j].lock);
+                free(q->heaps[j].e);
+            }
+            free(q->heaps);
+            free(q);
+            return NULL;
+        }
+        atomic_init(&h->top, 0);
+        atomic_init(&h->n, 0);
+        omp_init_lock(&h->lock);
+    }
+
+    return q;
+}
+
+PQueue* pq_create(int capacity) {
+    return create_heaps(capacity, 1);
+}
+
+PQueue* pq_create_relaxed(int capacity, int heaps) {
+    return create_heaps(capacity, heaps);
+}
+
+void pq_destroy(PQueue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+
+    // Destroy locks and free the heaps (caller must ensure no one is
+    // using q anymore)
+    for (int i = 0; i < q->n_heaps; i++) {
+        omp_destroy_lock(&q->heaps[i].lock);
+        free(q->heaps[i].e);
+    }
+    free(q->heaps);
+    //Free the queue struct
+    free(q);
+}
+
+bool pq_push(PQueue *q, int64_t key, int value) {
+    //Edge case: q is NULL
+    if (!q) return false;
+
+    int k = q->n_heaps;
+    bool ok;
+
+    // Strict queue: one heap, one lock
+    if (k == 1) {
+        omp_set_lock(&q->heaps[0].lock);
+        ok = heap_push(&q->heaps[0], key, value);
+        omp_unset_lock(&q->heaps[0].lock);
+        return ok;
+    }
+
+    // Random heaps, skipping ones that are full or busy
+    for (int i = 0; i < k; i++) {
+        Heap *h = &q->heaps[rand_below(k)];
+        if (heap_size(h) >= h->capacity) continue;
+        if (!omp_test_lock(&h->lock)) continue;
+        ok = heap_push(h, key, value);
+        omp_unset_lock(&h->lock);
+        if (ok) return true;
+    }
+
+    // Every pick was full or busy: wait for each heap's lock in turn
+    int start = rand_below(k);
+    for (int i = 0; i < k; i++) {
+        Heap *h = &q->heaps[(start + i) % k];
+        if (heap_size(h) >= h->capacity) continue;
+        omp_set_lock(&h->lock);
+        ok = heap_push(h, key, value);
+        omp_unset_lock(&h->lock);
+        if (ok) return true;
+    }
+    // Every heap is full
+    return false;
+}
+
+bool pq_pop_min(PQueue *q, int64_t *key, int *value) {
+    //Edge case: q or value is NULL
+    if (!q || !value) return false;
+
+    int k = q->n_heaps;
+    bool ok;
+
+    // Strict queue: one heap, one lock
+    if (k == 1) {
+        omp_set_lock(&q->heaps[0].lock);
+        ok = heap_pop(&q->heaps[0], key, value);
+        omp_unset_lock(&q->heaps[0].lock);
+        return ok;
+    }
+
+    // Two random choices: try the heap whose top key is smaller
+    for (int i = 0; i < k; i++) {
+        Heap *a = &q->heaps[rand_below(k)];
+        Heap *b = &q->heaps[rand_below(k)];
+        int64_t ka, kb;
+        bool has_a = heap_top(a, &ka);
+        bool has_b = heap_top(b, &kb);
+        if (!has_a && !has_b) continue;
+        Heap *h = (!has_b || (has_a && ka <= kb)) ? a : b;
+        if (!omp_test_lock(&h->lock)) continue;
+        ok = heap_pop(h, key, value);
+        omp_unset_lock(&h->lock);
+        if (ok) return true;
+    }
+
+    // Every pick was empty or busy: wait for the heap with the smallest
+    // top, rescanning while other consumers empty the ones we pick
+    while (1) {
+        Heap *best = NULL;
+        int64_t best_key = 0;
+        for (int i = 0; i < k; i++) {
+            int64_t kh;
+            if (heap_top(&q->heaps[i], &kh) && (!best || kh < best_key)) {
+                best = &q->heaps[i];
+                best_key = kh;
+            }
+        }
+        // Every heap is empty
+        if (!best) return false;
+
+        omp_set_lock(&best->lock);
+        ok = heap_pop(best, key, value);
+        omp_unset_lock(&best->lock);
+        if (ok) return true;
+    }
+}
+
+int pq_size(const PQueue *q) {
+    if (!q) return 0;
+    // Exact when no operation is in flight, approximate otherwise
+    int total = 0;
+    for (int i = 0; i < q->n_heaps; i++) total += heap_size(&q->heaps[i]);
+    return total;
+}
+
+int pq_capacity(const PQueue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no lock/atomic needed
+    return q->capacity;
+}
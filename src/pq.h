@@ -0,0 +1,66 @@
+//pq.h
+#ifndef PQ_H
+#define PQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Concurrent bounded priority queue of (key, value) pairs, smallest key
+// first. Built with MODE=pq. Two flavours share the API:
+//   - strict (pq_create): one binary heap behind one lock; pq_pop_min
+//     always returns the smallest key present
+//   - relaxed (pq_create_relaxed): a MultiQueue of k independently
+//     locked heaps; pushes go to a random heap and pq_pop_min takes the
+//     better top of two random heaps, so it returns one of the smallest
+//     keys (rank error grows with k, on the order of k) but threads
+//     rarely contend for the same lock
+
+typedef struct PQueue PQueue;
+
+/**
+ * Create a strict priority queue holding at most `capacity` pairs.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+PQueue* pq_create(int capacity);
+
+/**
+ * Create a relaxed (MultiQueue) priority queue of `heaps` heaps sharing
+ * `capacity` between them (heaps <= 0 means two per OpenMP thread, and
+ * there are never more heaps than capacity).
+ * Returns NULL on failure or if capacity <= 0.
+ */
+PQueue* pq_create_relaxed(int capacity, int heaps);
+
+/**
+ * Free all memory associated with the queue.
+ * Safe to call with NULL (no-op).
+ */
+void pq_destroy(PQueue *q);
+
+/**
+ * Insert value with priority key (smaller keys come out first).
+ * Returns true on success, false if the queue is full or q is NULL.
+ */
+bool pq_push(PQueue *q, int64_t key, int value);
+
+/**
+ * Remove the pair with the smallest key (strict) or one of the smallest
+ * keys (relaxed) and store it in *key and *value.
+ * key may be NULL if the caller only needs the value.
+ * Returns true on success, false if the queue is empty or q/value is NULL.
+ */
+bool pq_pop_min(PQueue *q, int64_t *key, int *value);
+
+/**
+ * Current number of pairs in the queue.
+ * If q is NULL, returns 0.
+ */
+int pq_size(const PQueue *q);
+
+/**
+ * Maximum number of pairs that can be stored.
+ * If q is NULL, returns 0.
+ */
+int pq_capacity(const PQueue *q);
+
+#endif // PQ_H
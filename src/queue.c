@@ -1,157 +1,480 @@
 //queue.c 
 #include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+#include "numa_mem.h"
 
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
-#include <omp.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
 
 // Internal representation: bounded circular buffer.
+//
+// head/tail are monotonically increasing 64-bit counters (slot = counter & mask
+// for power-of-two rings, counter % slots otherwise) and size is derived as
+// tail - head, so there is no shared size counter.
+// Producer-side and consumer-side state live on separate cache lines;
+// each side keeps a cached copy of the other side's counter and only
+// reads the other line when the cache says the queue looks full/empty.
 struct Queue {
-    int *data;      // array of length capacity
-    int capacity;   // maximum number of elements
-    int head;       // index of next element to dequeue
-    int tail;       // index of next slot to enqueue
-    int size;       // current number of elements
-    omp_lock_t head_lock;   // protects head movement
-    omp_lock_t tail_lock;   // protects tail movement
+    // Read-only after create
+    void *data;     // array of length slots, elem_size bytes per slot
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity;   // maximum number of elements (as requested)
+    size_t slots;   // ring size (capacity, or rounded up to a power of two)
+    size_t mask;    // slots - 1 if slots is a power of two, else 0
+    int node;       // node given to create_on_node/create_ex, -1 if none
+    unsigned mem;     // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+
+    // Producer side (guarded by tail_lock)
+    _Alignas(CACHE_LINE) QLock tail_lock;   // protects tail movement
+    _Atomic uint64_t tail;                       // next value to enqueue
+    uint64_t head_cache;                         // producers' last view of head
+    Parker not_empty;                            // consumers blocked in dequeue_wait
+
+    // Consumer side (guarded by head_lock)
+    _Alignas(CACHE_LINE) QLock head_lock;   // protects head movement
+    _Atomic uint64_t head;                       // next value to dequeue
+    uint64_t tail_cache;                         // consumers' last view of tail
+    Parker not_full;                             // producers blocked in enqueue_wait
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;                       // per-thread counters (stats.h)
+#endif
 };
 
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
 
-Queue* create(int capacity) {
-    //Edge case: capacity <= 0
-    if (capacity <= 0) return NULL;
-
-    //Allocate memory for the queue struct
-    Queue *q = (Queue *)malloc(sizeof(Queue));
-    //Edge case: malloc fails
+    //Allocate the queue struct on its own cache lines (on node, if given)
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), CACHE_LINE, node, &bound);
+    //Edge case: allocation fails
     if(!q) return NULL;
 
-    //Allocate memory for the data array
-    q->data = (int *)malloc(sizeof(int) * capacity);
-    //Edge case: malloc fails
+    //Allocate the data array cache-line aligned (size rounded up to a line)
+    q->slots = ring_slots_for(capacity, pow2);
+    size_t bytes = esize * q->slots;
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    q->data = numa_mem_ring_alloc(bytes, CACHE_LINE, node, mem, &q->mem);
+    //Edge case: allocation fails
     if (!q->data) {
-        free(q);
+        numa_mem_free(q, sizeof(Queue), node);
         return NULL;
     }
+    q->node = node;
 
     //Initialize the queue fields
+    q->elem_size = esize;
     q->capacity = capacity;
-    q->head = 0;
-    q->tail = 0;
-    q->size = 0;
+    q->mask = ring_mask_for(q->slots);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->head_cache = 0;
+    q->tail_cache = 0;
 
     // Initialize locks
-    omp_init_lock(&q->head_lock);
-    omp_init_lock(&q->tail_lock);
+    qlock_init(&q->head_lock);
+    qlock_init(&q->tail_lock);
+
+    // Initialize parking spots for the blocking calls
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
 
+    STATS_INIT(q);
     return q;
 }
 
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
+
 void destroy(Queue *q) {
     //Edge case: q is NULL
     if (!q) return;
 
     // Destroy locks (caller must ensure no one is using q anymore)
-    omp_destroy_lock(&q->head_lock);
-    omp_destroy_lock(&q->tail_lock);
+    qlock_destroy(&q->head_lock);
+    qlock_destroy(&q->tail_lock);
 
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
     //Free the data array
-    free(q->data);
+    numa_mem_ring_free(q->data, q->elem_size * q->slots, q->mem);
     //Free the queue struct
-    free(q);
+    numa_mem_free(q, sizeof(Queue), q->node);
 }
 
-bool enqueue(Queue *q, int value) {
-    //Edge case: q is NULL
-    if (!q) return false;
-
+// Copy one esize-byte element in at tail. Inlined with a constant esize
+// for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
     // Acquire the tail lock
-    omp_set_lock(&q->tail_lock);
+    QUEUE_LOCK(q, &q->tail_lock);
 
-    int s;
-    #pragma omp atomic read
-    s = q->size;
+    // Only tail_lock holders write tail
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
 
-    // Queue is full
-    if (s == q->capacity) {
-        omp_unset_lock(&q->tail_lock);
-        return false; 
-    }
+    // Looks full from the cached head: refresh it from the consumer side
+    if (tail - q->head_cache == (uint64_t)q->capacity) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
 
-    // Enqueue the value at tail
-    q->data[q->tail] = value;
-    q->tail = (q->tail + 1) % q->capacity;
+        // Queue is full
+        if (tail - q->head_cache == (uint64_t)q->capacity) {
+            qlock_release(&q->tail_lock);
+            STATS_ADD(q, full, 1);
+            return false; 
+        }
+    }
 
-    // Increment size atomically
-    #pragma omp atomic update
-    q->size++;
+    // Enqueue the element at tail, then publish it to consumers
+    size_t slot = ring_slot(q->mask, q->slots, tail);
+    ring_elem_copy((char *)q->data + slot * esize, src, esize);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
 
     //Release the tail lock
-    omp_unset_lock(&q->tail_lock);
+    qlock_release(&q->tail_lock);
+
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, tail + 1 - atomic_load_explicit(&q->head, memory_order_relaxed));
+
+    // Wake a blocked consumer, if any
+    parker_wake(&q->not_empty, 1);
+    return true;
+}
+
+// Copy the element at head out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    // Acquire the head lock
+    QUEUE_LOCK(q, &q->head_lock);
+
+    // Only head_lock holders write head
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Looks empty from the cached tail: refresh it from the producer side
+    if (head == q->tail_cache) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+        // Queue is empty
+        if (head == q->tail_cache) {
+            qlock_release(&q->head_lock);
+            STATS_ADD(q, empty, 1);
+            return false; 
+        }
+    }
+
+    // Dequeue the element at head, then hand the slot back to producers
+    size_t slot = ring_slot(q->mask, q->slots, head);
+    ring_elem_copy(dst, (const char *)q->data + slot * esize, esize);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    //Release the head lock
+    qlock_release(&q->head_lock);
+
+    STATS_ADD(q, dequeued, 1);
+
+    // Wake a blocked producer, if any
+    parker_wake(&q->not_full, 1);
     return true;
 }
 
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
 bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
     //Edge case: q or out is NULL
     if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
 
-    // Acquire the head lock
-    omp_set_lock(&q->head_lock);
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
 
-    // Check if queue is empty (read size atomically)
-    int s;
-    #pragma omp atomic read
-    s = q->size;
+    // Acquire the tail lock once for the whole batch
+    QUEUE_LOCK(q, &q->tail_lock);
 
-    // Queue is empty
-    if (s == 0) {
-        omp_unset_lock(&q->head_lock);
-        return false; 
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - q->head_cache);
+    if (room < (uint64_t)n) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = cap - (tail - q->head_cache);
+    }
+
+    // Take as many values as there is free space
+    int k = (room < (uint64_t)n) ? (int)room : n;
+
+    if (k > 0) {
+        // Copy the batch in, then publish all of it with one store
+        ring_copy_in(q->data, q->slots, sizeof(int),
+                     ring_slot(q->mask, q->slots, tail), values, (size_t)k);
+        atomic_store_explicit(&q->tail, tail + (uint64_t)k, memory_order_release);
+    }
+
+    //Release the tail lock
+    qlock_release(&q->tail_lock);
+
+    if (k > 0) {
+        STATS_ADD(q, enqueued, k);
+        STATS_HIGH_WATER(q, tail + (uint64_t)k - atomic_load_explicit(&q->head, memory_order_relaxed));
+    } else {
+        STATS_ADD(q, full, 1);
+    }
+
+    // Wake up to k blocked consumers, if any
+    if (k > 0) parker_wake(&q->not_empty, k);
+    return k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    // Acquire the head lock once for the whole batch
+    QUEUE_LOCK(q, &q->head_lock);
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = q->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->tail_cache - head;
     }
 
-   // Dequeue the value at head
-    *out = q->data[q->head];
-    q->head = (q->head + 1) % q->capacity;
+    // Take as many values as are available
+    int k = (avail < (uint64_t)max) ? (int)avail : max;
+
+    if (k > 0) {
+        // Copy the batch out, then hand all of it back with one store
+        ring_copy_out(q->data, q->slots, sizeof(int),
+                      ring_slot(q->mask, q->slots, head), out, (size_t)k);
+        atomic_store_explicit(&q->head, head + (uint64_t)k, memory_order_release);
+    }
 
-    // Update size atomically
-    #pragma omp atomic update
-    q->size--;
     //Release the head lock
-    omp_unset_lock(&q->head_lock);
-    return true;
+    qlock_release(&q->head_lock);
+
+    if (k > 0) STATS_ADD(q, dequeued, k);
+    else STATS_ADD(q, empty, 1);
+
+    // Wake up to k blocked producers, if any
+    if (k > 0) parker_wake(&q->not_full, k);
+    return k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    // Acquire the tail lock; on success it stays held until enqueue_commit
+    QUEUE_LOCK(q, &q->tail_lock);
+
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - q->head_cache);
+    if (room < (uint64_t)n) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = cap - (tail - q->head_cache);
+    }
+
+    // Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, tail);
+    size_t k = ring_contig(q->slots, at, room < (uint64_t)n ? (size_t)room : (size_t)n);
+
+    // Queue is full
+    if (k == 0) {
+        qlock_release(&q->tail_lock);
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+
+    // Publish the filled slots with one store
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, tail + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, tail + (uint64_t)n - atomic_load_explicit(&q->head, memory_order_relaxed));
+
+    //Release the tail lock taken by enqueue_reserve
+    qlock_release(&q->tail_lock);
+
+    // Wake up to n blocked consumers, if any
+    parker_wake(&q->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    // Acquire the head lock; on success it stays held until dequeue_release
+    QUEUE_LOCK(q, &q->head_lock);
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = q->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->tail_cache - head;
+    }
+
+    // Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, head);
+    size_t k = ring_contig(q->slots, at, avail < (uint64_t)max ? (size_t)avail : (size_t)max);
+
+    // Queue is empty
+    if (k == 0) {
+        qlock_release(&q->head_lock);
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+
+    // Hand the slots back with one store
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->head, head + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, dequeued, n);
+
+    //Release the head lock taken by dequeue_peek
+    qlock_release(&q->head_lock);
+
+    // Wake up to n blocked producers, if any
+    parker_wake(&q->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+// Snapshot of tail - head, clamped to [0, capacity].
+// Exact when no operation is in flight, approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (tail <= head) return 0;
+    if (tail - head > (uint64_t)q->capacity) return q->capacity;
+    return (int)(tail - head);
 }
 
 bool is_empty(const Queue *q) {
     if (!q) return true;
-
-    int s;
-    
-    #pragma omp atomic read
-    s = q->size;
-    return (s == 0);
+    return snapshot_size(q) == 0;
 }
 
 bool is_full(const Queue *q) {
     if (!q) return false;
-
-    int s;
-    #pragma omp atomic read
-    s = q->size;
-    return (s == q->capacity);
+    return snapshot_size(q) == q->capacity;
 }
 
 int size(const Queue *q) {
     if (!q) return 0;
-
-    int s;
-    #pragma omp atomic read
-    s = q->size;
-    return s;
+    return snapshot_size(q);
 }
 
 int capacity(const Queue *q) {
     if (!q) return 0;
     // capacity is immutable after creation, so no lock/atomic needed
     return q->capacity;
-}
\ No newline at end of file
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
@@ -3,6 +3,7 @@
 #define QUEUE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct Queue Queue; 
 
@@ -13,6 +14,88 @@ typedef struct Queue Queue;
  */
 Queue* create(int capacity);
 
+/**
+ * Like create, but rounds the ring up to a power of two internally so every
+ * index update is a mask instead of a modulo. The queue still holds at most
+ * `capacity` elements and capacity() reports the requested value.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Queue* create_pow2(int capacity);
+
+/**
+ * Create a queue whose slots hold elem_size-byte elements stored inline
+ * in the ring (no per-element allocation). Use enqueue_elem/dequeue_elem
+ * on it; the int calls (enqueue, dequeue, the bulk and wait calls) only
+ * work when elem_size == sizeof(int) and fail otherwise.
+ * Sizes 4, 8, 16 and 64 take specialized copy paths.
+ * Returns NULL on failure or if capacity <= 0 or elem_size == 0.
+ */
+Queue* create_sized(int capacity, size_t elem_size);
+
+/**
+ * create_sized with the ring rounded up to a power of two (see create_pow2).
+ */
+Queue* create_sized_pow2(int capacity, size_t elem_size);
+
+/**
+ * Like create, but the queue (its struct and ring) lives in memory bound
+ * to NUMA node `node`, so a pipeline pinned to one socket does not pay
+ * for cross-socket traffic to wherever malloc put the ring. node < 0
+ * means the node of the calling thread's CPU.
+ * Degrades gracefully: if the node does not exist or the kernel has no
+ * NUMA support, the queue is still created, unbound (queue_node tells).
+ * The segmented and sharded implementations ignore the node.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Queue* create_on_node(int capacity, int node);
+
+/**
+ * NUMA node q's memory is bound to, or -1 if it is not bound (made by
+ * create, binding unavailable, or q is NULL).
+ */
+int queue_node(const Queue *q);
+
+/** Back the ring with huge pages: MAP_HUGETLB if the system has huge
+ *  pages reserved, else transparent huge pages (madvise). */
+#define QUEUE_MEM_HUGE     0x1u
+/** Fault every page of the ring in at create, not on first use. */
+#define QUEUE_MEM_PREFAULT 0x2u
+/** Lock the ring in RAM (mlock); implies QUEUE_MEM_PREFAULT. Subject to
+ *  RLIMIT_MEMLOCK. */
+#define QUEUE_MEM_LOCK     0x4u
+/** Bind the queue to NUMA node QueueOptions.node (see create_on_node). */
+#define QUEUE_MEM_NODE     0x8u
+
+/**
+ * Options of create_ex. Zero-initialized ({0}) it gives the same queue as
+ * create.
+ */
+typedef struct QueueOptions {
+    size_t elem_size;   // bytes per element, 0 for sizeof(int) (see create_sized)
+    bool pow2;          // round the ring up to a power of two (see create_pow2)
+    unsigned mem;       // QUEUE_MEM_* flags for the ring's memory
+    int node;           // node for QUEUE_MEM_NODE; < 0 means the caller's node
+} QueueOptions;
+
+/**
+ * Create a queue with the given options (NULL: same as create). The
+ * QUEUE_MEM_* flags are for large queues, whose first pass through a
+ * malloc'd ring takes one page fault per 4 KB and whose steady state pays
+ * for TLB misses. Each flag is best effort: the queue is created anyway
+ * and queue_mem reports what took effect. The segmented queue allocates
+ * as it grows and ignores them; the shared-memory queue only honours
+ * QUEUE_MEM_PREFAULT and QUEUE_MEM_LOCK.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Queue* create_ex(int capacity, const QueueOptions *opts);
+
+/**
+ * The QUEUE_MEM_* flags in effect for q's ring (0 for a malloc'd ring or
+ * if q is NULL). QUEUE_MEM_HUGE means huge pages were mapped, or the
+ * kernel accepted the transparent huge page advice.
+ */
+unsigned queue_mem(const Queue *q);
+
 /**
  * Free all memory associated with the queue.
  * Safe to call with NULL (no-op).
@@ -31,6 +114,194 @@ bool enqueue(Queue *q, int value);
  */
 bool dequeue(Queue *q, int *out);
 
+/**
+ * Copy one element of elem_size(q) bytes from *elem into the queue.
+ * Returns true on success, false if the queue is full or q/elem is NULL.
+ */
+bool enqueue_elem(Queue *q, const void *elem);
+
+/**
+ * Copy the oldest element out of the queue into *out (elem_size(q) bytes).
+ * Returns true on success, false if the queue is empty or q/out is NULL.
+ */
+bool dequeue_elem(Queue *q, void *out);
+
+/**
+ * Enqueue up to n values from values[0..n-1], in order.
+ * All values go in with a single synchronization round trip.
+ * Returns the number of values enqueued: less than n if the queue fills up,
+ * 0 if the queue is full, q/values is NULL or n <= 0.
+ */
+int enqueue_bulk(Queue *q, const int *values, int n);
+
+/**
+ * Dequeue up to max values into out[0..max-1], in FIFO order.
+ * All values come out with a single synchronization round trip.
+ * Returns the number of values dequeued: 0 if the queue is empty,
+ * q/out is NULL or max <= 0.
+ */
+int dequeue_bulk(Queue *q, int *out, int max);
+
+/**
+ * Zero-copy enqueue, phase 1: reserve up to n contiguous free slots and
+ * return a pointer to the first one (slots are elem_size(q) bytes apart).
+ * The producer fills them in place, then publishes them with
+ * enqueue_commit. *count receives the number of slots reserved: fewer
+ * than n if the queue is nearly full or the run reaches the end of the
+ * ring (the lock-free ring reserves one slot at a time).
+ * Returns NULL (and *count = 0) if the queue is full, q/count is NULL or
+ * n <= 0.
+ * Until the commit the reservation is exclusive: the locked queues keep
+ * their enqueue lock held, so the same thread must commit and must not
+ * call other functions on q in between.
+ */
+void *enqueue_reserve(Queue *q, int n, int *count);
+
+/**
+ * Zero-copy enqueue, phase 2: publish the first n (1 <= n <= count) slots
+ * of the reservation starting at slot (as returned by enqueue_reserve).
+ * Unfilled slots past n are given back. A reservation cannot be
+ * cancelled: n <= 0 fails an assert, and with NDEBUG it is taken as 1.
+ */
+void enqueue_commit(Queue *q, void *slot, int n);
+
+/**
+ * Zero-copy dequeue, phase 1: return a pointer to up to max contiguous
+ * queued elements, oldest first, without copying them out. *count
+ * receives the number of elements available through the pointer (the
+ * lock-free ring hands out one at a time). The slots stay owned by the
+ * caller until dequeue_release.
+ * Returns NULL (and *count = 0) if the queue is empty, q/count is NULL
+ * or max <= 0. Same exclusivity rules as enqueue_reserve.
+ */
+void *dequeue_peek(Queue *q, int max, int *count);
+
+/**
+ * Zero-copy dequeue, phase 2: remove the first n (1 <= n <= count)
+ * elements of the peek starting at slot and hand their slots back to
+ * producers. Elements past n stay queued. A peek cannot be cancelled:
+ * n <= 0 fails an assert, and with NDEBUG it is taken as 1.
+ */
+void dequeue_release(Queue *q, void *slot, int n);
+
+/**
+ * Blocking enqueue: waits until there is room, then enqueues value.
+ * Spins briefly, then sleeps until a consumer frees a slot.
+ * Returns true on success, false if q is NULL.
+ * The sequential queue cannot block: all four wait calls try once.
+ */
+bool enqueue_wait(Queue *q, int value);
+
+/**
+ * Blocking dequeue: waits until a value is available, then dequeues it
+ * into *out. Spins briefly, then sleeps until a producer adds a value.
+ * Returns true on success, false if q/out is NULL.
+ */
+bool dequeue_wait(Queue *q, int *out);
+
+/**
+ * Like enqueue_wait, but gives up after timeout_ms milliseconds
+ * (timeout_ms < 0 waits forever, 0 tries once).
+ * Returns true on success, false on timeout or if q is NULL.
+ */
+bool enqueue_wait_timeout(Queue *q, int value, int timeout_ms);
+
+/**
+ * Like dequeue_wait, but gives up after timeout_ms milliseconds
+ * (timeout_ms < 0 waits forever, 0 tries once).
+ * Returns true on success, false on timeout or if q/out is NULL.
+ */
+bool dequeue_wait_timeout(Queue *q, int *out, int timeout_ms);
+
+/**
+ * Event-loop integration (Linux): an eventfd that becomes readable when
+ * the queue goes from empty to non-empty, for use with epoll/poll next to
+ * sockets. Created on the first call (readable at once if the queue
+ * already holds values) and closed by destroy; do not close it yourself.
+ * Signals are edge-coalesced: one write per empty -> non-empty edge, not
+ * per element. Consume with dequeue_or_arm until it returns false, then
+ * go back to waiting on the fd.
+ * Returns -1 if q is NULL, eventfd is unavailable or the implementation
+ * is sequential or shared-memory (an fd cannot be shared through the
+ * queue between processes).
+ */
+int queue_get_fd(Queue *q);
+
+/**
+ * Like queue_get_fd for producers: an eventfd that becomes readable when
+ * a full queue gets room again (an eventfd is always writable, so room is
+ * reported as readability). Use with enqueue_or_arm.
+ */
+int queue_get_space_fd(Queue *q);
+
+/**
+ * Non-blocking dequeue for event loops. On success behaves like dequeue.
+ * When the queue is empty it clears and re-arms the queue_get_fd eventfd
+ * before returning false, so the fd becomes readable on the next enqueue.
+ * Returns false if the queue is empty or q/out is NULL.
+ */
+bool dequeue_or_arm(Queue *q, int *out);
+
+/**
+ * Non-blocking enqueue for event loops: like enqueue, but re-arms the
+ * queue_get_space_fd eventfd when the queue is full.
+ * Returns false if the queue is full or q is NULL.
+ */
+bool enqueue_or_arm(Queue *q, int value);
+
+/**
+ * Runtime counters of one queue (see queue_get_stats). Counts are totals
+ * since create; rejected attempts include every failed try of the
+ * blocking and *_or_arm calls.
+ */
+typedef struct QueueStats {
+    unsigned long long enqueued;   // elements enqueued
+    unsigned long long dequeued;   // elements dequeued
+    unsigned long long full;       // enqueue attempts rejected because the queue was full
+    unsigned long long empty;      // dequeue attempts rejected because the queue was empty
+    unsigned long long contended;  // lock acquisitions that had to wait (failed
+                                   // try-lock), or CAS retries in lock-free code
+    unsigned long long high_water; // most elements seen queued at once
+    double wait_s;                 // seconds callers spent waiting for locks or
+                                   // parked in the *_wait calls
+} QueueStats;
+
+/**
+ * Fill *out with q's counters. Only available when the library is built
+ * with -DQUEUE_STATS (make STATS=1); otherwise, or if q/out is NULL, *out
+ * is zeroed and false is returned. Counting is per thread and sharded
+ * across cache lines; built without QUEUE_STATS it costs nothing.
+ * The result is a snapshot: exact when no operation is in flight.
+ */
+bool queue_get_stats(const Queue *q, QueueStats *out);
+
+/**
+ * Name of the kernel that copies the contiguous spans of bulk transfers
+ * (enqueue_bulk/dequeue_bulk of the ring-based implementations; the
+ * lock-free and segmented queues copy element by element): "avx2",
+ * "sse2" or "memcpy". By default the widest one the CPU supports is
+ * used. Spans shorter than 256 bytes are always copied with memcpy.
+ * Process-wide, not per queue.
+ */
+const char *queue_copy_kernel(void);
+
+/**
+ * Force the bulk copy kernel ("avx2", "sse2" or "memcpy"); NULL goes
+ * back to the automatic choice. Meant for benchmarks and tests; set it
+ * before the queues are in use.
+ * Returns false, changing nothing, if the name is unknown or the CPU
+ * lacks the instructions.
+ */
+bool queue_set_copy_kernel(const char *name);
+
+/**
+ * Copy spans of at least `bytes` bytes with non-temporal (streaming)
+ * stores, which bypass the cache. This helps only for transfers much
+ * larger than the cache whose data is not read again soon. 0, the
+ * default, never uses them. The memcpy kernel ignores this setting.
+ */
+void queue_set_stream_threshold(size_t bytes);
+
 /**
  * Returns true if the queue is empty.
  * If q is NULL, returns true.
@@ -55,5 +326,95 @@ int size(const Queue *q);
  */
 int capacity(const Queue *q);
 
+/**
+ * Size in bytes of one element (sizeof(int) unless made by create_sized).
+ * If q is NULL, returns 0.
+ */
+size_t elem_size(const Queue *q);
+
+/**
+ * Number of segments currently linked into the queue (memory in use is
+ * about live_segments * segment size). Only provided by the segmented
+ * implementation (MODE=segmented); if q is NULL, returns 0.
+ */
+int live_segments(const Queue *q);
+
+/**
+ * Create a sharded queue of `lanes` independent rings that share
+ * `capacity` between them (lanes <= 0 means one per OpenMP thread, and
+ * there are never more lanes than capacity). Each thread enqueues into
+ * and dequeues from its own home lane first, spilling or stealing to the
+ * other lanes only when it is full or empty.
+ * Only per-lane FIFO is guaranteed: values from different lanes can come
+ * out in any order. lanes == 1 gives a strict FIFO queue.
+ * Only provided by the sharded implementation (MODE=sharded); create and
+ * create_sized there use the default lane count.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Queue* create_sharded(int capacity, int lanes);
+
+/**
+ * Number of lanes of a sharded queue (MODE=sharded only).
+ * If q is NULL, returns 0.
+ */
+int lane_count(const Queue *q);
+
+/**
+ * Create a hierarchical NUMA queue of `nodes` sub-queues that share
+ * `capacity` between them (nodes <= 0 means one per NUMA node). Each
+ * sub-queue's memory is bound to its node; threads enqueue into and
+ * dequeue from the sub-queue of the node they run on. A consumer whose
+ * sub-queue is empty moves a batch of values from another node's
+ * sub-queue into its own in one transfer, so values cross sockets in
+ * batches rather than one at a time.
+ * Only per-node FIFO is guaranteed (as for create_sharded), and a
+ * producer's values keep their order only while none of them moved.
+ * With more sub-queues than NUMA nodes (emulation on a smaller machine)
+ * threads are spread round-robin over them instead.
+ * Only provided by the hierarchical implementation (MODE=hier); create
+ * and create_sized there use the default node count.
+ * Returns NULL on failure or if capacity <= 0.
+ */
+Queue* create_hier(int capacity, int nodes);
+
+/**
+ * Number of per-node sub-queues of a hierarchical queue (MODE=hier only).
+ * If q is NULL, returns 0.
+ */
+int hier_nodes(const Queue *q);
+
+/**
+ * Open the int queue named `name` in POSIX shared memory (a shm_open name
+ * such as "/jobs"), creating it with `capacity` if it does not exist yet,
+ * so that separate processes can enqueue into and dequeue from it. The
+ * queued values live in the shared region and outlive every process:
+ * a consumer that restarts and opens the queue again finds them there.
+ * Locks are robust, so a process that dies inside a queue call does not
+ * block the others; whatever it had reserved but not committed is lost.
+ * destroy only unmaps this process's view; the queue goes away when it is
+ * unlinked (queue_unlink_shared) and every process has destroyed it.
+ * Blocking calls (enqueue_wait, dequeue_wait) work across processes.
+ * Only provided by the shared-memory implementation (MODE=shm), whose
+ * create and create_sized make queues in anonymous shared memory that
+ * processes forked afterwards share.
+ * Returns NULL on failure, if capacity <= 0, or if the queue exists with
+ * another capacity.
+ */
+Queue* queue_open_shared(const char *name, int capacity);
+
+/**
+ * Open an existing shared queue (see queue_open_shared), whatever its
+ * capacity (MODE=shm only).
+ * Returns NULL if there is no queue named `name` or on failure.
+ */
+Queue* queue_attach_shared(const char *name);
+
+/**
+ * Remove the name of a shared queue (MODE=shm only). Processes that have
+ * it open keep using it; later opens create a new, empty queue.
+ * Returns false if there is no such name.
+ */
+bool queue_unlink_shared(const char *name);
+
 #endif // QUEUE_H
 
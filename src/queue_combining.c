@@ -0,0 +1,506 @@
+//queue_combining.c
+// Flat-combining queue: the single-lock ring of queue_v1.c, but threads do
+// not take turns on the lock one operation at a time. A thread posts its
+// enqueue/dequeue in a publication slot, and whichever thread gets the
+// combiner lock applies every pending operation in one pass, so under
+// contention one lock hand-off serves a whole batch. Within a pass,
+// dequeues that find the ring empty take their value straight from a
+// pending enqueue (elimination) without touching the ring.
+// Single-element calls are combined; the bulk and zero-copy calls already
+// batch, so they take the combiner lock directly like queue_v1.c (and
+// serve the publication slots before releasing it).
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+#include "numa_mem.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Publication slots per queue. A thread starts at its home slot and takes
+// the next free one, so more threads than slots only costs probing.
+#ifndef FC_SLOTS
+#define FC_SLOTS 64
+#endif
+
+// Slot states: FREE -> CLAIMED (owner fills it in) -> PENDING (visible to
+// the combiner) -> DONE (result written) -> FREE (owner read the result)
+enum { FC_FREE, FC_CLAIMED, FC_PENDING, FC_DONE };
+enum { FC_ENQ, FC_DEQ };
+
+typedef struct {
+    _Alignas(64) atomic_int state;
+    int op;            // FC_ENQ or FC_DEQ
+    bool ok;           // result, written by the combiner before DONE
+    const void *src;   // FC_ENQ: element to copy in
+    void *dst;         // FC_DEQ: where to copy the element out
+} FcSlot;
+
+// Internal representation: bounded circular buffer guarded by the combiner
+// lock, plus the publication slots.
+// head/tail are monotonically increasing 64-bit counters (slot = ring_slot).
+struct Queue {
+    void *data; // array of length slots, elem_size bytes per slot
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity; // maximum number of elements (as requested)
+    size_t slots; // ring size (capacity, or rounded up to a power of two)
+    size_t mask; // slots - 1 if slots is a power of two, else 0
+    int node; // node given to create_on_node/create_ex, -1 if none
+    unsigned mem; // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+    uint64_t head; // count of elements dequeued so far
+    uint64_t tail; // count of elements enqueued so far
+    int size; // current number of elements
+    QLock lock; // combiner lock: whoever holds it owns the ring
+    atomic_int used; // 1 + highest publication slot ever claimed
+    Parker not_full; // producers blocked in enqueue_wait
+    Parker not_empty; // consumers blocked in dequeue_wait
+    FcSlot pub[FC_SLOTS]; // publication slots, one cache line each
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats; // per-thread counters (stats.h)
+#endif
+};
+
+// Calling thread's first publication slot
+static atomic_int fc_threads;
+static _Thread_local int fc_home = -1;
+
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    //Allocate memory for the queue struct (publication slots are cache-line aligned)
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), _Alignof(Queue), node, &bound);
+
+    //Edge case: malloc fails
+    if(!q) return NULL;
+
+    //Allocate memory for the data array
+    q->slots = ring_slots_for(capacity, pow2);
+    q->data = numa_mem_ring_alloc(esize * q->slots, _Alignof(max_align_t), node, mem, &q->mem);
+
+    //Edge case: malloc fails
+    if (!q->data) { numa_mem_free(q, sizeof(Queue), node); return NULL; }
+    //Initialize the queue fields
+    q->elem_size = esize;
+    q->node = node;
+    q->capacity = capacity;
+    q->mask = ring_mask_for(q->slots);
+    q->head = 0;
+    q->tail = 0;
+    q->size = 0;
+    qlock_init(&q->lock);
+    atomic_init(&q->used, 0);
+    for (int i = 0; i < FC_SLOTS; i++) atomic_init(&q->pub[i].state, FC_FREE);
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+
+    // Destroy lock (caller must ensure no one is using q anymore)
+    qlock_destroy(&q->lock);
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    //Free the data array
+    numa_mem_ring_free(q->data, q->elem_size * q->slots, q->mem);
+    //Free the queue struct
+    numa_mem_free(q, sizeof(Queue), q->node);
+}
+
+// Hand an operation's result back to its owner
+static inline void fc_finish(FcSlot *s, bool ok) {
+    s->ok = ok;
+    atomic_store_explicit(&s->state, FC_DONE, memory_order_release);
+}
+
+// One combining pass (caller holds q->lock): apply every pending
+// operation. Dequeues go first so they see the oldest elements and free
+// room for the enqueues; the order is a valid linearization of the batch.
+// *added/*removed count elements that entered/left the ring, for wake-ups.
+static void fc_combine(Queue *q, int *added, int *removed) {
+    int enq[FC_SLOTS], deq[FC_SLOTS];
+    int ne = 0, nd = 0;
+    int used = atomic_load_explicit(&q->used, memory_order_acquire);
+    //Collect the pending operations
+    for (int i = 0; i < used; i++) {
+        if (atomic_load_explicit(&q->pub[i].state, memory_order_acquire) != FC_PENDING) continue;
+        if (q->pub[i].op == FC_ENQ) enq[ne++] = i;
+        else deq[nd++] = i;
+    }
+    size_t esize = q->elem_size;
+    int d = 0, e = 0;
+    //Dequeues take what is already queued, oldest first
+    for (; d < nd && q->size > 0; d++) {
+        size_t slot = ring_slot(q->mask, q->slots, q->head);
+        ring_elem_copy(q->pub[deq[d]].dst, (const char *)q->data + slot * esize, esize);
+        q->head++;
+        q->size--;
+        (*removed)++;
+        fc_finish(&q->pub[deq[d]], true);
+    }
+    //The ring is empty now: pair the remaining dequeues with enqueues
+    //(each pair is an enqueue immediately followed by its dequeue)
+    for (; d < nd && e < ne; d++, e++) {
+        ring_elem_copy(q->pub[deq[d]].dst, q->pub[enq[e]].src, esize);
+        fc_finish(&q->pub[enq[e]], true);
+        fc_finish(&q->pub[deq[d]], true);
+    }
+    //Edge case: more dequeues than elements
+    for (; d < nd; d++) fc_finish(&q->pub[deq[d]], false);
+    //The remaining enqueues go into the ring while there is room
+    for (; e < ne; e++) {
+        //Edge case: queue is full
+        if (q->size == q->capacity) {
+            fc_finish(&q->pub[enq[e]], false);
+            continue;
+        }
+        size_t slot = ring_slot(q->mask, q->slots, q->tail);
+        ring_elem_copy((char *)q->data + slot * esize, q->pub[enq[e]].src, esize);
+        q->tail++;
+        q->size++;
+        (*added)++;
+        fc_finish(&q->pub[enq[e]], true);
+    }
+    if (*added > 0) STATS_HIGH_WATER(q, q->size);
+}
+
+// Release the combiner lock, first serving whatever was posted while it
+// was held. The bulk and zero-copy calls hold the lock too: without this,
+// a FIFO lock (ticket, mcs) kept busy by them is never free for qlock_try
+// and the posted operations starve. Returns the size with those served,
+// for is_empty, is_full and size.
+static int fc_unlock(Queue *q) {
+    int added = 0, removed = 0;
+    fc_combine(q, &added, &removed);
+    int r = q->size;
+    qlock_release(&q->lock);
+    //Wake blocked callers for the elements that moved, if any
+    if (added > 0) parker_wake(&q->not_empty, added);
+    if (removed > 0) parker_wake(&q->not_full, removed);
+    return r;
+}
+
+// Claim a free publication slot, starting at the calling thread's home slot
+static FcSlot *fc_claim(Queue *q) {
+    if (fc_home < 0) fc_home = atomic_fetch_add(&fc_threads, 1) % FC_SLOTS;
+    unsigned spins = 0;
+    for (;;) {
+        for (int i = 0; i < FC_SLOTS; i++) {
+            int k = (fc_home + i) % FC_SLOTS;
+            int expected = FC_FREE;
+            if (atomic_compare_exchange_strong_explicit(&q->pub[k].state, &expected, FC_CLAIMED,
+                                                        memory_order_acquire,
+                                                        memory_order_relaxed)) {
+                //Make sure the combiner scans this far
+                int u = atomic_load_explicit(&q->used, memory_order_relaxed);
+                while (u <= k && !atomic_compare_exchange_weak_explicit(
+                           &q->used, &u, k + 1, memory_order_release, memory_order_relaxed)) {}
+                return &q->pub[k];
+            }
+        }
+        //Edge case: every slot is taken; wait for one to be freed
+        lock_relax(&spins);
+    }
+}
+
+// Post one operation and wait until a combiner (possibly this thread) has
+// applied it. Returns the operation's result.
+static bool fc_apply(Queue *q, int op, const void *src, void *dst) {
+    //Publish the operation
+    FcSlot *s = fc_claim(q);
+    s->op = op;
+    s->src = src;
+    s->dst = dst;
+    atomic_store_explicit(&s->state, FC_PENDING, memory_order_release);
+
+    unsigned spins = 0;
+#ifdef QUEUE_STATS
+    long long t0 = -1;
+#endif
+    while (atomic_load_explicit(&s->state, memory_order_acquire) != FC_DONE) {
+        //Become the combiner if nobody is
+        if (qlock_try(&q->lock)) {
+            fc_unlock(q);
+            continue;
+        }
+#ifdef QUEUE_STATS
+        if (t0 < 0) {
+            t0 = STATS_NOW();
+            STATS_ADD(q, contended, 1);
+        }
+#endif
+        //Another thread is combining: it will likely serve this slot too
+        lock_relax(&spins);
+    }
+#ifdef QUEUE_STATS
+    if (t0 >= 0) STATS_WAITED(q, t0);
+#endif
+    bool ok = s->ok;
+    //Give the slot back
+    atomic_store_explicit(&s->state, FC_FREE, memory_order_release);
+    return ok;
+}
+
+// Copy one esize-byte element in, through a publication slot
+static bool enqueue_copy(Queue *q, const void *src) {
+    bool ok = fc_apply(q, FC_ENQ, src, NULL);
+    if (ok) STATS_ADD(q, enqueued, 1);
+    else STATS_ADD(q, full, 1);
+    return ok;
+}
+
+// Copy the oldest element out (mirror of enqueue_copy)
+static bool dequeue_copy(Queue *q, void *dst) {
+    bool ok = fc_apply(q, FC_DEQ, NULL, dst);
+    if (ok) STATS_ADD(q, dequeued, 1);
+    else STATS_ADD(q, empty, 1);
+    return ok;
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value);
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out);
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return enqueue_copy(q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return dequeue_copy(q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+    //Acquire the combiner lock once for the whole batch
+    QUEUE_LOCK(q, &q->lock);
+    //Take as many values as there is free space
+    int k = q->capacity - q->size;
+    if (k > n) k = n;
+    //Copy the batch in
+    ring_copy_in(q->data, q->slots, sizeof(int),
+                 ring_slot(q->mask, q->slots, q->tail), values, (size_t)k);
+    q->tail += (uint64_t)k;
+    q->size += k;
+    STATS_HIGH_WATER(q, q->size);
+    //Serve the publication slots and release the lock
+    fc_unlock(q);
+    if (k > 0) STATS_ADD(q, enqueued, k);
+    else STATS_ADD(q, full, 1);
+    //Wake up to k blocked consumers, if any
+    if (k > 0) parker_wake(&q->not_empty, k);
+    return k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+    //Acquire the combiner lock once for the whole batch
+    QUEUE_LOCK(q, &q->lock);
+    //Take as many values as are available
+    int k = (q->size < max) ? q->size : max;
+    //Copy the batch out
+    ring_copy_out(q->data, q->slots, sizeof(int),
+                  ring_slot(q->mask, q->slots, q->head), out, (size_t)k);
+    q->head += (uint64_t)k;
+    q->size -= k;
+    //Serve the publication slots and release the lock
+    fc_unlock(q);
+    if (k > 0) STATS_ADD(q, dequeued, k);
+    else STATS_ADD(q, empty, 1);
+    //Wake up to k blocked producers, if any
+    if (k > 0) parker_wake(&q->not_full, k);
+    return k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+    //Acquire the combiner lock; on success it stays held until enqueue_commit
+    QUEUE_LOCK(q, &q->lock);
+    //Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->tail);
+    int room = q->capacity - q->size;
+    size_t k = ring_contig(q->slots, at, (size_t)(room < n ? room : n));
+    //Edge case: queue is full
+    if (k == 0) {
+        fc_unlock(q);
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    //Publish the filled slots
+    q->tail += (uint64_t)n;
+    q->size += n;
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, q->size);
+    //Release the lock taken by enqueue_reserve
+    fc_unlock(q);
+    //Wake up to n blocked consumers, if any
+    parker_wake(&q->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+    //Acquire the combiner lock; on success it stays held until dequeue_release
+    QUEUE_LOCK(q, &q->lock);
+    //Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->head);
+    size_t k = ring_contig(q->slots, at, (size_t)(q->size < max ? q->size : max));
+    //Edge case: queue is empty
+    if (k == 0) {
+        fc_unlock(q);
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    //Remove the consumed elements
+    q->head += (uint64_t)n;
+    q->size -= n;
+    STATS_ADD(q, dequeued, n);
+    //Release the lock taken by dequeue_peek
+    fc_unlock(q);
+    //Wake up to n blocked producers, if any
+    parker_wake(&q->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+bool is_empty(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return true;
+    //Acquire the lock
+    qlock_acquire((QLock *)&q->lock);
+    //Release it through fc_unlock, which serves posted operations first
+    int n = fc_unlock((Queue *)q);
+    return n == 0;
+}
+
+bool is_full(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return false;
+    //Acquire the lock
+    qlock_acquire((QLock *)&q->lock);
+    //Release it through fc_unlock, which serves posted operations first
+    int n = fc_unlock((Queue *)q);
+    return n == q->capacity;
+}
+
+int size(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    //Acquire the lock
+    qlock_acquire((QLock *)&q->lock);
+    //Release it through fc_unlock, which serves posted operations first
+    int n = fc_unlock((Queue *)q);
+    return n;
+}
+
+int capacity(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->elem_size;
+}
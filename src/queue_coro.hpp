@@ -0,0 +1,299 @@
+//queue_coro.hpp
+// C++20 coroutine wrapper over the queue library (queue.h, the MODE's
+// implementation): `co_await q.pop()` and `co_await q.push(v)` suspend
+// the calling coroutine instead of blocking its thread.
+//
+//   queue_coro::LoopExecutor ex;
+//   queue_coro::AsyncQueue<int> q(1024, ex);
+//   ... in a coroutine:  int v = co_await q.pop();  co_await q.push(v + 1);
+//   ex.run();
+//
+// A coroutine that finds the queue empty (full) is linked into an
+// intrusive list of waiters, the node living in its own coroutine frame,
+// so there is no allocation and no thread per waiter. The side that
+// makes room (a value) completes the oldest waiter's operation on its
+// behalf, then hands the coroutine to the user's executor to resume.
+// Pushes and pops that need not wait never take the waiter lock: one
+// fence and one load check for waiters, as with the C blocking calls
+// (park.h).
+//
+// Elements are copied in and out with enqueue_elem/dequeue_elem, so T
+// must be trivially copyable. Do not mix in the C calls on the same
+// queue: they would not resume the waiters.
+#ifndef QUEUE_CORO_HPP
+#define QUEUE_CORO_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+extern "C" {
+#include "queue.h"
+}
+
+namespace queue_coro {
+
+// Where resumed coroutines run. post() is called by whichever thread
+// completed the operation, after the queue's waiter lock is released;
+// it must schedule the resumption, not resume inline.
+class Executor {
+public:
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+protected:
+    ~Executor() = default;
+};
+
+// Single-threaded run loop: post() from any thread, run() on one
+class LoopExecutor final : public Executor {
+public:
+    void post(std::coroutine_handle<> h) override {
+        std::lock_guard<std::mutex> g(mu_);
+        ready_.push_back(h);
+    }
+
+    // Resume one posted coroutine; false if none is ready
+    bool run_one() {
+        std::coroutine_handle<> h;
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            if (ready_.empty()) return false;
+            h = ready_.front();
+            ready_.pop_front();
+        }
+        h.resume();
+        return true;
+    }
+
+    // Resume posted coroutines until none is ready
+    void run() {
+        while (run_one()) {}
+    }
+
+private:
+    std::mutex mu_;
+    std::deque<std::coroutine_handle<>> ready_;
+};
+
+// Fire-and-forget coroutine type: starts at once, frees itself at the end
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template <class T>
+class AsyncQueue {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      std::is_default_constructible<T>::value,
+                  "AsyncQueue elements are copied like the C queue's (trivially copyable T)");
+
+    // One suspended push or pop: lives in the awaiting coroutine's frame
+    struct Waiter {
+        Waiter *next = nullptr;
+        std::coroutine_handle<> handle;
+        T value{};   // pushed value, or where the popped one lands
+    };
+
+    // FIFO of waiters, guarded by mu_
+    struct WaiterList {
+        Waiter *head = nullptr;
+        Waiter *tail = nullptr;
+
+        void push(Waiter *w) {
+            w->next = nullptr;
+            if (tail) tail->next = w;
+            else head = w;
+            tail = w;
+        }
+
+        Waiter *pop() {
+            Waiter *w = head;
+            if (w) {
+                head = w->next;
+                if (!head) tail = nullptr;
+            }
+            return w;
+        }
+
+        void push_front(Waiter *w) {
+            w->next = head;
+            head = w;
+            if (!tail) tail = w;
+        }
+    };
+
+public:
+    class PopAwaiter {
+    public:
+        explicit PopAwaiter(AsyncQueue &q) : q_(q) {}
+
+        bool await_ready() {
+            if (!dequeue_elem(q_.q_, &w_.value)) return false;
+            q_.after_pop();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            w_.handle = h;
+            return q_.suspend(q_.poppers_, &w_, [this] {
+                return dequeue_elem(q_.q_, &w_.value);
+            });
+        }
+
+        T await_resume() { return w_.value; }
+
+    private:
+        AsyncQueue &q_;
+        Waiter w_;
+    };
+
+    class PushAwaiter {
+    public:
+        PushAwaiter(AsyncQueue &q, const T &value) : q_(q) { w_.value = value; }
+
+        bool await_ready() {
+            if (!enqueue_elem(q_.q_, &w_.value)) return false;
+            q_.after_push();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            w_.handle = h;
+            return q_.suspend(q_.pushers_, &w_, [this] {
+                return enqueue_elem(q_.q_, &w_.value);
+            });
+        }
+
+        void await_resume() noexcept {}
+
+    private:
+        AsyncQueue &q_;
+        Waiter w_;
+    };
+
+    // Throws std::bad_alloc if the queue cannot be created
+    AsyncQueue(int capacity, Executor &ex) : q_(create_sized(capacity, sizeof(T))), ex_(ex) {
+        if (!q_) throw std::bad_alloc();
+    }
+
+    ~AsyncQueue() { destroy(q_); }
+    AsyncQueue(const AsyncQueue &) = delete;
+    AsyncQueue &operator=(const AsyncQueue &) = delete;
+
+    // co_await: the oldest value, suspending while the queue is empty
+    PopAwaiter pop() { return PopAwaiter(*this); }
+    // co_await: enqueue value, suspending while the queue is full
+    PushAwaiter push(const T &value) { return PushAwaiter(*this, value); }
+
+    // Non-suspending forms: false if the queue is empty (full)
+    bool try_pop(T &out) {
+        if (!dequeue_elem(q_, &out)) return false;
+        after_pop();
+        return true;
+    }
+
+    bool try_push(const T &value) {
+        if (!enqueue_elem(q_, &value)) return false;
+        after_push();
+        return true;
+    }
+
+    int size() const { return ::size(q_); }
+    int capacity() const { return ::capacity(q_); }
+
+private:
+    // Register w, unless the operation succeeds on the re-check made
+    // under the lock (then the coroutine does not suspend). Counting the
+    // waiter before the re-check pairs with the fence in has_waiters:
+    // either the re-check sees the other side's change, or the other
+    // side sees the waiter.
+    template <class TryOp>
+    bool suspend(WaiterList &list, Waiter *w, TryOp try_op) {
+        bool done;
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            done = try_op();
+            if (done) waiters_.fetch_sub(1, std::memory_order_relaxed);
+            else list.push(w);
+        }
+        if (done) {
+            // Our own operation may unblock the other side
+            if (&list == &poppers_) after_pop();
+            else after_push();
+        }
+        return !done;
+    }
+
+    bool has_waiters() const {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return waiters_.load(std::memory_order_relaxed) != 0;
+    }
+
+    void after_push() {
+        if (has_waiters()) hand_off();
+    }
+
+    void after_pop() {
+        if (has_waiters()) hand_off();
+    }
+
+    // Complete waiting operations for as long as the queue allows: a
+    // popper takes a value, a pusher puts its value in. Each one done may
+    // unblock the other kind, so alternate until neither can proceed.
+    // The coroutines are posted after the lock is released.
+    void hand_off() {
+        WaiterList ready;
+        {
+            std::lock_guard<std::mutex> g(mu_);
+            bool progress = true;
+            while (progress) {
+                progress = false;
+                if (Waiter *w = poppers_.pop()) {
+                    if (dequeue_elem(q_, &w->value)) {
+                        ready.push(w);
+                        progress = true;
+                    } else {
+                        poppers_.push_front(w);
+                    }
+                }
+                if (Waiter *w = pushers_.pop()) {
+                    if (enqueue_elem(q_, &w->value)) {
+                        ready.push(w);
+                        progress = true;
+                    } else {
+                        pushers_.push_front(w);
+                    }
+                }
+            }
+        }
+        // Read next before posting: the resumed coroutine may free w
+        for (Waiter *w = ready.head; w;) {
+            Waiter *next = w->next;
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            ex_.post(w->handle);
+            w = next;
+        }
+    }
+
+    Queue *q_;
+    Executor &ex_;
+    std::mutex mu_;
+    WaiterList poppers_;
+    WaiterList pushers_;
+    std::atomic<int> waiters_{0};
+};
+
+} // namespace queue_coro
+
+#endif // QUEUE_CORO_HPP
@@ -0,0 +1,629 @@
+// queue_hier.c
+// Hierarchical NUMA queue (MODE=hier): one sub-queue per NUMA node, each a
+// single-lock ring (laid out like queue_v1.c) whose memory is bound to its
+// node (numa_mem.h). Threads work on the sub-queue of the node they run
+// on, so a producer and a consumer on the same socket never touch a
+// remote cache line. A consumer goes remote only when its own sub-queue
+// is empty, and then moves a batch of up to HIER_BATCH values into its
+// own sub-queue under one pair of lock acquisitions: one cross-socket
+// round trip for many values instead of one per value. Producers whose
+// sub-queue is full spill single values to the other nodes, like
+// queue_sharded.c.
+//
+// ORDERING: only per-node FIFO is guaranteed. A producer's values keep
+// their order only while none of them spilled or moved to another node.
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+#include "numa_mem.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+// Sub-queues used by create/create_sized; 0 means one per NUMA node
+#ifndef HIER_NODES
+#define HIER_NODES 0
+#endif
+
+// Most values one refill moves from a remote sub-queue
+#ifndef HIER_BATCH
+#define HIER_BATCH 32
+#endif
+
+// 0: homes always round-robin, even with one sub-queue per node (tests)
+#ifndef HIER_BY_CPU
+#define HIER_BY_CPU 1
+#endif
+
+// One node's sub-queue. The struct and its ring share one allocation
+// bound to the node.
+typedef struct {
+    _Alignas(CACHE_LINE) QLock lock;   // guards head, tail and the ring
+    uint64_t head;                     // count of values dequeued so far
+    uint64_t tail;                     // count of values enqueued so far
+    atomic_int size;                   // written under lock, read as a hint
+
+    // Read-only after create
+    unsigned char *data;   // slots * elem_size bytes, after this struct
+    int capacity;          // this sub-queue's share of the queue capacity
+    size_t slots;          // ring size (capacity, or rounded up to a power of two)
+    size_t mask;           // slots - 1 if slots is a power of two, else 0
+    size_t bytes;          // size of the allocation (struct + ring)
+    int node;              // node the allocation was bound to
+    unsigned mem;          // QUEUE_MEM_* flags in effect (numa_mem.h)
+} NodeQueue;
+
+struct Queue {
+    // Read-only after create
+    NodeQueue **nq;     // n_nodes sub-queues
+    int n_nodes;
+    bool by_cpu;        // home = node of the thread's CPU (else round-robin)
+    int node;           // node given to create_on_node, -1 for create/create_hier
+    int capacity;       // maximum number of elements (as requested)
+    size_t elem_size;   // bytes per element (sizeof(int) for int queues)
+
+    _Alignas(CACHE_LINE) Parker not_empty;   // consumers blocked in dequeue_wait
+    _Alignas(CACHE_LINE) Parker not_full;    // producers blocked in enqueue_wait
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;                   // per-thread counters (stats.h)
+#endif
+};
+
+#ifdef QUEUE_STATS
+// High water is over the whole queue, not one node
+static int snapshot_size(const Queue *q);
+#endif
+
+// A thread's node is looked up on its first call (pin threads for it to
+// stay right); without one node per sub-queue, threads go round-robin
+static _Thread_local int home_cpu_node = -1;
+static _Thread_local unsigned home_id = UINT_MAX;
+static atomic_uint next_home_id;
+
+// Calling thread's home sub-queue
+static inline int home_of(const Queue *q) {
+    if (q->by_cpu) {
+        if (home_cpu_node < 0) home_cpu_node = numa_mem_current_node();
+        return home_cpu_node % q->n_nodes;
+    }
+    if (home_id == UINT_MAX) {
+        home_id = atomic_fetch_add_explicit(&next_home_id, 1, memory_order_relaxed);
+    }
+    return (int)(home_id % (unsigned)q->n_nodes);
+}
+
+// i-th sub-queue in search order starting from `home`
+static inline NodeQueue *nq_at(const Queue *q, int home, int i) {
+    int n = home + i;
+    if (n >= q->n_nodes) n -= q->n_nodes;
+    return q->nq[n];
+}
+
+// Lock-free hints used to skip sub-queues without touching their locks
+static inline int nq_size(NodeQueue *nq) {
+    return atomic_load_explicit(&nq->size, memory_order_relaxed);
+}
+
+// Size change of a locked sub-queue
+static inline void nq_grow(NodeQueue *nq, int n) {
+    atomic_store_explicit(&nq->size, nq_size(nq) + n, memory_order_relaxed);
+}
+
+// Sub-queue whose ring contains slot (zero-copy commit/release)
+static NodeQueue *nq_of(const Queue *q, const void *slot) {
+    const unsigned char *p = (const unsigned char *)slot;
+    for (int i = 0; i < q->n_nodes; i++) {
+        NodeQueue *nq = q->nq[i];
+        if (p >= nq->data && p < nq->data + nq->slots * q->elem_size) return nq;
+    }
+    return NULL;
+}
+
+static void nq_free(NodeQueue *nq) {
+    qlock_destroy(&nq->lock);
+    numa_mem_ring_free(nq, nq->bytes, nq->mem);
+}
+
+// n_nodes sub-queues; node < 0 puts sub-queue i on node i (modulo the
+// machine's nodes), node >= 0 puts all of them on that node
+static Queue* create_nodes(int capacity, int n_nodes, size_t esize, int pow2, int node,
+                           unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    // Default: one sub-queue per node; never more sub-queues than elements
+    int machine = numa_mem_nodes();
+    if (n_nodes <= 0) n_nodes = machine;
+    if (n_nodes > capacity) n_nodes = capacity;
+
+    //Allocate the queue struct on its own cache lines
+    Queue *q = (Queue *)aligned_alloc(CACHE_LINE, sizeof(Queue));
+    //Edge case: allocation fails
+    if (!q) return NULL;
+    q->nq = (NodeQueue **)malloc(sizeof(NodeQueue *) * (size_t)n_nodes);
+    if (!q->nq) {
+        free(q);
+        return NULL;
+    }
+
+    //Initialize the queue fields
+    q->n_nodes = n_nodes;
+    q->by_cpu = HIER_BY_CPU && n_nodes == machine && machine > 1;
+    q->node = node;
+    q->capacity = capacity;
+    q->elem_size = esize;
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    //Make the sub-queues, each in memory of its node, splitting capacity
+    //as evenly as possible
+    size_t header = (sizeof(NodeQueue) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    for (int i = 0; i < n_nodes; i++) {
+        int cap = capacity / n_nodes + (i < capacity % n_nodes ? 1 : 0);
+        size_t slots = ring_slots_for(cap, pow2);
+        int on = node >= 0 ? node : i % machine;
+        unsigned got;
+        NodeQueue *nq = (NodeQueue *)numa_mem_ring_alloc(header + esize * slots, CACHE_LINE, on, mem, &got);
+        //Edge case: allocation fails, undo the sub-queues made so far
+        if (!nq) {
+            for (int j = 0; j < i; j++) nq_free(q->nq[j]);
+            free(q->nq);
+            free(q);
+            return NULL;
+        }
+        qlock_init(&nq->lock);
+        nq->head = 0;
+        nq->tail = 0;
+        atomic_init(&nq->size, 0);
+        nq->data = (unsigned char *)nq + header;
+        nq->capacity = cap;
+        nq->slots = slots;
+        nq->mask = ring_mask_for(slots);
+        nq->bytes = header + esize * slots;
+        nq->node = on;
+        nq->mem = got;
+        q->nq[i] = nq;
+    }
+
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_nodes(capacity, HIER_NODES, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_nodes(capacity, HIER_NODES, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_nodes(capacity, HIER_NODES, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_nodes(capacity, HIER_NODES, elem_size, 1, -1, 0);
+}
+
+Queue* create_hier(int capacity, int nodes) {
+    return create_nodes(capacity, nodes, sizeof(int), 0, -1, 0);
+}
+
+// A single sub-queue bound to node
+Queue* create_on_node(int capacity, int node) {
+    return create_nodes(capacity, 1, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+// The QUEUE_MEM_* options apply to every sub-queue; with QUEUE_MEM_NODE
+// there is one sub-queue, as from create_on_node
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    int node = numa_mem_opts_node(opts);
+    return create_nodes(capacity, node < 0 ? HIER_NODES : 1, esize, opts->pow2, node, opts->mem);
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+
+    // Free the sub-queues (caller must ensure no one is using q anymore)
+    for (int i = 0; i < q->n_nodes; i++) nq_free(q->nq[i]);
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    free(q->nq);
+    //Free the queue struct
+    free(q);
+}
+
+// Copy one value in at a locked sub-queue's tail
+static inline void nq_put(NodeQueue *nq, const void *src, size_t esize) {
+    size_t slot = ring_slot(nq->mask, nq->slots, nq->tail);
+    ring_elem_copy(nq->data + slot * esize, src, esize);
+    nq->tail++;
+}
+
+// Copy one value out at a locked sub-queue's head
+static inline void nq_take(NodeQueue *nq, void *dst, size_t esize) {
+    size_t slot = ring_slot(nq->mask, nq->slots, nq->head);
+    ring_elem_copy(dst, nq->data + slot * esize, esize);
+    nq->head++;
+}
+
+// Own sub-queue is empty: take one value from `far` for the caller and
+// move up to HIER_BATCH - 1 more into `own`, holding both locks once.
+// Locks are taken in address order, so two refills in opposite
+// directions cannot deadlock.
+static bool nq_refill(Queue *q, NodeQueue *own, NodeQueue *far, void *dst, size_t esize) {
+    NodeQueue *first = own < far ? own : far;
+    NodeQueue *second = own < far ? far : own;
+    QUEUE_LOCK(q, &first->lock);
+    QUEUE_LOCK(q, &second->lock);
+
+    int avail = nq_size(far);
+    bool ok = avail > 0;
+    if (ok) {
+        nq_take(far, dst, esize);
+        int k = avail - 1;
+        if (k > HIER_BATCH - 1) k = HIER_BATCH - 1;
+        if (k > own->capacity - nq_size(own)) k = own->capacity - nq_size(own);
+        if (k > 0) {
+            // far's values as at most two spans (split at its wrap), each
+            // copied in with ring_copy_in (split at own's wrap)
+            size_t from = ring_slot(far->mask, far->slots, far->head);
+            size_t n1 = ring_contig(far->slots, from, (size_t)k);
+            ring_copy_in(own->data, own->slots, esize,
+                         ring_slot(own->mask, own->slots, own->tail),
+                         far->data + from * esize, n1);
+            if ((size_t)k > n1) {
+                ring_copy_in(own->data, own->slots, esize,
+                             ring_slot(own->mask, own->slots, own->tail + n1),
+                             far->data, (size_t)k - n1);
+            }
+            far->head += (uint64_t)k;
+            own->tail += (uint64_t)k;
+        }
+        nq_grow(far, -1 - k);
+        nq_grow(own, k);
+    }
+
+    qlock_release(&second->lock);
+    qlock_release(&first->lock);
+    return ok;
+}
+
+// Copy one esize-byte element into the home sub-queue, or the next one
+// with room. Inlined with a constant esize for the int calls and the
+// common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    int home = home_of(q);
+
+    for (int i = 0; i < q->n_nodes; i++) {
+        NodeQueue *nq = nq_at(q, home, i);
+        // Spill only into sub-queues that look like they have room
+        if (i > 0 && nq_size(nq) >= nq->capacity) continue;
+
+        QUEUE_LOCK(q, &nq->lock);
+        bool ok = nq_size(nq) < nq->capacity;
+        if (ok) {
+            nq_put(nq, src, esize);
+            nq_grow(nq, 1);
+        }
+        qlock_release(&nq->lock);
+
+        if (ok) {
+            STATS_ADD(q, enqueued, 1);
+            STATS_HIGH_WATER(q, snapshot_size(q));
+            // Wake a blocked consumer, if any
+            parker_wake(&q->not_empty, 1);
+            return true;
+        }
+    }
+    // Every sub-queue is full
+    STATS_ADD(q, full, 1);
+    return false;
+}
+
+// Copy one element out of the home sub-queue, refilling it with a batch
+// from another node if it is empty (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    int home = home_of(q);
+    NodeQueue *own = q->nq[home];
+
+    bool ok = false;
+    if (nq_size(own) > 0) {
+        QUEUE_LOCK(q, &own->lock);
+        ok = nq_size(own) > 0;
+        if (ok) {
+            nq_take(own, dst, esize);
+            nq_grow(own, -1);
+        }
+        qlock_release(&own->lock);
+    }
+    // Own sub-queue is empty: go remote, one batch at a time
+    for (int i = 1; i < q->n_nodes && !ok; i++) {
+        NodeQueue *far = nq_at(q, home, i);
+        if (nq_size(far) == 0) continue;
+        ok = nq_refill(q, own, far, dst, esize);
+    }
+
+    if (!ok) {
+        // Every sub-queue is empty
+        STATS_ADD(q, empty, 1);
+        return false;
+    }
+    STATS_ADD(q, dequeued, 1);
+    // Wake a blocked producer, if any
+    parker_wake(&q->not_full, 1);
+    return true;
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    int home = home_of(q);
+    int done = 0;
+
+    // As much as fits into the home sub-queue under one lock, the rest spills
+    for (int i = 0; i < q->n_nodes && done < n; i++) {
+        NodeQueue *nq = nq_at(q, home, i);
+        if (i > 0 && nq_size(nq) >= nq->capacity) continue;
+
+        QUEUE_LOCK(q, &nq->lock);
+        int k = nq->capacity - nq_size(nq);
+        if (k > n - done) k = n - done;
+        ring_copy_in(nq->data, nq->slots, sizeof(int),
+                     ring_slot(nq->mask, nq->slots, nq->tail), values + done, (size_t)k);
+        nq->tail += (uint64_t)k;
+        nq_grow(nq, k);
+        qlock_release(&nq->lock);
+        done += k;
+    }
+
+    if (done > 0) {
+        STATS_ADD(q, enqueued, done);
+        STATS_HIGH_WATER(q, snapshot_size(q));
+    } else {
+        STATS_ADD(q, full, 1);
+    }
+
+    // Wake up to done blocked consumers, if any
+    if (done > 0) parker_wake(&q->not_empty, done);
+    return done;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    int home = home_of(q);
+    int done = 0;
+
+    // Home first, then straight from the other nodes: the caller's batch
+    // already amortizes the remote trip
+    for (int i = 0; i < q->n_nodes && done < max; i++) {
+        NodeQueue *nq = nq_at(q, home, i);
+        if (nq_size(nq) == 0) continue;
+
+        QUEUE_LOCK(q, &nq->lock);
+        int k = nq_size(nq);
+        if (k > max - done) k = max - done;
+        ring_copy_out(nq->data, nq->slots, sizeof(int),
+                      ring_slot(nq->mask, nq->slots, nq->head), out + done, (size_t)k);
+        nq->head += (uint64_t)k;
+        nq_grow(nq, -k);
+        qlock_release(&nq->lock);
+        done += k;
+    }
+
+    if (done > 0) STATS_ADD(q, dequeued, done);
+    else STATS_ADD(q, empty, 1);
+
+    // Wake up to done blocked producers, if any
+    if (done > 0) parker_wake(&q->not_full, done);
+    return done;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    int home = home_of(q);
+
+    for (int i = 0; i < q->n_nodes; i++) {
+        NodeQueue *nq = nq_at(q, home, i);
+        if (i > 0 && nq_size(nq) >= nq->capacity) continue;
+
+        // On success the sub-queue's lock stays held until enqueue_commit
+        QUEUE_LOCK(q, &nq->lock);
+        int room = nq->capacity - nq_size(nq);
+        size_t at = ring_slot(nq->mask, nq->slots, nq->tail);
+        size_t k = ring_contig(nq->slots, at, (size_t)(room < n ? room : n));
+        if (k > 0) {
+            *count = (int)k;
+            return nq->data + at * q->elem_size;
+        }
+        qlock_release(&nq->lock);
+    }
+    // Every sub-queue is full
+    STATS_ADD(q, full, 1);
+    return NULL;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    NodeQueue *nq = nq_of(q, slot);
+    if (!nq) return;
+
+    // Publish the filled slots
+    nq->tail += (uint64_t)n;
+    nq_grow(nq, n);
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, snapshot_size(q));
+
+    //Release the lock taken by enqueue_reserve
+    qlock_release(&nq->lock);
+
+    // Wake up to n blocked consumers, if any
+    parker_wake(&q->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    int home = home_of(q);
+
+    for (int i = 0; i < q->n_nodes; i++) {
+        NodeQueue *nq = nq_at(q, home, i);
+        if (nq_size(nq) == 0) continue;
+
+        // On success the sub-queue's lock stays held until dequeue_release
+        QUEUE_LOCK(q, &nq->lock);
+        int avail = nq_size(nq);
+        size_t at = ring_slot(nq->mask, nq->slots, nq->head);
+        size_t k = ring_contig(nq->slots, at, (size_t)(avail < max ? avail : max));
+        if (k > 0) {
+            *count = (int)k;
+            return nq->data + at * q->elem_size;
+        }
+        qlock_release(&nq->lock);
+    }
+    // Every sub-queue is empty
+    STATS_ADD(q, empty, 1);
+    return NULL;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    NodeQueue *nq = nq_of(q, slot);
+    if (!nq) return;
+
+    // Remove the consumed elements
+    nq->head += (uint64_t)n;
+    nq_grow(nq, -n);
+    STATS_ADD(q, dequeued, n);
+
+    //Release the lock taken by dequeue_peek
+    qlock_release(&nq->lock);
+
+    // Wake up to n blocked producers, if any
+    parker_wake(&q->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+// Sum of the sub-queue sizes. Exact when no operation is in flight,
+// approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    int total = 0;
+    for (int i = 0; i < q->n_nodes; i++) total += nq_size(q->nq[i]);
+    return total;
+}
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no lock/atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL or not made by create_on_node (its sub-queues
+    //are spread over the nodes)
+    if (!q || q->node < 0 || !(q->nq[0]->mem & QUEUE_MEM_NODE)) return -1;
+    return q->node;
+}
+
+// Flags that took effect on every sub-queue (QUEUE_MEM_NODE only for a
+// queue on one node, see queue_node)
+unsigned queue_mem(const Queue *q) {
+    if (!q) return 0;
+    unsigned mem = NUMA_MEM_FLAGS;
+    for (int i = 0; i < q->n_nodes; i++) mem &= q->nq[i]->mem;
+    return q->node < 0 ? mem & ~QUEUE_MEM_NODE : mem;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
+
+int hier_nodes(const Queue *q) {
+    if (!q) return 0;
+    return q->n_nodes;
+}
@@ -0,0 +1,557 @@
+// queue_lockfree.c
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "stats.h"
+#include "numa_mem.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+// One slot of the ring. `seq` tells which ticket may use the slot next:
+//   seq == pos       -> free, the producer holding ticket pos may write it
+//   seq == pos + 1   -> full, the consumer holding ticket pos may read it
+// After a read the consumer sets seq = pos + slots (free for the next lap).
+// The element (elem_size bytes) is stored inline right after the header, so
+// cells are `stride` bytes apart rather than sizeof(Cell).
+typedef struct {
+    _Atomic uint64_t seq;
+} Cell;
+
+// Internal representation: bounded MPMC ring (Vyukov style).
+// Producers and consumers claim tickets with a CAS on tail/head, which
+// sit on separate cache lines so the two sides do not false-share.
+// Tickets are monotonically increasing 64-bit counters (slot = ring_slot).
+struct Queue {
+    unsigned char *cells; // slots cells of stride bytes each
+    size_t stride;  // sizeof(Cell) + elem_size, rounded up to keep seq aligned
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity;   // maximum number of elements (as requested)
+    size_t slots;   // ring size (capacity, or rounded up to a power of two)
+    size_t mask;    // slots - 1 if slots is a power of two, else 0
+    int node;       // node given to create_on_node/create_ex, -1 if none
+    unsigned mem;     // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+    _Alignas(CACHE_LINE) _Atomic uint64_t tail;   // next ticket to enqueue
+    Parker not_empty;                             // consumers blocked in dequeue_wait
+    _Alignas(CACHE_LINE) _Atomic uint64_t head;   // next ticket to dequeue
+    Parker not_full;                              // producers blocked in enqueue_wait
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;                        // per-thread counters (stats.h)
+#endif
+};
+
+// A ring rounded up to a power of two has more slots than the caller asked
+// for; the slot sequence numbers alone would let it hold `slots` values, so
+// producers also check ticket pos against head to honour the capacity.
+// pos is a possibly stale copy of tail, so head may already be past it:
+// the difference is signed, and ROOM_STALE tells the caller to reload tail.
+enum { ROOM_OK, ROOM_FULL, ROOM_STALE };
+
+static inline int check_capacity(Queue *q, uint64_t pos) {
+    if (q->slots == (size_t)q->capacity) return ROOM_OK;
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    int64_t used = (int64_t)(pos - head);
+    if (used < 0) return ROOM_STALE;
+    return (used >= q->capacity) ? ROOM_FULL : ROOM_OK;
+}
+
+// Cell holding ticket pos, and the element stored in it
+static inline Cell *cell_at(const Queue *q, uint64_t pos) {
+    return (Cell *)(q->cells + ring_slot(q->mask, q->slots, pos) * q->stride);
+}
+
+static inline void *cell_value(Cell *cell) {
+    return (unsigned char *)cell + sizeof(Cell);
+}
+
+#ifdef QUEUE_STATS
+// Queue length right after tickets up to end (exclusive) were claimed
+static inline uint64_t stats_len(Queue *q, uint64_t end) {
+    return end - atomic_load_explicit(&q->head, memory_order_relaxed);
+}
+#endif
+
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    //Allocate the queue struct on its own cache lines
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), CACHE_LINE, node, &bound);
+    //Edge case: allocation fails
+    if (!q) return NULL;
+
+    //Allocate memory for the cells
+    q->slots = ring_slots_for(capacity, pow2);
+    //Edge case: with one slot a full cell's seq equals the next lap's free
+    //seq, so use two and let check_capacity enforce the capacity
+    if (q->slots < 2) q->slots = 2;
+    q->stride = (sizeof(Cell) + esize + _Alignof(Cell) - 1) / _Alignof(Cell) * _Alignof(Cell);
+    q->cells = (unsigned char *)numa_mem_ring_alloc(q->stride * q->slots, _Alignof(max_align_t), node, mem, &q->mem);
+    //Edge case: malloc fails
+    if (!q->cells) {
+        numa_mem_free(q, sizeof(Queue), node);
+        return NULL;
+    }
+
+    //Initialize the queue fields: slot i is free for ticket i
+    q->elem_size = esize;
+    q->node = node;
+    q->capacity = capacity;
+    q->mask = ring_mask_for(q->slots);
+    for (size_t i = 0; i < q->slots; i++) {
+        atomic_init(&cell_at(q, i)->seq, (uint64_t)i);
+    }
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    //Free the cells (caller must ensure no one is using q anymore)
+    numa_mem_ring_free(q->cells, q->stride * q->slots, q->mem);
+    //Free the queue struct
+    numa_mem_free(q, sizeof(Queue), q->node);
+}
+
+// Copy one esize-byte element in under a fresh ticket. Inlined with a
+// constant esize for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for (;;) {
+        Cell *cell = cell_at(q, pos);
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+
+        if (dif == 0) {
+            // Slot is free, but the ring may be over the requested capacity
+            int room = check_capacity(q, pos);
+            if (room == ROOM_FULL) {
+                STATS_ADD(q, full, 1);
+                return false;
+            }
+            if (room == ROOM_STALE) {
+                // Consumers moved past our copy of tail; catch up
+                STATS_ADD(q, contended, 1);
+                pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+                continue;
+            }
+            // Slot is free for this ticket: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                // Write the element, then publish it to the consumer
+                ring_elem_copy(cell_value(cell), src, esize);
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                STATS_ADD(q, enqueued, 1);
+                STATS_HIGH_WATER(q, stats_len(q, pos + 1));
+                // Wake a blocked consumer, if any
+                parker_wake(&q->not_empty, 1);
+                return true;
+            }
+            // CAS failure reloaded pos; retry with the new ticket
+            STATS_ADD(q, contended, 1);
+        } else if (dif < 0) {
+            // Slot still holds the previous lap's value: queue is full
+            STATS_ADD(q, full, 1);
+            return false;
+        } else {
+            // Another producer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+}
+
+// Copy the element of the next ticket out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        Cell *cell = cell_at(q, pos);
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - (pos + 1));
+
+        if (dif == 0) {
+            // Slot is full for this ticket: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                // Read the element, then hand the slot to the next lap
+                ring_elem_copy(dst, cell_value(cell), esize);
+                atomic_store_explicit(&cell->seq, pos + q->slots, memory_order_release);
+                STATS_ADD(q, dequeued, 1);
+                // Wake a blocked producer, if any
+                parker_wake(&q->not_full, 1);
+                return true;
+            }
+            STATS_ADD(q, contended, 1);
+        } else if (dif < 0) {
+            // Producer for this ticket has not published yet: queue is empty
+            STATS_ADD(q, empty, 1);
+            return false;
+        } else {
+            // Another consumer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for (;;) {
+        // Count the run of consecutive slots that are free for tickets
+        // pos, pos+1, ... so the whole run can be claimed with one CAS
+        uint64_t want = (uint64_t)n;
+        if (q->slots != (size_t)q->capacity) {
+            // Rounded-up ring: never go past the requested capacity
+            uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+            int64_t used = (int64_t)(pos - head);
+            if (used < 0) {
+                // Consumers moved past our copy of tail; catch up
+                STATS_ADD(q, contended, 1);
+                pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+                continue;
+            }
+            uint64_t room = (used < q->capacity) ? (uint64_t)(q->capacity - used) : 0;
+            if (room < want) want = room;
+        }
+
+        uint64_t k = 0;
+        while (k < want) {
+            uint64_t seq = atomic_load_explicit(&cell_at(q, pos + k)->seq, memory_order_acquire);
+            if (seq != pos + k) break;
+            k++;
+        }
+
+        if (k == 0) {
+            uint64_t seq = atomic_load_explicit(&cell_at(q, pos)->seq, memory_order_acquire);
+            // Slot still holds the previous lap's value: queue is full
+            if ((int64_t)(seq - pos) < 0 || want == 0) {
+                STATS_ADD(q, full, 1);
+                return 0;
+            }
+            // Another producer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + k,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            // Tickets pos .. pos+k-1 are ours: write and publish each slot
+            for (uint64_t i = 0; i < k; i++) {
+                Cell *cell = cell_at(q, pos + i);
+                ring_elem_copy(cell_value(cell), &values[i], sizeof(int));
+                atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+            }
+            STATS_ADD(q, enqueued, k);
+            STATS_HIGH_WATER(q, stats_len(q, pos + k));
+            // Wake up to k blocked consumers, if any
+            parker_wake(&q->not_empty, (int)k);
+            return (int)k;
+        }
+        // CAS failure reloaded pos; rescan from the new ticket
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        // Count the run of consecutive slots already published for tickets
+        // pos, pos+1, ... so the whole run can be claimed with one CAS
+        uint64_t k = 0;
+        while (k < (uint64_t)max) {
+            uint64_t seq = atomic_load_explicit(&cell_at(q, pos + k)->seq, memory_order_acquire);
+            if (seq != pos + k + 1) break;
+            k++;
+        }
+
+        if (k == 0) {
+            uint64_t seq = atomic_load_explicit(&cell_at(q, pos)->seq, memory_order_acquire);
+            // Producer for this ticket has not published yet: queue is empty
+            if ((int64_t)(seq - (pos + 1)) < 0) {
+                STATS_ADD(q, empty, 1);
+                return 0;
+            }
+            // Another consumer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + k,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            // Tickets pos .. pos+k-1 are ours: read each slot and release it
+            for (uint64_t i = 0; i < k; i++) {
+                Cell *cell = cell_at(q, pos + i);
+                ring_elem_copy(&out[i], cell_value(cell), sizeof(int));
+                atomic_store_explicit(&cell->seq, pos + i + q->slots, memory_order_release);
+            }
+            STATS_ADD(q, dequeued, k);
+            // Wake up to k blocked producers, if any
+            parker_wake(&q->not_full, (int)k);
+            return (int)k;
+        }
+        // CAS failure reloaded pos; rescan from the new ticket
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+// Zero-copy calls: the payloads of neighbouring cells are not adjacent
+// (each has its own seq header), so a reservation or peek covers exactly
+// one cell. The claimed ticket is recovered from the cell's seq, which
+// nobody else touches until the commit/release.
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for (;;) {
+        Cell *cell = cell_at(q, pos);
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+
+        if (dif == 0) {
+            // Slot is free, but the ring may be over the requested capacity
+            int room = check_capacity(q, pos);
+            if (room == ROOM_FULL) {
+                STATS_ADD(q, full, 1);
+                return NULL;
+            }
+            if (room == ROOM_STALE) {
+                // Consumers moved past our copy of tail; catch up
+                STATS_ADD(q, contended, 1);
+                pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+                continue;
+            }
+            // Slot is free for this ticket: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *count = 1;
+                return cell_value(cell);
+            }
+            STATS_ADD(q, contended, 1);
+        } else if (dif < 0) {
+            // Slot still holds the previous lap's value: queue is full
+            STATS_ADD(q, full, 1);
+            return NULL;
+        } else {
+            // Another producer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled, and it is always one cell
+    (void)ring_zc_count(n);
+
+    // seq still holds our ticket pos: publish the cell as pos + 1
+    Cell *cell = (Cell *)((unsigned char *)slot - sizeof(Cell));
+    uint64_t pos = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, stats_len(q, pos + 1));
+    // Wake a blocked consumer, if any
+    parker_wake(&q->not_empty, 1);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        Cell *cell = cell_at(q, pos);
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - (pos + 1));
+
+        if (dif == 0) {
+            // Slot is full for this ticket: try to claim it
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *count = 1;
+                return cell_value(cell);
+            }
+            STATS_ADD(q, contended, 1);
+        } else if (dif < 0) {
+            // Producer for this ticket has not published yet: queue is empty
+            STATS_ADD(q, empty, 1);
+            return NULL;
+        } else {
+            // Another consumer claimed this ticket; catch up
+            STATS_ADD(q, contended, 1);
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A peek cannot be cancelled, and it is always one cell
+    (void)ring_zc_count(n);
+
+    // seq still holds our ticket pos + 1: free the cell for the next lap
+    Cell *cell = (Cell *)((unsigned char *)slot - sizeof(Cell));
+    uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_relaxed);
+    atomic_store_explicit(&cell->seq, seq - 1 + q->slots, memory_order_release);
+    STATS_ADD(q, dequeued, 1);
+    // Wake a blocked producer, if any
+    parker_wake(&q->not_full, 1);
+}
+
+// Snapshot of tail - head, clamped to [0, capacity].
+// Exact when no operation is in flight, approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    int64_t s = (int64_t)(tail - head);
+    if (s < 0) return 0;
+    if (s > q->capacity) return q->capacity;
+    return (int)s;
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
@@ -0,0 +1,142 @@
+// queue_notify.c
+// Event-loop integration on top of any queue implementation: an eventfd
+// per parking spot (see park.h) that an epoll/poll loop can wait on next
+// to its sockets.
+//
+// Each fd is edge-coalesced. While armed it counts as one waiter on its
+// parker, so the first wake after arming takes parker_wake's slow path,
+// disarms the fd and writes to it; every later wake sees no waiter and
+// costs nothing, until the consumer finds the queue empty again and
+// re-arms it (dequeue_or_arm / enqueue_or_arm). One write() per
+// empty -> non-empty (or full -> not-full) edge, not per element.
+#define _GNU_SOURCE
+#include "queue.h"
+#include "park.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+void parker_signal_fd(Parker *p) {
+    // Only the wake that flips armed 1 -> 0 writes
+    if (atomic_load_explicit(&p->armed, memory_order_relaxed) == 0) return;
+    if (atomic_exchange_explicit(&p->armed, 0, memory_order_acq_rel) == 0) return;
+#ifdef __linux__
+    eventfd_write(atomic_load_explicit(&p->fd, memory_order_relaxed), 1);
+#endif
+    atomic_fetch_sub_explicit(&p->waiters, 1, memory_order_relaxed);
+}
+
+void parker_destroy(Parker *p) {
+#ifdef __linux__
+    int fd = atomic_load_explicit(&p->fd, memory_order_relaxed);
+    if (fd >= 0) close(fd);
+#endif
+    atomic_store_explicit(&p->fd, -1, memory_order_relaxed);
+}
+
+// Arm the fd for the next wake. The waiter is counted before armed is
+// set (and dropped again if it already was), so waiters never
+// under-counts the futex sleepers while a wake disarms the fd.
+static void parker_arm(Parker *p) {
+    parker_prepare(p);
+    atomic_fetch_add_explicit(&p->waiters, 1, memory_order_seq_cst);
+    if (atomic_exchange_explicit(&p->armed, 1, memory_order_seq_cst)) {
+        atomic_fetch_sub_explicit(&p->waiters, 1, memory_order_relaxed);
+    }
+}
+
+// Eventfd of p, created and armed on first use; -1 if unsupported
+static int parker_get_fd(Parker *p) {
+    //Edge case: the implementation has no parkers (sequential queue)
+    if (!p) return -1;
+#ifdef PARK_SHARED
+    //Edge case: p is shared between processes (MODE=shm), where an fd
+    //number in p would mean nothing to the other side
+    return -1;
+#endif
+
+    int fd = atomic_load_explicit(&p->fd, memory_order_acquire);
+    if (fd >= 0) return fd;
+
+#ifdef __linux__
+    int nfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (nfd < 0) return -1;
+    // Another thread may have created one at the same time: keep theirs
+    if (!atomic_compare_exchange_strong_explicit(&p->fd, &fd, nfd,
+                                                 memory_order_acq_rel,
+                                                 memory_order_acquire)) {
+        close(nfd);
+        return fd;
+    }
+    parker_arm(p);
+    return nfd;
+#else
+    return -1;
+#endif
+}
+
+// Drain the fd's counter so epoll stops reporting it (non-blocking)
+static void parker_clear_fd(Parker *p) {
+#ifdef __linux__
+    eventfd_t v;
+    eventfd_read(atomic_load_explicit(&p->fd, memory_order_relaxed), &v);
+#else
+    (void)p;
+#endif
+}
+
+int queue_get_fd(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    Parker *p = queue_not_empty_parker(q);
+    int fd = parker_get_fd(p);
+    // Already non-empty: report it right away
+    if (fd >= 0 && !is_empty(q)) parker_signal_fd(p);
+    return fd;
+}
+
+int queue_get_space_fd(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    Parker *p = queue_not_full_parker(q);
+    int fd = parker_get_fd(p);
+    // Already has room: report it right away
+    if (fd >= 0 && !is_full(q)) parker_signal_fd(p);
+    return fd;
+}
+
+bool dequeue_or_arm(Queue *q, int *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    if (dequeue(q, out)) return true;
+
+    Parker *p = queue_not_empty_parker(q);
+    //Edge case: no fd yet, nothing to arm
+    if (!p || atomic_load_explicit(&p->fd, memory_order_acquire) < 0) return false;
+
+    // Empty: clear the fd, arm it, then re-check so an enqueue that ran
+    // before the arm is not missed (one after it will signal the fd)
+    parker_clear_fd(p);
+    parker_arm(p);
+    return dequeue(q, out);
+}
+
+bool enqueue_or_arm(Queue *q, int value) {
+    //Edge case: q is NULL
+    if (!q) return false;
+    if (enqueue(q, value)) return true;
+
+    Parker *p = queue_not_full_parker(q);
+    //Edge case: no fd yet, nothing to arm
+    if (!p || atomic_load_explicit(&p->fd, memory_order_acquire) < 0) return false;
+
+    // Full: same protocol as dequeue_or_arm
+    parker_clear_fd(p);
+    parker_arm(p);
+    return enqueue(q, value);
+}
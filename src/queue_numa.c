@@ -0,0 +1,161 @@
+// queue_numa.c
+// Memory placement for every implementation (see numa_mem.h): node count
+// and current node from sysfs/getcpu, page allocations bound with mbind,
+// rings on huge, pre-faulted or mlocked pages for create_ex.
+// Everything degrades to "one node, unbound 4 KB pages" when the machine
+// or kernel cannot do better.
+#define _GNU_SOURCE
+#include "numa_mem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// mbind policy (linux/mempolicy.h): allocate only on the given nodes
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+// Node mask words passed to mbind (nodes 0..NUMA_MAX_NODES-1)
+#define NUMA_MAX_NODES 1024
+#define MASK_BITS (8 * sizeof(unsigned long))
+
+// Bookkeeping bits of numa_mem_ring_alloc's *got, above the QUEUE_MEM_* flags
+#define MEM_MAPPED  0x10000u   // mmap'd (else aligned_alloc)
+#define MEM_HUGETLB 0x20000u   // MAP_HUGETLB: length is whole huge pages
+
+static atomic_int n_nodes;   // 0 until first read
+static atomic_size_t huge_size;   // 0 until first read
+
+// Highest number in a sysfs list such as "0", "0-1" or "0,2-3"
+static int list_max(FILE *f) {
+    int max = -1, v;
+    char sep;
+    while (fscanf(f, "%d", &v) == 1) {
+        if (v > max) max = v;
+        if (fscanf(f, "%c", &sep) != 1 || (sep != ',' && sep != '-')) break;
+    }
+    return max;
+}
+
+int numa_mem_nodes(void) {
+    int n = atomic_load_explicit(&n_nodes, memory_order_relaxed);
+    if (n > 0) return n;
+    n = 1;
+    FILE *f = fopen("/sys/devices/system/node/online", "r");
+    if (f) {
+        int max = list_max(f);
+        fclose(f);
+        if (max >= 1 && max < NUMA_MAX_NODES) n = max + 1;
+    }
+    atomic_store_explicit(&n_nodes, n, memory_order_relaxed);
+    return n;
+}
+
+int numa_mem_current_node(void) {
+    unsigned cpu = 0, node = 0;
+    //Edge case: no getcpu, or a node past what numa_mem_nodes reports
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) return 0;
+    return (int)node < numa_mem_nodes() ? (int)node : 0;
+}
+
+// Default huge page size from /proc/meminfo ("Hugepagesize: 2048 kB")
+static size_t huge_page_size(void) {
+    size_t n = atomic_load_explicit(&huge_size, memory_order_relaxed);
+    if (n > 0) return n;
+    n = 2u << 20;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f) {
+        char line[128];
+        unsigned long kb;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1 && kb > 0) {
+                n = (size_t)kb << 10;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    atomic_store_explicit(&huge_size, n, memory_order_relaxed);
+    return n;
+}
+
+static size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+void *numa_mem_ring_alloc(size_t bytes, size_t align, int node, unsigned flags, unsigned *got) {
+    *got = 0;
+    //Edge case: nothing to allocate
+    if (bytes == 0) return NULL;
+    if (flags & QUEUE_MEM_LOCK) flags |= QUEUE_MEM_PREFAULT;
+
+    //No node and no page options: plain allocation (size rounded up to the alignment)
+    if (node < 0 && !(flags & (QUEUE_MEM_HUGE | QUEUE_MEM_PREFAULT))) {
+        return aligned_alloc(align, round_up(bytes, align));
+    }
+
+    //Whole pages, so the options apply to nothing else. Huge pages from
+    //the reserved pool first, else 4 KB pages with the THP advice.
+    int prot = PROT_READ | PROT_WRITE, map = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t len = bytes;
+    void *p = MAP_FAILED;
+    if (flags & QUEUE_MEM_HUGE) {
+        len = round_up(bytes, huge_page_size());
+        p = mmap(NULL, len, prot, map | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) *got |= QUEUE_MEM_HUGE | MEM_HUGETLB;
+    }
+    if (p == MAP_FAILED) {
+        len = bytes;
+        p = mmap(NULL, len, prot, map, -1, 0);
+        //Edge case: out of memory
+        if (p == MAP_FAILED) return NULL;
+        if ((flags & QUEUE_MEM_HUGE) && madvise(p, len, MADV_HUGEPAGE) == 0) *got |= QUEUE_MEM_HUGE;
+    }
+    *got |= MEM_MAPPED;
+
+    //Bind before anything touches the pages; unbound if node does not exist
+    if (node >= 0 && node < numa_mem_nodes()) {
+        unsigned long mask[NUMA_MAX_NODES / MASK_BITS] = {0};
+        mask[node / MASK_BITS] = 1UL << (node % MASK_BITS);
+        // maxnode counts one past the last bit the kernel should read
+        if (syscall(SYS_mbind, p, len, MPOL_BIND, mask,
+                    (unsigned long)NUMA_MAX_NODES + 1, 0UL) == 0) *got |= QUEUE_MEM_NODE;
+    }
+
+    //Fault every page in now (writing zeros keeps the contents), once bound
+    if (flags & QUEUE_MEM_PREFAULT) {
+        size_t step = (*got & MEM_HUGETLB) ? huge_page_size() : (size_t)sysconf(_SC_PAGESIZE);
+        for (size_t off = 0; off < len; off += step) ((volatile unsigned char *)p)[off] = 0;
+        *got |= QUEUE_MEM_PREFAULT;
+    }
+    //Edge case: over RLIMIT_MEMLOCK, the ring stays pageable
+    if ((flags & QUEUE_MEM_LOCK) && mlock(p, len) == 0) *got |= QUEUE_MEM_LOCK;
+    return p;
+}
+
+void numa_mem_ring_free(void *p, size_t bytes, unsigned got) {
+    //Edge case: p is NULL
+    if (!p) return;
+    if (!(got & MEM_MAPPED)) free(p);
+    else munmap(p, (got & MEM_HUGETLB) ? round_up(bytes, huge_page_size()) : bytes);
+}
+
+void *numa_mem_alloc(size_t bytes, size_t align, int node, bool *bound) {
+    unsigned got;
+    void *p = numa_mem_ring_alloc(bytes, align, node, 0, &got);
+    *bound = (got & QUEUE_MEM_NODE) != 0;
+    return p;
+}
+
+void numa_mem_free(void *p, size_t bytes, int node) {
+    numa_mem_ring_free(p, bytes, node < 0 ? 0 : MEM_MAPPED);
+}
+
+int numa_mem_opts_node(const QueueOptions *opts) {
+    if (!opts || !(opts->mem & QUEUE_MEM_NODE)) return -1;
+    return opts->node < 0 ? numa_mem_current_node() : opts->node;
+}
@@ -0,0 +1,807 @@
+// queue_segmented.c
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+// Cells per segment for large queues (power of two). Smaller queues use
+// capacity rounded up to a power of two.
+#ifndef SEGMENT_CELLS
+#define SEGMENT_CELLS 1024
+#endif
+
+// Drained segments kept for reuse; the rest go back to the allocator
+#ifndef FREE_SEGMENTS_MAX
+#define FREE_SEGMENTS_MAX 4
+#endif
+
+// Epoch slots threads are spread over (shared slots are fine, just slower)
+#define EBR_SLOTS 64
+
+// Internal representation: unbounded MPMC queue made of linked fixed-size
+// segments ("ring of rings"). Tickets are monotonically increasing 64-bit
+// counters as in the lock-free ring: ticket t lives in cell t % seglen of
+// segment t / seglen. Producers claim tickets on tail and append segments
+// on demand; consumers claim published cells on head. A segment whose
+// cells have all been read is unlinked, retired, and recycled through a
+// small free list once no thread can still hold a pointer to it
+// (epoch-based reclamation). There is no global resize step: memory grows
+// and shrinks one segment at a time. capacity still bounds the number of
+// queued elements; create(INT_MAX) gives an effectively unbounded queue.
+
+enum { CELL_EMPTY = 0, CELL_FULL = 1 };
+
+// One cell; the element (elem_size bytes) is stored right after it.
+typedef struct {
+    _Atomic uint32_t state;   // CELL_EMPTY until the producer publishes
+    uint32_t index;           // position in its segment (cell -> segment)
+} Cell;
+
+typedef struct Segment {
+    _Atomic(struct Segment *) next;   // newer segment, NULL at the tail
+    uint64_t id;                      // holds tickets id*seglen .. id*seglen+seglen-1
+    _Atomic uint32_t consumed;        // cells read so far; seglen -> retirable
+    uint64_t retire_epoch;            // epoch at which it was unlinked
+    struct Segment *link;             // free list / retired list
+    _Alignas(8) unsigned char cells[];
+} Segment;
+
+// Per-slot count of threads inside an operation, by epoch parity
+typedef struct {
+    _Alignas(CACHE_LINE) atomic_ulong active[2];
+} EbrSlot;
+
+struct Queue {
+    // Read-only after create
+    size_t elem_size;   // bytes per element (sizeof(int) for int queues)
+    size_t stride;      // sizeof(Cell) + elem_size, rounded up to keep Cell aligned
+    int capacity;       // maximum number of elements (as requested)
+    bool unbounded;     // capacity == INT_MAX: no capacity check on enqueue
+    uint32_t seglen;    // cells per segment (power of two)
+    unsigned shift;     // log2(seglen)
+
+    // Segment allocation and reclamation (rare: once per seglen operations)
+    QLock seg_lock;      // protects free_list, retired, epoch advances
+    Segment *free_list;       // drained segments ready for reuse
+    int free_count;
+    Segment *retired;         // unlinked segments waiting for a grace period
+    _Atomic int live;         // segments linked into the queue
+
+    // Producer side
+    _Alignas(CACHE_LINE) _Atomic uint64_t tail;   // next ticket to enqueue
+    _Atomic(Segment *) tail_seg;                  // hint: segment near tail
+    Parker not_empty;                             // consumers blocked in dequeue_wait
+
+    // Consumer side
+    _Alignas(CACHE_LINE) _Atomic uint64_t head;   // next ticket to dequeue
+    _Atomic(Segment *) head_seg;                  // oldest linked segment
+    Parker not_full;                              // producers blocked in enqueue_wait
+
+    // Epoch-based reclamation
+    _Alignas(CACHE_LINE) _Atomic uint64_t epoch;
+    EbrSlot ebr[EBR_SLOTS];
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;    // per-thread counters (stats.h)
+#endif
+};
+
+static _Thread_local unsigned ebr_my_slot = UINT_MAX;
+static atomic_uint ebr_next_slot;
+
+static inline Cell *seg_cell(const Queue *q, Segment *seg, uint64_t pos) {
+    return (Cell *)(seg->cells + (size_t)(pos & (q->seglen - 1)) * q->stride);
+}
+
+static inline void *cell_value(Cell *cell) {
+    return (unsigned char *)cell + sizeof(Cell);
+}
+
+// Segment a cell belongs to (used by commit/release, which only get the cell)
+static inline Segment *cell_segment(const Queue *q, Cell *cell) {
+    return (Segment *)((unsigned char *)cell - (size_t)cell->index * q->stride
+                       - offsetof(Segment, cells));
+}
+
+// ---------------------------------------------------------------------
+// Epoch-based reclamation: every operation that follows segment pointers
+// runs between ebr_enter and ebr_exit. A retired segment is reused only
+// after the epoch has advanced twice, i.e. once every thread that could
+// have seen it linked has left its operation.
+// ---------------------------------------------------------------------
+static inline EbrSlot *ebr_slot(Queue *q) {
+    if (ebr_my_slot == UINT_MAX) {
+        ebr_my_slot = atomic_fetch_add_explicit(&ebr_next_slot, 1, memory_order_relaxed);
+    }
+    return &q->ebr[ebr_my_slot % EBR_SLOTS];
+}
+
+static inline uint64_t ebr_enter(Queue *q) {
+    EbrSlot *s = ebr_slot(q);
+    for (;;) {
+        uint64_t e = atomic_load_explicit(&q->epoch, memory_order_seq_cst);
+        atomic_fetch_add_explicit(&s->active[e & 1], 1, memory_order_seq_cst);
+        // Epoch moved while we announced ourselves: announce again
+        if (atomic_load_explicit(&q->epoch, memory_order_seq_cst) == e) return e;
+        atomic_fetch_sub_explicit(&s->active[e & 1], 1, memory_order_release);
+    }
+}
+
+static inline void ebr_exit(Queue *q, uint64_t e) {
+    atomic_fetch_sub_explicit(&ebr_slot(q)->active[e & 1], 1, memory_order_release);
+}
+
+// Put a segment on the free list, or free it if the list is full.
+// Caller holds seg_lock.
+static void seg_release_locked(Queue *q, Segment *seg) {
+    if (q->free_count < FREE_SEGMENTS_MAX) {
+        seg->link = q->free_list;
+        q->free_list = seg;
+        q->free_count++;
+    } else {
+        free(seg);
+    }
+}
+
+// Advance the epoch if no thread is still in the previous one, then
+// recycle the retired segments whose grace period is over.
+// Caller holds seg_lock.
+static void ebr_reclaim_locked(Queue *q) {
+    uint64_t e = atomic_load_explicit(&q->epoch, memory_order_seq_cst);
+    bool quiet = true;
+    for (int i = 0; i < EBR_SLOTS && quiet; i++) {
+        quiet = atomic_load_explicit(&q->ebr[i].active[(e + 1) & 1], memory_order_seq_cst) == 0;
+    }
+    if (quiet) atomic_store_explicit(&q->epoch, ++e, memory_order_seq_cst);
+
+    Segment **pp = &q->retired;
+    while (*pp) {
+        Segment *seg = *pp;
+        if (seg->retire_epoch + 2 <= e) {
+            *pp = seg->link;
+            seg_release_locked(q, seg);
+        } else {
+            pp = &seg->link;
+        }
+    }
+}
+
+static void seg_retire(Queue *q, Segment *seg) {
+    atomic_fetch_sub_explicit(&q->live, 1, memory_order_relaxed);
+    QUEUE_LOCK(q, &q->seg_lock);
+    seg->retire_epoch = atomic_load_explicit(&q->epoch, memory_order_seq_cst);
+    seg->link = q->retired;
+    q->retired = seg;
+    ebr_reclaim_locked(q);
+    qlock_release(&q->seg_lock);
+}
+
+// A fresh segment for tickets id*seglen.., from the free list if possible
+static Segment *seg_alloc(Queue *q, uint64_t id) {
+    QUEUE_LOCK(q, &q->seg_lock);
+    Segment *seg = q->free_list;
+    if (seg) {
+        q->free_list = seg->link;
+        q->free_count--;
+    }
+    qlock_release(&q->seg_lock);
+
+    if (!seg) {
+        seg = (Segment *)malloc(sizeof(Segment) + (size_t)q->seglen * q->stride);
+        //Edge case: malloc fails
+        if (!seg) return NULL;
+    }
+
+    atomic_init(&seg->next, NULL);
+    seg->id = id;
+    atomic_init(&seg->consumed, 0);
+    seg->link = NULL;
+    for (uint32_t i = 0; i < q->seglen; i++) {
+        Cell *cell = seg_cell(q, seg, i);
+        atomic_init(&cell->state, CELL_EMPTY);
+        cell->index = i;
+    }
+    return seg;
+}
+
+// Unlink and retire fully read segments from the head of the list.
+// Needs a successor to exist, so producers call it too after appending.
+static void advance_head(Queue *q) {
+    Segment *seg = atomic_load_explicit(&q->head_seg, memory_order_acquire);
+    for (;;) {
+        if (atomic_load_explicit(&seg->consumed, memory_order_acquire) != q->seglen) return;
+        Segment *next = atomic_load_explicit(&seg->next, memory_order_acquire);
+        if (!next) return;
+        // CAS failure reloads seg with the current head segment
+        if (!atomic_compare_exchange_strong_explicit(&q->head_seg, &seg, next,
+                                                     memory_order_acq_rel,
+                                                     memory_order_acquire)) {
+            continue;
+        }
+        // Every producer of seg has published, so none will point the
+        // tail hint at it again; move the hint past it if it lags
+        Segment *expected = seg;
+        atomic_compare_exchange_strong_explicit(&q->tail_seg, &expected, next,
+                                                memory_order_acq_rel,
+                                                memory_order_relaxed);
+        seg_retire(q, seg);
+        seg = next;
+    }
+}
+
+// Segment holding producer ticket pos, appended if it does not exist yet.
+// pos may already be taken by another producer (and its segment retired);
+// claim_tail then fails its CAS and does not use the result.
+// Returns NULL only if a new segment cannot be allocated.
+static Segment *producer_segment(Queue *q, uint64_t pos) {
+    uint64_t target = pos >> q->shift;
+    Segment *seg = atomic_load_explicit(&q->tail_seg, memory_order_acquire);
+    // Hint already past the ticket: unless the ticket is already taken, its
+    // cell is unread, so its segment is still linked somewhere after head_seg
+    if (seg->id > target) seg = atomic_load_explicit(&q->head_seg, memory_order_acquire);
+
+    bool appended = false;
+    while (seg->id < target) {
+        Segment *next = atomic_load_explicit(&seg->next, memory_order_acquire);
+        if (!next) {
+            Segment *fresh = seg_alloc(q, seg->id + 1);
+            if (!fresh) return NULL;
+            // CAS failure loads the segment another producer appended
+            if (atomic_compare_exchange_strong_explicit(&seg->next, &next, fresh,
+                                                        memory_order_acq_rel,
+                                                        memory_order_acquire)) {
+                atomic_fetch_add_explicit(&q->live, 1, memory_order_relaxed);
+                next = fresh;
+                appended = true;
+            } else {
+                QUEUE_LOCK(q, &q->seg_lock);
+                seg_release_locked(q, fresh);
+                qlock_release(&q->seg_lock);
+            }
+        }
+        seg = next;
+    }
+
+    // The old head segment may have been waiting for a successor
+    if (appended) advance_head(q);
+    return seg;
+}
+
+// Move the tail hint forward to seg. Called once a ticket in seg is held
+// and before its cell is published, so the hint never names a segment
+// that may already be retired.
+static void advance_tail_hint(Queue *q, Segment *seg) {
+    Segment *hint = atomic_load_explicit(&q->tail_seg, memory_order_acquire);
+    while (hint->id < seg->id &&
+           !atomic_compare_exchange_weak_explicit(&q->tail_seg, &hint, seg,
+                                                  memory_order_acq_rel,
+                                                  memory_order_acquire)) {
+    }
+}
+
+// Claim up to n consecutive producer tickets starting at *pos, all in
+// segment *seg (so at most up to its end). The segment is found, or
+// appended, before the tickets are taken: a ticket whose segment could
+// not be allocated would never be published, and consumers would stop at
+// it for good. Caller is inside ebr_enter/ebr_exit.
+// Returns how many were claimed: 0 if the queue is at capacity, -1 if a
+// new segment cannot be allocated (nothing claimed either way).
+static int claim_tail(Queue *q, int n, uint64_t *pos, Segment **seg) {
+    uint64_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    for (;;) {
+        int k = n;
+        if (!q->unbounded) {
+            uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+            int64_t used = (int64_t)(t - head);
+            if (used < 0) used = 0;
+            int64_t room = (int64_t)q->capacity - used;
+            if (room <= 0) return 0;
+            if (room < (int64_t)k) k = (int)room;
+        }
+        uint32_t left = q->seglen - (uint32_t)(t & (q->seglen - 1));
+        if ((uint32_t)k > left) k = (int)left;
+
+        Segment *s = producer_segment(q, t);
+        //Edge case: no memory for a new segment
+        if (!s) return -1;
+        // CAS failure reloads t; retry with the new ticket (a segment we
+        // appended stays linked for whoever claims its tickets)
+        if (atomic_compare_exchange_weak_explicit(&q->tail, &t, t + (uint64_t)k,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            advance_tail_hint(q, s);
+            *pos = t;
+            *seg = s;
+            return k;
+        }
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+// Segment holding consumer ticket pos, or NULL if producers have not
+// reached it yet. *stale is set when pos is behind head_seg.
+static Segment *consumer_segment(Queue *q, uint64_t pos, bool *stale) {
+    uint64_t target = pos >> q->shift;
+    Segment *seg = atomic_load_explicit(&q->head_seg, memory_order_acquire);
+    *stale = seg->id > target;
+    if (*stale) return NULL;
+    while (seg && seg->id < target) {
+        seg = atomic_load_explicit(&seg->next, memory_order_acquire);
+    }
+    return seg;
+}
+
+// Count one more read cell of seg, retiring it once all have been read
+static inline void mark_consumed(Queue *q, Segment *seg, uint32_t n) {
+    uint32_t done = atomic_fetch_add_explicit(&seg->consumed, n, memory_order_acq_rel) + n;
+    if (done == q->seglen) advance_head(q);
+}
+
+static Queue* create_segmented(int capacity, size_t esize) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    //Allocate the queue struct on its own cache lines
+    Queue *q = (Queue *)aligned_alloc(CACHE_LINE, sizeof(Queue));
+    //Edge case: allocation fails
+    if (!q) return NULL;
+
+    //Initialize the queue fields
+    q->elem_size = esize;
+    q->stride = (sizeof(Cell) + esize + _Alignof(Cell) - 1) / _Alignof(Cell) * _Alignof(Cell);
+    q->capacity = capacity;
+    q->unbounded = (capacity == INT_MAX);
+    q->seglen = (uint32_t)ring_round_pow2(capacity < SEGMENT_CELLS ? (size_t)capacity
+                                                                   : SEGMENT_CELLS);
+    q->shift = 0;
+    while ((1u << q->shift) < q->seglen) q->shift++;
+
+    qlock_init(&q->seg_lock);
+    q->free_list = NULL;
+    q->free_count = 0;
+    q->retired = NULL;
+    atomic_init(&q->epoch, 0);
+    for (int i = 0; i < EBR_SLOTS; i++) {
+        atomic_init(&q->ebr[i].active[0], 0);
+        atomic_init(&q->ebr[i].active[1], 0);
+    }
+
+    //Allocate the first segment
+    Segment *seg = seg_alloc(q, 0);
+    //Edge case: allocation fails
+    if (!seg) {
+        qlock_destroy(&q->seg_lock);
+        free(q);
+        return NULL;
+    }
+    atomic_init(&q->live, 1);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail_seg, seg);
+    atomic_init(&q->head_seg, seg);
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    return q;
+}
+
+// Segments are always a power of two, so create and create_pow2 (and the
+// sized variants) build the same queue.
+Queue* create(int capacity) {
+    return create_segmented(capacity, sizeof(int));
+}
+
+Queue* create_pow2(int capacity) {
+    return create_segmented(capacity, sizeof(int));
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_segmented(capacity, elem_size);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_segmented(capacity, elem_size);
+}
+
+// Segments come and go with the load, so there is no single ring to place:
+// the node is ignored and queue_node reports -1 (see MODE=hier)
+Queue* create_on_node(int capacity, int node) {
+    (void)node;
+    return create_segmented(capacity, sizeof(int));
+}
+
+// Same for the QUEUE_MEM_* options: segments are malloc'd as the queue
+// grows, so only the element size applies (queue_mem reports 0)
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    return create_segmented(capacity, opts && opts->elem_size ? opts->elem_size : sizeof(int));
+}
+
+static void free_chain(Segment *seg, bool by_next) {
+    while (seg) {
+        Segment *n = by_next ? atomic_load_explicit(&seg->next, memory_order_relaxed)
+                             : seg->link;
+        free(seg);
+        seg = n;
+    }
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+    //Free linked, retired and cached segments (caller must ensure no one
+    //is using q anymore)
+    free_chain(atomic_load_explicit(&q->head_seg, memory_order_relaxed), true);
+    free_chain(q->retired, false);
+    free_chain(q->free_list, false);
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    qlock_destroy(&q->seg_lock);
+    //Free the queue struct
+    free(q);
+}
+
+// Copy one esize-byte element in under a fresh ticket. Inlined with a
+// constant esize for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    uint64_t e = ebr_enter(q);
+    uint64_t pos;
+    Segment *seg;
+    int k = claim_tail(q, 1, &pos, &seg);
+    // Queue is at capacity, or no memory for a new segment
+    if (k <= 0) {
+        ebr_exit(q, e);
+        if (k == 0) STATS_ADD(q, full, 1);
+        return false;
+    }
+    // Write the element, then publish it to consumers
+    Cell *cell = seg_cell(q, seg, pos);
+    ring_elem_copy(cell_value(cell), src, esize);
+    atomic_store_explicit(&cell->state, CELL_FULL, memory_order_release);
+    ebr_exit(q, e);
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, pos + 1 - atomic_load_explicit(&q->head, memory_order_relaxed));
+
+    // Wake a blocked consumer, if any
+    parker_wake(&q->not_empty, 1);
+    return true;
+}
+
+// Copy the element of the next ticket out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    uint64_t e = ebr_enter(q);
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        bool stale;
+        Segment *seg = consumer_segment(q, pos, &stale);
+        Cell *cell = seg ? seg_cell(q, seg, pos) : NULL;
+
+        if (!cell || atomic_load_explicit(&cell->state, memory_order_acquire) != CELL_FULL) {
+            // Another consumer took this ticket meanwhile; catch up
+            uint64_t now = atomic_load_explicit(&q->head, memory_order_relaxed);
+            if (stale || now != pos) {
+                STATS_ADD(q, contended, 1);
+                pos = now;
+                continue;
+            }
+            // Producer for this ticket has not published yet: queue is empty
+            ebr_exit(q, e);
+            STATS_ADD(q, empty, 1);
+            return false;
+        }
+
+        // Cell is published for this ticket: try to claim it
+        if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            ring_elem_copy(dst, cell_value(cell), esize);
+            mark_consumed(q, seg, 1);
+            ebr_exit(q, e);
+            STATS_ADD(q, dequeued, 1);
+            // Wake a blocked producer, if any
+            parker_wake(&q->not_full, 1);
+            return true;
+        }
+        // CAS failure reloaded pos; retry with the new ticket
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    // One claim per segment the batch spans
+    uint64_t e = ebr_enter(q);
+    int k = 0;
+    while (k < n) {
+        uint64_t pos;
+        Segment *seg;
+        int m = claim_tail(q, n - k, &pos, &seg);
+        // Queue is at capacity, or no memory for a new segment
+        if (m <= 0) {
+            if (m == 0 && k == 0) STATS_ADD(q, full, 1);
+            break;
+        }
+        for (int i = 0; i < m; i++) {
+            Cell *cell = seg_cell(q, seg, pos + (uint64_t)i);
+            ring_elem_copy(cell_value(cell), &values[k + i], sizeof(int));
+            atomic_store_explicit(&cell->state, CELL_FULL, memory_order_release);
+        }
+        k += m;
+        STATS_HIGH_WATER(q, pos + (uint64_t)m - atomic_load_explicit(&q->head, memory_order_relaxed));
+    }
+    ebr_exit(q, e);
+    if (k > 0) STATS_ADD(q, enqueued, k);
+
+    // Wake up to k blocked consumers, if any
+    if (k > 0) parker_wake(&q->not_empty, k);
+    return k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    uint64_t e = ebr_enter(q);
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        bool stale;
+        Segment *first = consumer_segment(q, pos, &stale);
+
+        // Count the run of published cells for tickets pos, pos+1, ...
+        // (possibly across segments) so it can be claimed with one CAS
+        int k = 0;
+        Segment *seg = first;
+        while (seg && k < max) {
+            uint64_t t = pos + (uint64_t)k;
+            if (k > 0 && (t & (q->seglen - 1)) == 0) {
+                seg = atomic_load_explicit(&seg->next, memory_order_acquire);
+                if (!seg) break;
+            }
+            if (atomic_load_explicit(&seg_cell(q, seg, t)->state,
+                                     memory_order_acquire) != CELL_FULL) break;
+            k++;
+        }
+
+        if (k == 0) {
+            // Another consumer took this ticket meanwhile; catch up
+            uint64_t now = atomic_load_explicit(&q->head, memory_order_relaxed);
+            if (stale || now != pos) {
+                STATS_ADD(q, contended, 1);
+                pos = now;
+                continue;
+            }
+            // Producer for this ticket has not published yet: queue is empty
+            ebr_exit(q, e);
+            STATS_ADD(q, empty, 1);
+            return 0;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + (uint64_t)k,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            // Tickets pos .. pos+k-1 are ours: read them segment by segment
+            seg = first;
+            int i = 0;
+            while (i < k) {
+                Segment *next = atomic_load_explicit(&seg->next, memory_order_acquire);
+                uint32_t n = 0;
+                do {
+                    uint64_t t = pos + (uint64_t)i;
+                    ring_elem_copy(&out[i], cell_value(seg_cell(q, seg, t)), sizeof(int));
+                    i++;
+                    n++;
+                } while (i < k && ((pos + (uint64_t)i) & (q->seglen - 1)) != 0);
+                mark_consumed(q, seg, n);
+                seg = next;
+            }
+            ebr_exit(q, e);
+            STATS_ADD(q, dequeued, k);
+            // Wake up to k blocked producers, if any
+            parker_wake(&q->not_full, k);
+            return k;
+        }
+        // CAS failure reloaded pos; rescan from the new ticket
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+// Zero-copy calls: a reservation or peek covers exactly one cell (cells
+// carry a header, so payloads are not adjacent). The cell's segment cannot
+// be retired while the cell is reserved or peeked, since retiring needs
+// every cell of the segment to have been released.
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    uint64_t e = ebr_enter(q);
+    uint64_t pos;
+    Segment *seg;
+    int k = claim_tail(q, 1, &pos, &seg);
+    ebr_exit(q, e);
+    // Queue is at capacity, or no memory for a new segment
+    if (k <= 0) {
+        if (k == 0) STATS_ADD(q, full, 1);
+        return NULL;
+    }
+
+    *count = 1;
+    return cell_value(seg_cell(q, seg, pos));
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled, and it is always one cell
+    (void)ring_zc_count(n);
+
+    Cell *cell = (Cell *)((unsigned char *)slot - sizeof(Cell));
+    atomic_store_explicit(&cell->state, CELL_FULL, memory_order_release);
+    STATS_ADD(q, enqueued, 1);
+    // Wake a blocked consumer, if any
+    parker_wake(&q->not_empty, 1);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    uint64_t e = ebr_enter(q);
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;) {
+        bool stale;
+        Segment *seg = consumer_segment(q, pos, &stale);
+        Cell *cell = seg ? seg_cell(q, seg, pos) : NULL;
+
+        if (!cell || atomic_load_explicit(&cell->state, memory_order_acquire) != CELL_FULL) {
+            // Another consumer took this ticket meanwhile; catch up
+            uint64_t now = atomic_load_explicit(&q->head, memory_order_relaxed);
+            if (stale || now != pos) {
+                STATS_ADD(q, contended, 1);
+                pos = now;
+                continue;
+            }
+            // Producer for this ticket has not published yet: queue is empty
+            ebr_exit(q, e);
+            STATS_ADD(q, empty, 1);
+            return NULL;
+        }
+
+        // Cell is published for this ticket: try to claim it
+        if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            ebr_exit(q, e);
+            *count = 1;
+            return cell_value(cell);
+        }
+        // CAS failure reloaded pos; retry with the new ticket
+        STATS_ADD(q, contended, 1);
+    }
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A peek cannot be cancelled, and it is always one cell
+    (void)ring_zc_count(n);
+
+    Cell *cell = (Cell *)((unsigned char *)slot - sizeof(Cell));
+    uint64_t e = ebr_enter(q);
+    mark_consumed(q, cell_segment(q, cell), 1);
+    ebr_exit(q, e);
+    STATS_ADD(q, dequeued, 1);
+    // Wake a blocked producer, if any
+    parker_wake(&q->not_full, 1);
+}
+
+// Snapshot of tail - head, clamped to [0, capacity].
+// Exact when no operation is in flight, approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    int64_t s = (int64_t)(tail - head);
+    if (s < 0) return 0;
+    if (s > q->capacity) return q->capacity;
+    return (int)s;
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    (void)q;
+    return -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    (void)q;
+    return 0;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
+
+int live_segments(const Queue *q) {
+    if (!q) return 0;
+    return atomic_load_explicit(&q->live, memory_order_relaxed);
+}
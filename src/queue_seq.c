@@ -1,101 +1,309 @@
 // queue_seq.c
 #include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "stats.h"
+#include "numa_mem.h"
 
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 // Internal representation: bounded circular buffer (sequential).
+// head/tail are monotonically increasing 64-bit counters; the slot of a
+// counter is counter & mask when the ring size is a power of two.
 struct Queue {
-    int *data;      // array of length capacity
-    int capacity;   // maximum number of elements
-    int head;       // index of next element to dequeue
-    int tail;       // index of next slot to enqueue
-    int size;       // current number of elements
+    void *data;     // array of length slots, elem_size bytes per slot
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity;   // maximum number of elements (as requested)
+    size_t slots;   // ring size (capacity, or rounded up to a power of two)
+    size_t mask;    // slots - 1 if slots is a power of two, else 0
+    int node;       // node given to create_on_node/create_ex, -1 if none
+    unsigned mem;     // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+    uint64_t head;  // count of elements dequeued so far
+    uint64_t tail;  // count of elements enqueued so far
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats; // counters (stats.h)
+#endif
 };
 
-Queue* create(int capacity) {
-    // Edge case: capacity <= 0
-    if (capacity <= 0) return NULL;
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) {
+    // Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
 
-    // Allocate memory for the queue struct
-    Queue *q = (Queue *)malloc(sizeof(Queue));
+    // Allocate memory for the queue struct (cache-line aligned if it holds stats)
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), _Alignof(Queue), node, &bound);
     if (!q) return NULL;
 
     // Allocate memory for the data array
-    q->data = (int *)malloc(sizeof(int) * capacity);
+    q->slots = ring_slots_for(capacity, pow2);
+    q->data = numa_mem_ring_alloc(esize * q->slots, _Alignof(max_align_t), node, mem, &q->mem);
     if (!q->data) {
-        free(q);
+        numa_mem_free(q, sizeof(Queue), node);
         return NULL;
     }
 
     // Initialize fields
+    q->elem_size = esize;
+    q->node = node;
     q->capacity = capacity;
+    q->mask = ring_mask_for(q->slots);
     q->head = 0;
     q->tail = 0;
-    q->size = 0;
+    STATS_INIT(q);
 
     return q;
 }
 
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
+
 void destroy(Queue *q) {
     //Edge case: q is NULL
     if (!q) return;
     //Free the data array
-    free(q->data);
+    numa_mem_ring_free(q->data, q->elem_size * q->slots, q->mem);
     //Free the queue struct
-    free(q);
+    numa_mem_free(q, sizeof(Queue), q->node);
 }
 
-bool enqueue(Queue *q, int value) {
-    //Edge case: q is NULL
-    if (!q) return false;
-
+// Copy one esize-byte element in at tail. Inlined with a constant esize
+// for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
     // Queue is full
-    if (q->size == q->capacity) {
+    if (q->tail - q->head == (uint64_t)q->capacity) {
+        STATS_ADD(q, full, 1);
         return false;
     }
 
-    // Enqueue the value at tail
-    q->data[q->tail] = value;
-    q->tail = (q->tail + 1) % q->capacity;
-    q->size++;
+    // Enqueue the element at tail
+    size_t slot = ring_slot(q->mask, q->slots, q->tail);
+    ring_elem_copy((char *)q->data + slot * esize, src, esize);
+    q->tail++;
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, q->tail - q->head);
+
+    return true;
+}
+
+// Copy the element at head out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    // Queue is empty
+    if (q->tail == q->head) {
+        STATS_ADD(q, empty, 1);
+        return false;
+    }
+    // Dequeue the element at head
+    size_t slot = ring_slot(q->mask, q->slots, q->head);
+    ring_elem_copy(dst, (const char *)q->data + slot * esize, esize);
+    q->head++;
+    STATS_ADD(q, dequeued, 1);
 
     return true;
 }
 
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
 bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
     //Edge case: q or out is NULL
     if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
 
-    // Queue is empty
-    if (q->size == 0) {
-        return false;
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    // Take as many values as there is free space
+    int k = q->capacity - (int)(q->tail - q->head);
+    if (k > n) k = n;
+
+    // Copy the batch in and advance tail past it
+    ring_copy_in(q->data, q->slots, sizeof(int),
+                 ring_slot(q->mask, q->slots, q->tail), values, (size_t)k);
+    q->tail += (uint64_t)k;
+    if (k > 0) {
+        STATS_ADD(q, enqueued, k);
+        STATS_HIGH_WATER(q, q->tail - q->head);
+    } else {
+        STATS_ADD(q, full, 1);
     }
-    // Dequeue the value at head
-    *out = q->data[q->head];
-    q->head = (q->head + 1) % q->capacity;
-    q->size--;
 
-    return true;
+    return k;
 }
 
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    // Take as many values as are available
+    int s = (int)(q->tail - q->head);
+    int k = (s < max) ? s : max;
+
+    // Copy the batch out and advance head past it
+    ring_copy_out(q->data, q->slots, sizeof(int),
+                  ring_slot(q->mask, q->slots, q->head), out, (size_t)k);
+    q->head += (uint64_t)k;
+    if (k > 0) STATS_ADD(q, dequeued, k);
+    else STATS_ADD(q, empty, 1);
+
+    return k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    // Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->tail);
+    size_t room = (size_t)q->capacity - (size_t)(q->tail - q->head);
+    size_t k = ring_contig(q->slots, at, room < (size_t)n ? room : (size_t)n);
+    //Queue is full
+    if (k == 0) {
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    q->tail += (uint64_t)n;
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, q->tail - q->head);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    // Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->head);
+    size_t avail = (size_t)(q->tail - q->head);
+    size_t k = ring_contig(q->slots, at, avail < (size_t)max ? avail : (size_t)max);
+    //Queue is empty
+    if (k == 0) {
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    q->head += (uint64_t)n;
+    STATS_ADD(q, dequeued, n);
+}
+
+// Single-threaded queue: nothing else can make room or add values,
+// so the blocking calls never park (they behave like a single try).
+Parker *queue_not_full_parker(Queue *q) {
+    (void)q;
+    return NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    (void)q;
+    return NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
 bool is_empty(const Queue *q) {
     if (!q) return true;
-    return (q->size == 0);
+    return (q->tail == q->head);
 }
 
 bool is_full(const Queue *q) {
     if (!q) return false;
-    return (q->size == q->capacity);
+    return (q->tail - q->head == (uint64_t)q->capacity);
 }
 
 int size(const Queue *q) {
     if (!q) return 0;
-    return q->size;
+    return (int)(q->tail - q->head);
 }
 
 int capacity(const Queue *q) {
     if (!q) return 0;
     return q->capacity;
 }
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
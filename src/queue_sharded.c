@@ -0,0 +1,630 @@
+// queue_sharded.c
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+#include "numa_mem.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <omp.h>
+
+#define CACHE_LINE 64
+
+// Lanes used by create/create_sized; 0 means one per OpenMP thread
+// (omp_get_max_threads() at create time)
+#ifndef SHARDED_LANES
+#define SHARDED_LANES 0
+#endif
+
+// Internal representation: N independent bounded rings ("lanes"), each
+// laid out like queue.c: tail_lock/tail and head_lock/head on separate
+// cache lines, with a cached copy of the opposite counter. The requested
+// capacity is split across the lanes.
+//
+// Each thread has a home lane (threads are spread round-robin over the
+// lanes on first use). Producers enqueue into their home lane and only
+// spill into the next lanes when it is full; consumers drain their home
+// lane first and then steal from the others, try-locking victims so
+// thieves do not queue up behind each other. With one thread per lane,
+// producers and consumers mostly touch disjoint locks and throughput
+// scales with the number of lanes instead of one lock hand-off per
+// operation.
+//
+// ORDERING: only per-lane FIFO is guaranteed. Values that went into the
+// same lane come out in the order they went in; there is no order
+// between lanes. In particular one producer's values keep their order
+// only while none of them spilled out of its home lane, and a consumer
+// may see a newer value from one lane before an older value from another.
+// Use create_sharded(capacity, 1) for a strict FIFO queue.
+
+typedef struct {
+    // Producer side (guarded by tail_lock)
+    _Alignas(CACHE_LINE) QLock tail_lock;   // protects tail movement
+    _Atomic uint64_t tail;                       // next value to enqueue
+    uint64_t head_cache;                         // producers' last view of head
+
+    // Consumer side (guarded by head_lock)
+    _Alignas(CACHE_LINE) QLock head_lock;   // protects head movement
+    _Atomic uint64_t head;                       // next value to dequeue
+    uint64_t tail_cache;                         // consumers' last view of tail
+
+    // Read-only after create
+    _Alignas(CACHE_LINE) unsigned char *data;    // slots * elem_size bytes
+    int capacity;   // this lane's share of the queue capacity
+    size_t slots;   // ring size (capacity, or rounded up to a power of two)
+    size_t mask;    // slots - 1 if slots is a power of two, else 0
+    size_t bytes;   // size of data
+    unsigned mem;   // QUEUE_MEM_* flags in effect for data (numa_mem.h)
+} Lane;
+
+struct Queue {
+    // Read-only after create
+    Lane *lanes;        // n_lanes lanes
+    int n_lanes;
+    int capacity;       // maximum number of elements (as requested)
+    size_t elem_size;   // bytes per element (sizeof(int) for int queues)
+
+    _Alignas(CACHE_LINE) Parker not_empty;   // consumers blocked in dequeue_wait
+    _Alignas(CACHE_LINE) Parker not_full;    // producers blocked in enqueue_wait
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;                   // per-thread counters (stats.h)
+#endif
+};
+
+#ifdef QUEUE_STATS
+// High water is over the whole queue, not one lane
+static int snapshot_size(const Queue *q);
+#endif
+
+static _Thread_local unsigned home_id = UINT_MAX;
+static atomic_uint next_home_id;
+
+// Calling thread's home lane, assigned round-robin on first use
+static inline int home_lane(const Queue *q) {
+    if (home_id == UINT_MAX) {
+        home_id = atomic_fetch_add_explicit(&next_home_id, 1, memory_order_relaxed);
+    }
+    return (int)(home_id % (unsigned)q->n_lanes);
+}
+
+// i-th lane in search order starting from lane `home`
+static inline Lane *lane_at(const Queue *q, int home, int i) {
+    int l = home + i;
+    if (l >= q->n_lanes) l -= q->n_lanes;
+    return &q->lanes[l];
+}
+
+// Lock-free hints used to skip lanes without touching their locks
+static inline bool lane_looks_empty(Lane *ln) {
+    return atomic_load_explicit(&ln->tail, memory_order_relaxed) ==
+           atomic_load_explicit(&ln->head, memory_order_relaxed);
+}
+
+static inline bool lane_looks_full(Lane *ln) {
+    return atomic_load_explicit(&ln->tail, memory_order_relaxed) -
+           atomic_load_explicit(&ln->head, memory_order_relaxed) >= (uint64_t)ln->capacity;
+}
+
+// Take a lock: blocking, or a single try (used while stealing)
+static inline bool lane_lock(Queue *q, QLock *lock, bool wait) {
+    if (wait) {
+        QUEUE_LOCK(q, lock);
+        return true;
+    }
+    if (qlock_try(lock)) return true;
+    STATS_ADD(q, contended, 1);
+    return false;
+}
+
+// Free slots of a lane; tail_lock must be held
+static inline uint64_t lane_room(Lane *ln, uint64_t tail, uint64_t want) {
+    uint64_t cap = (uint64_t)ln->capacity;
+    uint64_t room = cap - (tail - ln->head_cache);
+    // Not enough room according to the cached head: refresh it
+    if (room < want) {
+        ln->head_cache = atomic_load_explicit(&ln->head, memory_order_acquire);
+        room = cap - (tail - ln->head_cache);
+    }
+    return room;
+}
+
+// Queued values of a lane; head_lock must be held
+static inline uint64_t lane_avail(Lane *ln, uint64_t head, uint64_t want) {
+    uint64_t avail = ln->tail_cache - head;
+    // Fewer values than requested according to the cached tail: refresh it
+    if (avail < want) {
+        ln->tail_cache = atomic_load_explicit(&ln->tail, memory_order_acquire);
+        avail = ln->tail_cache - head;
+    }
+    return avail;
+}
+
+// Lane whose ring contains slot (zero-copy commit/release)
+static Lane *lane_of(const Queue *q, const void *slot) {
+    const unsigned char *p = (const unsigned char *)slot;
+    for (int i = 0; i < q->n_lanes; i++) {
+        Lane *ln = &q->lanes[i];
+        if (p >= ln->data && p < ln->data + ln->slots * q->elem_size) return ln;
+    }
+    return NULL;
+}
+
+static Queue* create_lanes(int capacity, int n_lanes, size_t esize, int pow2, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    // Default: one lane per thread; never more lanes than elements
+    if (n_lanes <= 0) n_lanes = omp_get_max_threads();
+    if (n_lanes > capacity) n_lanes = capacity;
+
+    //Allocate the queue struct and the lanes on their own cache lines
+    Queue *q = (Queue *)aligned_alloc(CACHE_LINE, sizeof(Queue));
+    //Edge case: allocation fails
+    if (!q) return NULL;
+    q->lanes = (Lane *)aligned_alloc(CACHE_LINE, sizeof(Lane) * (size_t)n_lanes);
+    if (!q->lanes) {
+        free(q);
+        return NULL;
+    }
+
+    //Initialize the queue fields
+    q->n_lanes = n_lanes;
+    q->capacity = capacity;
+    q->elem_size = esize;
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    //Initialize the lanes, splitting capacity as evenly as possible
+    for (int i = 0; i < n_lanes; i++) {
+        Lane *ln = &q->lanes[i];
+        ln->capacity = capacity / n_lanes + (i < capacity % n_lanes ? 1 : 0);
+        ln->slots = ring_slots_for(ln->capacity, pow2);
+        ln->mask = ring_mask_for(ln->slots);
+        size_t bytes = esize * ln->slots;
+        bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+        ln->bytes = bytes;
+        ln->data = (unsigned char *)numa_mem_ring_alloc(bytes, CACHE_LINE, -1, mem, &ln->mem);
+        //Edge case: allocation fails, undo the lanes made so far
+        if (!ln->data) {
+            for (int j = 0; j < i; j++) {
+                qlock_destroy(&q->lanes[j].head_lock);
+                qlock_destroy(&q->lanes[j].tail_lock);
+                numa_mem_ring_free(q->lanes[j].data, q->lanes[j].bytes, q->lanes[j].mem);
+            }
+            free(q->lanes);
+            free(q);
+            return NULL;
+        }
+        atomic_init(&ln->head, 0);
+        atomic_init(&ln->tail, 0);
+        ln->head_cache = 0;
+        ln->tail_cache = 0;
+        qlock_init(&ln->head_lock);
+        qlock_init(&ln->tail_lock);
+    }
+
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_lanes(capacity, SHARDED_LANES, sizeof(int), 0, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_lanes(capacity, SHARDED_LANES, sizeof(int), 1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_lanes(capacity, SHARDED_LANES, elem_size, 0, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_lanes(capacity, SHARDED_LANES, elem_size, 1, 0);
+}
+
+// Lanes serve threads on every node, so there is no one node to place them on:
+// the node is ignored and queue_node reports -1 (see MODE=hier)
+Queue* create_on_node(int capacity, int node) {
+    (void)node;
+    return create_lanes(capacity, SHARDED_LANES, sizeof(int), 0, 0);
+}
+
+// The QUEUE_MEM_* options apply to every lane's ring, except the node
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_lanes(capacity, SHARDED_LANES, esize, opts->pow2, opts->mem & ~QUEUE_MEM_NODE);
+}
+
+Queue* create_sharded(int capacity, int lanes) {
+    return create_lanes(capacity, lanes, sizeof(int), 0, 0);
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+
+    // Destroy locks and free the lanes (caller must ensure no one is
+    // using q anymore)
+    for (int i = 0; i < q->n_lanes; i++) {
+        qlock_destroy(&q->lanes[i].head_lock);
+        qlock_destroy(&q->lanes[i].tail_lock);
+        numa_mem_ring_free(q->lanes[i].data, q->lanes[i].bytes, q->lanes[i].mem);
+    }
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    free(q->lanes);
+    //Free the queue struct
+    free(q);
+}
+
+// Copy one esize-byte element into the home lane, or the next lane with
+// room. Inlined with a constant esize for the int calls and the common
+// element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    int home = home_lane(q);
+
+    for (int i = 0; i < q->n_lanes; i++) {
+        Lane *ln = lane_at(q, home, i);
+        // Spill only into lanes that look like they have room
+        if (i > 0 && lane_looks_full(ln)) continue;
+
+        QUEUE_LOCK(q, &ln->tail_lock);
+        uint64_t tail = atomic_load_explicit(&ln->tail, memory_order_relaxed);
+        bool ok = lane_room(ln, tail, 1) > 0;
+        if (ok) {
+            // Enqueue the element at tail, then publish it to consumers
+            size_t slot = ring_slot(ln->mask, ln->slots, tail);
+            ring_elem_copy(ln->data + slot * esize, src, esize);
+            atomic_store_explicit(&ln->tail, tail + 1, memory_order_release);
+        }
+        qlock_release(&ln->tail_lock);
+
+        if (ok) {
+            STATS_ADD(q, enqueued, 1);
+            STATS_HIGH_WATER(q, snapshot_size(q));
+            // Wake a blocked consumer, if any
+            parker_wake(&q->not_empty, 1);
+            return true;
+        }
+    }
+    // Every lane is full
+    STATS_ADD(q, full, 1);
+    return false;
+}
+
+// Copy one element out of the home lane, or steal one from another lane
+// (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    int home = home_lane(q);
+
+    // First pass only try-locks the other lanes; a second, blocking pass
+    // runs only if a non-empty lane was skipped because it was busy
+    for (int pass = 0; pass < 2; pass++) {
+        bool skipped = false;
+        for (int i = 0; i < q->n_lanes; i++) {
+            Lane *ln = lane_at(q, home, i);
+            if (lane_looks_empty(ln)) continue;
+            if (!lane_lock(q, &ln->head_lock, i == 0 || pass == 1)) {
+                skipped = true;
+                continue;
+            }
+
+            uint64_t head = atomic_load_explicit(&ln->head, memory_order_relaxed);
+            bool ok = lane_avail(ln, head, 1) > 0;
+            if (ok) {
+                // Dequeue the element at head, then hand the slot back
+                size_t slot = ring_slot(ln->mask, ln->slots, head);
+                ring_elem_copy(dst, ln->data + slot * esize, esize);
+                atomic_store_explicit(&ln->head, head + 1, memory_order_release);
+            }
+            qlock_release(&ln->head_lock);
+
+            if (ok) {
+                STATS_ADD(q, dequeued, 1);
+                // Wake a blocked producer, if any
+                parker_wake(&q->not_full, 1);
+                return true;
+            }
+        }
+        if (!skipped) break;
+    }
+    // Every lane is empty
+    STATS_ADD(q, empty, 1);
+    return false;
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    int home = home_lane(q);
+    int done = 0;
+
+    // As much as fits into the home lane under one lock, the rest spills
+    for (int i = 0; i < q->n_lanes && done < n; i++) {
+        Lane *ln = lane_at(q, home, i);
+        if (i > 0 && lane_looks_full(ln)) continue;
+
+        QUEUE_LOCK(q, &ln->tail_lock);
+        uint64_t tail = atomic_load_explicit(&ln->tail, memory_order_relaxed);
+        uint64_t room = lane_room(ln, tail, (uint64_t)(n - done));
+        int k = (room < (uint64_t)(n - done)) ? (int)room : n - done;
+        if (k > 0) {
+            // Copy the batch in, then publish all of it with one store
+            ring_copy_in(ln->data, ln->slots, sizeof(int),
+                         ring_slot(ln->mask, ln->slots, tail), values + done, (size_t)k);
+            atomic_store_explicit(&ln->tail, tail + (uint64_t)k, memory_order_release);
+        }
+        qlock_release(&ln->tail_lock);
+        done += k;
+    }
+
+    if (done > 0) {
+        STATS_ADD(q, enqueued, done);
+        STATS_HIGH_WATER(q, snapshot_size(q));
+    } else {
+        STATS_ADD(q, full, 1);
+    }
+
+    // Wake up to done blocked consumers, if any
+    if (done > 0) parker_wake(&q->not_empty, done);
+    return done;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    int home = home_lane(q);
+    int done = 0;
+
+    // Same two passes as dequeue_copy, taking a batch from each lane
+    for (int pass = 0; pass < 2 && done < max; pass++) {
+        bool skipped = false;
+        for (int i = 0; i < q->n_lanes && done < max; i++) {
+            Lane *ln = lane_at(q, home, i);
+            if (lane_looks_empty(ln)) continue;
+            if (!lane_lock(q, &ln->head_lock, i == 0 || pass == 1)) {
+                skipped = true;
+                continue;
+            }
+
+            uint64_t head = atomic_load_explicit(&ln->head, memory_order_relaxed);
+            uint64_t avail = lane_avail(ln, head, (uint64_t)(max - done));
+            int k = (avail < (uint64_t)(max - done)) ? (int)avail : max - done;
+            if (k > 0) {
+                // Copy the batch out, then hand all of it back with one store
+                ring_copy_out(ln->data, ln->slots, sizeof(int),
+                              ring_slot(ln->mask, ln->slots, head), out + done, (size_t)k);
+                atomic_store_explicit(&ln->head, head + (uint64_t)k, memory_order_release);
+            }
+            qlock_release(&ln->head_lock);
+            done += k;
+        }
+        if (!skipped) break;
+    }
+
+    if (done > 0) STATS_ADD(q, dequeued, done);
+    else STATS_ADD(q, empty, 1);
+
+    // Wake up to done blocked producers, if any
+    if (done > 0) parker_wake(&q->not_full, done);
+    return done;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    int home = home_lane(q);
+
+    for (int i = 0; i < q->n_lanes; i++) {
+        Lane *ln = lane_at(q, home, i);
+        if (i > 0 && lane_looks_full(ln)) continue;
+
+        // On success the lane's tail lock stays held until enqueue_commit
+        QUEUE_LOCK(q, &ln->tail_lock);
+        uint64_t tail = atomic_load_explicit(&ln->tail, memory_order_relaxed);
+        uint64_t room = lane_room(ln, tail, (uint64_t)n);
+        size_t at = ring_slot(ln->mask, ln->slots, tail);
+        size_t k = ring_contig(ln->slots, at, room < (uint64_t)n ? (size_t)room : (size_t)n);
+        if (k > 0) {
+            *count = (int)k;
+            return ln->data + at * q->elem_size;
+        }
+        qlock_release(&ln->tail_lock);
+    }
+    // Every lane is full
+    STATS_ADD(q, full, 1);
+    return NULL;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    Lane *ln = lane_of(q, slot);
+    if (!ln) return;
+
+    // Publish the filled slots with one store
+    uint64_t tail = atomic_load_explicit(&ln->tail, memory_order_relaxed);
+    atomic_store_explicit(&ln->tail, tail + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, snapshot_size(q));
+
+    //Release the tail lock taken by enqueue_reserve
+    qlock_release(&ln->tail_lock);
+
+    // Wake up to n blocked consumers, if any
+    parker_wake(&q->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    int home = home_lane(q);
+
+    // Same two passes as dequeue_copy
+    for (int pass = 0; pass < 2; pass++) {
+        bool skipped = false;
+        for (int i = 0; i < q->n_lanes; i++) {
+            Lane *ln = lane_at(q, home, i);
+            if (lane_looks_empty(ln)) continue;
+            // On success the lane's head lock stays held until dequeue_release
+            if (!lane_lock(q, &ln->head_lock, i == 0 || pass == 1)) {
+                skipped = true;
+                continue;
+            }
+
+            uint64_t head = atomic_load_explicit(&ln->head, memory_order_relaxed);
+            uint64_t avail = lane_avail(ln, head, (uint64_t)max);
+            size_t at = ring_slot(ln->mask, ln->slots, head);
+            size_t k = ring_contig(ln->slots, at,
+                                   avail < (uint64_t)max ? (size_t)avail : (size_t)max);
+            if (k > 0) {
+                *count = (int)k;
+                return ln->data + at * q->elem_size;
+            }
+            qlock_release(&ln->head_lock);
+        }
+        if (!skipped) break;
+    }
+    // Every lane is empty
+    STATS_ADD(q, empty, 1);
+    return NULL;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    Lane *ln = lane_of(q, slot);
+    if (!ln) return;
+
+    // Hand the slots back with one store
+    uint64_t head = atomic_load_explicit(&ln->head, memory_order_relaxed);
+    atomic_store_explicit(&ln->head, head + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, dequeued, n);
+
+    //Release the head lock taken by dequeue_peek
+    qlock_release(&ln->head_lock);
+
+    // Wake up to n blocked producers, if any
+    parker_wake(&q->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+// Sum of the lanes' tail - head, each clamped to [0, lane capacity].
+// Exact when no operation is in flight, approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    int total = 0;
+    for (int i = 0; i < q->n_lanes; i++) {
+        Lane *ln = &q->lanes[i];
+        uint64_t head = atomic_load_explicit(&ln->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&ln->tail, memory_order_acquire);
+        if (tail <= head) continue;
+        total += (tail - head > (uint64_t)ln->capacity) ? ln->capacity : (int)(tail - head);
+    }
+    return total;
+}
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no lock/atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    (void)q;
+    return -1;
+}
+
+// Flags that took effect on every lane
+unsigned queue_mem(const Queue *q) {
+    if (!q) return 0;
+    unsigned mem = NUMA_MEM_FLAGS;
+    for (int i = 0; i < q->n_lanes; i++) mem &= q->lanes[i].mem;
+    return mem;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
+
+int lane_count(const Queue *q) {
+    if (!q) return 0;
+    return q->n_lanes;
+}
@@ -0,0 +1,702 @@
+//queue_shm.c
+#define _GNU_SOURCE   // for MAP_ANONYMOUS
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "stats.h"
+#include "numa_mem.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_LINE 64
+
+// "QSHM", set last by the creator: the header is ready once it reads this
+#define SHM_MAGIC 0x4d485351u
+// Bump whenever ShmHeader changes, so old and new binaries refuse each other
+#define SHM_VERSION 2u
+
+// How long queue_open_shared/queue_attach_shared wait for the creating
+// process to finish initializing the region
+#ifndef SHM_ATTACH_MS
+#define SHM_ATTACH_MS 1000
+#endif
+
+// Internal representation: the two-lock ring of queue.c, with everything
+// the processes share in one mapping (a shm_open object, or anonymous
+// shared memory for create, which forked children inherit):
+//
+//   [ ShmHeader | ring of slots * elem_size bytes ]
+//
+// The locks are process-shared robust pthread mutexes (futex-based; an
+// omp_lock_t only works inside one process) and the parkers use shared
+// futexes (-DPARK_SHARED). head/tail only move after the copy they
+// publish is complete, so whatever a process was doing when it died, the
+// ring is consistent: the next locker gets EOWNERDEAD, marks the mutex
+// consistent and carries on. An element copied in but not published
+// (a dead producer's enqueue_reserve) is dropped; one copied out but not
+// released (a dead consumer's dequeue_peek) stays queued. A process
+// killed while parked in a *_wait call leaves its parker's waiter count
+// one too high, which costs the other side a futex wake per operation
+// but loses no wake-up.
+typedef struct {
+    // Written once by the creator, before magic
+    _Atomic uint32_t magic;     // SHM_MAGIC once initialized
+    uint32_t version;           // SHM_VERSION
+    int capacity;               // maximum number of elements (as requested)
+    size_t elem_size;           // bytes per element
+    size_t slots;               // ring size (capacity, or rounded up to a power of two)
+    size_t mask;                // slots - 1 if slots is a power of two, else 0
+    size_t bytes;               // size of the whole mapping
+
+    // Producer side (guarded by tail_lock)
+    _Alignas(CACHE_LINE) pthread_mutex_t tail_lock;  // protects tail movement
+    _Atomic uint64_t tail;                           // next value to enqueue
+    uint64_t head_cache;                             // producers' last view of head
+    Parker not_empty;                                // consumers blocked in dequeue_wait
+
+    // Consumer side (guarded by head_lock)
+    _Alignas(CACHE_LINE) pthread_mutex_t head_lock;  // protects head movement
+    _Atomic uint64_t head;                           // next value to dequeue
+    uint64_t tail_cache;                             // consumers' last view of tail
+    Parker not_full;                                 // producers blocked in enqueue_wait
+} ShmHeader;
+
+// One process's handle on a shared ring
+struct Queue {
+    // Read-only after create/attach (copied out of the header)
+    ShmHeader *h;       // start of the mapping
+    void *data;         // the ring, right after the header
+    size_t bytes;       // size of the mapping
+    size_t elem_size;   // bytes per element
+    int capacity;       // maximum number of elements
+    size_t slots;       // ring size
+    size_t mask;        // slots - 1 if slots is a power of two, else 0
+    unsigned mem;       // QUEUE_MEM_* flags in effect for this process's mapping
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;  // this process's counters (stats.h)
+#endif
+};
+
+// Size of the mapping for slots elements of esize bytes
+static size_t shm_bytes_for(size_t esize, size_t slots) {
+    size_t ring = (esize * slots + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    return sizeof(ShmHeader) + ring;
+}
+
+static bool shm_mutex_init(pthread_mutex_t *m) {
+    pthread_mutexattr_t attr;
+    if (pthread_mutexattr_init(&attr) != 0) return false;
+    bool ok = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0 &&
+              pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == 0 &&
+              pthread_mutex_init(m, &attr) == 0;
+    pthread_mutexattr_destroy(&attr);
+    return ok;
+}
+
+// Creator side: initialize the header of a fresh mapping, then publish it
+static bool shm_init(ShmHeader *h, int capacity, size_t esize, size_t slots, size_t bytes) {
+    h->version = SHM_VERSION;
+    h->capacity = capacity;
+    h->elem_size = esize;
+    h->slots = slots;
+    h->mask = ring_mask_for(slots);
+    h->bytes = bytes;
+    atomic_init(&h->head, 0);
+    atomic_init(&h->tail, 0);
+    h->head_cache = 0;
+    h->tail_cache = 0;
+
+    // Initialize locks
+    if (!shm_mutex_init(&h->tail_lock)) return false;
+    if (!shm_mutex_init(&h->head_lock)) {
+        pthread_mutex_destroy(&h->tail_lock);
+        return false;
+    }
+
+    // Initialize parking spots for the blocking calls
+    parker_init(&h->not_full);
+    parker_init(&h->not_empty);
+
+    // Everything above is visible to whoever reads the magic
+    atomic_store_explicit(&h->magic, SHM_MAGIC, memory_order_release);
+    return true;
+}
+
+// Wrap a mapping whose header is initialized in a local handle
+static Queue *shm_wrap(ShmHeader *h) {
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), CACHE_LINE, -1, &bound);
+    //Edge case: allocation fails
+    if (!q) return NULL;
+
+    q->h = h;
+    q->data = (char *)h + sizeof(ShmHeader);
+    q->bytes = h->bytes;
+    q->elem_size = h->elem_size;
+    q->capacity = h->capacity;
+    q->slots = h->slots;
+    q->mask = h->mask;
+    q->mem = 0;
+
+    STATS_INIT(q);
+    return q;
+}
+
+// Queue in anonymous shared memory: shared with the processes this one
+// forks after create, and with no one else. Of the QUEUE_MEM_* flags in
+// mem only PREFAULT (MAP_POPULATE) and LOCK apply to shared memory.
+static Queue* create_ring(int capacity, size_t esize, int pow2, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    size_t slots = ring_slots_for(capacity, pow2);
+    size_t bytes = shm_bytes_for(esize, slots);
+    bool populate = (mem & (QUEUE_MEM_PREFAULT | QUEUE_MEM_LOCK)) != 0;
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS | (populate ? MAP_POPULATE : 0), -1, 0);
+    //Edge case: mapping fails
+    if (map == MAP_FAILED) return NULL;
+
+    ShmHeader *h = (ShmHeader *)map;
+    Queue *q = shm_init(h, capacity, esize, slots, bytes) ? shm_wrap(h) : NULL;
+    if (!q) {
+        munmap(map, bytes);
+        return NULL;
+    }
+    if (populate) q->mem |= QUEUE_MEM_PREFAULT;
+    //Edge case: over RLIMIT_MEMLOCK, the ring is just not locked
+    if ((mem & QUEUE_MEM_LOCK) && mlock(map, bytes) == 0) q->mem |= QUEUE_MEM_LOCK;
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    // Shared mappings are not bound: the node is ignored
+    (void)node;
+    return create(capacity);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, opts->mem);
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// Map the shm object behind fd once its creator has sized and initialized
+// it (waiting up to SHM_ATTACH_MS). capacity > 0 must match the queue's.
+static Queue *shm_attach_fd(int fd, int capacity) {
+    struct stat st;
+    int waited = 0;
+
+    // The creator sizes the object before initializing it
+    for (;;) {
+        //Edge case: fstat fails
+        if (fstat(fd, &st) != 0) return NULL;
+        if ((size_t)st.st_size >= sizeof(ShmHeader)) break;
+        //Edge case: creator died (or is stuck) before sizing the object
+        if (waited++ >= SHM_ATTACH_MS) return NULL;
+        sleep_ms(1);
+    }
+
+    size_t bytes = (size_t)st.st_size;
+    void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    //Edge case: mapping fails
+    if (map == MAP_FAILED) return NULL;
+    ShmHeader *h = (ShmHeader *)map;
+
+    // ... and sets the magic last
+    while (atomic_load_explicit(&h->magic, memory_order_acquire) != SHM_MAGIC) {
+        //Edge case: creator died before finishing, or not one of our queues
+        if (waited++ >= SHM_ATTACH_MS) {
+            munmap(map, bytes);
+            return NULL;
+        }
+        sleep_ms(1);
+    }
+
+    //Edge case: other layout version, inconsistent header or capacity mismatch
+    if (h->version != SHM_VERSION || h->bytes != bytes || h->capacity <= 0 ||
+        h->elem_size == 0 || (size_t)h->capacity > h->slots ||
+        shm_bytes_for(h->elem_size, h->slots) != bytes ||
+        (capacity > 0 && h->capacity != capacity)) {
+        munmap(map, bytes);
+        return NULL;
+    }
+
+    Queue *q = shm_wrap(h);
+    if (!q) munmap(map, bytes);
+    return q;
+}
+
+Queue* queue_open_shared(const char *name, int capacity) {
+    //Edge case: no name or capacity <= 0
+    if (!name || capacity <= 0) return NULL;
+
+    // O_EXCL picks exactly one creator; everyone else attaches
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        //Edge case: shm_open fails for any reason but an existing queue
+        if (errno != EEXIST) return NULL;
+        fd = shm_open(name, O_RDWR, 0);
+        //Edge case: the queue was unlinked in between
+        if (fd < 0) return NULL;
+        Queue *q = shm_attach_fd(fd, capacity);
+        close(fd);
+        return q;
+    }
+
+    size_t slots = ring_slots_for(capacity, 0);
+    size_t bytes = shm_bytes_for(sizeof(int), slots);
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)bytes) == 0) {
+        map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    Queue *q = NULL;
+    if (map != MAP_FAILED) {
+        if (shm_init((ShmHeader *)map, capacity, sizeof(int), slots, bytes)) {
+            q = shm_wrap((ShmHeader *)map);
+        }
+        if (!q) munmap(map, bytes);
+    }
+    //Edge case: sizing, mapping or initializing fails: drop the name so
+    //the next open starts over instead of waiting on a dead queue
+    if (!q) shm_unlink(name);
+    return q;
+}
+
+Queue* queue_attach_shared(const char *name) {
+    //Edge case: no name
+    if (!name) return NULL;
+    int fd = shm_open(name, O_RDWR, 0);
+    //Edge case: no such queue
+    if (fd < 0) return NULL;
+    Queue *q = shm_attach_fd(fd, 0);
+    close(fd);
+    return q;
+}
+
+bool queue_unlink_shared(const char *name) {
+    //Edge case: no name
+    if (!name) return false;
+    return shm_unlink(name) == 0;
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+
+    // Only this process's handle goes away: other processes may still use
+    // the locks and parkers, so they are left as they are. The memory is
+    // freed with the last mapping (and, for a named queue, the name).
+    if (q->mem & QUEUE_MEM_LOCK) munlock(q->h, q->bytes);
+    munmap(q->h, q->bytes);
+    //Free the queue struct
+    numa_mem_free(q, sizeof(Queue), -1);
+}
+
+// Take m, counting contention on q. A holder that died (EOWNERDEAD) left
+// the ring consistent (see the top of this file), so the mutex is just
+// marked usable again. False only if that failed and m is unusable.
+static inline bool shm_lock(Queue *q, pthread_mutex_t *m) {
+    int rc = pthread_mutex_trylock(m);
+    if (rc == EBUSY) {
+        long long t0 = STATS_NOW();
+        rc = pthread_mutex_lock(m);
+        STATS_ADD(q, contended, 1);
+        STATS_WAITED(q, t0);
+    }
+    if (rc == EOWNERDEAD) rc = pthread_mutex_consistent(m);
+    return rc == 0;
+}
+
+static inline void shm_unlock(pthread_mutex_t *m) {
+    pthread_mutex_unlock(m);
+}
+
+// Copy one esize-byte element in at tail. Inlined with a constant esize
+// for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    ShmHeader *h = q->h;
+
+    // Acquire the tail lock
+    if (!shm_lock(q, &h->tail_lock)) return false;
+
+    // Only tail_lock holders write tail
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+
+    // Looks full from the cached head: refresh it from the consumer side
+    if (tail - h->head_cache == (uint64_t)q->capacity) {
+        h->head_cache = atomic_load_explicit(&h->head, memory_order_acquire);
+
+        // Queue is full
+        if (tail - h->head_cache == (uint64_t)q->capacity) {
+            shm_unlock(&h->tail_lock);
+            STATS_ADD(q, full, 1);
+            return false;
+        }
+    }
+
+    // Enqueue the element at tail, then publish it to consumers
+    size_t slot = ring_slot(q->mask, q->slots, tail);
+    ring_elem_copy((char *)q->data + slot * esize, src, esize);
+    atomic_store_explicit(&h->tail, tail + 1, memory_order_release);
+
+    //Release the tail lock
+    shm_unlock(&h->tail_lock);
+
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, tail + 1 - atomic_load_explicit(&h->head, memory_order_relaxed));
+
+    // Wake a blocked consumer, if any
+    parker_wake(&h->not_empty, 1);
+    return true;
+}
+
+// Copy the element at head out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    ShmHeader *h = q->h;
+
+    // Acquire the head lock
+    if (!shm_lock(q, &h->head_lock)) return false;
+
+    // Only head_lock holders write head
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+
+    // Looks empty from the cached tail: refresh it from the producer side
+    if (head == h->tail_cache) {
+        h->tail_cache = atomic_load_explicit(&h->tail, memory_order_acquire);
+
+        // Queue is empty
+        if (head == h->tail_cache) {
+            shm_unlock(&h->head_lock);
+            STATS_ADD(q, empty, 1);
+            return false;
+        }
+    }
+
+    // Dequeue the element at head, then hand the slot back to producers
+    size_t slot = ring_slot(q->mask, q->slots, head);
+    ring_elem_copy(dst, (const char *)q->data + slot * esize, esize);
+    atomic_store_explicit(&h->head, head + 1, memory_order_release);
+
+    //Release the head lock
+    shm_unlock(&h->head_lock);
+
+    STATS_ADD(q, dequeued, 1);
+
+    // Wake a blocked producer, if any
+    parker_wake(&h->not_full, 1);
+    return true;
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+    ShmHeader *h = q->h;
+
+    // Acquire the tail lock once for the whole batch
+    if (!shm_lock(q, &h->tail_lock)) return 0;
+
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - h->head_cache);
+    if (room < (uint64_t)n) {
+        h->head_cache = atomic_load_explicit(&h->head, memory_order_acquire);
+        room = cap - (tail - h->head_cache);
+    }
+
+    // Take as many values as there is free space
+    int k = (room < (uint64_t)n) ? (int)room : n;
+
+    if (k > 0) {
+        // Copy the batch in, then publish all of it with one store
+        ring_copy_in(q->data, q->slots, sizeof(int),
+                     ring_slot(q->mask, q->slots, tail), values, (size_t)k);
+        atomic_store_explicit(&h->tail, tail + (uint64_t)k, memory_order_release);
+    }
+
+    //Release the tail lock
+    shm_unlock(&h->tail_lock);
+
+    if (k > 0) {
+        STATS_ADD(q, enqueued, k);
+        STATS_HIGH_WATER(q, tail + (uint64_t)k - atomic_load_explicit(&h->head, memory_order_relaxed));
+    } else {
+        STATS_ADD(q, full, 1);
+    }
+
+    // Wake up to k blocked consumers, if any
+    if (k > 0) parker_wake(&h->not_empty, k);
+    return k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+    ShmHeader *h = q->h;
+
+    // Acquire the head lock once for the whole batch
+    if (!shm_lock(q, &h->head_lock)) return 0;
+
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = h->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        h->tail_cache = atomic_load_explicit(&h->tail, memory_order_acquire);
+        avail = h->tail_cache - head;
+    }
+
+    // Take as many values as are available
+    int k = (avail < (uint64_t)max) ? (int)avail : max;
+
+    if (k > 0) {
+        // Copy the batch out, then hand all of it back with one store
+        ring_copy_out(q->data, q->slots, sizeof(int),
+                      ring_slot(q->mask, q->slots, head), out, (size_t)k);
+        atomic_store_explicit(&h->head, head + (uint64_t)k, memory_order_release);
+    }
+
+    //Release the head lock
+    shm_unlock(&h->head_lock);
+
+    if (k > 0) STATS_ADD(q, dequeued, k);
+    else STATS_ADD(q, empty, 1);
+
+    // Wake up to k blocked producers, if any
+    if (k > 0) parker_wake(&h->not_full, k);
+    return k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+    ShmHeader *h = q->h;
+
+    // Acquire the tail lock; on success it stays held until enqueue_commit
+    if (!shm_lock(q, &h->tail_lock)) return NULL;
+
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - h->head_cache);
+    if (room < (uint64_t)n) {
+        h->head_cache = atomic_load_explicit(&h->head, memory_order_acquire);
+        room = cap - (tail - h->head_cache);
+    }
+
+    // Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, tail);
+    size_t k = ring_contig(q->slots, at, room < (uint64_t)n ? (size_t)room : (size_t)n);
+
+    // Queue is full
+    if (k == 0) {
+        shm_unlock(&h->tail_lock);
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    ShmHeader *h = q->h;
+
+    // Publish the filled slots with one store
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    atomic_store_explicit(&h->tail, tail + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, tail + (uint64_t)n - atomic_load_explicit(&h->head, memory_order_relaxed));
+
+    //Release the tail lock taken by enqueue_reserve
+    shm_unlock(&h->tail_lock);
+
+    // Wake up to n blocked consumers, if any
+    parker_wake(&h->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+    ShmHeader *h = q->h;
+
+    // Acquire the head lock; on success it stays held until dequeue_release
+    if (!shm_lock(q, &h->head_lock)) return NULL;
+
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = h->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        h->tail_cache = atomic_load_explicit(&h->tail, memory_order_acquire);
+        avail = h->tail_cache - head;
+    }
+
+    // Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, head);
+    size_t k = ring_contig(q->slots, at, avail < (uint64_t)max ? (size_t)avail : (size_t)max);
+
+    // Queue is empty
+    if (k == 0) {
+        shm_unlock(&h->head_lock);
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    ShmHeader *h = q->h;
+
+    // Hand the slots back with one store
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    atomic_store_explicit(&h->head, head + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, dequeued, n);
+
+    //Release the head lock taken by dequeue_peek
+    shm_unlock(&h->head_lock);
+
+    // Wake up to n blocked producers, if any
+    parker_wake(&h->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->h->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->h->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+// Snapshot of tail - head, clamped to [0, capacity].
+// Exact when no operation is in flight, approximate otherwise.
+static int snapshot_size(const Queue *q) {
+    uint64_t head = atomic_load_explicit(&q->h->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&q->h->tail, memory_order_acquire);
+    if (tail <= head) return 0;
+    if (tail - head > (uint64_t)q->capacity) return q->capacity;
+    return (int)(tail - head);
+}
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no lock/atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    // Shared mappings are never bound
+    (void)q;
+    return -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
@@ -0,0 +1,407 @@
+// queue_spsc.c
+#include "queue.h"
+#include "park.h"
+#include "ring.h"
+#include "stats.h"
+#include "numa_mem.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define CACHE_LINE 64
+
+// Internal representation: bounded single-producer/single-consumer ring.
+// Only ONE thread may call enqueue and only ONE thread may call dequeue.
+//
+// head/tail are monotonically increasing 64-bit counters (slot = ring_slot).
+// Each side owns its index and keeps a cached copy of the opposite one, so
+// it only touches the other side's cache line when the cache says the
+// queue looks full (producer) or empty (consumer).
+struct Queue {
+    void *data;     // array of length slots, elem_size bytes per slot
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity;   // maximum number of elements (as requested)
+    size_t slots;   // ring size (capacity, or rounded up to a power of two)
+    size_t mask;    // slots - 1 if slots is a power of two, else 0
+    int node;       // node given to create_on_node/create_ex, -1 if none
+    unsigned mem;     // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+
+    // Producer side
+    _Alignas(CACHE_LINE) _Atomic uint64_t tail;   // next slot to enqueue
+    uint64_t head_cache;                          // producer's last view of head
+    Parker not_empty;                             // consumer blocked in dequeue_wait
+
+    // Consumer side
+    _Alignas(CACHE_LINE) _Atomic uint64_t head;   // next slot to dequeue
+    uint64_t tail_cache;                          // consumer's last view of tail
+    Parker not_full;                              // producer blocked in enqueue_wait
+
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats;                        // per-thread counters (stats.h)
+#endif
+};
+
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) {
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL;
+
+    //Allocate the queue struct on its own cache lines
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), CACHE_LINE, node, &bound);
+    //Edge case: allocation fails
+    if (!q) return NULL;
+
+    //Allocate memory for the data array
+    q->slots = ring_slots_for(capacity, pow2);
+    q->data = numa_mem_ring_alloc(esize * q->slots, _Alignof(max_align_t), node, mem, &q->mem);
+    //Edge case: malloc fails
+    if (!q->data) {
+        numa_mem_free(q, sizeof(Queue), node);
+        return NULL;
+    }
+
+    //Initialize the queue fields
+    q->elem_size = esize;
+    q->node = node;
+    q->capacity = capacity;
+    q->mask = ring_mask_for(q->slots);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->head_cache = 0;
+    q->tail_cache = 0;
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
+
+    return q;
+}
+
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
+
+void destroy(Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return;
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
+    //Free the data array
+    numa_mem_ring_free(q->data, q->elem_size * q->slots, q->mem);
+    //Free the queue struct
+    numa_mem_free(q, sizeof(Queue), q->node);
+}
+
+// Copy one esize-byte element in at tail. Inlined with a constant esize
+// for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
+    // Only the producer writes tail, so a relaxed load is enough
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Looks full from the cached head: refresh it from the consumer
+    if (tail - q->head_cache == (uint64_t)q->capacity) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        // Queue is full
+        if (tail - q->head_cache == (uint64_t)q->capacity) {
+            STATS_ADD(q, full, 1);
+            return false;
+        }
+    }
+
+    // Write the element, then publish it to the consumer
+    size_t slot = ring_slot(q->mask, q->slots, tail);
+    ring_elem_copy((char *)q->data + slot * esize, src, esize);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    STATS_ADD(q, enqueued, 1);
+    STATS_HIGH_WATER(q, tail + 1 - atomic_load_explicit(&q->head, memory_order_relaxed));
+    // Wake the consumer if it is blocked
+    parker_wake(&q->not_empty, 1);
+    return true;
+}
+
+// Copy the element at head out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
+    // Only the consumer writes head, so a relaxed load is enough
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Looks empty from the cached tail: refresh it from the producer
+    if (head == q->tail_cache) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        // Queue is empty
+        if (head == q->tail_cache) {
+            STATS_ADD(q, empty, 1);
+            return false;
+        }
+    }
+
+    // Read the element, then hand the slot back to the producer
+    size_t slot = ring_slot(q->mask, q->slots, head);
+    ring_elem_copy(dst, (const char *)q->data + slot * esize, esize);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    STATS_ADD(q, dequeued, 1);
+    // Wake the producer if it is blocked
+    parker_wake(&q->not_full, 1);
+    return true;
+}
+
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - q->head_cache);
+    if (room < (uint64_t)n) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = cap - (tail - q->head_cache);
+    }
+
+    size_t k = (room < (uint64_t)n) ? (size_t)room : (size_t)n;
+    if (k == 0) {
+        STATS_ADD(q, full, 1);
+        return 0;
+    }
+
+    // Copy the batch in, then publish all of it with one store
+    ring_copy_in(q->data, q->slots, sizeof(int), ring_slot(q->mask, q->slots, tail),
+                 values, k);
+    atomic_store_explicit(&q->tail, tail + k, memory_order_release);
+    STATS_ADD(q, enqueued, k);
+    STATS_HIGH_WATER(q, tail + k - atomic_load_explicit(&q->head, memory_order_relaxed));
+    // Wake the consumer if it is blocked
+    parker_wake(&q->not_empty, 1);
+    return (int)k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = q->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->tail_cache - head;
+    }
+
+    size_t k = (avail < (uint64_t)max) ? (size_t)avail : (size_t)max;
+    if (k == 0) {
+        STATS_ADD(q, empty, 1);
+        return 0;
+    }
+
+    // Copy the batch out, then hand all of it back with one store
+    ring_copy_out(q->data, q->slots, sizeof(int), ring_slot(q->mask, q->slots, head),
+                  out, k);
+    atomic_store_explicit(&q->head, head + k, memory_order_release);
+    STATS_ADD(q, dequeued, k);
+    // Wake the producer if it is blocked
+    parker_wake(&q->not_full, 1);
+    return (int)k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+
+    uint64_t cap = (uint64_t)q->capacity;
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    // Not enough room according to the cached head: refresh it
+    uint64_t room = cap - (tail - q->head_cache);
+    if (room < (uint64_t)n) {
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = cap - (tail - q->head_cache);
+    }
+
+    // Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, tail);
+    size_t k = ring_contig(q->slots, at, room < (uint64_t)n ? (size_t)room : (size_t)n);
+    // Queue is full
+    if (k == 0) {
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+
+    // Only this producer moves tail, so nothing else needs to be held
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+
+    // Publish the filled slots with one store
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, tail + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, tail + (uint64_t)n - atomic_load_explicit(&q->head, memory_order_relaxed));
+    // Wake the consumer if it is blocked
+    parker_wake(&q->not_empty, 1);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    // Fewer values than requested according to the cached tail: refresh it
+    uint64_t avail = q->tail_cache - head;
+    if (avail < (uint64_t)max) {
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        avail = q->tail_cache - head;
+    }
+
+    // Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, head);
+    size_t k = ring_contig(q->slots, at, avail < (uint64_t)max ? (size_t)avail : (size_t)max);
+    // Queue is empty
+    if (k == 0) {
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+
+    // Hand the slots back to the producer with one store
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->head, head + (uint64_t)n, memory_order_release);
+    STATS_ADD(q, dequeued, n);
+    // Wake the producer if it is blocked
+    parker_wake(&q->not_full, 1);
+}
+
+// Snapshot of tail - head, clamped to [0, capacity]. Exact from the
+// producer or consumer thread when the other side is idle, approximate
+// otherwise (a third thread can see both move between its two loads).
+static int snapshot_size(const Queue *q) {
+    uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (tail <= head) return 0;
+    if (tail - head > (uint64_t)q->capacity) return q->capacity;
+    return (int)(tail - head);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
+bool is_empty(const Queue *q) {
+    if (!q) return true;
+    return snapshot_size(q) == 0;
+}
+
+bool is_full(const Queue *q) {
+    if (!q) return false;
+    return snapshot_size(q) == q->capacity;
+}
+
+int size(const Queue *q) {
+    if (!q) return 0;
+    return snapshot_size(q);
+}
+
+int capacity(const Queue *q) {
+    if (!q) return 0;
+    // capacity is immutable after creation, so no atomic needed
+    return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    if (!q) return 0;
+    return q->elem_size;
+}
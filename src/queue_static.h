@@ -0,0 +1,325 @@
+//queue_static.h
+// Header-only queues specialized at compile time for one element type and
+// capacity. The opaque Queue of queue.h costs an out-of-line call per
+// operation, and its capacity and element size are runtime values.
+//
+//   DEFINE_QUEUE(name, T, CAP, policy)
+//
+// emits a struct `name` holding a ring of CAP elements of type T inline
+// (no allocation), and static inline functions around it:
+//
+//   void name_init(name *q);            // before first use
+//   void name_destroy(name *q);         // after last use (frees the locks)
+//   bool name_enqueue(name *q, T value);
+//   bool name_dequeue(name *q, T *out);
+//   int  name_size(const name *q);      // snapshot, like size()
+//   bool name_is_empty(const name *q);
+//   bool name_is_full(const name *q);
+//   int  name_capacity(void);           // CAP
+//
+// The ring is rounded up to a power of two at compile time, so every index
+// is a constant mask; the queue still holds at most CAP elements. policy is
+// one of
+//
+//   seq       no synchronization (one thread, like queue_seq.c)
+//   onelock   one lock for both ends (like queue_v1.c)
+//   twolock   a lock per end with cached opposite counters (like queue.c)
+//   lockfree  Vyukov MPMC ring with per-slot sequence numbers
+//             (like queue_lockfree.c)
+//
+// The lock policies use the QLock picked by LOCK= (lock.h). There are no
+// blocking or bulk calls; use the opaque Queue for those. T is copied by
+// assignment and must not need a destructor. queue_static.hpp wraps the
+// same code in a C++ class template.
+#ifndef QUEUE_STATIC_H
+#define QUEUE_STATIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lock.h"
+
+// The generated code is shared with the C++ wrapper, so atomics and
+// alignment go through these
+#ifdef __cplusplus
+#include <atomic>
+#define QS_ATOMIC(t) std::atomic<t>
+#define QS_INIT(p, v) (p)->store((v), std::memory_order_relaxed)
+#define QS_LOAD(p, mo) (p)->load(std::memory_order_##mo)
+#define QS_STORE(p, v, mo) (p)->store((v), std::memory_order_##mo)
+#define QS_CAS_WEAK(p, expected, desired) \
+    (p)->compare_exchange_weak(*(expected), (desired), std::memory_order_relaxed, \
+                               std::memory_order_relaxed)
+#define QS_ALIGNAS(n) alignas(n)
+#define QS_STATIC_ASSERT(e, msg) static_assert(e, msg)
+#else
+#include <stdbool.h>
+#include <stdatomic.h>
+#define QS_ATOMIC(t) _Atomic t
+#define QS_INIT(p, v) atomic_init((p), (v))
+#define QS_LOAD(p, mo) atomic_load_explicit((p), memory_order_##mo)
+#define QS_STORE(p, v, mo) atomic_store_explicit((p), (v), memory_order_##mo)
+#define QS_CAS_WEAK(p, expected, desired) \
+    atomic_compare_exchange_weak_explicit((p), (expected), (desired), memory_order_relaxed, \
+                                          memory_order_relaxed)
+#define QS_ALIGNAS(n) _Alignas(n)
+#define QS_STATIC_ASSERT(e, msg) _Static_assert(e, msg)
+#endif
+
+#define QS_CACHE_LINE 64
+
+// Smallest power of two >= n, as a constant expression (n <= 2^30)
+#define QS_P2(n, k) (size_t)(n) <= ((size_t)1 << (k)) ? ((size_t)1 << (k)) :
+#define QS_POW2_CEIL(n) \
+    (QS_P2(n, 0) QS_P2(n, 1) QS_P2(n, 2) QS_P2(n, 3) QS_P2(n, 4) QS_P2(n, 5) \
+     QS_P2(n, 6) QS_P2(n, 7) QS_P2(n, 8) QS_P2(n, 9) QS_P2(n, 10) QS_P2(n, 11) \
+     QS_P2(n, 12) QS_P2(n, 13) QS_P2(n, 14) QS_P2(n, 15) QS_P2(n, 16) QS_P2(n, 17) \
+     QS_P2(n, 18) QS_P2(n, 19) QS_P2(n, 20) QS_P2(n, 21) QS_P2(n, 22) QS_P2(n, 23) \
+     QS_P2(n, 24) QS_P2(n, 25) QS_P2(n, 26) QS_P2(n, 27) QS_P2(n, 28) QS_P2(n, 29) \
+     QS_P2(n, 30) (size_t)0)
+
+// Ring size and index mask of a CAP-element queue
+#define QS_SLOTS(CAP) QS_POW2_CEIL(CAP)
+#define QS_MASK(CAP) (QS_SLOTS(CAP) - 1)
+// The lockfree policy needs two slots or more: with one, a full cell's seq
+// equals the next lap's free seq (the head check then enforces CAP)
+#define QS_LF_SLOTS(CAP) QS_POW2_CEIL((CAP) < 2 ? 2 : (CAP))
+#define QS_LF_MASK(CAP) (QS_LF_SLOTS(CAP) - 1)
+
+#define DEFINE_QUEUE(name, T, CAP, policy) QUEUE_STATIC_##policy(name, T, CAP)
+
+// Snapshot of tail - head clamped to [0, CAP], plus the calls built on it
+// (same rules as snapshot_size in the implementations)
+#define QUEUE_STATIC_SIZE_CALLS(name, CAP, head_expr, tail_expr)                 \
+    static inline int name##_size(const name *q) {                              \
+        uint64_t head = head_expr;                                              \
+        uint64_t tail = tail_expr;                                              \
+        if (tail <= head) return 0;                                             \
+        if (tail - head > (uint64_t)(CAP)) return (int)(CAP);                   \
+        return (int)(tail - head);                                              \
+    }                                                                           \
+    static inline bool name##_is_empty(const name *q) { return name##_size(q) == 0; } \
+    static inline bool name##_is_full(const name *q) {                          \
+        return name##_size(q) == (int)(CAP);                                    \
+    }                                                                           \
+    static inline int name##_capacity(void) { return (int)(CAP); }
+
+#define QUEUE_STATIC_CHECK(CAP) \
+    QS_STATIC_ASSERT((CAP) > 0 && (CAP) <= (1 << 30), "queue capacity must be in 1..2^30")
+
+// ---------------------------------------------------------------------
+// seq: head/tail counters and nothing else
+// ---------------------------------------------------------------------
+#define QUEUE_STATIC_seq(name, T, CAP)                                          \
+    QUEUE_STATIC_CHECK(CAP);                                                    \
+    typedef struct name {                                                       \
+        uint64_t head;  /* count of elements dequeued so far */                 \
+        uint64_t tail;  /* count of elements enqueued so far */                 \
+        T data[QS_SLOTS(CAP)];                                                  \
+    } name;                                                                     \
+    static inline void name##_init(name *q) { q->head = 0; q->tail = 0; }       \
+    static inline void name##_destroy(name *q) { (void)q; }                     \
+    static inline bool name##_enqueue(name *q, T value) {                       \
+        /* Queue is full */                                                     \
+        if (q->tail - q->head == (uint64_t)(CAP)) return false;                 \
+        q->data[q->tail & QS_MASK(CAP)] = value;                                \
+        q->tail++;                                                              \
+        return true;                                                            \
+    }                                                                           \
+    static inline bool name##_dequeue(name *q, T *out) {                        \
+        /* Queue is empty */                                                    \
+        if (q->head == q->tail) return false;                                   \
+        *out = q->data[q->head & QS_MASK(CAP)];                                 \
+        q->head++;                                                              \
+        return true;                                                            \
+    }                                                                           \
+    QUEUE_STATIC_SIZE_CALLS(name, CAP, q->head, q->tail)
+
+// ---------------------------------------------------------------------
+// onelock: one lock around both ends. head/tail are atomic only so the
+// size calls can read them without the lock.
+// ---------------------------------------------------------------------
+#define QUEUE_STATIC_onelock(name, T, CAP)                                      \
+    QUEUE_STATIC_CHECK(CAP);                                                    \
+    typedef struct name {                                                       \
+        QLock lock;                                                             \
+        QS_ATOMIC(uint64_t) head;                                               \
+        QS_ATOMIC(uint64_t) tail;                                               \
+        QS_ALIGNAS(QS_CACHE_LINE) T data[QS_SLOTS(CAP)];                        \
+    } name;                                                                     \
+    static inline void name##_init(name *q) {                                   \
+        qlock_init(&q->lock);                                                   \
+        QS_INIT(&q->head, 0);                                                   \
+        QS_INIT(&q->tail, 0);                                                   \
+    }                                                                           \
+    static inline void name##_destroy(name *q) { qlock_destroy(&q->lock); }     \
+    static inline bool name##_enqueue(name *q, T value) {                       \
+        qlock_acquire(&q->lock);                                                \
+        uint64_t tail = QS_LOAD(&q->tail, relaxed);                             \
+        /* Queue is full */                                                     \
+        if (tail - QS_LOAD(&q->head, relaxed) == (uint64_t)(CAP)) {             \
+            qlock_release(&q->lock);                                            \
+            return false;                                                       \
+        }                                                                       \
+        q->data[tail & QS_MASK(CAP)] = value;                                   \
+        QS_STORE(&q->tail, tail + 1, relaxed);                                  \
+        qlock_release(&q->lock);                                                \
+        return true;                                                            \
+    }                                                                           \
+    static inline bool name##_dequeue(name *q, T *out) {                        \
+        qlock_acquire(&q->lock);                                                \
+        uint64_t head = QS_LOAD(&q->head, relaxed);                             \
+        /* Queue is empty */                                                    \
+        if (head == QS_LOAD(&q->tail, relaxed)) {                               \
+            qlock_release(&q->lock);                                            \
+            return false;                                                       \
+        }                                                                       \
+        *out = q->data[head & QS_MASK(CAP)];                                    \
+        QS_STORE(&q->head, head + 1, relaxed);                                  \
+        qlock_release(&q->lock);                                                \
+        return true;                                                            \
+    }                                                                           \
+    QUEUE_STATIC_SIZE_CALLS(name, CAP, QS_LOAD(&q->head, acquire), QS_LOAD(&q->tail, acquire))
+
+// ---------------------------------------------------------------------
+// twolock: producers and consumers each take their own lock, on separate
+// cache lines, and only read the other side's counter when the cached
+// copy says the queue looks full/empty
+// ---------------------------------------------------------------------
+#define QUEUE_STATIC_twolock(name, T, CAP)                                      \
+    QUEUE_STATIC_CHECK(CAP);                                                    \
+    typedef struct name {                                                       \
+        /* Producer side (guarded by tail_lock) */                              \
+        QS_ALIGNAS(QS_CACHE_LINE) QLock tail_lock;                              \
+        QS_ATOMIC(uint64_t) tail;                                               \
+        uint64_t head_cache;                                                    \
+        /* Consumer side (guarded by head_lock) */                              \
+        QS_ALIGNAS(QS_CACHE_LINE) QLock head_lock;                              \
+        QS_ATOMIC(uint64_t) head;                                               \
+        uint64_t tail_cache;                                                    \
+        QS_ALIGNAS(QS_CACHE_LINE) T data[QS_SLOTS(CAP)];                        \
+    } name;                                                                     \
+    static inline void name##_init(name *q) {                                   \
+        qlock_init(&q->tail_lock);                                              \
+        qlock_init(&q->head_lock);                                              \
+        QS_INIT(&q->tail, 0);                                                   \
+        QS_INIT(&q->head, 0);                                                   \
+        q->head_cache = 0;                                                      \
+        q->tail_cache = 0;                                                      \
+    }                                                                           \
+    static inline void name##_destroy(name *q) {                                \
+        qlock_destroy(&q->tail_lock);                                           \
+        qlock_destroy(&q->head_lock);                                           \
+    }                                                                           \
+    static inline bool name##_enqueue(name *q, T value) {                       \
+        qlock_acquire(&q->tail_lock);                                           \
+        uint64_t tail = QS_LOAD(&q->tail, relaxed);                             \
+        /* Looks full from the cached head: refresh it */                       \
+        if (tail - q->head_cache == (uint64_t)(CAP)) {                          \
+            q->head_cache = QS_LOAD(&q->head, acquire);                         \
+            /* Queue is full */                                                 \
+            if (tail - q->head_cache == (uint64_t)(CAP)) {                      \
+                qlock_release(&q->tail_lock);                                   \
+                return false;                                                   \
+            }                                                                   \
+        }                                                                       \
+        q->data[tail & QS_MASK(CAP)] = value;                                   \
+        QS_STORE(&q->tail, tail + 1, release);                                  \
+        qlock_release(&q->tail_lock);                                           \
+        return true;                                                            \
+    }                                                                           \
+    static inline bool name##_dequeue(name *q, T *out) {                        \
+        qlock_acquire(&q->head_lock);                                           \
+        uint64_t head = QS_LOAD(&q->head, relaxed);                             \
+        /* Looks empty from the cached tail: refresh it */                      \
+        if (head == q->tail_cache) {                                            \
+            q->tail_cache = QS_LOAD(&q->tail, acquire);                         \
+            /* Queue is empty */                                                \
+            if (head == q->tail_cache) {                                        \
+                qlock_release(&q->head_lock);                                   \
+                return false;                                                   \
+            }                                                                   \
+        }                                                                       \
+        *out = q->data[head & QS_MASK(CAP)];                                    \
+        QS_STORE(&q->head, head + 1, release);                                  \
+        qlock_release(&q->head_lock);                                           \
+        return true;                                                            \
+    }                                                                           \
+    QUEUE_STATIC_SIZE_CALLS(name, CAP, QS_LOAD(&q->head, acquire), QS_LOAD(&q->tail, acquire))
+
+// ---------------------------------------------------------------------
+// lockfree: tickets claimed with a CAS on tail/head; slot seq == pos
+// means free for ticket pos, pos + 1 full for ticket pos. When CAP is not
+// a power of two (or is 1) the ring has spare slots, so producers also
+// check the ticket against head (the check folds away otherwise).
+// ---------------------------------------------------------------------
+#define QUEUE_STATIC_lockfree(name, T, CAP)                                     \
+    QUEUE_STATIC_CHECK(CAP);                                                    \
+    typedef struct name##_cell {                                                \
+        QS_ATOMIC(uint64_t) seq;                                                \
+        T value;                                                                \
+    } name##_cell;                                                              \
+    typedef struct name {                                                       \
+        QS_ALIGNAS(QS_CACHE_LINE) QS_ATOMIC(uint64_t) tail;                     \
+        QS_ALIGNAS(QS_CACHE_LINE) QS_ATOMIC(uint64_t) head;                     \
+        QS_ALIGNAS(QS_CACHE_LINE) name##_cell cells[QS_LF_SLOTS(CAP)];          \
+    } name;                                                                     \
+    static inline void name##_init(name *q) {                                   \
+        QS_INIT(&q->tail, 0);                                                   \
+        QS_INIT(&q->head, 0);                                                   \
+        for (size_t i = 0; i < QS_LF_SLOTS(CAP); i++) QS_INIT(&q->cells[i].seq, i); \
+    }                                                                           \
+    static inline void name##_destroy(name *q) { (void)q; }                     \
+    static inline bool name##_enqueue(name *q, T value) {                       \
+        uint64_t pos = QS_LOAD(&q->tail, relaxed);                              \
+        for (;;) {                                                              \
+            name##_cell *cell = &q->cells[pos & QS_LF_MASK(CAP)];               \
+            int64_t dif = (int64_t)(QS_LOAD(&cell->seq, acquire) - pos);        \
+            if (dif == 0) {                                                     \
+                /* Free, but the ring may be over the requested capacity */     \
+                if (QS_LF_SLOTS(CAP) != (size_t)(CAP)) {                        \
+                    /* Signed: head may already be past a stale pos */          \
+                    int64_t used = (int64_t)(pos - QS_LOAD(&q->head, acquire)); \
+                    if (used < 0) {                                             \
+                        pos = QS_LOAD(&q->tail, relaxed);                       \
+                        continue;                                               \
+                    }                                                           \
+                    if (used >= (int64_t)(CAP)) return false;                   \
+                }                                                               \
+                if (QS_CAS_WEAK(&q->tail, &pos, pos + 1)) {                     \
+                    cell->value = value;                                        \
+                    QS_STORE(&cell->seq, pos + 1, release);                     \
+                    return true;                                                \
+                }                                                               \
+            } else if (dif < 0) {                                               \
+                /* Previous lap's value still there: queue is full */           \
+                return false;                                                   \
+            } else {                                                            \
+                /* Another producer took this ticket; catch up */               \
+                pos = QS_LOAD(&q->tail, relaxed);                               \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+    static inline bool name##_dequeue(name *q, T *out) {                        \
+        uint64_t pos = QS_LOAD(&q->head, relaxed);                              \
+        for (;;) {                                                              \
+            name##_cell *cell = &q->cells[pos & QS_LF_MASK(CAP)];               \
+            int64_t dif = (int64_t)(QS_LOAD(&cell->seq, acquire) - (pos + 1));  \
+            if (dif == 0) {                                                     \
+                if (QS_CAS_WEAK(&q->head, &pos, pos + 1)) {                     \
+                    *out = cell->value;                                         \
+                    QS_STORE(&cell->seq, pos + QS_LF_SLOTS(CAP), release);      \
+                    return true;                                                \
+                }                                                               \
+            } else if (dif < 0) {                                               \
+                /* Not published yet: queue is empty */                         \
+                return false;                                                   \
+            } else {                                                            \
+                /* Another consumer took this ticket; catch up */               \
+                pos = QS_LOAD(&q->head, relaxed);                               \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+    QUEUE_STATIC_SIZE_CALLS(name, CAP, QS_LOAD(&q->head, acquire), QS_LOAD(&q->tail, acquire))
+
+#endif // QUEUE_STATIC_H
@@ -0,0 +1,57 @@
+//queue_static.hpp
+// C++ wrapper over queue_static.h: the same generated code as DEFINE_QUEUE,
+// as a class template.
+//
+//   StaticQueue<int, 1024> q;                             // twolock
+//   StaticQueue<Msg, 256, queue_policy::lockfree> m;
+//   if (q.push(42)) ...; int v; if (q.pop(v)) ...;
+//
+// Needs LOCK=omp or LOCK=pthread: the spinning locks of lock.h use C11
+// atomics.
+#ifndef QUEUE_STATIC_HPP
+#define QUEUE_STATIC_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+#include "queue_static.h"
+
+namespace queue_policy {
+
+// One class per policy, each holding DEFINE_QUEUE's struct (`q`) and its
+// functions as static members
+template <class T, std::size_t N> struct seq { DEFINE_QUEUE(q, T, N, seq) };
+template <class T, std::size_t N> struct onelock { DEFINE_QUEUE(q, T, N, onelock) };
+template <class T, std::size_t N> struct twolock { DEFINE_QUEUE(q, T, N, twolock) };
+template <class T, std::size_t N> struct lockfree { DEFINE_QUEUE(q, T, N, lockfree) };
+
+} // namespace queue_policy
+
+template <class T, std::size_t N,
+          template <class, std::size_t> class Policy = queue_policy::twolock>
+class StaticQueue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "StaticQueue elements are copied like the C queues' (trivially copyable T)");
+    using impl = Policy<T, N>;
+
+public:
+    StaticQueue() { impl::q_init(&q_); }
+    ~StaticQueue() { impl::q_destroy(&q_); }
+    StaticQueue(const StaticQueue &) = delete;
+    StaticQueue &operator=(const StaticQueue &) = delete;
+
+    // false if the queue is full
+    bool push(const T &value) { return impl::q_enqueue(&q_, value); }
+    // false if the queue is empty
+    bool pop(T &out) { return impl::q_dequeue(&q_, &out); }
+
+    int size() const { return impl::q_size(&q_); }
+    bool empty() const { return impl::q_is_empty(&q_); }
+    bool full() const { return impl::q_is_full(&q_); }
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    typename impl::q q_;
+};
+
+#endif // QUEUE_STATIC_HPP
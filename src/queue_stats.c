@@ -0,0 +1,62 @@
+// queue_stats.c
+// queue_get_stats on top of any queue implementation: sums the per-thread
+// shards of the counters declared in stats.h. Built without QUEUE_STATS
+// it only reports that there is nothing to read.
+#define _GNU_SOURCE
+#include "queue.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef QUEUE_STATS
+#include <stdatomic.h>
+#include <time.h>
+
+static atomic_int next_shard = 0;
+static _Thread_local int my_shard = -1;
+
+int stats_shard_index(void) {
+    // First call on this thread: take the next shard
+    if (my_shard < 0) {
+        my_shard = atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed) % STATS_SHARDS;
+    }
+    return my_shard;
+}
+
+long long stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#endif
+
+bool queue_get_stats(const Queue *q, QueueStats *out) {
+    //Edge case: out is NULL
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    //Edge case: q is NULL
+    if (!q) return false;
+
+#ifdef QUEUE_STATS
+    // Reading never changes the counters
+    QueueStatsBlock *s = queue_stats_block((Queue *)q);
+    unsigned long long wait_ns = 0;
+    for (int i = 0; i < STATS_SHARDS; i++) {
+        StatsShard *sh = &s->shard[i];
+        out->enqueued += atomic_load_explicit(&sh->enqueued, memory_order_relaxed);
+        out->dequeued += atomic_load_explicit(&sh->dequeued, memory_order_relaxed);
+        out->full += atomic_load_explicit(&sh->full, memory_order_relaxed);
+        out->empty += atomic_load_explicit(&sh->empty, memory_order_relaxed);
+        out->contended += atomic_load_explicit(&sh->contended, memory_order_relaxed);
+        wait_ns += atomic_load_explicit(&sh->wait_ns, memory_order_relaxed);
+        unsigned long long hw = atomic_load_explicit(&sh->high_water, memory_order_relaxed);
+        if (hw > out->high_water) out->high_water = hw;
+    }
+    out->wait_s = (double)wait_ns * 1e-9;
+    return true;
+#else
+    //Edge case: built without QUEUE_STATS, no counters to read
+    return false;
+#endif
+}
@@ -1,102 +1,322 @@
 //queue.c 
 #include "queue.h" 
+#include "park.h"
+#include "ring.h"
+#include "lock.h"
+#include "stats.h"
+#include "numa_mem.h"
 #include <stdlib.h> 
 #include <stddef.h> 
 #include <stdbool.h> 
-#include <omp.h> 
+#include <stdint.h> 
 // Internal representation: bounded circular buffer. 
+// head/tail are monotonically increasing 64-bit counters (slot = ring_slot).
 struct Queue { 
-    int *data; // array of length capacity 
-    int capacity; // maximum number of elements 
-    int head; // index of next element to dequeue 
-    int tail; // index of next slot to enqueue 
+    void *data; // array of length slots, elem_size bytes per slot 
+    size_t elem_size; // bytes per element (sizeof(int) for int queues)
+    int capacity; // maximum number of elements (as requested) 
+    size_t slots; // ring size (capacity, or rounded up to a power of two) 
+    size_t mask; // slots - 1 if slots is a power of two, else 0 
+    int node; // node given to create_on_node/create_ex, -1 if none
+    unsigned mem; // QUEUE_MEM_* flags in effect for the ring (numa_mem.h)
+    uint64_t head; // count of elements dequeued so far 
+    uint64_t tail; // count of elements enqueued so far 
     int size; // current number of elements 
-    omp_lock_t lock; 
+    QLock lock; 
+    Parker not_full; // producers blocked in enqueue_wait
+    Parker not_empty; // consumers blocked in dequeue_wait
+#ifdef QUEUE_STATS
+    QueueStatsBlock stats; // per-thread counters (stats.h)
+#endif
 }; 
 
-Queue* create(int capacity) { 
-    //Edge case: capacity <= 0 
-    if (capacity <= 0) return NULL; 
+static Queue* create_ring(int capacity, size_t esize, int pow2, int node, unsigned mem) { 
+    //Edge case: capacity <= 0 or zero-sized elements
+    if (capacity <= 0 || esize == 0) return NULL; 
     
-    //Allocate memory for the queue struct 
-    Queue *q = (Queue *)malloc(sizeof(Queue)); 
+    //Allocate memory for the queue struct (cache-line aligned if it holds stats)
+    bool bound;
+    Queue *q = (Queue *)numa_mem_alloc(sizeof(Queue), _Alignof(Queue), node, &bound);
     
     //Edge case: malloc fails 
     if(!q) return NULL; 
     
     //Allocate memory for the data array
-    q->data = (int *)malloc(sizeof(int) * capacity); 
+    q->slots = ring_slots_for(capacity, pow2); 
+    q->data = numa_mem_ring_alloc(esize * q->slots, _Alignof(max_align_t), node, mem, &q->mem); 
     
     //Edge case: malloc fails 
-    if (!q->data) { free(q); return NULL; } 
+    if (!q->data) { numa_mem_free(q, sizeof(Queue), node); return NULL; } 
     //Initialize the queue fields 
+    q->elem_size = esize;
+    q->node = node;
     q->capacity = capacity; 
+    q->mask = ring_mask_for(q->slots); 
     q->head = 0; 
     q->tail = 0; 
     q->size = 0; 
-    omp_init_lock(&q->lock); 
+    qlock_init(&q->lock); 
+    parker_init(&q->not_full);
+    parker_init(&q->not_empty);
+    STATS_INIT(q);
     
     return q; 
 } 
+
+Queue* create(int capacity) {
+    return create_ring(capacity, sizeof(int), 0, -1, 0);
+}
+
+Queue* create_pow2(int capacity) {
+    return create_ring(capacity, sizeof(int), 1, -1, 0);
+}
+
+Queue* create_sized(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 0, -1, 0);
+}
+
+Queue* create_sized_pow2(int capacity, size_t elem_size) {
+    return create_ring(capacity, elem_size, 1, -1, 0);
+}
+
+Queue* create_on_node(int capacity, int node) {
+    return create_ring(capacity, sizeof(int), 0, node < 0 ? numa_mem_current_node() : node, 0);
+}
+
+Queue* create_ex(int capacity, const QueueOptions *opts) {
+    //Edge case: no options, same as create
+    if (!opts) return create(capacity);
+    size_t esize = opts->elem_size ? opts->elem_size : sizeof(int);
+    return create_ring(capacity, esize, opts->pow2, numa_mem_opts_node(opts), opts->mem);
+}
     
 void destroy(Queue *q) {
     //Edge case: q is NULL
     if (!q) return;
     
     // Destroy lock (caller must ensure no one is using q anymore)
-    omp_destroy_lock(&q->lock);
+    qlock_destroy(&q->lock);
+    //Close the eventfds, if any
+    parker_destroy(&q->not_full);
+    parker_destroy(&q->not_empty);
     //Free the data array
-    free(q->data);
+    numa_mem_ring_free(q->data, q->elem_size * q->slots, q->mem);
     //Free the queue struct
-    free(q);
+    numa_mem_free(q, sizeof(Queue), q->node);
 }
 
-bool enqueue(Queue *q, int value) {
-    //Edge case: q is NULL
-    if (!q) return false;
+// Copy one esize-byte element in at tail. Inlined with a constant esize
+// for the int calls and the common element sizes.
+RING_INLINE bool enqueue_copy(Queue *q, const void *src, size_t esize) {
     //Acquire the lock
-    omp_set_lock(&q->lock);
+    QUEUE_LOCK(q, &q->lock);
     //Edge case: queue is full
     if (q->size == q->capacity) {
-        omp_unset_lock(&q->lock);
+        qlock_release(&q->lock);
+        STATS_ADD(q, full, 1);
         return false;
     }
-    //Enqueue the value
-    q->data[q->tail] = value;
-    q->tail = (q->tail + 1) % q->capacity;
+    //Enqueue the element
+    size_t slot = ring_slot(q->mask, q->slots, q->tail);
+    ring_elem_copy((char *)q->data + slot * esize, src, esize);
+    q->tail++;
     q->size++;
+    STATS_HIGH_WATER(q, q->size);
     //Release the lock
-    omp_unset_lock(&q->lock);
+    qlock_release(&q->lock);
+    STATS_ADD(q, enqueued, 1);
+    //Wake a blocked consumer, if any
+    parker_wake(&q->not_empty, 1);
     return true;
 }
 
-bool dequeue(Queue *q, int *out) {
-    //Edge case: q or out is NULL
-    if (!q || !out) return false;
+// Copy the element at head out (mirror of enqueue_copy).
+RING_INLINE bool dequeue_copy(Queue *q, void *dst, size_t esize) {
     //Acquire the lock
-    omp_set_lock(&q->lock);
+    QUEUE_LOCK(q, &q->lock);
     //Edge case: queue is empty
     if (q->size == 0) {
-        omp_unset_lock(&q->lock);
+        qlock_release(&q->lock);
+        STATS_ADD(q, empty, 1);
         return false;
     }
-    //Dequeue the value
-    *out = q->data[q->head];
-    q->head = (q->head + 1) % q->capacity;
+    //Dequeue the element
+    size_t slot = ring_slot(q->mask, q->slots, q->head);
+    ring_elem_copy(dst, (const char *)q->data + slot * esize, esize);
+    q->head++;
     q->size--;
     //Release the lock
-    omp_unset_lock(&q->lock);
+    qlock_release(&q->lock);
+    STATS_ADD(q, dequeued, 1);
+    //Wake a blocked producer, if any
+    parker_wake(&q->not_full, 1);
     return true;
 }
 
+bool enqueue(Queue *q, int value) {
+    //Edge case: q is NULL or does not hold ints
+    if (!q || q->elem_size != sizeof(int)) return false;
+    return enqueue_copy(q, &value, sizeof(int));
+}
+
+bool dequeue(Queue *q, int *out) {
+    //Edge case: q or out is NULL, or q does not hold ints
+    if (!q || !out || q->elem_size != sizeof(int)) return false;
+    return dequeue_copy(q, out, sizeof(int));
+}
+
+bool enqueue_elem(Queue *q, const void *elem) {
+    //Edge case: q or elem is NULL
+    if (!q || !elem) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, enqueue_copy, q, elem);
+}
+
+bool dequeue_elem(Queue *q, void *out) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return RING_SIZE_DISPATCH(q->elem_size, dequeue_copy, q, out);
+}
+
+int enqueue_bulk(Queue *q, const int *values, int n) {
+    //Edge case: q or values is NULL, nothing to enqueue, not an int queue
+    if (!q || !values || n <= 0 || q->elem_size != sizeof(int)) return 0;
+    //Acquire the lock once for the whole batch
+    QUEUE_LOCK(q, &q->lock);
+    //Take as many values as there is free space
+    int k = q->capacity - q->size;
+    if (k > n) k = n;
+    //Copy the batch in
+    ring_copy_in(q->data, q->slots, sizeof(int),
+                 ring_slot(q->mask, q->slots, q->tail), values, (size_t)k);
+    q->tail += (uint64_t)k;
+    q->size += k;
+    STATS_HIGH_WATER(q, q->size);
+    //Release the lock
+    qlock_release(&q->lock);
+    if (k > 0) STATS_ADD(q, enqueued, k);
+    else STATS_ADD(q, full, 1);
+    //Wake up to k blocked consumers, if any
+    if (k > 0) parker_wake(&q->not_empty, k);
+    return k;
+}
+
+int dequeue_bulk(Queue *q, int *out, int max) {
+    //Edge case: q or out is NULL, nothing requested, not an int queue
+    if (!q || !out || max <= 0 || q->elem_size != sizeof(int)) return 0;
+    //Acquire the lock once for the whole batch
+    QUEUE_LOCK(q, &q->lock);
+    //Take as many values as are available
+    int k = (q->size < max) ? q->size : max;
+    //Copy the batch out
+    ring_copy_out(q->data, q->slots, sizeof(int),
+                  ring_slot(q->mask, q->slots, q->head), out, (size_t)k);
+    q->head += (uint64_t)k;
+    q->size -= k;
+    //Release the lock
+    qlock_release(&q->lock);
+    if (k > 0) STATS_ADD(q, dequeued, k);
+    else STATS_ADD(q, empty, 1);
+    //Wake up to k blocked producers, if any
+    if (k > 0) parker_wake(&q->not_full, k);
+    return k;
+}
+
+void *enqueue_reserve(Queue *q, int n, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || n <= 0) return NULL;
+    //Acquire the lock; on success it stays held until enqueue_commit
+    QUEUE_LOCK(q, &q->lock);
+    //Free slots, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->tail);
+    int room = q->capacity - q->size;
+    size_t k = ring_contig(q->slots, at, (size_t)(room < n ? room : n));
+    //Edge case: queue is full
+    if (k == 0) {
+        qlock_release(&q->lock);
+        STATS_ADD(q, full, 1);
+        return NULL;
+    }
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void enqueue_commit(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no reservation, so no lock to release)
+    if (!q || !slot) return;
+    //A reservation cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    //Publish the filled slots
+    q->tail += (uint64_t)n;
+    q->size += n;
+    STATS_ADD(q, enqueued, n);
+    STATS_HIGH_WATER(q, q->size);
+    //Release the lock taken by enqueue_reserve
+    qlock_release(&q->lock);
+    //Wake up to n blocked consumers, if any
+    parker_wake(&q->not_empty, n);
+}
+
+void *dequeue_peek(Queue *q, int max, int *count) {
+    //Edge case: count is NULL
+    if (!count) return NULL;
+    *count = 0;
+    //Edge case: q is NULL, nothing requested
+    if (!q || max <= 0) return NULL;
+    //Acquire the lock; on success it stays held until dequeue_release
+    QUEUE_LOCK(q, &q->lock);
+    //Queued elements, cut at the end of the ring
+    size_t at = ring_slot(q->mask, q->slots, q->head);
+    size_t k = ring_contig(q->slots, at, (size_t)(q->size < max ? q->size : max));
+    //Edge case: queue is empty
+    if (k == 0) {
+        qlock_release(&q->lock);
+        STATS_ADD(q, empty, 1);
+        return NULL;
+    }
+    *count = (int)k;
+    return (char *)q->data + at * q->elem_size;
+}
+
+void dequeue_release(Queue *q, void *slot, int n) {
+    //Edge case: q or slot is NULL (no peek, so no lock to release)
+    if (!q || !slot) return;
+    //A peek cannot be cancelled: n is at least 1 (ring_zc_count)
+    n = ring_zc_count(n);
+    //Remove the consumed elements
+    q->head += (uint64_t)n;
+    q->size -= n;
+    STATS_ADD(q, dequeued, n);
+    //Release the lock taken by dequeue_peek
+    qlock_release(&q->lock);
+    //Wake up to n blocked producers, if any
+    parker_wake(&q->not_full, n);
+}
+
+Parker *queue_not_full_parker(Queue *q) {
+    return q ? &q->not_full : NULL;
+}
+
+Parker *queue_not_empty_parker(Queue *q) {
+    return q ? &q->not_empty : NULL;
+}
+
+#ifdef QUEUE_STATS
+QueueStatsBlock *queue_stats_block(Queue *q) {
+    return q ? &q->stats : NULL;
+}
+#endif
+
 bool is_empty(const Queue *q) {
     //Edge case: q is NULL
     if (!q) return true;
     //Acquire the lock
-    omp_set_lock((omp_lock_t *)&q->lock);
+    qlock_acquire((QLock *)&q->lock);
     int r = (q->size == 0);
     //Release the lock
-    omp_unset_lock((omp_lock_t *)&q->lock);
+    qlock_release((QLock *)&q->lock);
     return r;
 }
 
@@ -104,10 +324,10 @@ bool is_full(const Queue *q) {
     //Edge case: q is NULL
     if (!q) return false;
     //Acquire the lock
-    omp_set_lock((omp_lock_t *)&q->lock);
+    qlock_acquire((QLock *)&q->lock);
     int r = (q->size == q->capacity);
     //Release the lock
-    omp_unset_lock((omp_lock_t *)&q->lock);
+    qlock_release((QLock *)&q->lock);
     return r;
 }
 
@@ -115,10 +335,10 @@ int size(const Queue *q) {
     //Edge case: q is NULL
     if (!q) return 0;
     //Acquire the lock
-    omp_set_lock((omp_lock_t *)&q->lock);
+    qlock_acquire((QLock *)&q->lock);
     int r = q->size;
     //Release the lock
-    omp_unset_lock((omp_lock_t *)&q->lock);
+    qlock_release((QLock *)&q->lock);
     return r;
 }
 
@@ -126,4 +346,22 @@ int capacity(const Queue *q) {
     //Edge case: q is NULL
     if (!q) return 0;
     return q->capacity;
+}
+
+int queue_node(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return -1;
+    return (q->mem & QUEUE_MEM_NODE) ? q->node : -1;
+}
+
+unsigned queue_mem(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->mem & NUMA_MEM_FLAGS;
+}
+
+size_t elem_size(const Queue *q) {
+    //Edge case: q is NULL
+    if (!q) return 0;
+    return q->elem_size;
 }
\ No newline at end of file
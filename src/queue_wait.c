@@ -0,0 +1,189 @@
+// queue_wait.c
+// Blocking enqueue/dequeue on top of any queue implementation:
+// try, spin briefly with a pause hint, then park on a futex until the
+// opposite side wakes us (see park.h).
+#define _GNU_SOURCE
+#include "queue.h"
+#include "park.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+// Parkers in memory shared between processes (MODE=shm) need the
+// shared futex ops: the private ones key on the process's own mapping
+#ifdef PARK_SHARED
+#define PARK_FUTEX_WAIT FUTEX_WAIT
+#define PARK_FUTEX_WAKE FUTEX_WAKE
+#else
+#define PARK_FUTEX_WAIT FUTEX_WAIT_PRIVATE
+#define PARK_FUTEX_WAKE FUTEX_WAKE_PRIVATE
+#endif
+
+// Failed attempts before a caller parks
+#ifndef WAIT_SPIN_LIMIT
+#define WAIT_SPIN_LIMIT 128
+#endif
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Sleep while p->seq == key, for at most timeout_ns (< 0: no limit).
+// Spurious returns are fine: the caller re-checks the queue.
+static void futex_wait(Parker *p, unsigned key, long long timeout_ns) {
+#ifdef __linux__
+    struct timespec ts, *tsp = NULL;
+    if (timeout_ns >= 0) {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, (unsigned *)&p->seq, PARK_FUTEX_WAIT, key, tsp, NULL, 0);
+#else
+    // No futex: yield and let the caller poll
+    (void)p; (void)key; (void)timeout_ns;
+    sched_yield();
+#endif
+}
+
+// Whether this process can use private expedited membarrier: probed and
+// registered once, by the first parker_initial_state
+static atomic_int membarrier_state;   // 0 unknown, 1 usable, -1 not
+
+int parker_initial_state(void) {
+#ifdef __linux__
+    int st = atomic_load_explicit(&membarrier_state, memory_order_acquire);
+    if (st == 0) {
+        long cmds = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        st = (cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+              syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0)
+                 ? 1 : -1;
+        atomic_store_explicit(&membarrier_state, st, memory_order_release);
+    }
+    return st > 0 ? PARK_UNFENCED : PARK_FENCED;
+#else
+    return PARK_FENCED;
+#endif
+}
+
+void parker_prepare_slow(Parker *p) {
+    int expected = PARK_UNFENCED;
+    atomic_compare_exchange_strong_explicit(&p->fenced, &expected, PARK_FENCING,
+                                            memory_order_seq_cst, memory_order_seq_cst);
+#ifdef __linux__
+    // A wake that read PARK_UNFENCED did so before the barrier this runs
+    // on its CPU, so its queue change is visible to our re-check; any
+    // later wake sees PARK_FENCING and takes the fence. Every waiter that
+    // finds the state short of PARK_FENCED runs it, in case the first one
+    // is still inside the call.
+    syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+#endif
+    atomic_store_explicit(&p->fenced, PARK_FENCED, memory_order_release);
+}
+
+void parker_wake_slow(Parker *p, int n) {
+    // An armed eventfd counts as a waiter; if it was the only one, the
+    // write below is the whole wake-up
+    parker_signal_fd(p);
+    if (atomic_load_explicit(&p->waiters, memory_order_seq_cst) == 0) return;
+
+    atomic_fetch_add_explicit(&p->seq, 1, memory_order_seq_cst);
+#ifdef __linux__
+    syscall(SYS_futex, (unsigned *)&p->seq, PARK_FUTEX_WAKE, n, NULL, NULL, 0);
+#else
+    (void)n;
+#endif
+}
+
+// Shared wait loop. try_op performs one non-blocking attempt.
+// timeout_ms < 0 waits forever, 0 only tries once.
+static bool wait_for(Queue *q, Parker *p, int timeout_ms,
+                     bool (*try_op)(Queue *, void *), void *arg) {
+    // Fast path and brief spin
+    for (int spin = 0; spin < WAIT_SPIN_LIMIT; spin++) {
+        if (try_op(q, arg)) return true;
+        // Nobody else can change the queue, or caller asked not to wait
+        if (!p || timeout_ms == 0) return false;
+        cpu_relax();
+    }
+
+    long long deadline = (timeout_ms > 0) ? now_ns() + (long long)timeout_ms * 1000000LL : -1;
+
+    parker_prepare(p);
+    for (;;) {
+        // Announce ourselves before the re-check (pairs with parker_wake)
+        atomic_fetch_add_explicit(&p->waiters, 1, memory_order_seq_cst);
+        unsigned key = atomic_load_explicit(&p->seq, memory_order_seq_cst);
+
+        if (try_op(q, arg)) {
+            atomic_fetch_sub_explicit(&p->waiters, 1, memory_order_relaxed);
+            return true;
+        }
+
+        long long remaining = -1;
+        if (deadline >= 0) {
+            remaining = deadline - now_ns();
+            if (remaining <= 0) {
+                atomic_fetch_sub_explicit(&p->waiters, 1, memory_order_relaxed);
+                return false;
+            }
+        }
+
+        // Returns at once if a wake bumped seq since we read key
+        long long t0 = STATS_NOW();
+        futex_wait(p, key, remaining);
+        STATS_WAITED(q, t0);
+        atomic_fetch_sub_explicit(&p->waiters, 1, memory_order_relaxed);
+
+        if (try_op(q, arg)) return true;
+    }
+}
+
+static bool try_enqueue(Queue *q, void *arg) {
+    return enqueue(q, *(const int *)arg);
+}
+
+static bool try_dequeue(Queue *q, void *arg) {
+    return dequeue(q, (int *)arg);
+}
+
+bool enqueue_wait_timeout(Queue *q, int value, int timeout_ms) {
+    //Edge case: q is NULL
+    if (!q) return false;
+    return wait_for(q, queue_not_full_parker(q), timeout_ms, try_enqueue, &value);
+}
+
+bool dequeue_wait_timeout(Queue *q, int *out, int timeout_ms) {
+    //Edge case: q or out is NULL
+    if (!q || !out) return false;
+    return wait_for(q, queue_not_empty_parker(q), timeout_ms, try_dequeue, out);
+}
+
+bool enqueue_wait(Queue *q, int value) {
+    return enqueue_wait_timeout(q, value, -1);
+}
+
+bool dequeue_wait(Queue *q, int *out) {
+    return dequeue_wait_timeout(q, out, -1);
+}
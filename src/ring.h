@@ -0,0 +1,110 @@
+// ring.h
+// Internal helpers shared by the ring-buffer implementations: slot
+// indexing for monotonically increasing 64-bit counters and wrap-aware
+// element copies. Not part of the public API.
+#ifndef RING_H
+#define RING_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Force inlining of the per-element-size specialized cores
+#if defined(__GNUC__)
+#define RING_INLINE static inline __attribute__((always_inline))
+#else
+#define RING_INLINE static inline
+#endif
+
+// Count passed to enqueue_commit/dequeue_release, which must be >= 1.
+// The lock-free rings cannot hand a claimed ticket back, so no mode lets
+// a reservation or peek be cancelled. Debug builds trap n <= 0; with
+// NDEBUG it is taken as 1, so no mode is left with a claimed slot.
+static inline int ring_zc_count(int n) {
+    assert(n > 0);
+    return n > 0 ? n : 1;
+}
+
+// Smallest power of two >= n (n >= 1).
+static inline size_t ring_round_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+// Number of slots to allocate for a requested capacity.
+// With pow2 the ring is rounded up so every index update is a mask.
+static inline size_t ring_slots_for(int capacity, int pow2) {
+    return pow2 ? ring_round_pow2((size_t)capacity) : (size_t)capacity;
+}
+
+// Mask for a ring of `slots` slots, or 0 if slots is not a power of two
+// (a one-slot ring maps everything to slot 0 either way).
+static inline size_t ring_mask_for(size_t slots) {
+    return (slots & (slots - 1)) == 0 ? slots - 1 : 0;
+}
+
+// Slot of counter `pos`: a mask when the ring size is a power of two,
+// a modulo otherwise.
+static inline size_t ring_slot(size_t mask, size_t slots, uint64_t pos) {
+    return mask ? (size_t)(pos & mask) : (size_t)(pos % slots);
+}
+
+// How many of n slots starting at slot `at` lie before the end of the ring,
+// i.e. the longest contiguous run a zero-copy reservation can hand out.
+static inline size_t ring_contig(size_t slots, size_t at, size_t n) {
+    return (slots - at < n) ? slots - at : n;
+}
+
+// Copy one element of `esize` bytes. When esize is a compile-time
+// constant (see RING_SIZE_DISPATCH) the memcpy becomes a few moves.
+static inline void ring_elem_copy(void *dst, const void *src, size_t esize) {
+    memcpy(dst, src, esize);
+}
+
+// Call fn(q, p, esize) with esize as a compile-time constant for the
+// common element sizes, so an inlined fn gets a specialized copy; other
+// sizes fall back to the runtime value.
+#define RING_SIZE_DISPATCH(esize, fn, q, p) \
+    ((esize) == 4  ? fn((q), (p), 4)  : \
+     (esize) == 8  ? fn((q), (p), 8)  : \
+     (esize) == 16 ? fn((q), (p), 16) : \
+     (esize) == 64 ? fn((q), (p), 64) : fn((q), (p), (esize)))
+
+// Bulk copies of at least this many bytes go through the wide-copy
+// kernels of ring_copy.c; shorter ones stay an inlined memcpy.
+#define RING_WIDE_MIN 256
+
+// Copy bytes >= RING_WIDE_MIN with the kernel picked at run time (AVX2,
+// SSE2 or memcpy; see queue_set_copy_kernel), optionally with
+// non-temporal stores (queue_set_stream_threshold). Defined in ring_copy.c.
+void ring_copy_wide(void *dst, const void *src, size_t bytes);
+
+// One contiguous span of a bulk copy.
+static inline void ring_copy_bytes(void *dst, const void *src, size_t bytes) {
+    if (bytes < RING_WIDE_MIN) memcpy(dst, src, bytes);
+    else ring_copy_wide(dst, src, bytes);
+}
+
+// Copy n elements of `esize` bytes into a ring of `slots` slots starting at
+// slot `at`, splitting the copy at the wrap point (at most two contiguous
+// spans).
+static inline void ring_copy_in(void *data, size_t slots, size_t esize,
+                                size_t at, const void *src, size_t n) {
+    size_t first = slots - at;
+    if (first > n) first = n;
+    ring_copy_bytes((char *)data + at * esize, src, esize * first);
+    ring_copy_bytes(data, (const char *)src + first * esize, esize * (n - first));
+}
+
+// Copy n elements out of a ring starting at slot `at` (mirror of ring_copy_in).
+static inline void ring_copy_out(const void *data, size_t slots, size_t esize,
+                                 size_t at, void *dst, size_t n) {
+    size_t first = slots - at;
+    if (first > n) first = n;
+    ring_copy_bytes(dst, (const char *)data + at * esize, esize * first);
+    ring_copy_bytes((char *)dst + first * esize, data, esize * (n - first));
+}
+
+#endif // RING_H
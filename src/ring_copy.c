@@ -0,0 +1,206 @@
+// ring_copy.c
+// Wide-copy kernels behind ring_copy_in/ring_copy_out (ring.h): the spans
+// of a bulk transfer are copied with 32-byte AVX2 or 16-byte SSE2 loads
+// and stores, picked at run time from what the CPU supports, or memcpy
+// on other CPUs. Each kernel aligns the destination with one unaligned
+// store, streams the aligned body four vectors at a time and finishes
+// with one unaligned store that overlaps the body.
+//
+// Spans of at least the stream threshold (queue_set_stream_threshold,
+// off by default) are written with non-temporal stores, which go around
+// the cache: for transfers much larger than the cache whose data is not
+// read again soon, they avoid evicting everything else and the reads for
+// ownership of the destination lines.
+#include "queue.h"
+#include "ring.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RING_COPY_X86 1
+#include <immintrin.h>
+#endif
+
+enum { KERNEL_MEMCPY, KERNEL_SSE2, KERNEL_AVX2, KERNEL_AUTO };
+
+static const char *const kernel_names[] = { "memcpy", "sse2", "avx2" };
+
+// Kernel in use (KERNEL_AUTO until the first copy or queue_copy_kernel)
+static atomic_int kernel = KERNEL_AUTO;
+
+// Spans of at least this many bytes use non-temporal stores; 0: never
+static atomic_size_t stream_threshold = 0;
+
+#ifdef RING_COPY_X86
+
+// Copies bytes >= RING_WIDE_MIN (>= 64), so the head and tail stores
+// always land inside the span
+__attribute__((target("avx2")))
+static void copy_avx2(void *dst, const void *src, size_t bytes, bool nt) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+    char *end = d + bytes;
+    const char *send = s + bytes;
+
+    // Unaligned head, then step to the next 32-byte boundary of d
+    __m256i tail = _mm256_loadu_si256((const __m256i *)(send - 32));
+    _mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+    size_t skip = 32 - ((uintptr_t)d & 31);
+    d += skip;
+    s += skip;
+    size_t n = (size_t)(end - d);
+
+    if (nt) {
+        for (; n >= 128; n -= 128, d += 128, s += 128) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)s);
+            __m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i *)(s + 64));
+            __m256i e = _mm256_loadu_si256((const __m256i *)(s + 96));
+            _mm256_stream_si256((__m256i *)d, a);
+            _mm256_stream_si256((__m256i *)(d + 32), b);
+            _mm256_stream_si256((__m256i *)(d + 64), c);
+            _mm256_stream_si256((__m256i *)(d + 96), e);
+        }
+        for (; n >= 32; n -= 32, d += 32, s += 32) {
+            _mm256_stream_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+        }
+        // Streaming stores are weakly ordered: make them visible before
+        // the caller publishes the new head/tail
+        _mm_sfence();
+    } else {
+        for (; n >= 128; n -= 128, d += 128, s += 128) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)s);
+            __m256i b = _mm256_loadu_si256((const __m256i *)(s + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i *)(s + 64));
+            __m256i e = _mm256_loadu_si256((const __m256i *)(s + 96));
+            _mm256_store_si256((__m256i *)d, a);
+            _mm256_store_si256((__m256i *)(d + 32), b);
+            _mm256_store_si256((__m256i *)(d + 64), c);
+            _mm256_store_si256((__m256i *)(d + 96), e);
+        }
+        for (; n >= 32; n -= 32, d += 32, s += 32) {
+            _mm256_store_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+        }
+    }
+
+    // Last (up to) 32 bytes, overlapping what the body wrote
+    _mm256_storeu_si256((__m256i *)(end - 32), tail);
+}
+
+// Same as copy_avx2 with 16-byte vectors (SSE2 is baseline on x86-64)
+__attribute__((target("sse2")))
+static void copy_sse2(void *dst, const void *src, size_t bytes, bool nt) {
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+    char *end = d + bytes;
+    const char *send = s + bytes;
+
+    __m128i tail = _mm_loadu_si128((const __m128i *)(send - 16));
+    _mm_storeu_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+    size_t skip = 16 - ((uintptr_t)d & 15);
+    d += skip;
+    s += skip;
+    size_t n = (size_t)(end - d);
+
+    if (nt) {
+        for (; n >= 64; n -= 64, d += 64, s += 64) {
+            __m128i a = _mm_loadu_si128((const __m128i *)s);
+            __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+            __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+            _mm_stream_si128((__m128i *)d, a);
+            _mm_stream_si128((__m128i *)(d + 16), b);
+            _mm_stream_si128((__m128i *)(d + 32), c);
+            _mm_stream_si128((__m128i *)(d + 48), e);
+        }
+        for (; n >= 16; n -= 16, d += 16, s += 16) {
+            _mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+        }
+        _mm_sfence();
+    } else {
+        for (; n >= 64; n -= 64, d += 64, s += 64) {
+            __m128i a = _mm_loadu_si128((const __m128i *)s);
+            __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+            __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+            _mm_store_si128((__m128i *)d, a);
+            _mm_store_si128((__m128i *)(d + 16), b);
+            _mm_store_si128((__m128i *)(d + 32), c);
+            _mm_store_si128((__m128i *)(d + 48), e);
+        }
+        for (; n >= 16; n -= 16, d += 16, s += 16) {
+            _mm_store_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+        }
+    }
+
+    _mm_storeu_si128((__m128i *)(end - 16), tail);
+}
+
+#endif // RING_COPY_X86
+
+static bool kernel_supported(int k) {
+#ifdef RING_COPY_X86
+    if (k == KERNEL_AVX2) return __builtin_cpu_supports("avx2");
+    if (k == KERNEL_SSE2) return __builtin_cpu_supports("sse2");
+#endif
+    return k == KERNEL_MEMCPY;
+}
+
+// Kernel in use, resolving the automatic choice on first use (racing
+// first callers all pick the same one)
+static int current_kernel(void) {
+    int k = atomic_load_explicit(&kernel, memory_order_relaxed);
+    if (k != KERNEL_AUTO) return k;
+    k = kernel_supported(KERNEL_AVX2) ? KERNEL_AVX2 :
+        kernel_supported(KERNEL_SSE2) ? KERNEL_SSE2 : KERNEL_MEMCPY;
+    atomic_store_explicit(&kernel, k, memory_order_relaxed);
+    return k;
+}
+
+void ring_copy_wide(void *dst, const void *src, size_t bytes) {
+    size_t nt_min = atomic_load_explicit(&stream_threshold, memory_order_relaxed);
+    bool nt = nt_min != 0 && bytes >= nt_min;
+
+    switch (current_kernel()) {
+#ifdef RING_COPY_X86
+    case KERNEL_AVX2:
+        copy_avx2(dst, src, bytes, nt);
+        return;
+    case KERNEL_SSE2:
+        copy_sse2(dst, src, bytes, nt);
+        return;
+#endif
+    default:
+        memcpy(dst, src, bytes);
+        return;
+    }
+}
+
+const char *queue_copy_kernel(void) {
+    return kernel_names[current_kernel()];
+}
+
+bool queue_set_copy_kernel(const char *name) {
+    //Edge case: NULL goes back to the automatic choice
+    if (!name) {
+        atomic_store_explicit(&kernel, KERNEL_AUTO, memory_order_relaxed);
+        return true;
+    }
+    for (int k = KERNEL_MEMCPY; k < KERNEL_AUTO; k++) {
+        if (strcmp(name, kernel_names[k]) != 0) continue;
+        //Edge case: the CPU lacks the instructions
+        if (!kernel_supported(k)) return false;
+        atomic_store_explicit(&kernel, k, memory_order_relaxed);
+        return true;
+    }
+    //Edge case: unknown kernel name
+    return false;
+}
+
+void queue_set_stream_threshold(size_t bytes) {
+    atomic_store_explicit(&stream_threshold, bytes, memory_order_relaxed);
+}
@@ -0,0 +1,112 @@
+// stats.h
+// Internal helper shared by the queue implementations: runtime counters
+// behind queue_get_stats, compiled in with -DQUEUE_STATS (make STATS=1).
+// Without it every macro below expands to nothing (or to a plain
+// qlock_acquire) and struct Queue has no stats member. Not part of the
+// public API.
+//
+// Counters are sharded: each thread adds into its own cache line
+// (thread-local index from a global counter, modulo STATS_SHARDS), so
+// counting adds no false sharing between threads. queue_get_stats sums
+// the shards.
+#ifndef STATS_H
+#define STATS_H
+
+#include "queue.h"
+#include "lock.h"
+
+#ifdef QUEUE_STATS
+
+#include <stdatomic.h>
+#include <string.h>
+
+#ifndef STATS_SHARDS
+#define STATS_SHARDS 64
+#endif
+
+typedef struct {
+    _Alignas(64) atomic_ullong enqueued;
+    atomic_ullong dequeued;
+    atomic_ullong full;         // enqueue attempts rejected (queue full)
+    atomic_ullong empty;        // dequeue attempts rejected (queue empty)
+    atomic_ullong contended;    // lock waits / CAS retries
+    atomic_ullong wait_ns;      // time blocked on locks or parked
+    atomic_ullong high_water;   // largest size this thread saw
+} StatsShard;
+
+typedef struct {
+    StatsShard shard[STATS_SHARDS];
+} QueueStatsBlock;
+
+// Calling thread's shard index (queue_stats.c)
+int stats_shard_index(void);
+
+// Monotonic clock in ns (queue_stats.c)
+long long stats_now_ns(void);
+
+static inline StatsShard *stats_here(QueueStatsBlock *s) {
+    return &s->shard[stats_shard_index()];
+}
+
+static inline void stats_init(QueueStatsBlock *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+static inline void stats_high_water(QueueStatsBlock *s, unsigned long long n) {
+    StatsShard *sh = stats_here(s);
+    // Only this thread (or one sharing the shard) raises it: rarely retried
+    unsigned long long cur = atomic_load_explicit(&sh->high_water, memory_order_relaxed);
+    while (n > cur && !atomic_compare_exchange_weak_explicit(
+               &sh->high_water, &cur, n, memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+// Add the time since t0 to the calling thread's wait total
+static inline void stats_waited(QueueStatsBlock *s, long long t0) {
+    atomic_fetch_add_explicit(&stats_here(s)->wait_ns, (unsigned long long)(stats_now_ns() - t0),
+                              memory_order_relaxed);
+}
+
+// Take l; if it is held, count a contended acquisition and the time
+// spent waiting for it
+static inline void stats_lock(QueueStatsBlock *s, QLock *l) {
+    if (qlock_try(l)) return;
+    long long t0 = stats_now_ns();
+    qlock_acquire(l);
+    atomic_fetch_add_explicit(&stats_here(s)->contended, 1, memory_order_relaxed);
+    stats_waited(s, t0);
+}
+
+// Zero q's counters (create)
+#define STATS_INIT(q) stats_init(&(q)->stats)
+
+// Add n to a counter of q's calling-thread shard
+#define STATS_ADD(q, field, n) \
+    atomic_fetch_add_explicit(&stats_here(&(q)->stats)->field, \
+                              (unsigned long long)(n), memory_order_relaxed)
+
+// Record that q held n elements
+#define STATS_HIGH_WATER(q, n) stats_high_water(&(q)->stats, (unsigned long long)(n))
+
+// qlock_acquire(l) that counts contention on q
+#define QUEUE_LOCK(q, l) stats_lock(&(q)->stats, (l))
+
+// Implemented by each queue_*.c: q's counters, or NULL if q is NULL
+QueueStatsBlock *queue_stats_block(Queue *q);
+
+// For code outside the implementations (queue_wait.c): time a wait
+// started at t0 = STATS_NOW() on q
+#define STATS_NOW() stats_now_ns()
+#define STATS_WAITED(q, t0) stats_waited(queue_stats_block(q), (t0))
+
+#else
+
+#define STATS_INIT(q) ((void)0)
+#define STATS_ADD(q, field, n) ((void)0)
+#define STATS_HIGH_WATER(q, n) ((void)0)
+#define QUEUE_LOCK(q, l) qlock_acquire(l)
+#define STATS_NOW() 0LL
+#define STATS_WAITED(q, t0) ((void)(t0))
+
+#endif // QUEUE_STATS
+
+#endif // STATS_H
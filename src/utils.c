@@ -27,3 +27,248 @@ void print_row_seq(const char *impl, int cap, int items, int t,
 void print_footer() {
     printf("+----------+-----+---+---+--------+--------+------------+------------+------------+-----------------------+\n");
 }
+
+void print_header_bulk() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+------------+-----------------------+\n");
+    printf("| impl     | cap | P | C | items  | batch | trials | time_avg_s | time_min_s | time_max_s | throughput_ops_per_s |\n");
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+------------+-----------------------+\n");
+}
+
+void print_row_bulk(const char *impl, int cap, int P, int C, int items, int batch, int t,
+                    double avg, double tmin, double tmax, double thr) {
+    printf("| %-8s | %3d | %1d | %1d | %6d | %5d | %6d | %10.4f | %10.4f | %10.4f | %21.1f |\n",
+           impl, cap, P, C, items, batch, t, avg, tmin, tmax, thr);
+}
+
+void print_footer_bulk() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+------------+-----------------------+\n");
+}
+
+void print_header_sized() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+-----------------------+\n");
+    printf("| impl     | cap | P | C | items  | bytes | trials | time_avg_s | time_min_s | throughput_ops_per_s | MB_per_s | zero_copy_ops_per_s  |\n");
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+-----------------------+\n");
+}
+
+void print_row_sized(const char *impl, int cap, int P, int C, int items, int bytes, int t,
+                     double avg, double tmin, double thr, double mbps, double zc_thr) {
+    printf("| %-8s | %3d | %1d | %1d | %6d | %5d | %6d | %10.4f | %10.4f | %21.1f | %8.1f | %21.1f |\n",
+           impl, cap, P, C, items, bytes, t, avg, tmin, thr, mbps, zc_thr);
+}
+
+void print_footer_sized() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+-----------------------+\n");
+}
+
+void print_header_oversub() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+\n");
+    printf("| impl     | cap | P | C | items  | wait  | trials | time_avg_s | cpu_avg_s  | throughput_ops_per_s | cpu/wall |\n");
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+\n");
+}
+
+void print_row_oversub(const char *impl, int cap, int P, int C, int items, const char *wait, int t,
+                       double avg, double cpu, double thr) {
+    printf("| %-8s | %3d | %1d | %1d | %6d | %-5s | %6d | %10.4f | %10.4f | %21.1f | %8.2f |\n",
+           impl, cap, P, C, items, wait, t, avg, cpu, thr, cpu / avg);
+}
+
+void print_footer_oversub() {
+    printf("+----------+-----+---+---+--------+-------+--------+------------+------------+-----------------------+----------+\n");
+}
+
+void print_header_burst() {
+    printf("+------------+--------+--------+--------+----------+-----------------------+-------------+--------------+----------+\n");
+    printf("| impl       | queues | burst  | rounds | time_s   | throughput_ops_per_s | peak_rss_kb | rss_drain_kb | segments |\n");
+    printf("+------------+--------+--------+--------+----------+-----------------------+-------------+--------------+----------+\n");
+}
+
+void print_row_burst(const char *impl, int queues, int burst, int rounds, double sec, double thr,
+                     long peak_kb, long rss_kb, int segs) {
+    printf("| %-10s | %6d | %6d | %6d | %8.4f | %21.1f | %11ld | %12ld | %8d |\n",
+           impl, queues, burst, rounds, sec, thr, peak_kb, rss_kb, segs);
+}
+
+void print_footer_burst() {
+    printf("+------------+--------+--------+--------+----------+-----------------------+-------------+--------------+----------+\n");
+}
+
+void print_header_forkjoin() {
+    printf("+------------+---------+---------+--------+------------+------------------------+------------+\n");
+    printf("| pool       | workers | tasks   | trials | time_avg_s | throughput_tasks_per_s | steals_avg |\n");
+    printf("+------------+---------+---------+--------+------------+------------------------+------------+\n");
+}
+
+void print_row_forkjoin(const char *pool, int workers, int tasks, int t,
+                        double avg, double thr, double steals) {
+    printf("| %-10s | %7d | %7d | %6d | %10.4f | %22.1f | %10.1f |\n",
+           pool, workers, tasks, t, avg, thr, steals);
+}
+
+void print_footer_forkjoin() {
+    printf("+------------+---------+---------+--------+------------+------------------------+------------+\n");
+}
+
+void print_header_pq() {
+    printf("+----------+---------+---------+--------+------------+-----------------------+--------------+--------------+\n");
+    printf("| impl     | threads | ops     | trials | time_avg_s | throughput_ops_per_s | rank_err_avg | rank_err_max |\n");
+    printf("+----------+---------+---------+--------+------------+-----------------------+--------------+--------------+\n");
+}
+
+void print_row_pq(const char *impl, int threads, int ops, int t, double avg, double thr,
+                  double rank_avg, int rank_max) {
+    printf("| %-8s | %7d | %7d | %6d | %10.4f | %21.1f | %12.3f | %12d |\n",
+           impl, threads, ops, t, avg, thr, rank_avg, rank_max);
+}
+
+void print_footer_pq() {
+    printf("+----------+---------+---------+--------+------------+-----------------------+--------------+--------------+\n");
+}
+
+void print_header_notify() {
+    printf("+----------+-------+------+--------+------------+------------+------------+----------------+\n");
+    printf("| impl     | wait  | msgs | gap_us | lat_avg_us | lat_p50_us | lat_p99_us | consumer_cpu_s |\n");
+    printf("+----------+-------+------+--------+------------+------------+------------+----------------+\n");
+}
+
+void print_row_notify(const char *impl, const char *wait, int msgs, int gap_us,
+                      double avg_us, double p50_us, double p99_us, double cpu) {
+    printf("| %-8s | %-5s | %4d | %6d | %10.2f | %10.2f | %10.2f | %14.4f |\n",
+           impl, wait, msgs, gap_us, avg_us, p50_us, p99_us, cpu);
+}
+
+void print_footer_notify() {
+    printf("+----------+-------+------+--------+------------+------------+------------+----------------+\n");
+}
+
+void print_header_latency() {
+    printf("+----------+------+----+----+--------+-------------+-------------+-------------+--------------+--------------+\n");
+    printf("| impl     | cap  | P  | C  | items  | lat_p50_ns  | lat_p90_ns  | lat_p99_ns  | lat_p999_ns  | lat_max_ns   |\n");
+    printf("+----------+------+----+----+--------+-------------+-------------+-------------+--------------+--------------+\n");
+}
+
+void print_row_latency(const char *impl, int cap, int P, int C, int items,
+                       long long p50, long long p90, long long p99, long long p999,
+                       long long max) {
+    printf("| %-8s | %4d | %2d | %2d | %6d | %11lld | %11lld | %11lld | %12lld | %12lld |\n",
+           impl, cap, P, C, items, p50, p90, p99, p999, max);
+}
+
+void print_footer_latency() {
+    printf("+----------+------+----+----+--------+-------------+-------------+-------------+--------------+--------------+\n");
+}
+
+void print_header_stats() {
+    printf("+----------+------+----+----+--------+-----------+-----------+-----------+-----------+-----------+--------+-----------+\n");
+    printf("| impl     | cap  | P  | C  | items  | enqueued  | dequeued  | full      | empty     | contended | hwm    | wait_s    |\n");
+    printf("+----------+------+----+----+--------+-----------+-----------+-----------+-----------+-----------+--------+-----------+\n");
+}
+
+void print_row_stats(const char *impl, int cap, int P, int C, int items,
+                     unsigned long long enqueued, unsigned long long dequeued,
+                     unsigned long long full, unsigned long long empty,
+                     unsigned long long contended, unsigned long long high_water,
+                     double wait_s) {
+    printf("| %-8s | %4d | %2d | %2d | %6d | %9llu | %9llu | %9llu | %9llu | %9llu | %6llu | %9.6f |\n",
+           impl, cap, P, C, items, enqueued, dequeued, full, empty, contended, high_water, wait_s);
+}
+
+void print_footer_stats() {
+    printf("+----------+------+----+----+--------+-----------+-----------+-----------+-----------+-----------+--------+-----------+\n");
+}
+
+void print_header_mem() {
+    printf("+------------+-----------+---------------+------+------------+------------+----------+------------------+------------+\n");
+    printf("| impl       | cap       | options       | got  | create_ms  | first_ms   | faults   | steady_ops_per_s | dtlb_p_kop |\n");
+    printf("+------------+-----------+---------------+------+------------+------------+----------+------------------+------------+\n");
+}
+
+void print_row_mem(const char *impl, int cap, const char *options, const char *got,
+                   double create_ms, double first_ms, long faults, double steady,
+                   double dtlb_per_kop) {
+    printf("| %-10s | %9d | %-13s | %-4s | %10.3f | %10.3f | %8ld | %16.1f | %10.3f |\n",
+           impl, cap, options, got, create_ms, first_ms, faults, steady, dtlb_per_kop);
+}
+
+void print_footer_mem() {
+    printf("+------------+-----------+---------------+------+------------+------------+----------+------------------+------------+\n");
+}
+
+void print_header_shm() {
+    printf("+------------+--------------+-----------+----------+------------------+------------+------------+\n");
+    printf("| transport  | test         | msgs      | batch    | msgs_per_s       | p50_ns     | p99_ns     |\n");
+    printf("+------------+--------------+-----------+----------+------------------+------------+------------+\n");
+}
+
+void print_row_shm(const char *transport, const char *test, long msgs, int batch,
+                   double msgs_per_s, double p50_ns, double p99_ns) {
+    printf("| %-10s | %-12s | %9ld | %8d | %16.1f | %10.0f | %10.0f |\n",
+           transport, test, msgs, batch, msgs_per_s, p50_ns, p99_ns);
+}
+
+void print_footer_shm() {
+    printf("+------------+--------------+-----------+----------+------------------+------------+------------+\n");
+}
+
+void print_header_static() {
+    printf("+-----------------+----------+-----------+-----------+------------------+----------+\n");
+    printf("| variant         | workload | cap       | items     | ops_per_s        | vs_queue |\n");
+    printf("+-----------------+----------+-----------+-----------+------------------+----------+\n");
+}
+
+void print_row_static(const char *variant, const char *workload, int cap, int items,
+                      double ops_per_s, double vs_queue) {
+    printf("| %-15s | %-8s | %9d | %9d | %16.1f | %8.2f |\n",
+           variant, workload, cap, items, ops_per_s, vs_queue);
+}
+
+void print_footer_static() {
+    printf("+-----------------+----------+-----------+-----------+------------------+----------+\n");
+}
+
+void print_header_copy() {
+    printf("+-----------+-----------+----------+------------+-------------+\n");
+    printf("| impl      | cap       | kernel   | drain_gbps | memcpy_gbps |\n");
+    printf("+-----------+-----------+----------+------------+-------------+\n");
+}
+
+void print_row_copy(const char *impl, int cap, const char *kernel, double drain_gbps,
+                    double memcpy_gbps) {
+    printf("| %-9s | %9d | %-8s | %10.2f | %11.2f |\n",
+           impl, cap, kernel, drain_gbps, memcpy_gbps);
+}
+
+void print_footer_copy() {
+    printf("+-----------+-----------+----------+------------+-------------+\n");
+}
+
+void print_header_bcast() {
+    printf("+------------+-----------+------+-----------+------------------+------------------+-----------+\n");
+    printf("| variant    | impl      | subs | msgs      | msgs_per_s       | deliveries_per_s | vs_queues |\n");
+    printf("+------------+-----------+------+-----------+------------------+------------------+-----------+\n");
+}
+
+void print_row_bcast(const char *variant, const char *impl, int subs, int msgs,
+                     double msgs_per_s, double deliveries_per_s, double vs_queues) {
+    printf("| %-10s | %-9s | %4d | %9d | %16.1f | %16.1f | %9.2f |\n",
+           variant, impl, subs, msgs, msgs_per_s, deliveries_per_s, vs_queues);
+}
+
+void print_footer_bcast() {
+    printf("+------------+-----------+------+-----------+------------------+------------------+-----------+\n");
+}
+
+void print_header_coro() {
+    printf("+---------+-----------+---------+-----------+----------+----------+----------+--------------+\n");
+    printf("| variant | impl      | waiters | msgs      | spawn_ms | rss_kb   | drain_ms | msgs_per_s   |\n");
+    printf("+---------+-----------+---------+-----------+----------+----------+----------+--------------+\n");
+}
+
+void print_row_coro(const char *variant, const char *impl, int waiters, int msgs,
+                    double spawn_ms, long rss_kb, double drain_ms, double msgs_per_s) {
+    printf("| %-7s | %-9s | %7d | %9d | %8.2f | %8ld | %8.2f | %12.1f |\n",
+           variant, impl, waiters, msgs, spawn_ms, rss_kb, drain_ms, msgs_per_s);
+}
+
+void print_footer_coro() {
+    printf("+---------+-----------+---------+-----------+----------+----------+----------+--------------+\n");
+}
@@ -0,0 +1,183 @@
+// tests/test_bcast.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "bcast.h"
+
+// Every consumer sees every message; the slowest one gates the producer
+static void test_broadcast_gating(void) {
+    Bcast *b = bcast_create(5, 3);   // ring rounded up to 8, capacity 5
+    assert(b != NULL);
+    assert(bcast_capacity(b) == 5);
+
+    int c0 = bcast_subscribe(b, -1);
+    int c1 = bcast_subscribe(b, -1);
+    assert(c0 == 0 && c1 == 1);
+    assert(bcast_consumers(b) == 2);
+
+    int v, out[8];
+    assert(!bcast_consume(b, c0, &v));
+
+    for (int i = 0; i < 5; i++) assert(bcast_publish(b, i));
+    assert(!bcast_publish(b, 5));
+
+    // Consumer 0 takes everything; consumer 1 still holds the ring full
+    assert(bcast_consume_bulk(b, c0, out, 8) == 5);
+    for (int i = 0; i < 5; i++) assert(out[i] == i);
+    assert(!bcast_consume(b, c0, &v));
+    assert(!bcast_publish(b, 5));
+
+    assert(bcast_consume(b, c1, &v) && v == 0);
+    assert(bcast_consume(b, c1, &v) && v == 1);
+    assert(bcast_cursor(b, c0) == 5 && bcast_cursor(b, c1) == 2);
+    assert(bcast_publish(b, 5) && bcast_publish(b, 6));
+    assert(!bcast_publish(b, 7));
+
+    // Several laps around the 8-slot ring
+    int next = 7, expect0 = 5, expect1 = 2;
+    for (int round = 0; round < 20; round++) {
+        assert(bcast_consume_bulk(b, c1, out, 3) == 3);
+        for (int i = 0; i < 3; i++) assert(out[i] == expect1++);
+        while (bcast_consume(b, c0, &v)) assert(v == expect0++);
+        for (int i = 0; i < 3; i++) assert(bcast_publish(b, next++));
+        assert(!bcast_publish(b, -1));
+    }
+    assert(bcast_consume_bulk(b, c0, out, 8) == 3);
+    assert(bcast_consume_bulk(b, c1, out, 8) == 5);
+    assert(out[4] == next - 1);
+
+    // Too late to subscribe once messages flow
+    assert(bcast_subscribe(b, -1) == -1);
+
+    bcast_destroy(b);
+}
+
+// A pipeline stage only gets what its upstream consumer already took
+static void test_pipeline(void) {
+    Bcast *b = bcast_create(4, 3);
+    assert(b != NULL);
+    int a = bcast_subscribe(b, -1);
+    int s = bcast_subscribe(b, a);
+    int t = bcast_subscribe(b, s);
+    assert(a == 0 && s == 1 && t == 2);
+
+    int v, out[4];
+    for (int i = 0; i < 3; i++) assert(bcast_publish(b, i));
+    assert(!bcast_consume(b, s, &v));
+    assert(!bcast_consume(b, t, &v));
+
+    assert(bcast_consume(b, a, &v) && v == 0);
+    assert(!bcast_consume(b, t, &v));
+    assert(bcast_consume_bulk(b, s, out, 4) == 1 && out[0] == 0);
+    assert(!bcast_consume(b, s, &v));
+    assert(bcast_consume(b, t, &v) && v == 0);
+
+    assert(bcast_consume_bulk(b, a, out, 4) == 2);
+    assert(bcast_consume_bulk(b, s, out, 4) == 2 && out[0] == 1 && out[1] == 2);
+    assert(bcast_consume_bulk(b, t, out, 4) == 2 && out[1] == 2);
+
+    bcast_destroy(b);
+}
+
+static void test_null_args(void) {
+    int v;
+    assert(bcast_create(0, 1) == NULL);
+    assert(bcast_create(4, 0) == NULL);
+    assert(bcast_subscribe(NULL, -1) == -1);
+    assert(!bcast_publish(NULL, 1));
+    assert(!bcast_publish_wait(NULL, 1));
+    assert(!bcast_consume(NULL, 0, &v));
+    assert(bcast_consume_bulk(NULL, 0, &v, 1) == 0);
+    assert(!bcast_consume_wait(NULL, 0, &v));
+    assert(bcast_cursor(NULL, 0) == -1);
+    assert(bcast_consumers(NULL) == 0);
+    assert(bcast_capacity(NULL) == 0);
+    bcast_destroy(NULL);
+
+    Bcast *b = bcast_create(4, 1);
+    assert(b != NULL);
+    // Unknown consumers and upstreams
+    assert(bcast_subscribe(b, 0) == -1);
+    assert(bcast_subscribe(b, -2) == -1);
+    assert(!bcast_consume(b, 0, &v));
+    assert(bcast_subscribe(b, -1) == 0);
+    assert(bcast_subscribe(b, -1) == -1);   // max_consumers reached
+    assert(!bcast_consume(b, 1, &v));
+    assert(!bcast_consume(b, -1, &v));
+    assert(!bcast_consume(b, 0, NULL));
+    assert(bcast_consume_bulk(b, 0, &v, 0) == 0);
+    assert(bcast_cursor(b, 1) == -1);
+
+    // Nothing published: the wait gives up
+    assert(!bcast_consume_wait_timeout(b, 0, &v, 0));
+    assert(!bcast_consume_wait_timeout(b, 0, &v, 10));
+    bcast_destroy(b);
+}
+
+// P producers publish 1..items tagged with their id; `fan` consumers
+// subscribe to the producers and a chain of `chain` stages follows
+// consumer 0. Every consumer must see every message exactly once, in
+// per-producer order, and a stage never ahead of its upstream.
+static void test_mp_fanout(int P, int fan, int chain, int items) {
+    int C = fan + chain;
+    Bcast *b = bcast_create(16, C);
+    assert(b != NULL);
+    for (int i = 0; i < fan; i++) assert(bcast_subscribe(b, -1) == i);
+    for (int i = 0; i < chain; i++) {
+        int up = (i == 0) ? 0 : fan + i - 1;
+        assert(bcast_subscribe(b, up) == fan + i);
+    }
+
+    long long total = (long long)P * items;
+    bool ok = true;
+
+    #pragma omp parallel num_threads(P + C) shared(b, ok)
+    {
+        int tid = omp_get_thread_num();
+        if (tid < P) {
+            for (int i = 1; i <= items; i++) assert(bcast_publish_wait(b, tid * items + i));
+        } else {
+            int c = tid - P;
+            int up = (c < fan) ? -1 : (c == fan ? 0 : c - 1);
+            int last[64] = {0};
+            long long sum = 0;
+            int v;
+            for (long long n = 0; n < total; n++) {
+                assert(bcast_consume_wait(b, c, &v));
+                int from = (v - 1) / items, seq = (v - 1) % items + 1;
+                if (seq <= last[from]) ok = false;
+                last[from] = seq;
+                sum += v;
+                // Message n was already taken upstream
+                if (up >= 0 && bcast_cursor(b, up) <= n) ok = false;
+            }
+            if (sum != total * (total + 1) / 2) ok = false;
+        }
+    }
+
+    assert(ok);
+    for (int c = 0; c < C; c++) assert(bcast_cursor(b, c) == total);
+    bcast_destroy(b);
+
+    printf("  [OK] P=%d fan-out=%d chain=%d items=%d\n", P, fan, chain, items);
+}
+
+int main(void) {
+    printf("Running broadcast ring tests...\n");
+
+    test_broadcast_gating();
+    test_pipeline();
+    test_null_args();
+
+    test_mp_fanout(1, 1, 0, 20000);
+    test_mp_fanout(1, 3, 0, 20000);
+    test_mp_fanout(3, 2, 0, 5000);
+    test_mp_fanout(1, 2, 2, 10000);
+    test_mp_fanout(2, 1, 3, 5000);
+
+    printf("All broadcast ring tests PASSED.\n");
+    return 0;
+}
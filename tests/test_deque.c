@@ -0,0 +1,145 @@
+// tests/test_deque.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "deque.h"
+
+// Owner end is LIFO, thief end is FIFO
+static void test_lifo_fifo(void) {
+    Deque *d = deque_create(8);
+    assert(d != NULL);
+    assert(deque_size(d) == 0);
+    assert(deque_capacity(d) == 8);
+
+    int v;
+    assert(!deque_pop(d, &v));
+    assert(!deque_steal(d, &v));
+
+    for (int i = 0; i < 5; i++) assert(deque_push(d, i));
+    assert(deque_size(d) == 5);
+
+    assert(deque_pop(d, &v) && v == 4);
+    assert(deque_steal(d, &v) && v == 0);
+    assert(deque_pop(d, &v) && v == 3);
+    assert(deque_steal(d, &v) && v == 1);
+    // Last value: taken by pop through the CAS path
+    assert(deque_pop(d, &v) && v == 2);
+    assert(!deque_pop(d, &v));
+    assert(!deque_steal(d, &v));
+    assert(deque_size(d) == 0);
+
+    deque_destroy(d);
+}
+
+// Growth keeps every value and the order of both ends
+static void test_growth(void) {
+    Deque *d = deque_create(3);   // rounded up to 4
+    assert(d != NULL);
+    assert(deque_capacity(d) == 4);
+
+    int n = 1000;
+    int v;
+    // Move top forward first so the live range wraps in the old array
+    for (int i = 0; i < 3; i++) assert(deque_push(d, -1));
+    for (int i = 0; i < 3; i++) assert(deque_steal(d, &v) && v == -1);
+
+    for (int i = 0; i < n; i++) assert(deque_push(d, i));
+    assert(deque_size(d) == n);
+    assert(deque_capacity(d) >= n);
+
+    for (int i = 0; i < n / 2; i++) assert(deque_steal(d, &v) && v == i);
+    for (int i = n - 1; i >= n / 2; i--) assert(deque_pop(d, &v) && v == i);
+    assert(!deque_pop(d, &v));
+
+    deque_destroy(d);
+}
+
+static void test_null_args(void) {
+    int v;
+    assert(deque_create(0) == NULL);
+    assert(deque_create(-1) == NULL);
+    assert(!deque_push(NULL, 1));
+    assert(!deque_pop(NULL, &v));
+    assert(!deque_steal(NULL, &v));
+    assert(deque_size(NULL) == 0);
+    assert(deque_capacity(NULL) == 0);
+    deque_destroy(NULL);
+
+    Deque *d = deque_create(4);
+    assert(d != NULL);
+    assert(deque_push(d, 1));
+    assert(!deque_pop(d, NULL));
+    assert(!deque_steal(d, NULL));
+    deque_destroy(d);
+}
+
+// One owner pushing (growing from a tiny array) and popping while thieves
+// steal: every value must be taken exactly once
+static void test_owner_vs_thieves(int thieves, int n) {
+    Deque *d = deque_create(2);
+    assert(d != NULL);
+
+    int *taken = calloc((size_t)n, sizeof(int));
+    assert(taken != NULL);
+    int done = 0;
+
+    #pragma omp parallel num_threads(thieves + 1) shared(d, taken, done)
+    {
+        int v;
+        if (omp_get_thread_num() == 0) {
+            for (int i = 0; i < n; i++) {
+                assert(deque_push(d, i));
+                // Pop back every third value, like a task running a child inline
+                if (i % 3 == 0 && deque_pop(d, &v)) {
+                    #pragma omp atomic
+                    taken[v]++;
+                }
+            }
+            while (deque_pop(d, &v)) {
+                #pragma omp atomic
+                taken[v]++;
+            }
+            #pragma omp atomic write
+            done = 1;
+        } else {
+            while (1) {
+                if (deque_steal(d, &v)) {
+                    #pragma omp atomic
+                    taken[v]++;
+                    continue;
+                }
+                int stop;
+                #pragma omp atomic read
+                stop = done;
+                if (stop && deque_size(d) == 0) break;
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) assert(taken[i] == 1);
+    assert(deque_size(d) == 0);
+
+    free(taken);
+    deque_destroy(d);
+
+    printf("  [OK] owner vs %d thieves n=%d\n", thieves, n);
+}
+
+int main(void) {
+    printf("Running deque tests...\n");
+
+    test_lifo_fifo();
+    test_growth();
+    test_null_args();
+
+    int thieves[] = {1, 2, 4};
+    for (int i = 0; i < (int)(sizeof(thieves)/sizeof(thieves[0])); ++i) {
+        test_owner_vs_thieves(thieves[i], 20000);
+    }
+
+    printf("All deque tests PASSED.\n");
+    return 0;
+}
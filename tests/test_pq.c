@@ -0,0 +1,160 @@
+// tests/test_pq.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "pq.h"
+
+// Strict queue: pops come out sorted by key, values travel with keys
+static void test_strict_order(void) {
+    int n = 1000;
+    PQueue *q = pq_create(n);
+    assert(q != NULL);
+    assert(pq_capacity(q) == n);
+    assert(pq_size(q) == 0);
+
+    // Keys in a scrambled order, with duplicates
+    for (int i = 0; i < n; i++) {
+        int64_t key = (int64_t)((i * 7919) % 500);
+        assert(pq_push(q, key, (int)key * 2));
+    }
+    assert(pq_size(q) == n);
+    assert(!pq_push(q, 0, 0));   // full
+
+    int64_t key, prev = INT64_MIN;
+    int value;
+    for (int i = 0; i < n; i++) {
+        assert(pq_pop_min(q, &key, &value));
+        assert(key >= prev);
+        assert(value == (int)key * 2);
+        prev = key;
+    }
+    assert(!pq_pop_min(q, &key, &value));
+    assert(pq_size(q) == 0);
+
+    // key may be NULL
+    assert(pq_push(q, -5, 42));
+    assert(pq_pop_min(q, NULL, &value) && value == 42);
+
+    pq_destroy(q);
+}
+
+static void test_null_args(void) {
+    int64_t key;
+    int value;
+    assert(pq_create(0) == NULL);
+    assert(pq_create_relaxed(-1, 4) == NULL);
+    assert(!pq_push(NULL, 1, 1));
+    assert(!pq_pop_min(NULL, &key, &value));
+    assert(pq_size(NULL) == 0);
+    assert(pq_capacity(NULL) == 0);
+    pq_destroy(NULL);
+
+    PQueue *q = pq_create(4);
+    assert(q != NULL);
+    assert(pq_push(q, 1, 1));
+    assert(!pq_pop_min(q, &key, NULL));
+    pq_destroy(q);
+}
+
+// Relaxed queue: capacity is shared by the heaps, every pair comes out
+// exactly once, and the smallest key is never far behind
+static void test_relaxed_single(void) {
+    int n = 1000;
+    PQueue *q = pq_create_relaxed(n, 8);
+    assert(q != NULL);
+    assert(pq_capacity(q) == n);
+
+    for (int i = 0; i < n; i++) assert(pq_push(q, (int64_t)(n - 1 - i), n - 1 - i));
+    assert(pq_size(q) == n);
+    assert(!pq_push(q, 0, 0));   // every heap is full
+
+    int *seen = calloc((size_t)n, sizeof(int));
+    assert(seen != NULL);
+    int64_t key;
+    int value;
+    for (int i = 0; i < n; i++) {
+        assert(pq_pop_min(q, &key, &value));
+        assert(key == value);
+        seen[value]++;
+    }
+    for (int i = 0; i < n; i++) assert(seen[i] == 1);
+    assert(!pq_pop_min(q, &key, &value));
+    assert(pq_size(q) == 0);
+
+    free(seen);
+    pq_destroy(q);
+}
+
+// Pushers and poppers at once: nothing lost or duplicated
+static void test_mp_mc(bool relaxed, int cap, int P, int C, int items_per_prod) {
+    PQueue *q = relaxed ? pq_create_relaxed(cap, 0) : pq_create(cap);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            for (int i = 0; i < items_per_prod; i++) {
+                int v = base + i;
+                // Keys do not follow insertion order
+                while (!pq_push(q, (int64_t)((v * 7919) % 1000), v)) { /* busy-wait */ }
+                #pragma omp atomic
+                sum_enq += v;
+            }
+        } else {
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                int64_t key;
+                int v;
+                if (pq_pop_min(q, &key, &v)) {
+                    assert(key == (int64_t)((v * 7919) % 1000));
+                    #pragma omp atomic
+                    sum_deq += v;
+                    #pragma omp atomic
+                    consumed_total += 1;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(pq_size(q) == 0);
+    assert(sum_enq == sum_deq);
+
+    pq_destroy(q);
+
+    printf("  [OK] %s cap=%d P=%d C=%d items=%d\n",
+           relaxed ? "relaxed" : "strict", cap, P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running priority queue tests...\n");
+
+    test_strict_order();
+    test_null_args();
+    test_relaxed_single();
+
+    int pcs[] = {1, 2, 4};
+    for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+        test_mp_mc(false, 16, pcs[i], pcs[i], 2000);
+        test_mp_mc(true, 64, pcs[i], pcs[i], 2000);
+    }
+
+    printf("All priority queue tests PASSED.\n");
+    return 0;
+}
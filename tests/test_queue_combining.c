@@ -0,0 +1,131 @@
+// tests/test_queue_combining.c
+// Built with a small FC_SLOTS (see Makefile), so the larger runs have more
+// threads than publication slots.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+// Producer p enqueues (p << 20) | i for i = 0, 1, ...
+#define TAG(p, i) (((p) << 20) | (i))
+
+// P producers, C consumers: every value comes out exactly once, and each
+// consumer sees every producer's values in increasing order (FIFO holds
+// for combined and eliminated operations alike)
+static void test_per_producer_fifo(int cap, int P, int C, int items_per_prod) {
+    Queue *q = create(cap);
+    assert(q != NULL);
+    int total_items = P * items_per_prod;
+    int consumed = 0;
+    long long sum_enq = 0, sum_deq = 0;
+    bool in_order = true;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed) \
+        reduction(+:sum_enq, sum_deq) reduction(&&:in_order)
+    {
+        int tid = omp_get_thread_num();
+        if (tid < P) {
+            for (int i = 0; i < items_per_prod; i++) {
+                while (!enqueue(q, TAG(tid, i))) { /* busy-wait */ }
+                sum_enq += TAG(tid, i);
+            }
+        } else {
+            int *last = (int *)malloc(sizeof(int) * (size_t)P);
+            for (int p = 0; p < P; p++) last[p] = -1;
+            int v;
+            for (;;) {
+                int done;
+                #pragma omp atomic read
+                done = consumed;
+                if (done >= total_items) break;
+                if (!dequeue(q, &v)) continue;
+                #pragma omp atomic
+                consumed++;
+                sum_deq += v;
+                int p = v >> 20, i = v & ((1 << 20) - 1);
+                if (p < 0 || p >= P || i <= last[p]) in_order = false;
+                else last[p] = i;
+            }
+            free(last);
+        }
+    }
+
+    assert(consumed == total_items);
+    assert(sum_enq == sum_deq);
+    assert(in_order);
+    assert(is_empty(q));
+    destroy(q);
+
+    printf("  [OK] per-producer FIFO cap=%d P=%d C=%d items=%d\n",
+           cap, P, C, items_per_prod);
+}
+
+// Combined single-element calls interleaved with bulk calls, which take
+// the combiner lock directly: nothing is lost or duplicated
+static void test_mixed_bulk(int P, int C, int items_per_prod) {
+    Queue *q = create(32);
+    assert(q != NULL);
+    int total_items = P * items_per_prod;
+    int consumed = 0;
+    long long sum_enq = 0, sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed) reduction(+:sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+        if (tid < P) {
+            int i = 0;
+            while (i < items_per_prod) {
+                // Even producers batch, odd producers go one at a time
+                if (tid % 2 == 0) {
+                    int batch[8], n = 0;
+                    while (n < 8 && i + n < items_per_prod) { batch[n] = i + n; n++; }
+                    int k = enqueue_bulk(q, batch, n);
+                    for (int j = 0; j < k; j++) sum_enq += batch[j];
+                    i += k;
+                } else if (enqueue(q, i)) {
+                    sum_enq += i;
+                    i++;
+                }
+            }
+        } else {
+            int out[8];
+            for (;;) {
+                int done;
+                #pragma omp atomic read
+                done = consumed;
+                if (done >= total_items) break;
+                int k = (tid % 2 == 0) ? dequeue_bulk(q, out, 8) : dequeue(q, out);
+                if (k == 0) continue;
+                #pragma omp atomic
+                consumed += k;
+                for (int j = 0; j < k; j++) sum_deq += out[j];
+            }
+        }
+    }
+
+    assert(consumed == total_items);
+    assert(sum_enq == sum_deq);
+    assert(is_empty(q));
+    destroy(q);
+
+    printf("  [OK] mixed single/bulk P=%d C=%d items=%d\n", P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running combining queue tests...\n");
+
+    test_per_producer_fifo(64, 2, 2, 5000);
+    // More threads than publication slots
+    test_per_producer_fifo(64, 4, 4, 2000);
+    // Capacity 1: most values pass by elimination or a nearly empty ring
+    test_per_producer_fifo(1, 4, 4, 2000);
+
+    test_mixed_bulk(2, 2, 5000);
+    test_mixed_bulk(4, 4, 2000);
+
+    printf("All combining queue tests PASSED.\n");
+    return 0;
+}
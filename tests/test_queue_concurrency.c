@@ -9,8 +9,9 @@
 
 // A simple multi-producer / multi-consumer test.
 // Not a formal proof of correctness, but it will catch a lot of bugs.
-static void test_mp_mc(int cap, int P, int C, int items_per_prod) {
-    Queue *q = create(cap);
+// `make` is create or create_pow2.
+static void test_mp_mc(Queue *(*make)(int), int cap, int P, int C, int items_per_prod) {
+    Queue *q = make(cap);
     assert(q != NULL);
 
     int total_items = P * items_per_prod;
@@ -63,15 +64,198 @@ static void test_mp_mc(int cap, int P, int C, int items_per_prod) {
 
     destroy(q);
 
-    printf("  [OK] cap=%d P=%d C=%d items=%d\n",
+    printf("  [OK] %scap=%d P=%d C=%d items=%d\n",
+           make == create_pow2 ? "pow2 " : "", cap, P, C, items_per_prod);
+}
+
+// Same as test_mp_mc, but producers/consumers move values in batches.
+static void test_mp_mc_bulk(int cap, int P, int C, int items_per_prod, int batch) {
+    Queue *q = create(cap);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+        int *buf = (int *)malloc(sizeof(int) * (size_t)batch);
+        assert(buf != NULL);
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            for (int i = 0; i < items_per_prod; i += batch) {
+                int n = (items_per_prod - i < batch) ? items_per_prod - i : batch;
+                for (int j = 0; j < n; j++) buf[j] = base + i + j;
+
+                // Spin until the whole batch is in (it may go in pieces)
+                int done = 0;
+                while (done < n) {
+                    done += enqueue_bulk(q, buf + done, n - done);
+                }
+
+                long long s = 0;
+                for (int j = 0; j < n; j++) s += buf[j];
+                #pragma omp atomic
+                sum_enq += s;
+            }
+        } else {
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                int k = dequeue_bulk(q, buf, batch);
+                if (k > 0) {
+                    long long s = 0;
+                    for (int j = 0; j < k; j++) s += buf[j];
+
+                    #pragma omp atomic
+                    consumed_total += k;
+
+                    #pragma omp atomic
+                    sum_deq += s;
+                }
+            }
+        }
+        free(buf);
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] bulk cap=%d P=%d C=%d items=%d batch=%d\n",
+           cap, P, C, items_per_prod, batch);
+}
+
+// Producers and consumers use the blocking calls instead of spinning.
+// Each consumer first claims one of the remaining items, so exactly
+// total_items dequeue_wait calls are made and none blocks forever.
+static void test_mp_mc_wait(int cap, int P, int C, int items_per_prod) {
+    Queue *q = create(cap);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int claimed = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, claimed, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            for (int i = 0; i < items_per_prod; i++) {
+                int val = base + i;
+                bool ok = enqueue_wait(q, val);
+                assert(ok);
+
+                #pragma omp atomic
+                sum_enq += val;
+            }
+        } else {
+            int v;
+            while (1) {
+                int c;
+                #pragma omp atomic capture
+                c = claimed++;
+                if (c >= total_items) break;
+
+                bool ok = dequeue_wait(q, &v);
+                assert(ok);
+
+                #pragma omp atomic
+                sum_deq += v;
+            }
+        }
+    }
+
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] wait cap=%d P=%d C=%d items=%d\n",
            cap, P, C, items_per_prod);
 }
 
+// 64-byte payload: every word is derived from the value so a torn or
+// mixed-up copy is detected on the consumer side.
+typedef struct { long long w[8]; } Payload;
+
+static void test_mp_mc_sized(int cap, int P, int C, int items_per_prod) {
+    Queue *q = create_sized(cap, sizeof(Payload));
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            Payload p;
+            int base = tid * items_per_prod;
+            for (int i = 0; i < items_per_prod; i++) {
+                long long val = base + i;
+                for (int w = 0; w < 8; w++) p.w[w] = val * 8 + w;
+                while (!enqueue_elem(q, &p)) { /* busy-wait */ }
+
+                #pragma omp atomic
+                sum_enq += val;
+            }
+        } else {
+            Payload p;
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                if (dequeue_elem(q, &p)) {
+                    long long val = p.w[0] / 8;
+                    for (int w = 0; w < 8; w++) assert(p.w[w] == val * 8 + w);
+
+                    #pragma omp atomic
+                    consumed_total++;
+
+                    #pragma omp atomic
+                    sum_deq += val;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] sized(%zu) cap=%d P=%d C=%d items=%d\n",
+           sizeof(Payload), cap, P, C, items_per_prod);
+}
+
 int main(void) {
     printf("Running concurrency tests...\n");
 
     int caps[] = {8, 64, 256};
+#ifdef SPSC_ONLY
+    // Single-producer/single-consumer implementation: only P = C = 1 is valid
+    int pcs[]  = {1};
+#else
     int pcs[]  = {1, 2, 4, 8};
+#endif
     int items  = 1000;
 
     for (int ci = 0; ci < (int)(sizeof(caps)/sizeof(caps[0])); ++ci) {
@@ -79,10 +263,34 @@ int main(void) {
             int cap = caps[ci];
             int P = pcs[i];
             int C = pcs[i];   // same number of consumers
-            test_mp_mc(cap, P, C, items);
+            test_mp_mc(create, cap, P, C, items);
+        }
+    }
+
+    // Capacities that are not powers of two, rounded up internally
+    int odd_caps[] = {5, 100};
+    for (int ci = 0; ci < (int)(sizeof(odd_caps)/sizeof(odd_caps[0])); ++ci) {
+        for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+            test_mp_mc(create_pow2, odd_caps[ci], pcs[i], pcs[i], items);
         }
     }
 
+    int batches[] = {8, 64};
+    for (int bi = 0; bi < (int)(sizeof(batches)/sizeof(batches[0])); ++bi) {
+        for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+            test_mp_mc_bulk(64, pcs[i], pcs[i], items, batches[bi]);
+        }
+    }
+
+    for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+        test_mp_mc_sized(16, pcs[i], pcs[i], items);
+    }
+
+    // Small capacity so both sides park often
+    for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+        test_mp_mc_wait(4, pcs[i], pcs[i], items);
+    }
+
     printf("All concurrency tests PASSED.\n");
     return 0;
 }
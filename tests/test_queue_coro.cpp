@@ -0,0 +1,140 @@
+// tests/test_queue_coro.cpp
+// AsyncQueue (src/queue_coro.hpp): co_await push/pop over the MODE's
+// queue, resumed on a single-threaded LoopExecutor.
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "queue_coro.hpp"
+
+using queue_coro::AsyncQueue;
+using queue_coro::Detached;
+using queue_coro::LoopExecutor;
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+struct Pair {
+    int id;
+    double x;
+};
+
+static Detached produce(AsyncQueue<int> &q, int n) {
+    for (int i = 0; i < n; i++) co_await q.push(i);
+}
+
+static Detached consume(AsyncQueue<int> &q, int n, int &next) {
+    for (int i = 0; i < n; i++) {
+        int v = co_await q.pop();
+        assert(v == next);
+        next++;
+    }
+}
+
+// One producer and one consumer coroutine through a 2-slot queue: both
+// suspend over and over, in FIFO order
+static void test_ping_pong() {
+    LoopExecutor ex;
+    AsyncQueue<int> q(2, ex);
+    assert(q.capacity() == 2);
+    int next = 0;
+    consume(q, 1000, next);   // suspends at once: empty
+    produce(q, 1000);         // fills, resumes the consumer, suspends when full
+    ex.run();
+    assert(next == 1000);
+    assert(q.size() == 0);
+}
+
+static Detached pop_one(AsyncQueue<int> &q, std::vector<int> &got, int i) {
+    got[i] = co_await q.pop();
+}
+
+// Many suspended poppers: the oldest waiter gets the oldest value
+static void test_many_poppers(int n) {
+    LoopExecutor ex;
+    AsyncQueue<int> q(16, ex);
+    std::vector<int> got(n, -1);
+    for (int i = 0; i < n; i++) pop_one(q, got, i);
+
+    for (int i = 0; i < n; i++) {
+        while (!q.try_push(i)) ex.run();
+    }
+    ex.run();
+    for (int i = 0; i < n; i++) assert(got[i] == i);
+    int v;
+    assert(!q.try_pop(v));
+    std::printf("  [OK] %d suspended poppers\n", n);
+}
+
+static Detached push_one(AsyncQueue<Pair> &q, int i, int &done) {
+    co_await q.push(Pair{i, i * 0.5});
+    done++;
+}
+
+// Many suspended pushers on a full queue of structs: values go in in the
+// order the pushers waited
+static void test_many_pushers(int n) {
+    LoopExecutor ex;
+    AsyncQueue<Pair> q(4, ex);
+    int done = 0;
+    for (int i = 0; i < n; i++) push_one(q, i, done);
+    assert(done == 4 && q.size() == 4);
+
+    Pair p;
+    for (int i = 0; i < n; i++) {
+        assert(q.try_pop(p));
+        assert(p.id == i && p.x == i * 0.5);
+        ex.run();
+    }
+    assert(done == n);
+    assert(!q.try_pop(p));
+    std::printf("  [OK] %d suspended pushers\n", n);
+}
+
+static Detached sum_all(AsyncQueue<int> &q, int n, long long &sum, std::atomic<int> &left) {
+    for (int i = 0; i < n; i++) sum += co_await q.pop();
+    left--;
+}
+
+// Values pushed from another thread: the waiters are posted from there
+// and resumed on the loop thread
+static void test_cross_thread(int consumers, int per) {
+    LoopExecutor ex;
+    AsyncQueue<int> q(8, ex);
+    std::vector<long long> sums(consumers, 0);
+    std::atomic<int> left(consumers);
+    for (int c = 0; c < consumers; c++) sum_all(q, per, sums[c], left);
+
+    int total = consumers * per;
+    std::thread producer([&] {
+        for (int i = 1; i <= total; i++) {
+            while (!q.try_push(i)) std::this_thread::yield();
+        }
+    });
+    while (left.load() > 0) {
+        if (!ex.run_one()) std::this_thread::yield();
+    }
+    producer.join();
+
+    long long sum = 0;
+    for (long long s : sums) sum += s;
+    assert(sum == (long long)total * (total + 1) / 2);
+    std::printf("  [OK] cross-thread producer, %d consumers x %d\n", consumers, per);
+}
+
+int main() {
+    std::printf("Running coroutine queue tests...\n");
+
+    test_ping_pong();
+    test_many_poppers(1000);
+    test_many_pushers(100);
+    // The sequential queue is not thread-safe
+    if (std::strncmp(IMPL_NAME, "seq", 3) != 0) test_cross_thread(50, 200);
+
+    std::printf("All coroutine queue tests PASSED.\n");
+    return 0;
+}
@@ -0,0 +1,246 @@
+// tests/test_queue_hier.c
+// Built with -DHIER_BY_CPU=0 (threads take home sub-queues round-robin in
+// order of their first call, whatever the machine's NUMA layout) and a
+// small -DHIER_BATCH.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+// A consumer whose sub-queue is empty takes one value from the other node
+// and moves the next HIER_BATCH - 1 into its own sub-queue in one go.
+// Must run first: thread 0 gets home 0, thread 1 home 1.
+static void test_batch_transfer(void) {
+    int n = 3 * HIER_BATCH;
+    Queue *q = create_hier(2 * n, 2);
+    assert(q != NULL);
+    assert(hier_nodes(q) == 2);
+
+    #pragma omp parallel num_threads(2) shared(q)
+    {
+        int tid = omp_get_thread_num();
+        int v;
+
+        // Thread 0 first, so it takes home 0
+        if (tid == 0) {
+            for (int i = 0; i < n; i++) assert(enqueue(q, i));
+        }
+        #pragma omp barrier
+
+        // Home 1 is empty: the refill returns value 0 and moves 1..B-1
+        if (tid == 1) {
+            assert(dequeue(q, &v) && v == 0);
+            assert(size(q) == n - 1);
+        }
+        #pragma omp barrier
+
+        // Home 0 lost the whole batch, not just one value
+        if (tid == 0) {
+            assert(dequeue(q, &v) && v == HIER_BATCH);
+        }
+        #pragma omp barrier
+
+        // Home 1 serves the rest of the batch locally, in order, and then
+        // refills again from home 0
+        if (tid == 1) {
+            for (int i = 1; i < HIER_BATCH; i++) assert(dequeue(q, &v) && v == i);
+            assert(dequeue(q, &v) && v == HIER_BATCH + 1);
+        }
+        #pragma omp barrier
+
+        // Drain everything from thread 0: its own values, then the batch
+        // that moved to home 1
+        if (tid == 0) {
+            int got = 0;
+            long long sum = 0;
+            while (dequeue(q, &v)) {
+                sum += v;
+                got++;
+            }
+            assert(got == n - HIER_BATCH - 2);
+            long long expect = 0;
+            for (int i = HIER_BATCH + 2; i < n; i++) expect += i;
+            assert(sum == expect);
+            assert(is_empty(q));
+        }
+    }
+
+    destroy(q);
+    printf("  [OK] batch transfer batch=%d\n", HIER_BATCH);
+}
+
+// Same transfer with both rings about to wrap, so each batch is copied in
+// pieces. Runs after test_batch_transfer, with the same homes.
+static void test_batch_transfer_wrapped(void) {
+    int n = 3 * HIER_BATCH;
+    Queue *q = create_hier(2 * n, 2);
+    assert(q != NULL);
+
+    #pragma omp parallel num_threads(2) shared(q)
+    {
+        int tid = omp_get_thread_num();
+        int v;
+
+        // Move each home's head and tail close to the end of its ring:
+        // home 0 wraps 3 values into a batch, home 1 5 values in
+        for (int i = 0; i < n - 3 - 2 * tid; i++) {
+            assert(enqueue(q, -1));
+            assert(dequeue(q, &v) && v == -1);
+        }
+        #pragma omp barrier
+
+        if (tid == 0) {
+            for (int i = 0; i < n; i++) assert(enqueue(q, i));
+        }
+        #pragma omp barrier
+
+        // Every value comes through home 1's refills, still in order
+        if (tid == 1) {
+            for (int i = 0; i < n; i++) assert(dequeue(q, &v) && v == i);
+            assert(!dequeue(q, &v));
+        }
+    }
+
+    destroy(q);
+    printf("  [OK] wrapped batch transfer batch=%d\n", HIER_BATCH);
+}
+
+// Node count clamping, capacity split, spilling into the other nodes
+static void test_nodes_and_capacity(void) {
+    Queue *q = create_hier(3, 8);
+    assert(q != NULL);
+    assert(hier_nodes(q) == 3);   // never more sub-queues than elements
+    assert(queue_node(q) == -1);  // spread over nodes, not on one
+    destroy(q);
+
+    assert(create_hier(0, 2) == NULL);
+    assert(hier_nodes(NULL) == 0);
+
+    // One thread fills its home sub-queue, then spills into the others
+    // until the whole capacity is used, then drains them all
+    q = create_hier(10, 4);
+    assert(q != NULL);
+    assert(capacity(q) == 10);
+    long long sum = 0;
+    for (int i = 0; i < 10; i++) {
+        assert(enqueue(q, i));
+        sum += i;
+    }
+    assert(is_full(q));
+    assert(!enqueue(q, 99));
+
+    int v;
+    for (int i = 0; i < 10; i++) {
+        assert(dequeue(q, &v));
+        sum -= v;
+    }
+    assert(sum == 0);
+    assert(!dequeue(q, &v));
+    assert(is_empty(q));
+
+    // Zero-copy calls find the sub-queue from the slot pointer
+    int count, total = 0, next = 0;
+    int *slot;
+    while ((slot = (int *)enqueue_reserve(q, 10, &count)) != NULL) {
+        for (int i = 0; i < count; i++) slot[i] = next++;
+        enqueue_commit(q, slot, count);
+        total += count;
+    }
+    assert(total == 10);
+    total = 0;
+    while ((slot = (int *)dequeue_peek(q, 10, &count)) != NULL) {
+        for (int i = 0; i < count; i++) sum += slot[i];
+        dequeue_release(q, slot, count);
+        total += count;
+    }
+    assert(total == 10);
+    assert(sum == 45);
+    assert(is_empty(q));
+    destroy(q);
+}
+
+// Small sub-queues force spills and batch refills in both directions;
+// nothing may be lost or duplicated
+static void test_mp_mc(int cap, int nodes, int P, int C, int items_per_prod) {
+    Queue *q = create_hier(cap, nodes);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            int buf[8];
+            for (int i = 0; i < items_per_prod; ) {
+                // Mix single and bulk enqueues
+                if (i % 2 == 0) {
+                    while (!enqueue(q, base + i)) { /* busy-wait */ }
+                    #pragma omp atomic
+                    sum_enq += base + i;
+                    i++;
+                } else {
+                    int n = (items_per_prod - i < 8) ? items_per_prod - i : 8;
+                    for (int j = 0; j < n; j++) buf[j] = base + i + j;
+                    int done = 0;
+                    while (done < n) done += enqueue_bulk(q, buf + done, n - done);
+                    for (int j = 0; j < n; j++) {
+                        #pragma omp atomic
+                        sum_enq += buf[j];
+                    }
+                    i += n;
+                }
+            }
+        } else {
+            int buf[8];
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                int k = (tid & 1) ? dequeue_bulk(q, buf, 8) : dequeue(q, buf);
+                for (int j = 0; j < k; j++) {
+                    #pragma omp atomic
+                    sum_deq += buf[j];
+                }
+                if (k > 0) {
+                    #pragma omp atomic
+                    consumed_total += k;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] mp/mc cap=%d nodes=%d P=%d C=%d items=%d\n",
+           cap, nodes, P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running hierarchical queue tests...\n");
+
+    test_batch_transfer();
+    test_batch_transfer_wrapped();
+    test_nodes_and_capacity();
+
+    test_mp_mc(64, 2, 1, 2, 4000);
+    test_mp_mc(16, 4, 4, 4, 2000);
+    test_mp_mc(4 * HIER_BATCH, 2, 2, 2, 2000);
+
+    printf("All hierarchical queue tests PASSED.\n");
+    return 0;
+}
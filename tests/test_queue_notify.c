@@ -0,0 +1,203 @@
+// tests/test_queue_notify.c
+#define _GNU_SOURCE   // for usleep
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+#include <omp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "queue.h"
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// True if fd is readable right now
+static bool fd_readable(int fd) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+// Readable once per empty -> non-empty edge, however many values arrive
+static void test_edge_coalesced(void) {
+    Queue *q = create(64);
+    assert(q != NULL);
+    int fd = queue_get_fd(q);
+    assert(fd >= 0);
+    assert(queue_get_fd(q) == fd);   // same fd every call
+    assert(!fd_readable(fd));
+
+    for (int i = 0; i < 10; i++) assert(enqueue(q, i));
+    assert(fd_readable(fd));
+    // A single write for all ten values
+    uint64_t count;
+    assert(read(fd, &count, sizeof(count)) == (ssize_t)sizeof(count));
+    assert(count == 1);
+
+    int v;
+    for (int i = 0; i < 10; i++) assert(dequeue_or_arm(q, &v) && v == i);
+    assert(!dequeue_or_arm(q, &v));   // empty: re-armed
+    assert(!fd_readable(fd));
+
+    assert(enqueue(q, 7));
+    assert(fd_readable(fd));
+    assert(dequeue_or_arm(q, &v) && v == 7);
+    assert(!dequeue_or_arm(q, &v));
+    assert(!fd_readable(fd));   // cleared by the failed call
+
+    destroy(q);
+
+    // Created on a non-empty queue: readable at once
+    q = create(4);
+    assert(q != NULL);
+    assert(enqueue(q, 1));
+    fd = queue_get_fd(q);
+    assert(fd >= 0 && fd_readable(fd));
+    destroy(q);
+}
+
+// Space fd: readable when a full queue gets room again
+static void test_space_fd(void) {
+    Queue *q = create(4);
+    assert(q != NULL);
+    for (int i = 0; i < 4; i++) assert(enqueue(q, i));
+
+    int sfd = queue_get_space_fd(q);
+    assert(sfd >= 0);
+    assert(!fd_readable(sfd));
+    assert(!enqueue_or_arm(q, 4));
+
+    int v;
+    assert(dequeue(q, &v) && v == 0);
+    assert(fd_readable(sfd));
+    assert(enqueue_or_arm(q, 4));
+
+    destroy(q);
+}
+
+static void test_null_args(void) {
+    int v;
+    assert(queue_get_fd(NULL) == -1);
+    assert(queue_get_space_fd(NULL) == -1);
+    assert(!dequeue_or_arm(NULL, &v));
+    assert(!enqueue_or_arm(NULL, 1));
+
+    // Without an fd the calls are plain try-once enqueue/dequeue
+    Queue *q = create(1);
+    assert(q != NULL);
+    assert(!dequeue_or_arm(q, NULL));
+    assert(!dequeue_or_arm(q, &v));
+    assert(enqueue_or_arm(q, 5));
+    assert(!enqueue_or_arm(q, 6));
+    assert(dequeue_or_arm(q, &v) && v == 5);
+    destroy(q);
+}
+
+// A consumer event loop waiting on a socket and the queue with one epoll
+// set, while a producer thread feeds both with pauses in between
+static void test_epoll_socketpair(int items) {
+    Queue *q = create(16);
+    assert(q != NULL);
+    int qfd = queue_get_fd(q);
+    assert(qfd >= 0);
+
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+    int ep = epoll_create1(0);
+    assert(ep >= 0);
+    struct epoll_event ev = { .events = EPOLLIN };
+    ev.data.fd = sv[0];
+    assert(epoll_ctl(ep, EPOLL_CTL_ADD, sv[0], &ev) == 0);
+    ev.data.fd = qfd;
+    assert(epoll_ctl(ep, EPOLL_CTL_ADD, qfd, &ev) == 0);
+
+    int got_bytes = 0, got_items = 0, next = 0;
+
+    #pragma omp parallel num_threads(2) shared(q, sv)
+    {
+        if (omp_get_thread_num() == 0) {
+            for (int i = 0; i < items; i++) {
+                while (!enqueue(q, i)) { /* busy-wait */ }
+                if (i % 4 == 0) {
+                    char c = 'x';
+                    assert(write(sv[1], &c, 1) == 1);
+                }
+                // Let the consumer go back to epoll now and then
+                if (i % 16 == 0) usleep(200);
+            }
+        } else {
+            int want_bytes = (items + 3) / 4;
+            while (got_items < items || got_bytes < want_bytes) {
+                struct epoll_event evs[2];
+                int n = epoll_wait(ep, evs, 2, 5000);
+                assert(n > 0);   // no lost wake-ups
+                for (int e = 0; e < n; e++) {
+                    if (evs[e].data.fd == qfd) {
+                        int v;
+                        while (dequeue_or_arm(q, &v)) {
+                            assert(v == next++);   // one producer: FIFO
+                            got_items++;
+                        }
+                    } else {
+                        char buf[64];
+                        ssize_t r = read(sv[0], buf, sizeof(buf));
+                        assert(r > 0);
+                        got_bytes += (int)r;
+                    }
+                }
+            }
+        }
+    }
+
+    assert(got_items == items);
+    assert(is_empty(q));
+
+    close(ep);
+    close(sv[0]);
+    close(sv[1]);
+    destroy(q);
+
+    printf("  [OK] epoll socketpair + queue items=%d\n", items);
+}
+
+int main(void) {
+    printf("Running notification tests...\n");
+
+    test_null_args();
+
+    // The sequential queue never changes behind the caller's back, and a
+    // shared-memory queue's other side can be another process: no fd
+#ifdef PARK_SHARED
+    bool no_fd = true;
+#else
+    bool no_fd = strncmp(IMPL_NAME, "seq", 3) == 0;
+#endif
+    if (no_fd) {
+        Queue *q = create(4);
+        assert(q != NULL);
+        assert(queue_get_fd(q) == -1);
+        assert(queue_get_space_fd(q) == -1);
+        // Without an fd the *_or_arm calls are plain enqueue/dequeue
+        int v;
+        assert(enqueue_or_arm(q, 7));
+        assert(dequeue_or_arm(q, &v) && v == 7);
+        assert(!dequeue_or_arm(q, &v));
+        destroy(q);
+        printf("All notification tests PASSED.\n");
+        return 0;
+    }
+
+    test_edge_coalesced();
+    test_space_fd();
+    test_epoll_socketpair(2000);
+
+    printf("All notification tests PASSED.\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+// tests/test_queue_segmented.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+// The test is linked with -Wl,--wrap=malloc: the queue's segment
+// allocations fail while malloc_failures > 0
+static int malloc_failures;
+void *__real_malloc(size_t size);
+void *__wrap_malloc(size_t size) {
+    if (malloc_failures > 0) {
+        malloc_failures--;
+        return NULL;
+    }
+    return __real_malloc(size);
+}
+
+// Grows far past one segment, then shrinks back once drained
+static void test_unbounded_growth(void) {
+    Queue *q = create(INT_MAX);
+    assert(q != NULL);
+    assert(live_segments(q) == 1);
+
+    int n = 100000;
+    int v;
+    for (int i = 0; i < n; i++) assert(enqueue(q, i));
+    assert(size(q) == n);
+    assert(!is_full(q));
+    int grown = live_segments(q);
+    assert(grown > 1);
+
+    for (int i = 0; i < n; i++) assert(dequeue(q, &v) && v == i);
+    assert(!dequeue(q, &v));
+    assert(is_empty(q));
+    assert(live_segments(q) < grown);
+    assert(live_segments(q) <= 2);
+
+    // Drained segments are reused: a second burst does not leak
+    for (int i = 0; i < n; i++) assert(enqueue(q, i));
+    assert(live_segments(q) <= grown + 1);
+    for (int i = 0; i < n; i++) assert(dequeue(q, &v) && v == i);
+
+    destroy(q);
+    assert(live_segments(NULL) == 0);
+}
+
+// A bounded queue spanning several small segments: capacity still holds
+static void test_bounded_across_segments(void) {
+    Queue *q = create(3);   // 4-cell segments
+    assert(q != NULL);
+
+    int v;
+    int in[5] = {0, 1, 2, 3, 4};
+    int out[5];
+    for (int round = 0; round < 50; round++) {
+        assert(enqueue_bulk(q, in, 5) == 3);
+        assert(is_full(q));
+        assert(!enqueue(q, 9));
+        assert(dequeue(q, &v) && v == 0);
+        assert(enqueue(q, 3));
+        assert(dequeue_bulk(q, out, 5) == 3);
+        assert(out[0] == 1 && out[1] == 2 && out[2] == 3);
+        assert(is_empty(q));
+        assert(live_segments(q) <= 2);
+    }
+    destroy(q);
+}
+
+// A segment that cannot be allocated fails the enqueue without taking a
+// ticket, so the queue keeps working once memory is back
+static void test_segment_alloc_failure(void) {
+    Queue *q = create(INT_MAX);   // 1024-cell segments
+    assert(q != NULL);
+    int v;
+    for (int i = 0; i < 1024; i++) assert(enqueue(q, i));
+    malloc_failures = 1;
+    assert(!enqueue(q, -1));
+    assert(size(q) == 1024);
+    for (int i = 1024; i < 1034; i++) assert(enqueue(q, i));
+    assert(size(q) == 1034);
+    for (int i = 0; i < 1034; i++) assert(dequeue(q, &v) && v == i);
+    assert(!dequeue(q, &v));
+    destroy(q);
+
+    // A batch stops at the last segment that exists
+    q = create(INT_MAX);
+    assert(q != NULL);
+    int in[8] = {1020, 1021, 1022, 1023, 1024, 1025, 1026, 1027};
+    int out[8];
+    for (int i = 0; i < 1020; i++) assert(enqueue(q, i));
+    malloc_failures = 1;
+    assert(enqueue_bulk(q, in, 8) == 4);
+    assert(size(q) == 1024);
+    // Same for a reservation at the boundary
+    int count;
+    malloc_failures = 1;
+    assert(enqueue_reserve(q, 1, &count) == NULL && count == 0);
+    assert(enqueue_bulk(q, in + 4, 4) == 4);
+    for (int i = 0; i < 1024; i++) assert(dequeue(q, &v) && v == i);
+    assert(dequeue_bulk(q, out, 8) == 4);
+    assert(out[0] == 1024 && out[3] == 1027);
+    assert(is_empty(q));
+    destroy(q);
+}
+
+// Segments are appended, retired and recycled all the time (every 8
+// elements with cap = 8); producers spin while the queue is at capacity
+static void test_mp_mc_churn(int cap, int P, int C, int items_per_prod) {
+    Queue *q = create(cap);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            int buf[16];
+            for (int i = 0; i < items_per_prod; ) {
+                // Mix single and bulk enqueues
+                if (i % 3 == 0) {
+                    while (!enqueue(q, base + i)) { /* busy-wait */ }
+                    #pragma omp atomic
+                    sum_enq += base + i;
+                    i++;
+                } else {
+                    int n = (items_per_prod - i < 16) ? items_per_prod - i : 16;
+                    for (int j = 0; j < n; j++) buf[j] = base + i + j;
+                    int done = 0;
+                    while (done < n) done += enqueue_bulk(q, buf + done, n - done);
+                    for (int j = 0; j < n; j++) {
+                        #pragma omp atomic
+                        sum_enq += buf[j];
+                    }
+                    i += n;
+                }
+            }
+        } else {
+            int buf[16];
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                int k = dequeue_bulk(q, buf, (tid & 1) ? 16 : 1);
+                for (int j = 0; j < k; j++) {
+                    #pragma omp atomic
+                    sum_deq += buf[j];
+                }
+                if (k > 0) {
+                    #pragma omp atomic
+                    consumed_total += k;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+    assert(live_segments(q) <= 2);
+
+    destroy(q);
+
+    printf("  [OK] churn cap=%d P=%d C=%d items=%d\n", cap, P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running segmented queue tests...\n");
+
+    test_unbounded_growth();
+    test_bounded_across_segments();
+    test_segment_alloc_failure();
+
+    int pcs[] = {1, 2, 4};
+    for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+        test_mp_mc_churn(8, pcs[i], pcs[i], 4000);
+        test_mp_mc_churn(INT_MAX, pcs[i], pcs[i], 4000);
+    }
+
+    printf("All segmented queue tests PASSED.\n");
+    return 0;
+}
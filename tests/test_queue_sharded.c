@@ -0,0 +1,203 @@
+// tests/test_queue_sharded.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+// Lane count defaults, clamping, and capacity split across lanes
+static void test_lanes_and_capacity(void) {
+    Queue *q = create_sharded(3, 8);
+    assert(q != NULL);
+    assert(lane_count(q) == 3);   // never more lanes than elements
+    destroy(q);
+
+    q = create_sharded(1024, 0);
+    assert(q != NULL);
+    int expect = omp_get_max_threads() < 1024 ? omp_get_max_threads() : 1024;
+    assert(lane_count(q) == expect);
+    destroy(q);
+
+    assert(create_sharded(0, 4) == NULL);
+    assert(lane_count(NULL) == 0);
+
+    // One thread fills its home lane, then spills into the others until
+    // the whole capacity is used
+    q = create_sharded(10, 4);
+    assert(q != NULL);
+    assert(capacity(q) == 10);
+    long long sum = 0;
+    for (int i = 0; i < 10; i++) {
+        assert(enqueue(q, i));
+        sum += i;
+    }
+    assert(is_full(q));
+    assert(size(q) == 10);
+    assert(!enqueue(q, 99));
+
+    int v;
+    for (int i = 0; i < 10; i++) {
+        assert(dequeue(q, &v));
+        sum -= v;
+    }
+    assert(sum == 0);
+    assert(!dequeue(q, &v));
+    assert(is_empty(q));
+    destroy(q);
+}
+
+// Zero-copy reservations spill into other lanes too; commit/release find
+// the lane from the slot pointer
+static void test_zerocopy_lanes(void) {
+    Queue *q = create_sharded(8, 4);
+    assert(q != NULL);
+
+    int count, total = 0, next = 0;
+    int *slot;
+    while ((slot = (int *)enqueue_reserve(q, 8, &count)) != NULL) {
+        for (int i = 0; i < count; i++) slot[i] = next++;
+        enqueue_commit(q, slot, count);
+        total += count;
+    }
+    assert(total == 8);
+    assert(is_full(q));
+
+    long long sum = 0;
+    total = 0;
+    while ((slot = (int *)dequeue_peek(q, 8, &count)) != NULL) {
+        for (int i = 0; i < count; i++) sum += slot[i];
+        dequeue_release(q, slot, count);
+        total += count;
+    }
+    assert(total == 8);
+    assert(sum == 0 + 1 + 2 + 3 + 4 + 5 + 6 + 7);
+    assert(is_empty(q));
+    destroy(q);
+}
+
+// Per-lane FIFO: every lane has room for all values (producers may share
+// a home lane), so nothing spills, every producer's values stay in one
+// lane and come out in the order they went in
+static void test_per_lane_fifo(int P, int items_per_prod) {
+    Queue *q = create_sharded(P * P * items_per_prod, P);
+    assert(q != NULL);
+
+    int *last = malloc(sizeof(int) * (size_t)P);
+    assert(last != NULL);
+    for (int p = 0; p < P; p++) last[p] = -1;
+    int total_items = P * items_per_prod;
+
+    #pragma omp parallel num_threads(P + 1) shared(q, last)
+    {
+        int tid = omp_get_thread_num();
+        if (tid < P) {
+            for (int i = 0; i < items_per_prod; i++) {
+                assert(enqueue(q, tid * items_per_prod + i));
+            }
+        } else {
+            int v;
+            for (int got = 0; got < total_items; ) {
+                if (!dequeue(q, &v)) continue;
+                int p = v / items_per_prod;
+                assert(v % items_per_prod > last[p]);
+                last[p] = v % items_per_prod;
+                got++;
+            }
+        }
+    }
+
+    for (int p = 0; p < P; p++) assert(last[p] == items_per_prod - 1);
+    assert(is_empty(q));
+    free(last);
+    destroy(q);
+
+    printf("  [OK] per-lane FIFO P=%d items=%d\n", P, items_per_prod);
+}
+
+// Small lanes force spilling and stealing; nothing may be lost or duplicated
+static void test_mp_mc_steal(int cap, int lanes, int P, int C, int items_per_prod) {
+    Queue *q = create_sharded(cap, lanes);
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            int buf[8];
+            for (int i = 0; i < items_per_prod; ) {
+                // Mix single and bulk enqueues
+                if (i % 2 == 0) {
+                    while (!enqueue(q, base + i)) { /* busy-wait */ }
+                    #pragma omp atomic
+                    sum_enq += base + i;
+                    i++;
+                } else {
+                    int n = (items_per_prod - i < 8) ? items_per_prod - i : 8;
+                    for (int j = 0; j < n; j++) buf[j] = base + i + j;
+                    int done = 0;
+                    while (done < n) done += enqueue_bulk(q, buf + done, n - done);
+                    for (int j = 0; j < n; j++) {
+                        #pragma omp atomic
+                        sum_enq += buf[j];
+                    }
+                    i += n;
+                }
+            }
+        } else {
+            int buf[8];
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                int k = dequeue_bulk(q, buf, (tid & 1) ? 8 : 1);
+                for (int j = 0; j < k; j++) {
+                    #pragma omp atomic
+                    sum_deq += buf[j];
+                }
+                if (k > 0) {
+                    #pragma omp atomic
+                    consumed_total += k;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] steal cap=%d lanes=%d P=%d C=%d items=%d\n",
+           cap, lanes, P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running sharded queue tests...\n");
+
+    test_lanes_and_capacity();
+    test_zerocopy_lanes();
+
+    test_per_lane_fifo(2, 2000);
+    test_per_lane_fifo(4, 2000);
+
+    // One producer feeding many consumers: everything past the home
+    // lane is spilled and then stolen
+    test_mp_mc_steal(8, 4, 1, 4, 4000);
+    test_mp_mc_steal(16, 4, 4, 4, 2000);
+    test_mp_mc_steal(16, 8, 4, 2, 2000);
+
+    printf("All sharded queue tests PASSED.\n");
+    return 0;
+}
@@ -0,0 +1,315 @@
+// tests/test_queue_shm.c
+// Shared-memory queue (MODE=shm): every test forks, so producers and
+// consumers are separate processes. Named queues get a per-run name so
+// parallel runs do not meet.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "queue.h"
+
+static char qname[64];
+
+// Run fn(arg) in a child process; returns its pid
+static pid_t spawn(void (*fn)(int), int arg) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        fn(arg);
+        _exit(0);
+    }
+    return pid;
+}
+
+// Wait for pid; true if it exited with status 0
+static bool reap(pid_t pid) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Wait for pid and check it was killed by sig
+static void reap_killed(pid_t pid, int sig) {
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == sig);
+}
+
+// Children report through a small shared array (asserts in a child only
+// show up as its exit status)
+static long long *shared_results(int n) {
+    void *p = mmap(NULL, (size_t)n * sizeof(long long), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    assert(p != MAP_FAILED);
+    return (long long *)p;
+}
+
+static void test_open_attach(void) {
+    int v;
+    queue_unlink_shared(qname);
+    assert(queue_attach_shared(qname) == NULL);
+
+    // First open creates, the next ones attach to the same ring
+    Queue *a = queue_open_shared(qname, 8);
+    assert(a != NULL && capacity(a) == 8 && is_empty(a));
+    Queue *b = queue_open_shared(qname, 8);
+    Queue *c = queue_attach_shared(qname);
+    assert(b != NULL && c != NULL && capacity(c) == 8);
+    assert(enqueue(a, 1) && enqueue(b, 2) && enqueue(c, 3));
+    assert(size(a) == 3 && size(b) == 3);
+    assert(dequeue(c, &v) && v == 1);
+    assert(dequeue(a, &v) && v == 2);
+    assert(dequeue(b, &v) && v == 3);
+
+    // Another capacity is another queue
+    assert(queue_open_shared(qname, 16) == NULL);
+
+    // The queue outlives the handles that made it
+    assert(enqueue(a, 4));
+    destroy(a);
+    destroy(b);
+    assert(dequeue(c, &v) && v == 4);
+
+    // After unlink the open handle still works, the name does not
+    assert(queue_unlink_shared(qname));
+    assert(!queue_unlink_shared(qname));
+    assert(queue_attach_shared(qname) == NULL);
+    assert(enqueue(c, 5) && dequeue(c, &v) && v == 5);
+    destroy(c);
+
+    // Edge cases
+    assert(queue_open_shared(NULL, 8) == NULL);
+    assert(queue_open_shared(qname, 0) == NULL);
+    assert(queue_attach_shared(NULL) == NULL);
+    assert(!queue_unlink_shared(NULL));
+
+    printf("  [OK] open/attach/unlink by name\n");
+}
+
+// Producer child: opens the queue by name itself and enqueues 0..n-1,
+// blocking while it is full
+static void produce_named(int n) {
+    Queue *q = queue_open_shared(qname, 16);
+    if (!q) _exit(1);
+    for (int i = 0; i < n; i++) {
+        if (!enqueue_wait(q, i)) _exit(2);
+    }
+    destroy(q);
+}
+
+static void test_two_processes(int items) {
+    queue_unlink_shared(qname);
+    Queue *q = queue_open_shared(qname, 16);
+    assert(q != NULL);
+
+    // A small ring, so both sides block on each other across processes
+    pid_t pid = spawn(produce_named, items);
+    int v;
+    for (int i = 0; i < items; i++) {
+        assert(dequeue_wait(q, &v));
+        assert(v == i);   // one producer: FIFO
+    }
+    assert(reap(pid));
+    assert(is_empty(q));
+
+    destroy(q);
+    queue_unlink_shared(qname);
+    printf("  [OK] producer process -> consumer process items=%d\n", items);
+}
+
+// Consumer child: opens the queue by name, takes n values and checks they
+// continue from results[0], then records where it stopped
+static long long *restart_results;
+static void consume_some(int n) {
+    Queue *q = queue_open_shared(qname, 64);
+    if (!q) _exit(1);
+    int v;
+    for (int i = 0; i < n; i++) {
+        if (!dequeue_wait(q, &v) || v != restart_results[0]) _exit(2);
+        restart_results[0]++;
+    }
+    // Exit without destroy, as a crash would
+    _exit(0);
+}
+
+static void test_consumer_restart(void) {
+    queue_unlink_shared(qname);
+    restart_results = shared_results(1);
+    restart_results[0] = 0;
+    Queue *q = queue_open_shared(qname, 64);
+    assert(q != NULL);
+
+    // Three consumer lifetimes in a row; the queue keeps what was queued
+    // while no consumer was running
+    int next = 0;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 40; i++) assert(enqueue(q, next++));
+        pid_t pid = spawn(consume_some, 30);
+        assert(reap(pid));
+        assert(restart_results[0] == 30 * (round + 1));
+        assert(size(q) == next - (int)restart_results[0]);
+    }
+
+    // The parent drains the rest in order
+    int v;
+    while (dequeue(q, &v)) assert(v == restart_results[0]++);
+    assert(restart_results[0] == next);
+
+    destroy(q);
+    queue_unlink_shared(qname);
+    munmap(restart_results, sizeof(long long));
+    printf("  [OK] consumer restarts keep queued values\n");
+}
+
+// Children that die holding a lock: a reservation that is never
+// committed, a peek that is never released
+static Queue *crash_q;
+static void die_in_reserve(int n) {
+    int k;
+    int *slot = (int *)enqueue_reserve(crash_q, n, &k);
+    if (!slot) _exit(1);
+    for (int i = 0; i < k; i++) slot[i] = -1;
+    kill(getpid(), SIGKILL);
+}
+
+static void die_in_peek(int n) {
+    int k;
+    if (!dequeue_peek(crash_q, n, &k)) _exit(1);
+    kill(getpid(), SIGKILL);
+}
+
+static void test_owner_died(void) {
+    int v;
+    crash_q = create(8);
+    assert(crash_q != NULL);
+    assert(enqueue(crash_q, 1) && enqueue(crash_q, 2));
+
+    // Tail lock: the next enqueue recovers it; the reserved values never
+    // became visible
+    reap_killed(spawn(die_in_reserve, 4), SIGKILL);
+    assert(size(crash_q) == 2);
+    assert(enqueue(crash_q, 3));
+    assert(enqueue(crash_q, 4));
+
+    // Head lock: the peeked values are still queued
+    reap_killed(spawn(die_in_peek, 2), SIGKILL);
+    assert(size(crash_q) == 4);
+    for (int i = 1; i <= 4; i++) assert(dequeue(crash_q, &v) && v == i);
+    assert(!dequeue(crash_q, &v));
+
+    // Both locks stay usable, zero-copy included
+    int k;
+    int *slot = (int *)enqueue_reserve(crash_q, 2, &k);
+    assert(slot && k == 2);
+    slot[0] = 5;
+    slot[1] = 6;
+    enqueue_commit(crash_q, slot, 2);
+    assert(dequeue_bulk(crash_q, (int[2]){0}, 2) == 2);
+    assert(is_empty(crash_q));
+
+    destroy(crash_q);
+    printf("  [OK] recovery after a process died holding a lock\n");
+}
+
+// Consumer child that blocks until the queue has a value; 0 if it gets 42
+static void wait_for_value(int unused) {
+    (void)unused;
+    int v;
+    if (!dequeue_wait(crash_q, &v) || v != 42) _exit(1);
+}
+
+static void test_died_while_parked(void) {
+    crash_q = create(4);
+    assert(crash_q != NULL);
+
+    // A consumer killed while parked, then a live one parked next to it
+    pid_t dead = spawn(wait_for_value, 0);
+    usleep(50000);
+    kill(dead, SIGKILL);
+    reap_killed(dead, SIGKILL);
+    pid_t live = spawn(wait_for_value, 0);
+    usleep(50000);
+
+    // The live one still gets woken
+    assert(enqueue(crash_q, 42));
+    assert(reap(live));
+    assert(is_empty(crash_q));
+
+    destroy(crash_q);
+    printf("  [OK] wake-ups survive a consumer killed while parked\n");
+}
+
+// P producer and C consumer processes on one anonymous shared queue
+static Queue *mp_q;
+static long long *mp_results;
+static int mp_items;
+
+static void mp_produce(int id) {
+    for (int i = 0; i < mp_items; i++) {
+        if (!enqueue_wait(mp_q, id * mp_items + i + 1)) _exit(1);
+    }
+}
+
+static void mp_consume(int id) {
+    int v;
+    long long sum = 0, count = 0;
+    // 0 is the stop value
+    while (dequeue_wait(mp_q, &v) && v != 0) {
+        sum += v;
+        count++;
+    }
+    mp_results[2 * id] = sum;
+    mp_results[2 * id + 1] = count;
+}
+
+static void test_mp_mc(int cap, int P, int C, int items) {
+    mp_q = create(cap);
+    assert(mp_q != NULL);
+    mp_results = shared_results(2 * C);
+    mp_items = items;
+
+    pid_t pids[16];
+    for (int c = 0; c < C; c++) pids[c] = spawn(mp_consume, c);
+    for (int p = 0; p < P; p++) pids[C + p] = spawn(mp_produce, p);
+    for (int p = 0; p < P; p++) assert(reap(pids[C + p]));
+    for (int c = 0; c < C; c++) assert(enqueue_wait(mp_q, 0));
+    for (int c = 0; c < C; c++) assert(reap(pids[c]));
+
+    // Every value exactly once: 1 .. P * items
+    long long n = (long long)P * items, sum = 0, count = 0;
+    for (int c = 0; c < C; c++) {
+        sum += mp_results[2 * c];
+        count += mp_results[2 * c + 1];
+    }
+    assert(count == n);
+    assert(sum == n * (n + 1) / 2);
+    assert(is_empty(mp_q));
+
+    destroy(mp_q);
+    munmap(mp_results, 2 * C * sizeof(long long));
+    printf("  [OK] mp/mc processes cap=%d P=%d C=%d items=%d\n", cap, P, C, items);
+}
+
+int main(void) {
+    printf("Running shared-memory queue tests...\n");
+    snprintf(qname, sizeof(qname), "/test_queue_shm_%d", (int)getpid());
+
+    test_open_attach();
+    test_two_processes(20000);
+    test_consumer_restart();
+    test_owner_died();
+    test_died_while_parked();
+
+    test_mp_mc(64, 1, 1, 20000);
+    test_mp_mc(16, 2, 2, 5000);
+    test_mp_mc(4, 4, 3, 2000);
+
+    printf("All shared-memory queue tests PASSED.\n");
+    return 0;
+}
@@ -0,0 +1,172 @@
+// tests/test_queue_static.c
+// DEFINE_QUEUE (src/queue_static.h): every policy, at a capacity that is
+// not a power of two (spare ring slots), one that is, and capacity 1, with
+// ints and with a struct element type. Independent of MODE.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue_static.h"
+
+typedef struct {
+    int id;
+    double x;
+} Pair;
+
+DEFINE_QUEUE(seq5, int, 5, seq)
+DEFINE_QUEUE(one5, int, 5, onelock)
+DEFINE_QUEUE(two5, int, 5, twolock)
+DEFINE_QUEUE(lf5, int, 5, lockfree)
+DEFINE_QUEUE(lf4, int, 4, lockfree)
+DEFINE_QUEUE(seq1, int, 1, seq)
+DEFINE_QUEUE(one1, int, 1, onelock)
+DEFINE_QUEUE(two1, int, 1, twolock)
+DEFINE_QUEUE(lf1, int, 1, lockfree)
+DEFINE_QUEUE(pairs, Pair, 3, twolock)
+DEFINE_QUEUE(lf_pairs, Pair, 3, lockfree)
+
+// Concurrent ones: small, so both sides hit full and empty often
+DEFINE_QUEUE(one16, int, 16, onelock)
+DEFINE_QUEUE(two16, int, 16, twolock)
+DEFINE_QUEUE(lf16, int, 16, lockfree)
+DEFINE_QUEUE(lf3, int, 3, lockfree)
+DEFINE_QUEUE(lf1c, int, 1, lockfree)
+
+// Fill to capacity, drain, several laps around the ring
+#define TEST_FIFO(name, CAP)                                                    \
+    static void test_fifo_##name(void) {                                        \
+        static name q;                                                          \
+        name##_init(&q);                                                        \
+        assert(name##_capacity() == (CAP));                                     \
+        assert(name##_is_empty(&q) && !name##_is_full(&q));                     \
+        int v, next = 0, expect = 0;                                            \
+        for (int round = 0; round < 5; round++) {                               \
+            for (int i = 0; i < (CAP); i++) assert(name##_enqueue(&q, next++)); \
+            assert(name##_is_full(&q) && name##_size(&q) == (CAP));             \
+            assert(!name##_enqueue(&q, -1));                                    \
+            for (int i = 0; i < (CAP); i++) {                                   \
+                assert(name##_dequeue(&q, &v) && v == expect++);                \
+            }                                                                   \
+            assert(!name##_dequeue(&q, &v));                                    \
+            assert(name##_is_empty(&q));                                        \
+            /* Uneven fill, so the next lap starts mid-ring */                  \
+            assert(name##_enqueue(&q, next++));                                 \
+            assert(name##_dequeue(&q, &v) && v == expect++);                    \
+        }                                                                       \
+        name##_destroy(&q);                                                     \
+        printf("  [OK] FIFO and capacity %s\n", #name);                         \
+    }
+
+TEST_FIFO(seq5, 5)
+TEST_FIFO(one5, 5)
+TEST_FIFO(two5, 5)
+TEST_FIFO(lf5, 5)
+TEST_FIFO(lf4, 4)
+TEST_FIFO(seq1, 1)
+TEST_FIFO(one1, 1)
+TEST_FIFO(two1, 1)
+TEST_FIFO(lf1, 1)
+
+#define TEST_PAIRS(name)                                                        \
+    static void test_pairs_##name(void) {                                       \
+        name q;                                                                 \
+        name##_init(&q);                                                        \
+        Pair out;                                                               \
+        for (int i = 0; i < 3; i++) {                                           \
+            Pair p = {i, i * 0.5};                                              \
+            assert(name##_enqueue(&q, p));                                      \
+        }                                                                       \
+        assert(!name##_enqueue(&q, (Pair){-1, 0}));                             \
+        for (int i = 0; i < 3; i++) {                                           \
+            assert(name##_dequeue(&q, &out) && out.id == i && out.x == i * 0.5); \
+        }                                                                       \
+        assert(!name##_dequeue(&q, &out));                                      \
+        name##_destroy(&q);                                                     \
+        printf("  [OK] struct elements %s\n", #name);                           \
+    }
+
+TEST_PAIRS(pairs)
+TEST_PAIRS(lf_pairs)
+
+// P producers each enqueue 1..items tagged with their id; C consumers
+// check per-producer order and the total
+#define TEST_MP_MC(name)                                                        \
+    static void test_mp_mc_##name(int P, int C, int items) {                    \
+        static name q;                                                          \
+        name##_init(&q);                                                        \
+        long long sum = 0, count = 0;                                           \
+        int producing = P;                                                      \
+        _Pragma("omp parallel num_threads(P + C) shared(q, sum, count, producing)") \
+        {                                                                       \
+            int tid = omp_get_thread_num();                                     \
+            if (tid < P) {                                                      \
+                for (int i = 1; i <= items; i++) {                              \
+                    while (!name##_enqueue(&q, tid * items + i)) {}             \
+                }                                                               \
+                _Pragma("omp atomic")                                           \
+                producing--;                                                    \
+            } else {                                                            \
+                int last[64] = {0};                                             \
+                long long s = 0, n = 0;                                         \
+                int v, p;                                                       \
+                for (;;) {                                                      \
+                    if (name##_dequeue(&q, &v)) {                               \
+                        int from = (v - 1) / items, seq = (v - 1) % items + 1;  \
+                        assert(seq > last[from]);                               \
+                        last[from] = seq;                                       \
+                        s += v;                                                 \
+                        n++;                                                    \
+                        continue;                                               \
+                    }                                                           \
+                    _Pragma("omp atomic read")                                  \
+                    p = producing;                                              \
+                    if (p == 0 && name##_is_empty(&q)) break;                   \
+                }                                                               \
+                _Pragma("omp atomic")                                           \
+                sum += s;                                                       \
+                _Pragma("omp atomic")                                           \
+                count += n;                                                     \
+            }                                                                   \
+        }                                                                       \
+        long long total = (long long)P * items;                                 \
+        assert(count == total);                                                 \
+        assert(sum == total * (total + 1) / 2);                                 \
+        name##_destroy(&q);                                                     \
+        printf("  [OK] mp/mc %s P=%d C=%d items=%d\n", #name, P, C, items);     \
+    }
+
+TEST_MP_MC(one16)
+TEST_MP_MC(two16)
+TEST_MP_MC(lf16)
+TEST_MP_MC(lf3)
+TEST_MP_MC(lf1c)
+
+int main(void) {
+    printf("Running static queue tests...\n");
+
+    test_fifo_seq5();
+    test_fifo_one5();
+    test_fifo_two5();
+    test_fifo_lf5();
+    test_fifo_lf4();
+    test_fifo_seq1();
+    test_fifo_one1();
+    test_fifo_two1();
+    test_fifo_lf1();
+    test_pairs_pairs();
+    test_pairs_lf_pairs();
+
+    test_mp_mc_one16(1, 1, 20000);
+    test_mp_mc_one16(2, 2, 5000);
+    test_mp_mc_two16(1, 1, 20000);
+    test_mp_mc_two16(4, 4, 2000);
+    test_mp_mc_lf16(1, 1, 20000);
+    test_mp_mc_lf16(4, 4, 2000);
+    test_mp_mc_lf3(3, 2, 2000);
+    test_mp_mc_lf1c(2, 2, 2000);
+
+    printf("All static queue tests PASSED.\n");
+    return 0;
+}
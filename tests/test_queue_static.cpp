@@ -0,0 +1,90 @@
+// tests/test_queue_static.cpp
+// StaticQueue (src/queue_static.hpp): the C++ wrapper over DEFINE_QUEUE,
+// for every policy. Built with LOCK=omp or LOCK=pthread only.
+#include <cstdio>
+#include <cassert>
+#include <omp.h>
+
+#include "queue_static.hpp"
+
+struct Pair {
+    int id;
+    double x;
+};
+
+template <template <class, std::size_t> class Policy, std::size_t N>
+static void test_fifo(const char *name) {
+    static StaticQueue<int, N, Policy> q;
+    static_assert(StaticQueue<int, N, Policy>::capacity() == N, "capacity is N");
+    assert(q.empty() && !q.full());
+
+    const int cap = (int)N;
+    int v, next = 0, expect = 0;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < cap; i++) assert(q.push(next++));
+        assert(q.full() && q.size() == cap);
+        assert(!q.push(-1));
+        for (int i = 0; i < cap; i++) assert(q.pop(v) && v == expect++);
+        assert(!q.pop(v) && q.empty());
+        // Uneven fill, so the next lap starts mid-ring
+        assert(q.push(next++));
+        assert(q.pop(v) && v == expect++);
+    }
+    std::printf("  [OK] FIFO and capacity %zu %s\n", N, name);
+}
+
+template <template <class, std::size_t> class Policy>
+static void test_pairs(const char *name) {
+    StaticQueue<Pair, 3, Policy> q;
+    Pair out;
+    for (int i = 0; i < 3; i++) assert(q.push(Pair{i, i * 0.5}));
+    assert(!q.push(Pair{-1, 0}));
+    for (int i = 0; i < 3; i++) assert(q.pop(out) && out.id == i && out.x == i * 0.5);
+    assert(!q.pop(out));
+    std::printf("  [OK] struct elements %s\n", name);
+}
+
+// One producer, one consumer: FIFO across threads
+template <template <class, std::size_t> class Policy>
+static void test_p1c1(const char *name, int items) {
+    static StaticQueue<int, 16, Policy> q;
+    bool ok = true;
+    #pragma omp parallel num_threads(2) shared(q, ok)
+    {
+        if (omp_get_thread_num() == 0) {
+            for (int i = 0; i < items; i++) {
+                while (!q.push(i)) {}
+            }
+        } else {
+            int v;
+            for (int i = 0; i < items; i++) {
+                while (!q.pop(v)) {}
+                if (v != i) ok = false;
+            }
+        }
+    }
+    assert(ok && q.empty());
+    std::printf("  [OK] P=1 C=1 %s items=%d\n", name, items);
+}
+
+int main() {
+    std::printf("Running static queue C++ tests...\n");
+
+    test_fifo<queue_policy::seq, 5>("seq");
+    test_fifo<queue_policy::onelock, 5>("onelock");
+    test_fifo<queue_policy::twolock, 5>("twolock");
+    test_fifo<queue_policy::lockfree, 5>("lockfree");
+    test_fifo<queue_policy::seq, 1>("seq");
+    test_fifo<queue_policy::onelock, 1>("onelock");
+    test_fifo<queue_policy::twolock, 1>("twolock");
+    test_fifo<queue_policy::lockfree, 1>("lockfree");
+    test_pairs<queue_policy::twolock>("twolock");
+    test_pairs<queue_policy::lockfree>("lockfree");
+
+    test_p1c1<queue_policy::onelock>("onelock", 20000);
+    test_p1c1<queue_policy::twolock>("twolock", 20000);
+    test_p1c1<queue_policy::lockfree>("lockfree", 20000);
+
+    std::printf("All static queue C++ tests PASSED.\n");
+    return 0;
+}
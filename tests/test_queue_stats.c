@@ -0,0 +1,153 @@
+// tests/test_queue_stats.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+static void test_null_args(void) {
+    QueueStats st;
+    memset(&st, 0xff, sizeof(st));
+    assert(!queue_get_stats(NULL, &st));
+    assert(st.enqueued == 0 && st.dequeued == 0 && st.wait_s == 0.0);
+
+    Queue *q = create(4);
+    assert(q != NULL);
+    assert(!queue_get_stats(q, NULL));
+    destroy(q);
+}
+
+#ifndef QUEUE_STATS
+
+// Built without QUEUE_STATS: nothing is counted, *out is zeroed
+static void test_disabled(void) {
+    Queue *q = create(4);
+    assert(q != NULL);
+    assert(enqueue(q, 1));
+
+    QueueStats st;
+    memset(&st, 0xff, sizeof(st));
+    assert(!queue_get_stats(q, &st));
+    assert(st.enqueued == 0 && st.full == 0 && st.high_water == 0);
+    destroy(q);
+}
+
+#else
+
+// Single thread: every counter except contention is exact
+static void test_counts(void) {
+    Queue *q = create(4);
+    assert(q != NULL);
+    QueueStats st;
+    assert(queue_get_stats(q, &st));
+    assert(st.enqueued == 0 && st.dequeued == 0 && st.high_water == 0);
+
+    int v;
+    assert(!dequeue(q, &v));                 // empty: 1
+    for (int i = 0; i < 4; i++) assert(enqueue(q, i));
+    assert(!enqueue(q, 4));                  // full: 1
+    for (int i = 0; i < 2; i++) assert(dequeue(q, &v));
+
+    int vals[3] = {5, 6, 7}, out[8];
+    assert(enqueue_bulk(q, vals, 3) == 2);   // enqueued: 6
+    assert(enqueue_bulk(q, vals, 3) == 0);   // full: 2
+    assert(dequeue_bulk(q, out, 8) == 4);    // dequeued: 6
+    assert(dequeue_bulk(q, out, 8) == 0);    // empty: 2
+
+    int n;
+    int *slot = (int *)enqueue_reserve(q, 1, &n);
+    assert(slot && n == 1);
+    *slot = 9;
+    enqueue_commit(q, slot, 1);              // enqueued: 7
+    slot = (int *)dequeue_peek(q, 1, &n);
+    assert(slot && n == 1 && *slot == 9);
+    dequeue_release(q, slot, 1);             // dequeued: 7
+
+    assert(queue_get_stats(q, &st));
+    assert(st.enqueued == 7 && st.dequeued == 7);
+    assert(st.full == 2 && st.empty == 2);
+    assert(st.high_water == 4);
+
+    // Failed tries of a blocking call count as rejections too
+    assert(!dequeue_wait_timeout(q, &v, 0));
+    assert(queue_get_stats(q, &st));
+    assert(st.empty >= 3);
+
+    destroy(q);
+    printf("  [OK] single-thread counts\n");
+}
+
+// P producers and C consumers: totals add up across the per-thread shards
+static void test_concurrent(int P, int C, int items) {
+    Queue *q = create(64);
+    assert(q != NULL);
+    int per_producer = items / P;
+    items = per_producer * P;
+    int got = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, got)
+    {
+        int tid = omp_get_thread_num();
+        if (tid < P) {
+            for (int i = 0; i < per_producer; i++) {
+                while (!enqueue(q, i)) { /* busy-wait */ }
+            }
+        } else {
+            int v;
+            for (;;) {
+                int done;
+                #pragma omp atomic read
+                done = got;
+                if (done >= items) break;
+                if (dequeue(q, &v)) {
+                    #pragma omp atomic
+                    got++;
+                }
+            }
+        }
+    }
+
+    QueueStats st;
+    assert(queue_get_stats(q, &st));
+    assert(st.enqueued == (unsigned long long)items);
+    assert(st.dequeued == (unsigned long long)items);
+    assert(st.high_water >= 1 && st.high_water <= 64);
+    assert(st.wait_s >= 0.0);
+    destroy(q);
+
+    printf("  [OK] concurrent totals P=%d C=%d items=%d (contended=%llu)\n",
+           P, C, items, st.contended);
+}
+
+#endif // QUEUE_STATS
+
+int main(void) {
+    printf("Running statistics tests...\n");
+
+    test_null_args();
+
+#ifndef QUEUE_STATS
+    test_disabled();
+    printf("  [OK] built without QUEUE_STATS\n");
+#else
+    test_counts();
+
+    // The sequential queue is single-threaded; spsc allows one thread per side
+    if (strncmp(IMPL_NAME, "seq", 3) != 0) {
+        test_concurrent(1, 1, 20000);
+#ifndef SPSC_ONLY
+        test_concurrent(4, 4, 20000);
+#endif
+    }
+#endif
+
+    printf("All statistics tests PASSED.\n");
+    return 0;
+}
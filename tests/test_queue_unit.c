@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #include "queue.h"   
@@ -79,6 +80,337 @@ static void test_wraparound(void) {
     destroy(q);
 }
 
+// Capacity 1 holds exactly one value. The lock-free ring used to accept
+// a second one: with a single slot a full cell looked free for the next lap.
+static void test_capacity_one(void) {
+    Queue *qs[3] = { create(1), create_pow2(1), create_sized(1, sizeof(int)) };
+    int in[2] = {7, 8};
+    int v;
+
+    for (int i = 0; i < 3; i++) {
+        Queue *q = qs[i];
+        assert(q != NULL);
+        assert(capacity(q) == 1);
+
+        for (int round = 0; round < 4; round++) {
+            assert(enqueue(q, round));
+            assert(is_full(q));
+            assert(!enqueue(q, 100 + round));
+            assert(enqueue_bulk(q, in, 2) == 0);
+            assert(size(q) == 1);
+            assert(dequeue(q, &v) && v == round);
+            assert(!dequeue(q, &v));
+            assert(is_empty(q));
+        }
+
+        // A batch is cut down to the single free slot
+        assert(enqueue_bulk(q, in, 2) == 1);
+        assert(!enqueue(q, 9));
+        assert(dequeue_bulk(q, &v, 2) == 1 && v == 7);
+        assert(is_empty(q));
+
+        destroy(q);
+    }
+}
+
+static void test_bulk(void) {
+    Queue *q = create(5);
+    assert(q != NULL);
+
+    int in[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    int out[8];
+
+    // Partial enqueue when the batch does not fit
+    assert(enqueue_bulk(q, in, 3) == 3);
+    assert(enqueue_bulk(q, in + 3, 5) == 2);
+    assert(is_full(q));
+    assert(enqueue_bulk(q, in + 5, 3) == 0);
+
+    // Partial dequeue, then refill so the next batch wraps around
+    assert(dequeue_bulk(q, out, 3) == 3);
+    assert(out[0] == 1 && out[1] == 2 && out[2] == 3);
+    assert(enqueue_bulk(q, in + 5, 3) == 3);
+    assert(size(q) == 5);
+
+    // Wrapped batch comes out in FIFO order, and mixes with single ops
+    int v;
+    assert(dequeue(q, &v) && v == 4);
+    assert(dequeue_bulk(q, out, 8) == 4);
+    assert(out[0] == 5 && out[1] == 6 && out[2] == 7 && out[3] == 8);
+    assert(is_empty(q));
+    assert(dequeue_bulk(q, out, 8) == 0);
+
+    // Degenerate arguments
+    assert(enqueue_bulk(q, in, 0) == 0);
+    assert(enqueue_bulk(q, NULL, 3) == 0);
+    assert(dequeue_bulk(q, NULL, 3) == 0);
+    assert(dequeue_bulk(q, out, -1) == 0);
+
+    destroy(q);
+}
+
+// Bulk batches around and below the wide-copy threshold (64 ints), at
+// odd offsets, with every copy kernel the CPU has, plain and streaming
+static void test_copy_kernels(void) {
+    static const char *const kernels[] = {"memcpy", "sse2", "avx2"};
+    static const int batches[] = {1, 63, 64, 65, 97, 255, 301, 999, 1000, 7};
+    enum { CAP = 1000 };
+    static int in[CAP + 1], out[CAP + 1];
+
+    assert(!queue_set_copy_kernel("mmx"));
+    for (int k = 0; k < 3; k++) {
+        //Edge case: kernels this CPU lacks are refused and skipped
+        if (!queue_set_copy_kernel(kernels[k])) continue;
+        assert(strcmp(queue_copy_kernel(), kernels[k]) == 0);
+        for (int nt = 0; nt < 2; nt++) {
+            queue_set_stream_threshold(nt ? 1 : 0);
+            Queue *q = create(CAP);
+            assert(q != NULL);
+            int next = 0, expect = 0;
+            for (int round = 0; round < 3; round++) {
+                for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++) {
+                    int n = batches[b], off = (int)b % 2;
+                    for (int i = 0; i < n; i++) in[off + i] = next + i;
+                    assert(enqueue_bulk(q, in + off, n) == n);
+                    next += n;
+                    assert(dequeue_bulk(q, out + off, n) == n);
+                    for (int i = 0; i < n; i++) assert(out[off + i] == expect++);
+                    // Move on one slot, so the next batch starts elsewhere
+                    int v;
+                    assert(enqueue_bulk(q, in + off, 1) == 1);
+                    assert(dequeue(q, &v) && v == in[off]);
+                    expect = next;
+                }
+            }
+            assert(is_empty(q));
+            destroy(q);
+        }
+    }
+    queue_set_copy_kernel(NULL);
+    queue_set_stream_threshold(0);
+}
+
+static void test_wait_timeout(void) {
+    Queue *q = create(2);
+    assert(q != NULL);
+
+    int v;
+
+    // Room / values available: the blocking calls return at once
+    assert(enqueue_wait(q, 1));
+    assert(enqueue_wait_timeout(q, 2, 10));
+
+    // Full: gives up after the timeout
+    assert(!enqueue_wait_timeout(q, 3, 10));
+    assert(!enqueue_wait_timeout(q, 3, 0));
+
+    assert(dequeue_wait(q, &v) && v == 1);
+    assert(dequeue_wait_timeout(q, &v, 0) && v == 2);
+
+    // Empty: gives up after the timeout
+    assert(!dequeue_wait_timeout(q, &v, 10));
+    assert(is_empty(q));
+
+    destroy(q);
+}
+
+static void test_pow2(void) {
+    // Rounded up internally, but capacity is what was asked for
+    Queue *q = create_pow2(5);
+    assert(q != NULL);
+    assert(capacity(q) == 5);
+    assert(create_pow2(0) == NULL);
+
+    int v;
+    int in[4] = {1, 2, 3, 4};
+    int out[8];
+
+    for (int i = 0; i < 5; i++) assert(enqueue(q, i));
+    assert(is_full(q));
+    assert(!enqueue(q, 5));
+    assert(enqueue_bulk(q, in, 4) == 0);
+
+    // Go around the (8-slot) ring a few times with single and bulk ops
+    for (int round = 0; round < 10; round++) {
+        assert(dequeue_bulk(q, out, 3) == 3);
+        assert(enqueue_bulk(q, in, 4) == 3);
+        assert(is_full(q));
+        assert(size(q) == 5);
+    }
+    assert(dequeue_bulk(q, out, 8) == 5);
+    // Each round keeps the last two values and appends 1, 2, 3
+    assert(out[0] == 2 && out[1] == 3);
+    assert(out[2] == 1 && out[3] == 2 && out[4] == 3);
+    assert(!dequeue(q, &v));
+    assert(is_empty(q));
+
+    destroy(q);
+}
+
+typedef struct { long long id; double x; } Pair;      // 16 bytes
+typedef struct { int a, b, c, d, e, f; } Wide;         // 24 bytes (generic path)
+
+static void test_sized(void) {
+    Pair p, out;
+    Queue *q = create_sized(3, sizeof(Pair));
+    assert(q != NULL);
+    assert(elem_size(q) == sizeof(Pair));
+    assert(capacity(q) == 3);
+    assert(create_sized(3, 0) == NULL);
+    assert(create_sized(0, sizeof(Pair)) == NULL);
+
+    // The int API does not apply to a 16-byte queue
+    int v;
+    assert(!enqueue(q, 1));
+    assert(!dequeue(q, &v));
+    assert(enqueue_bulk(q, &v, 1) == 0);
+
+    // Go around the ring a few times, checking FIFO order and contents
+    long long next_in = 0, next_out = 0;
+    for (int round = 0; round < 10; round++) {
+        while (!is_full(q)) {
+            p.id = next_in; p.x = next_in * 0.5;
+            assert(enqueue_elem(q, &p));
+            next_in++;
+        }
+        p.id = -1;
+        assert(!enqueue_elem(q, &p));
+        for (int i = 0; i < 2; i++) {
+            assert(dequeue_elem(q, &out));
+            assert(out.id == next_out && out.x == next_out * 0.5);
+            next_out++;
+        }
+    }
+    while (dequeue_elem(q, &out)) {
+        assert(out.id == next_out);
+        next_out++;
+    }
+    assert(next_out == next_in);
+    assert(is_empty(q));
+    destroy(q);
+
+    // Size without a specialized copy, on a rounded-up ring
+    Wide t = {0}, tout;
+    q = create_sized_pow2(5, sizeof(Wide));
+    assert(q != NULL);
+    assert(elem_size(q) == sizeof(Wide));
+    for (int i = 0; i < 5; i++) {
+        t.a = i; t.f = -i;
+        assert(enqueue_elem(q, &t));
+    }
+    assert(!enqueue_elem(q, &t));
+    for (int i = 0; i < 5; i++) {
+        assert(dequeue_elem(q, &tout));
+        assert(tout.a == i && tout.f == -i);
+    }
+    assert(!dequeue_elem(q, &tout));
+    destroy(q);
+
+    // Int queues work through the generic calls too
+    q = create(2);
+    assert(elem_size(q) == sizeof(int));
+    v = 7;
+    assert(enqueue_elem(q, &v));
+    assert(dequeue(q, &v) && v == 7);
+    destroy(q);
+}
+
+static void test_create_on_node(void) {
+    int v;
+
+    // Node 0 always exists; the binding itself may be unavailable
+    Queue *q = create_on_node(4, 0);
+    assert(q != NULL);
+    assert(queue_node(q) == 0 || queue_node(q) == -1);
+    assert(capacity(q) == 4);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++) assert(enqueue(q, round * 4 + i));
+        assert(!enqueue(q, -1));
+        for (int i = 0; i < 4; i++) assert(dequeue(q, &v) && v == round * 4 + i);
+        assert(!dequeue(q, &v));
+    }
+    destroy(q);
+
+    // The calling thread's node
+    q = create_on_node(2, -1);
+    assert(q != NULL);
+    assert(enqueue(q, 5) && dequeue(q, &v) && v == 5);
+    destroy(q);
+
+    // A node that does not exist still gives a (unbound) queue
+    q = create_on_node(2, 1000);
+    assert(q != NULL);
+    assert(queue_node(q) == -1);
+    assert(enqueue(q, 6) && dequeue(q, &v) && v == 6);
+    destroy(q);
+
+    // Plain create is never bound
+    q = create(2);
+    assert(queue_node(q) == -1);
+    destroy(q);
+
+    assert(create_on_node(0, 0) == NULL);
+    assert(queue_node(NULL) == -1);
+}
+
+static void test_create_ex(void) {
+    int v;
+
+    // No options, or zeroed ones: a plain create
+    Queue *q = create_ex(3, NULL);
+    assert(q != NULL && capacity(q) == 3 && elem_size(q) == sizeof(int));
+    destroy(q);
+    QueueOptions o = {0};
+    q = create_ex(3, &o);
+    assert(q != NULL && capacity(q) == 3 && elem_size(q) == sizeof(int));
+    assert(queue_mem(q) == 0 && queue_node(q) == -1);
+    destroy(q);
+    assert(create_ex(0, &o) == NULL);
+
+    // Element size and power-of-two ring
+    o.elem_size = sizeof(Pair);
+    o.pow2 = true;
+    q = create_ex(5, &o);
+    assert(q != NULL && elem_size(q) == sizeof(Pair) && capacity(q) == 5);
+    Pair p = {42, 1.5}, out;
+    assert(enqueue_elem(q, &p) && dequeue_elem(q, &out));
+    assert(out.id == 42 && out.x == 1.5);
+    destroy(q);
+
+    // Every page option at once on a ring of several pages; each is best
+    // effort, but only requested flags may be reported
+    unsigned want = QUEUE_MEM_HUGE | QUEUE_MEM_PREFAULT | QUEUE_MEM_LOCK;
+    o = (QueueOptions){0};
+    o.mem = want;
+    int cap = 1 << 18;
+    q = create_ex(cap, &o);
+    assert(q != NULL && capacity(q) == cap);
+    assert((queue_mem(q) & ~want) == 0);
+#ifndef SEGMENTED
+    // Pre-faulting cannot fail (the segmented queue ignores the options)
+    assert(queue_mem(q) & QUEUE_MEM_PREFAULT);
+#endif
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < cap; i++) assert(enqueue(q, i));
+        assert(is_full(q));
+        for (int i = 0; i < cap; i++) assert(dequeue(q, &v) && v == i);
+        assert(is_empty(q));
+    }
+    destroy(q);
+
+    // On a node, like create_on_node
+    o.mem = QUEUE_MEM_NODE | QUEUE_MEM_PREFAULT;
+    o.node = 0;
+    q = create_ex(4, &o);
+    assert(q != NULL);
+    assert(queue_node(q) == 0 || queue_node(q) == -1);
+    assert((queue_node(q) == 0) == ((queue_mem(q) & QUEUE_MEM_NODE) != 0));
+    assert(enqueue(q, 9) && dequeue(q, &v) && v == 9);
+    destroy(q);
+
+    assert(queue_mem(NULL) == 0);
+}
+
 static void test_null_arguments(void) {
     int v;
     // All should be safe (return false / 0, not crash)
@@ -89,6 +421,15 @@ static void test_null_arguments(void) {
     assert(!is_full(NULL));
     assert(size(NULL) == 0);
     assert(capacity(NULL) == 0);
+    assert(enqueue_bulk(NULL, &v, 1) == 0);
+    assert(dequeue_bulk(NULL, &v, 1) == 0);
+    assert(!enqueue_wait(NULL, 1));
+    assert(!dequeue_wait(NULL, &v));
+    assert(!enqueue_wait_timeout(NULL, 1, 0));
+    assert(!dequeue_wait_timeout(NULL, NULL, 0));
+    assert(!enqueue_elem(NULL, &v));
+    assert(!dequeue_elem(NULL, &v));
+    assert(elem_size(NULL) == 0);
 }
 
 int main(void) {
@@ -97,6 +438,14 @@ int main(void) {
     test_create_destroy();
     test_enqueue_dequeue_basic();
     test_wraparound();
+    test_capacity_one();
+    test_bulk();
+    test_copy_kernels();
+    test_wait_timeout();
+    test_pow2();
+    test_sized();
+    test_create_on_node();
+    test_create_ex();
     test_null_arguments();
 
     printf("All unit tests PASSED.\n");
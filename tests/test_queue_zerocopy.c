@@ -0,0 +1,235 @@
+// tests/test_queue_zerocopy.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <omp.h>
+
+#include "queue.h"
+
+#ifndef IMPL_NAME
+#define IMPL_NAME "default"
+#endif
+
+// 64-byte message, filled in place through enqueue_reserve
+typedef struct { long long id; char body[56]; } Msg;
+
+static void fill_msg(Msg *m, long long id) {
+    m->id = id;
+    memset(m->body, (int)(id & 0x7f), sizeof(m->body));
+}
+
+static void check_msg(const Msg *m, long long id) {
+    assert(m->id == id);
+    for (int i = 0; i < (int)sizeof(m->body); i++) {
+        assert(m->body[i] == (char)(id & 0x7f));
+    }
+}
+
+static void test_reserve_commit_basic(void) {
+    Queue *q = create_sized(4, sizeof(Msg));
+    assert(q != NULL);
+
+    int count;
+
+    // Nothing to peek yet
+    assert(dequeue_peek(q, 1, &count) == NULL && count == 0);
+
+    // Reserve one slot, fill it in place, publish it
+    Msg *m = (Msg *)enqueue_reserve(q, 1, &count);
+    assert(m != NULL && count == 1);
+    fill_msg(m, 42);
+    enqueue_commit(q, m, 1);
+    assert(size(q) == 1);
+
+    // The copying calls see the same element
+    Msg out;
+    assert(dequeue_elem(q, &out));
+    check_msg(&out, 42);
+
+    // And the other way round
+    fill_msg(&out, 7);
+    assert(enqueue_elem(q, &out));
+    const Msg *p = (const Msg *)dequeue_peek(q, 1, &count);
+    assert(p != NULL && count == 1);
+    check_msg(p, 7);
+    dequeue_release(q, (void *)p, 1);
+    assert(is_empty(q));
+
+    // Fill up with reservations, then the queue is full
+    for (int i = 0; i < 4; i++) {
+        m = (Msg *)enqueue_reserve(q, 1, &count);
+        assert(m != NULL && count == 1);
+        fill_msg(m, 100 + i);
+        enqueue_commit(q, m, 1);
+    }
+    assert(is_full(q));
+    assert(enqueue_reserve(q, 1, &count) == NULL && count == 0);
+
+    for (int i = 0; i < 4; i++) {
+        p = (const Msg *)dequeue_peek(q, 1, &count);
+        assert(p != NULL && count == 1);
+        check_msg(p, 100 + i);
+        dequeue_release(q, (void *)p, 1);
+    }
+    assert(is_empty(q));
+
+    destroy(q);
+}
+
+// Multi-slot reservations: a batch is written straight into the ring and
+// cut where the ring wraps. The lock-free ring hands out one slot at a
+// time, so every batch there is a run of single-slot reservations.
+static void test_reserve_batches(void) {
+    Queue *q = create(8);
+    assert(q != NULL);
+
+    int count;
+    int next_in = 0, next_out = 0;
+
+    for (int round = 0; round < 20; round++) {
+        // Write 5 values in as few reservations as the ring allows
+        int want = 5;
+        while (want > 0) {
+            int *slots = (int *)enqueue_reserve(q, want, &count);
+            assert(slots != NULL);
+            assert(count >= 1 && count <= want);
+            for (int i = 0; i < count; i++) slots[i] = next_in++;
+            enqueue_commit(q, slots, count);
+            want -= count;
+        }
+
+        // Read them back, releasing only part of the last peek so the
+        // rest stays queued
+        int left = 5;
+        while (left > 0) {
+            const int *vals = (const int *)dequeue_peek(q, 8, &count);
+            assert(vals != NULL && count >= 1);
+            int take = (count > left) ? left : count;
+            if (take > 1 && left == 5) take--;   // leave one behind
+            for (int i = 0; i < take; i++) assert(vals[i] == next_out++);
+            dequeue_release(q, (void *)vals, take);
+            left -= take;
+        }
+        assert(is_empty(q));
+    }
+
+    // A reservation never runs past the end of the ring, and never past
+    // the free space
+    int v;
+    for (int i = 0; i < 6; i++) assert(enqueue(q, i));
+    for (int i = 0; i < 6; i++) assert(dequeue(q, &v) && v == i);
+    int *slots = (int *)enqueue_reserve(q, 8, &count);
+    assert(slots != NULL && count >= 1 && count <= 8);
+    for (int i = 0; i < count; i++) slots[i] = i;
+    enqueue_commit(q, slots, count);
+    assert(size(q) == count);
+
+    destroy(q);
+}
+
+static void test_zero_copy_null_arguments(void) {
+    int count = 5;
+    assert(enqueue_reserve(NULL, 1, &count) == NULL && count == 0);
+    count = 5;
+    assert(dequeue_peek(NULL, 1, &count) == NULL && count == 0);
+    assert(enqueue_reserve(NULL, 1, NULL) == NULL);
+    assert(dequeue_peek(NULL, 1, NULL) == NULL);
+
+    Queue *q = create(2);
+    count = 5;
+    assert(enqueue_reserve(q, 0, &count) == NULL && count == 0);
+    assert(dequeue_peek(q, -1, &count) == NULL && count == 0);
+    // Commit/release without a reservation are no-ops
+    enqueue_commit(NULL, &count, 1);
+    dequeue_release(NULL, &count, 1);
+    enqueue_commit(q, NULL, 1);
+    dequeue_release(q, NULL, 1);
+    assert(is_empty(q));
+    destroy(q);
+}
+
+// Producers and consumers move 64-byte messages with reserve/commit and
+// peek/release only; every message is checked field by field.
+static void test_mp_mc_zero_copy(int cap, int P, int C, int items_per_prod) {
+    Queue *q = create_sized(cap, sizeof(Msg));
+    assert(q != NULL);
+
+    int total_items = P * items_per_prod;
+    int consumed_total = 0;
+    long long sum_enq = 0;
+    long long sum_deq = 0;
+
+    #pragma omp parallel num_threads(P + C) shared(q, consumed_total, sum_enq, sum_deq)
+    {
+        int tid = omp_get_thread_num();
+        int count;
+
+        if (tid < P) {
+            int base = tid * items_per_prod;
+            for (int i = 0; i < items_per_prod; i++) {
+                long long id = base + i;
+                Msg *m;
+                while (!(m = (Msg *)enqueue_reserve(q, 1, &count))) { /* busy-wait */ }
+                fill_msg(m, id);
+                enqueue_commit(q, m, 1);
+
+                #pragma omp atomic
+                sum_enq += id;
+            }
+        } else {
+            while (1) {
+                int c;
+                #pragma omp atomic read
+                c = consumed_total;
+                if (c >= total_items) break;
+
+                const Msg *m = (const Msg *)dequeue_peek(q, 1, &count);
+                if (m) {
+                    long long id = m->id;
+                    check_msg(m, id);
+                    dequeue_release(q, (void *)m, 1);
+
+                    #pragma omp atomic
+                    consumed_total++;
+
+                    #pragma omp atomic
+                    sum_deq += id;
+                }
+            }
+        }
+    }
+
+    assert(consumed_total == total_items);
+    assert(is_empty(q));
+    assert(sum_enq == sum_deq);
+
+    destroy(q);
+
+    printf("  [OK] zero-copy cap=%d P=%d C=%d items=%d\n",
+           cap, P, C, items_per_prod);
+}
+
+int main(void) {
+    printf("Running zero-copy tests...\n");
+
+    test_reserve_commit_basic();
+    test_reserve_batches();
+    test_zero_copy_null_arguments();
+
+    // The sequential queue is single-threaded: no concurrent part
+    if (strncmp(IMPL_NAME, "seq", 3) != 0) {
+#ifdef SPSC_ONLY
+        int pcs[] = {1};
+#else
+        int pcs[] = {1, 2, 4};
+#endif
+        for (int i = 0; i < (int)(sizeof(pcs)/sizeof(pcs[0])); ++i) {
+            test_mp_mc_zero_copy(16, pcs[i], pcs[i], 1000);
+        }
+    }
+
+    printf("All zero-copy tests PASSED.\n");
+    return 0;
+}